@@ -8,12 +8,17 @@
  * - LED control on PB11
  * - Button interrupts on PC0, PC1, PC2, PC3
  * - GPIO library usage with interrupts
+ * - Button handlers deferred to the main loop through a GPIO::EventQueue
+ * - Click / double-click / long-press gestures on PC3 (debounced, TIM16)
  */
 
 #include "App.h"
 #include "main.h"
 
 #include "gpio.h"
+#include "gpio_events.h"
+#include "Debounce.h"
+#include "Gesture.h"
 
 #include <cstdio>
 
@@ -24,7 +29,18 @@ static GPIOOutput* led = nullptr;
 static GPIOEXTI* btn0 = nullptr;
 static GPIOEXTI* btn1 = nullptr; 
 static GPIOEXTI* btn2 = nullptr;
-static GPIOEXTI* btn3 = nullptr;
+static GPIOInput* btn3 = nullptr;
+
+// Button events: the interrupts only record, the handlers (printf) run in App_Run
+static EventQueue buttonEvents;
+
+// Button 3 is sampled and debounced on TIM16; its gestures are decided from the sample clock
+static constexpr uint32_t SAMPLE_MS = 2;
+static constexpr uint8_t BTN3_LANE = 3;
+static Debounce::PortScanner buttonPanel({GPIOC, 1U << BTN3_LANE, 1U << BTN3_LANE});
+
+static void btn3GestureCallback(void* context, uint8_t button, Gesture::Type gesture, uint32_t timeMs);
+static Gesture::ButtonSet buttonGestures(Gesture::DEFAULT_TIMING, btn3GestureCallback, nullptr);
 
 // LED patterns
 static uint32_t ledPattern = 0;
@@ -41,11 +57,11 @@ extern "C" void GPIO_EXTI_HandleInterrupt(uint32_t pin)
 }
 
 /**
- * @brief Button 0 (PC0) interrupt callback
+ * @brief Button 0 (PC0) event handler, run from App_Run via buttonEvents
  * 
  * Toggles the LED when button 0 is pressed
  */
-void btn0InterruptCallback()
+void btn0InterruptCallback(void* /*context*/, const PinEvent& /*event*/)
 {
     printf("Button 0 pressed - Toggling LED\n");
     if (led) {
@@ -54,11 +70,11 @@ void btn0InterruptCallback()
 }
 
 /**
- * @brief Button 1 (PC1) interrupt callback
+ * @brief Button 1 (PC1) event handler, run from App_Run via buttonEvents
  * 
  * Turns LED on when button 1 is pressed
  */
-void btn1InterruptCallback()
+void btn1InterruptCallback(void* /*context*/, const PinEvent& /*event*/)
 {
     printf("Button 1 pressed - LED ON\n");
     if (led) {
@@ -67,11 +83,11 @@ void btn1InterruptCallback()
 }
 
 /**
- * @brief Button 2 (PC2) interrupt callback
+ * @brief Button 2 (PC2) event handler, run from App_Run via buttonEvents
  * 
  * Turns LED off when button 2 is pressed  
  */
-void btn2InterruptCallback()
+void btn2InterruptCallback(void* /*context*/, const PinEvent& /*event*/)
 {
     printf("Button 2 pressed - LED OFF\n");
     if (led) {
@@ -80,14 +96,11 @@ void btn2InterruptCallback()
 }
 
 /**
- * @brief Button 3 (PC3) interrupt callback
- * 
- * Cycles through LED patterns when button 3 is pressed
+ * @brief Show the current LED pattern
  */
-void btn3InterruptCallback()
+static void applyLedPattern()
 {
-    ledPattern = (ledPattern + 1) % 4;
-    printf("Button 3 pressed - LED Pattern: %lu\n", ledPattern);
+    printf("LED Pattern: %lu\n", ledPattern);
     
     if (led) {
         switch (ledPattern) {
@@ -111,6 +124,36 @@ void btn3InterruptCallback()
     }
 }
 
+/**
+ * @brief Button 3 (PC3) gesture handler, run from App_Run via buttonGestures
+ * 
+ * Click: next LED pattern, double click: previous pattern,
+ * long press: LED off, repeat (held): next pattern
+ */
+static void btn3GestureCallback(void* /*context*/, uint8_t button, Gesture::Type gesture, uint32_t timeMs)
+{
+    if (button != BTN3_LANE) {
+        return;
+    }
+
+    switch (gesture) {
+        case Gesture::Type::CLICK:
+        case Gesture::Type::REPEAT:
+            printf("Button 3 %s at %lu ms\n", gesture == Gesture::Type::CLICK ? "click" : "repeat", timeMs);
+            ledPattern = (ledPattern + 1) % 4;
+            break;
+        case Gesture::Type::DOUBLE_CLICK:
+            printf("Button 3 double click at %lu ms\n", timeMs);
+            ledPattern = (ledPattern + 3) % 4;
+            break;
+        case Gesture::Type::LONG_PRESS:
+            printf("Button 3 long press at %lu ms\n", timeMs);
+            ledPattern = 0;
+            break;
+    }
+    applyLedPattern();
+}
+
 void App_Init(void)
 {
     printf("=== STM32L433 LPUART1 Debug Interface Active ===\n");
@@ -123,26 +166,26 @@ void App_Init(void)
     btn0 = new GPIOEXTI(GPIOC, 0, EXTITrigger::FALLING, PinPull::PULL_UP);
     btn1 = new GPIOEXTI(GPIOC, 1, EXTITrigger::FALLING, PinPull::PULL_UP);
     btn2 = new GPIOEXTI(GPIOC, 2, EXTITrigger::FALLING, PinPull::PULL_UP);
-    btn3 = new GPIOEXTI(GPIOC, 3, EXTITrigger::FALLING, PinPull::PULL_UP);
+    btn3 = new GPIOInput(GPIOC, 3, PinPull::PULL_UP);
     
-    // Set up interrupt callbacks
-    btn0->setCallback(btn0InterruptCallback);
-    btn1->setCallback(btn1InterruptCallback);
-    btn2->setCallback(btn2InterruptCallback);  
-    btn3->setCallback(btn3InterruptCallback);
+    // Route the button interrupts into the event queue
+    buttonEvents.attach(*btn0, btn0InterruptCallback);
+    buttonEvents.attach(*btn1, btn1InterruptCallback);
+    buttonEvents.attach(*btn2, btn2InterruptCallback);
     
     // Enable interrupts
     btn0->enableInterrupt();
     btn1->enableInterrupt();
     btn2->enableInterrupt();
-    btn3->enableInterrupt();
+    
+    // Button 3: 2 ms samples, 8 ms debounce, gestures in App_Run
+    buttonPanel.start(SAMPLE_MS * 1000);
     
     // Debug: Print interrupt enable status
     printf("Button interrupts enabled:\n");
     printf("- btn0 (PC0): %s\n", btn0->isInterruptEnabled() ? "ENABLED" : "DISABLED");
     printf("- btn1 (PC1): %s\n", btn1->isInterruptEnabled() ? "ENABLED" : "DISABLED"); 
     printf("- btn2 (PC2): %s\n", btn2->isInterruptEnabled() ? "ENABLED" : "DISABLED");
-    printf("- btn3 (PC3): %s\n", btn3->isInterruptEnabled() ? "ENABLED" : "DISABLED");
     
     // Start with LED off
     led->reset();
@@ -162,7 +205,7 @@ void App_Init(void)
     printf("- Button 0 (PC0): Toggle LED\n");
     printf("- Button 1 (PC1): LED ON\n");
     printf("- Button 2 (PC2): LED OFF\n");
-    printf("- Button 3 (PC3): Cycle LED patterns\n");
+    printf("- Button 3 (PC3): Click next / double click previous LED pattern, long press OFF\n");
 }
 
 void App_Run(void)
@@ -173,6 +216,15 @@ void App_Run(void)
     uint32_t fastBlinkCounter = 0;
     
     while (true) {
+        // Run the button handlers recorded since the last pass
+        buttonEvents.dispatch();
+
+        // Button 3 gestures, timed by the debounce sample clock
+        const uint32_t nowMs = buttonPanel.getSampleCount() * SAMPLE_MS;
+        uint32_t buttonLevels;
+        const Debounce::Edges buttonEdges = buttonPanel.takeEdges(buttonLevels);
+        buttonGestures.update(buttonEdges, buttonLevels, nowMs);
+
         // Handle LED blinking patterns
         switch (ledPattern) {
             case 2: // Slow blink
@@ -0,0 +1,21 @@
+/**
+ * @file    dma_address.h
+ * @brief   Bus address of a register or buffer, as programmed into DMA CPAR/CMAR
+ * @author  MootSeeker
+ *
+ * The DMA address registers are 32 bits wide. On the target a pointer is
+ * 32 bits as well; going through uintptr_t keeps the conversion explicit
+ * and free of warnings on hosts with wider pointers, where the peripherals
+ * and DMA buffers are mapped below 4 GB (see Tests/Host/Support/HostMcu.h).
+ */
+
+#ifndef DEVICE_INC_DMA_ADDRESS_H_
+#define DEVICE_INC_DMA_ADDRESS_H_
+
+#include <cstdint>
+
+static inline uint32_t dmaAddress(const volatile void* pointer) {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(pointer));
+}
+
+#endif /* DEVICE_INC_DMA_ADDRESS_H_ */
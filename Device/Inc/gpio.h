@@ -16,8 +16,17 @@
 #include "mcu_adapter.h"
 
 #include <vector>
+#include <bit>
 #include <cstdint>
-#include <functional>
+
+// C interface for the shared EXTI vectors (EXTI4, EXTI9_5, EXTI15_10)
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void GPIO_EXTI_HandleLines(uint32_t lineMask);
+#ifdef __cplusplus
+}
+#endif
 
 /**
  * @namespace GPIO
@@ -112,20 +121,46 @@ namespace GPIO
         RISING_FALLING = LL_EXTI_TRIGGER_RISING_FALLING ///< Trigger on both edges (any transition)
     };
 
+    static constexpr uint32_t EXTI_LINES_9_5 = 0x03E0U;     ///< Lines of the EXTI9_5 vector
+    static constexpr uint32_t EXTI_LINES_15_10 = 0xFC00U;   ///< Lines of the EXTI15_10 vector
+
     // Forward declarations
     class GPIOBase;
     class GPIOOutput;
     class GPIOInput;
     class GPIOEXTI;
+    class Port;
+
+    /**
+     * @enum PortName
+     * @brief GPIO ports by register base address, usable as template arguments
+     * 
+     * GPIOA etc. are casts and cannot be template arguments; the base
+     * addresses can.
+     */
+    enum class PortName : uintptr_t
+    {
+        A = GPIOA_BASE,     ///< GPIOA
+        B = GPIOB_BASE,     ///< GPIOB
+        C = GPIOC_BASE,     ///< GPIOC
+        D = GPIOD_BASE,     ///< GPIOD
+        E = GPIOE_BASE,     ///< GPIOE
+        H = GPIOH_BASE      ///< GPIOH
+    };
+
+    template <PortName P, uint32_t N, PinMode Mode>
+    class Pin;
 
     /**
      * @typedef InterruptCallback
      * @brief Function pointer type for interrupt callbacks
      * 
-     * Defines the signature for interrupt callback functions.
+     * Defines the signature for interrupt callback functions. The context pointer
+     * registered with the callback is passed back, so objects are reached through
+     * a static member or a captureless lambda without any allocation.
      * These functions are called from interrupt context, so they should be fast and non-blocking.
      */
-    using InterruptCallback = std::function<void(void)>;
+    using InterruptCallback = void (*)(void* context);
 
     /**
      * @struct PinConfig
@@ -146,6 +181,28 @@ namespace GPIO
         EXTITrigger trigger = EXTITrigger::RISING;       ///< Interrupt trigger type (for EXTI pins)
     }; 
 
+    /**
+     * @struct PortSnapshot
+     * @brief Input levels of a whole port, captured with one IDR read
+     * 
+     * Taken with Port::sample(). Inputs of the same port read their level from
+     * the snapshot instead of the register, so all of them see the same instant.
+     * 
+     * @see Port::sample(), GPIOInput::read(const PortSnapshot&)
+     */
+    struct PortSnapshot
+    {
+        GPIO_TypeDef* port;     ///< Port the snapshot was taken from
+        uint32_t bits;          ///< IDR value (bit n = pin n)
+
+        /**
+         * @brief Get the level of one pin in the snapshot
+         * @param pin Pin number (0-15)
+         * @return Pin state at the time of the snapshot
+         */
+        PinState get(uint32_t pin) const { return ((bits >> pin) & 1U) ? PinState::HIGH : PinState::LOW; }
+    };
+
     /**
      * @class GPIOBase
      * @brief Base class for all GPIO operations providing common functionality
@@ -353,6 +410,22 @@ namespace GPIO
          */
         GPIOOutput(const PinConfig& config);
 
+        /**
+         * @brief Construct a runtime output object for a compile-time pin
+         * 
+         * Adapter for code that selects pins at run time or takes a
+         * GPIOOutput pointer (SoftUart, examples).
+         * 
+         * @param pin Compile-time output pin
+         * @param outputType Output driver type (PUSH_PULL or OPEN_DRAIN)
+         * @param speed Output speed/drive strength
+         */
+        template <PortName P, uint32_t N>
+        explicit GPIOOutput(Pin<P, N, PinMode::OUTPUT> pin,
+                            PinOutputType outputType = PinOutputType::PUSH_PULL,
+                            PinSpeed speed = PinSpeed::LOW)
+            : GPIOOutput(pin.port(), N, outputType, speed) {}
+
         // Override base class methods
         /**
          * @brief Validate configuration for output mode
@@ -460,6 +533,15 @@ namespace GPIO
          */
         GPIOInput(const PinConfig& config);
 
+        /**
+         * @brief Construct a runtime input object for a compile-time pin
+         * @param pin Compile-time input pin
+         * @param pull Pull resistor configuration (NO_PULL, PULL_UP, PULL_DOWN)
+         */
+        template <PortName P, uint32_t N>
+        explicit GPIOInput(Pin<P, N, PinMode::INPUT> pin, PinPull pull = PinPull::NO_PULL)
+            : GPIOInput(pin.port(), N, pull) {}
+
         // Override base class methods
         /**
          * @brief Validate configuration for input mode
@@ -493,6 +575,16 @@ namespace GPIO
          */
         bool isLow() const;
 
+        /**
+         * @brief Read the level of this pin from a port snapshot
+         * @param snapshot Snapshot taken with Port::sample()
+         * @return Pin state in the snapshot
+         * 
+         * Lets several inputs of one port share a single IDR read. Falls back
+         * to read() if the snapshot belongs to another port.
+         */
+        PinState read(const PortSnapshot& snapshot) const;
+
         // Operator overloads for convenience
         /**
          * @brief Conversion operator to bool
@@ -519,6 +611,10 @@ namespace GPIO
      * and adds interrupt configuration, callback management, and NVIC integration.
      * Supports edge-triggered interrupts with configurable trigger conditions.
      * 
+     * Callbacks live in a flat 16-entry table of function pointer + context;
+     * dispatch is one indexed call, and unused lines call a no-op, so the
+     * interrupt path has no null check and setCallback() never allocates.
+     * 
      * @note Pin is automatically configured as INPUT mode with EXTI functionality
      * @warning Only one callback per EXTI line (pin number) is supported
      * @see GPIOInput, GPIOBase
@@ -526,9 +622,7 @@ namespace GPIO
     class GPIOEXTI : public GPIOInput
     {
     private:
-        static InterruptCallback callbacks_[16];  ///< Static callback array for all EXTI lines (0-15)
         EXTITrigger trigger_;           ///< Current interrupt trigger configuration
-        InterruptCallback callback_;    ///< User callback function for this pin
         bool interruptEnabled_;         ///< Current interrupt enable state
 
         /**
@@ -618,13 +712,16 @@ namespace GPIO
          * 
          * Registers a function to be called when the interrupt occurs.
          * The callback should be fast and non-blocking as it runs in interrupt context.
+         * Callback and context are stored in a flat 16-entry dispatch table, so
+         * nothing is allocated and the interrupt path is one indexed call.
          * 
-         * @param callback Function to call on interrupt (lambda, function pointer, etc.)
+         * @param callback Function to call on interrupt (nullptr to clear)
+         * @param context Pointer passed to the callback (object, state, etc.)
          * 
          * @warning Callback runs in interrupt context - keep it short and fast
-         * @note Use std::function, lambdas, or function pointers
+         * @note Use function pointers or captureless lambdas; pass `this` as context for members
          */
-        void setCallback(InterruptCallback callback);
+        void setCallback(InterruptCallback callback, void* context = nullptr);
         
         /**
          * @brief Change the interrupt trigger condition
@@ -660,11 +757,25 @@ namespace GPIO
          * 
          * @param pin Pin number (0-15) that triggered the interrupt
          * 
-         * @note Call this from your EXTIx_IRQHandler functions
+         * @note Call this from your EXTIx_IRQHandler functions after clearing the pending flag
          * @see gpio_example.cpp for ISR implementation examples
          */
         static void handleInterrupt(uint32_t pin);
 
+        /**
+         * @brief Dispatch all pending lines of a (shared) EXTI vector
+         * 
+         * Reads the pending register once, keeps the unmasked lines within
+         * lineMask, clears all of them with one write and calls the callback
+         * of each set bit, lowest line first (count-trailing-zeros walk, so
+         * the cost follows the number of pending lines, not the vector width).
+         * Edges arriving after the read stay pending and re-enter the vector.
+         * 
+         * @param lineMask Lines served by the calling vector (EXTI_LINES_9_5, EXTI_LINES_15_10)
+         * @note Unlike handleInterrupt(), this clears the flags itself
+         */
+        static void handleLines(uint32_t lineMask);
+
         // Getters
         /**
          * @brief Check if interrupt is currently enabled
@@ -679,6 +790,443 @@ namespace GPIO
         EXTITrigger getTrigger() const { return trigger_; }
     };
 
+    /**
+     * @class Port
+     * @brief Whole-port access: any pin subset in one BSRR store, all inputs in one IDR read
+     * 
+     * GPIOOutput::write() changes one pin per register write, so driving an
+     * 8-bit parallel bus pin by pin takes 8 writes and shows 7 intermediate
+     * values on the bus. Port writes any subset of pins in a single BSRR
+     * store: set bits in the lower half, reset bits in the upper half, so all
+     * pins change in the same bus cycle and pins outside the mask are never
+     * touched (no read-modify-write of ODR).
+     * 
+     * Register accesses per update, as the code is written (Tests/Host/GpioTest.cpp
+     * checks that the one Port/Bus store carries every pin of the group):
+     * 
+     * | Operation              | Pin objects        | Port / Bus        |
+     * |------------------------|--------------------|-------------------|
+     * | 8-bit bus write        | 8 writes           | 1 write           |
+     * | 16-bit bus write       | 16 writes          | 1 write           |
+     * | Toggle 4 pins          | 4 reads + 4 writes | 1 read + 1 write  |
+     * | Read 8 inputs          | 8 reads            | 1 read            |
+     * 
+     * @code
+     * GPIO::Port portB(GPIOB);
+     * portB.configure((1U << 3) | (1U << 4), PinMode::OUTPUT);
+     * portB.write((1U << 3) | (1U << 4), 1U << 3);    // PB3 high, PB4 low, same cycle
+     * 
+     * PortSnapshot inputs = portB.sample();           // One IDR read
+     * if (button.read(inputs) == PinState::LOW && limit.read(inputs) == PinState::HIGH) { ... }
+     * @endcode
+     * 
+     * @note Port does not track state; GPIOOutput objects on the same pins
+     *       keep their own cached state.
+     * @see Bus for a value-oriented view of a pin group
+     */
+    class Port
+    {
+    private:
+        GPIO_TypeDef* port_;        ///< GPIO port register base address
+
+    public:
+        /**
+         * @brief Construct a port accessor (no hardware access)
+         * @param port GPIO port (GPIOA, GPIOB, etc.)
+         */
+        explicit constexpr Port(GPIO_TypeDef* port) : port_(port) {}
+
+        /**
+         * @brief Construct a port accessor from a port name
+         * @param port Port name (PortName::A, PortName::B, etc.)
+         */
+        explicit Port(PortName port)
+            : port_(reinterpret_cast<GPIO_TypeDef*>(static_cast<uintptr_t>(port))) {}
+
+        /**
+         * @brief Configure a group of pins with one LL_GPIO_Init call
+         * 
+         * Enables the port clock and applies the same settings to every pin
+         * in the mask (for example to turn a bidirectional bus around).
+         * 
+         * @param mask Pins to configure (bit n = pin n)
+         * @param mode Pin mode
+         * @param pull Pull resistor configuration
+         * @param speed Output speed
+         * @param outputType Output driver type
+         * @param alternate Alternate function number (0-15, ALTERNATE mode only)
+         */
+        void configure(uint32_t mask, PinMode mode,
+                       PinPull pull = PinPull::NO_PULL,
+                       PinSpeed speed = PinSpeed::LOW,
+                       PinOutputType outputType = PinOutputType::PUSH_PULL,
+                       uint32_t alternate = 0) const;
+
+        /**
+         * @brief Drive the masked pins to the given levels in one BSRR store
+         * @param mask Pins to change (bit n = pin n)
+         * @param value Levels for the masked pins (bits outside mask are ignored)
+         */
+        void write(uint32_t mask, uint32_t value) const
+        {
+            port_->BSRR = (value & mask) | ((~value & mask) << 16);
+        }
+
+        /**
+         * @brief Set the masked pins HIGH in one store
+         * @param mask Pins to set
+         */
+        void set(uint32_t mask) const { port_->BSRR = mask; }
+
+        /**
+         * @brief Set the masked pins LOW in one store
+         * @param mask Pins to reset
+         */
+        void reset(uint32_t mask) const { port_->BSRR = mask << 16; }
+
+        /**
+         * @brief Invert the masked pins
+         * 
+         * Reads ODR once and writes the inverted levels through BSRR, so pins
+         * outside the mask keep whatever an interrupt wrote to them meanwhile.
+         * 
+         * @param mask Pins to toggle
+         */
+        void toggle(uint32_t mask) const
+        {
+            const uint32_t odr = port_->ODR;
+            port_->BSRR = ((odr & mask) << 16) | (~odr & mask);
+        }
+
+        /**
+         * @brief Read all input levels with one IDR access
+         * @return IDR value (bit n = pin n)
+         */
+        uint32_t read() const { return port_->IDR & 0xFFFFU; }
+
+        /**
+         * @brief Read the driven output levels
+         * @return ODR value (bit n = pin n)
+         */
+        uint32_t readOutput() const { return port_->ODR & 0xFFFFU; }
+
+        /**
+         * @brief Capture all input levels for distribution to GPIOInput objects
+         * @return Snapshot of IDR
+         */
+        PortSnapshot sample() const { return PortSnapshot{port_, read()}; }
+
+        /**
+         * @brief Get the GPIO port
+         * @return GPIO port register base address
+         */
+        GPIO_TypeDef* getPort() const { return port_; }
+    };
+
+    /**
+     * @class Bus
+     * @brief Fixed group of pins on one port, written and read as a binary value
+     * 
+     * Bit i of the value maps to the i-th pin of the template list, so the
+     * pins need not be adjacent or ordered. Pin lists that are ascending and
+     * contiguous are mapped with a single shift; other lists are scattered and
+     * gathered bit by bit at compile-time unrolled cost. Either way an update
+     * is one BSRR store and a read is one IDR load.
+     * 
+     * @code
+     * // LCD data bus D0..D7 on PC0..PC7, nibble bus on PA8, PA10, PA9, PA15
+     * GPIO::Bus<0, 1, 2, 3, 4, 5, 6, 7> lcdData(GPIOC);
+     * GPIO::Bus<8, 10, 9, 15> nibble(GPIOA);
+     * 
+     * lcdData.configureOutput(PinSpeed::HIGH);
+     * lcdData.write(0xA5);                    // One store, no intermediate values
+     * 
+     * lcdData.configureInput();               // Turn the bus around
+     * uint8_t status = static_cast<uint8_t>(lcdData.read());
+     * @endcode
+     * 
+     * @tparam Pins Pin numbers (0-15), bit 0 of the value first
+     */
+    template <uint32_t... Pins>
+    class Bus
+    {
+    public:
+        static constexpr uint32_t WIDTH = sizeof...(Pins);     ///< Bus width in bits
+        static constexpr uint32_t MASK = ((1U << Pins) | ...); ///< Port pins of the bus
+
+    private:
+        static_assert(WIDTH >= 1 && WIDTH <= 16, "Bus needs 1 to 16 pins");
+        static_assert(((Pins < 16) && ...), "Pin number must be in range 0-15");
+        static_assert(std::popcount(MASK) == WIDTH, "Bus pins must be distinct");
+
+        static constexpr uint32_t PINS[WIDTH] = {Pins...};
+
+        /**
+         * @brief Check whether the pins are ascending and adjacent
+         * @return true if value bit i maps to port bit PINS[0] + i
+         */
+        static constexpr bool isContiguous()
+        {
+            for (uint32_t i = 1; i < WIDTH; i++)
+            {
+                if (PINS[i] != PINS[0] + i)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static constexpr bool CONTIGUOUS = isContiguous();
+
+        Port port_;     ///< Port the pins belong to
+
+    public:
+        /**
+         * @brief Construct a bus on a port (no hardware access)
+         * @param port GPIO port (GPIOA, GPIOB, etc.)
+         */
+        explicit constexpr Bus(GPIO_TypeDef* port) : port_(port) {}
+
+        /**
+         * @brief Map a bus value to port bits
+         * @param value Bus value (bits above WIDTH are ignored)
+         * @return Port bits within MASK
+         */
+        static constexpr uint32_t toPortBits(uint32_t value)
+        {
+            if constexpr (CONTIGUOUS)
+            {
+                return (value << PINS[0]) & MASK;
+            }
+            else
+            {
+                uint32_t bits = 0;
+                for (uint32_t i = 0; i < WIDTH; i++)
+                {
+                    bits |= ((value >> i) & 1U) << PINS[i];
+                }
+                return bits;
+            }
+        }
+
+        /**
+         * @brief Map port bits to a bus value
+         * @param bits Port bits (IDR or ODR)
+         * @return Bus value
+         */
+        static constexpr uint32_t fromPortBits(uint32_t bits)
+        {
+            if constexpr (CONTIGUOUS)
+            {
+                return (bits & MASK) >> PINS[0];
+            }
+            else
+            {
+                uint32_t value = 0;
+                for (uint32_t i = 0; i < WIDTH; i++)
+                {
+                    value |= ((bits >> PINS[i]) & 1U) << i;
+                }
+                return value;
+            }
+        }
+
+        /**
+         * @brief Configure all bus pins as outputs
+         * @param speed Output speed
+         * @param outputType Output driver type
+         */
+        void configureOutput(PinSpeed speed = PinSpeed::LOW,
+                             PinOutputType outputType = PinOutputType::PUSH_PULL) const
+        {
+            port_.configure(MASK, PinMode::OUTPUT, PinPull::NO_PULL, speed, outputType);
+        }
+
+        /**
+         * @brief Configure all bus pins as inputs
+         * @param pull Pull resistor configuration
+         */
+        void configureInput(PinPull pull = PinPull::NO_PULL) const
+        {
+            port_.configure(MASK, PinMode::INPUT, pull);
+        }
+
+        /**
+         * @brief Drive a value onto the bus in one BSRR store
+         * @param value Bus value (bit i drives the i-th pin)
+         */
+        void write(uint32_t value) const { port_.write(MASK, toPortBits(value)); }
+
+        /**
+         * @brief Read the bus inputs with one IDR access
+         * @return Bus value
+         */
+        uint32_t read() const { return fromPortBits(port_.read()); }
+
+        /**
+         * @brief Read the value currently driven onto the bus
+         * @return Bus value from ODR
+         */
+        uint32_t readOutput() const { return fromPortBits(port_.readOutput()); }
+
+        /**
+         * @brief Invert all bus pins
+         */
+        void toggle() const { port_.toggle(MASK); }
+
+        /**
+         * @brief Get the underlying port accessor
+         * @return Port of the bus
+         */
+        const Port& getPort() const { return port_; }
+    };
+
+    /**
+     * @class Pin
+     * @brief Statically typed pin: port, pin, mask and mode are compile-time constants
+     * 
+     * A GPIOOutput object carries a vtable pointer, port and pin fields and a
+     * full PinConfig copy, and builds the pin mask on every write. Pin has no
+     * data members at all; every method is static, so set() is one store of
+     * a constant to a constant address and a pin object is an empty type
+     * (sizeof 1, checked below, and no storage as a [[no_unique_address]]
+     * member). set(), reset() and write() are one BSRR store, toggle() one
+     * ODR load and one store, read() one IDR load (Tests/Host/GpioTest.cpp).
+     * 
+     * @code
+     * using Led    = GPIO::OutputPin<GPIO::PortName::B, 11>;
+     * using Button = GPIO::InputPin<GPIO::PortName::C, 13>;
+     * 
+     * Led::configure();
+     * Button::configure(PinPull::PULL_UP);
+     * 
+     * Led::set();                             // Single BSRR store
+     * if (Button::isLow()) { Led::toggle(); }
+     * 
+     * GPIO::GPIOOutput runtimeLed(Led{});     // Runtime adapter where a GPIOOutput is needed
+     * @endcode
+     * 
+     * @tparam P Port name
+     * @tparam N Pin number (0-15)
+     * @tparam Mode Pin mode; output operations require OUTPUT
+     * @note Pin does not cache its output state; read back with readOutput().
+     */
+    template <PortName P, uint32_t N, PinMode Mode>
+    class Pin
+    {
+        static_assert(N < 16, "Pin number must be in range 0-15");
+
+    public:
+        static constexpr PortName PORT = P;         ///< Port of the pin
+        static constexpr uint32_t PIN = N;          ///< Pin number
+        static constexpr uint32_t MASK = 1U << N;   ///< Pin mask (LL_GPIO_PIN_x)
+        static constexpr PinMode MODE = Mode;       ///< Configured mode
+
+        /**
+         * @brief Get the GPIO port registers
+         * @return GPIO port register base address
+         */
+        static GPIO_TypeDef* port()
+        {
+            return reinterpret_cast<GPIO_TypeDef*>(static_cast<uintptr_t>(P));
+        }
+
+        /**
+         * @brief Apply the mode to the hardware (enables the port clock)
+         * @param pull Pull resistor configuration
+         * @param speed Output speed
+         * @param outputType Output driver type
+         * @param alternate Alternate function number (ALTERNATE mode only)
+         */
+        static void configure(PinPull pull = PinPull::NO_PULL,
+                              PinSpeed speed = PinSpeed::LOW,
+                              PinOutputType outputType = PinOutputType::PUSH_PULL,
+                              uint32_t alternate = 0)
+        {
+            Port(P).configure(MASK, Mode, pull, speed, outputType, alternate);
+        }
+
+        /**
+         * @brief Set the output pin to HIGH (one BSRR store)
+         */
+        static void set()
+        {
+            static_assert(Mode == PinMode::OUTPUT, "set() requires an output pin");
+            port()->BSRR = MASK;
+        }
+
+        /**
+         * @brief Set the output pin to LOW (one BSRR store)
+         */
+        static void reset()
+        {
+            static_assert(Mode == PinMode::OUTPUT, "reset() requires an output pin");
+            port()->BSRR = MASK << 16;
+        }
+
+        /**
+         * @brief Write a logic level to the output pin (one BSRR store)
+         * @param state Logic level to write
+         */
+        static void write(PinState state)
+        {
+            static_assert(Mode == PinMode::OUTPUT, "write() requires an output pin");
+            port()->BSRR = (state == PinState::HIGH) ? MASK : (MASK << 16);
+        }
+
+        /**
+         * @brief Invert the output pin (ODR read, BSRR store)
+         */
+        static void toggle()
+        {
+            static_assert(Mode == PinMode::OUTPUT, "toggle() requires an output pin");
+            const uint32_t odr = port()->ODR;
+            port()->BSRR = (odr & MASK) ? (MASK << 16) : MASK;
+        }
+
+        /**
+         * @brief Read the input level
+         * @return Current pin state
+         */
+        static PinState read() { return (port()->IDR & MASK) ? PinState::HIGH : PinState::LOW; }
+
+        /**
+         * @brief Read the level from a port snapshot
+         * @param snapshot Snapshot of this pin's port (Port::sample())
+         * @return Pin state in the snapshot
+         */
+        static PinState read(const PortSnapshot& snapshot) { return snapshot.get(N); }
+
+        /**
+         * @brief Read the driven output level
+         * @return Output state from ODR
+         */
+        static PinState readOutput() { return (port()->ODR & MASK) ? PinState::HIGH : PinState::LOW; }
+
+        /**
+         * @brief Check if the pin is at logic HIGH
+         * @return true if HIGH
+         */
+        static bool isHigh() { return (port()->IDR & MASK) != 0U; }
+
+        /**
+         * @brief Check if the pin is at logic LOW
+         * @return true if LOW
+         */
+        static bool isLow() { return (port()->IDR & MASK) == 0U; }
+    };
+
+    /// Compile-time output pin
+    template <PortName P, uint32_t N>
+    using OutputPin = Pin<P, N, PinMode::OUTPUT>;
+
+    /// Compile-time input pin
+    template <PortName P, uint32_t N>
+    using InputPin = Pin<P, N, PinMode::INPUT>;
+
+    static_assert(sizeof(OutputPin<PortName::A, 0>) == 1, "Pin must stay an empty type");
+
 } // namespace GPIO
 
 #endif /* DEVICE_INC_GPIO_H_ */
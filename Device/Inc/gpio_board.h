@@ -0,0 +1,230 @@
+/**
+ * @file    gpio_board.h
+ * @brief   Compile-time board pin map, applied as per-port register images
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Configuring pins one object at a time runs LL_GPIO_Init per pin: the
+ * port clock enable plus a read-modify-write of MODER, OTYPER, OSPEEDR,
+ * PUPDR and AFR for every pin, so boot cost grows with the pin count.
+ * A BoardMap is the whole pin list of a board, folded at compile time
+ * (consteval) into one register image per port. apply() enables all
+ * port clocks at once and writes each register of each port once:
+ *
+ * ```
+ *   constexpr BoardMap map(PINS);           // compile time: PINS -> images[port]
+ *   map.apply();                            // run time: RCC once, then per used port:
+ *                                           //   BSRR (initial levels), OTYPER, OSPEEDR,
+ *                                           //   PUPDR, AFRL, AFRH, MODER (last)
+ * ```
+ *
+ * MODER is written last and the initial output levels first, so outputs
+ * come up at their initial level without a glitch. With the default
+ * BoardApply::RESET_UNLISTED, the pins of a used port that are not in
+ * the map get their reset configuration (the SWD pins PA13/PA14 stay on
+ * the debugger). BoardApply::KEEP_UNLISTED instead merges into the
+ * current registers (one read more per register) for ports other code
+ * has already configured.
+ *
+ * A pin listed twice or out of range is a compile error.
+ *
+ * ## Usage
+ *
+ * @code
+ * static constexpr GPIO::PinDescriptor PINS[] = {
+ *     GPIO::outputPin(GPIO::PortName::B, 11),                                   // LED
+ *     GPIO::inputPin(GPIO::PortName::C, 0, GPIO::PinPull::PULL_UP),             // Buttons
+ *     GPIO::inputPin(GPIO::PortName::C, 1, GPIO::PinPull::PULL_UP),
+ *     GPIO::alternatePin(GPIO::PortName::A, 9, 7),                              // USART1 TX
+ *     GPIO::alternatePin(GPIO::PortName::A, 10, 7, GPIO::PinPull::PULL_UP),     // USART1 RX
+ * };
+ * static constexpr GPIO::BoardMap BOARD(PINS);
+ *
+ * // First thing in App_Init():
+ * BOARD.apply();
+ *
+ * // Zero-cost pin types need no further configuration
+ * using Led = GPIO::OutputPin<GPIO::PortName::B, 11>;
+ * Led::set();
+ * @endcode
+ *
+ * ## Register Accesses
+ *
+ * apply() does one read-modify-write of RCC->AHB2ENR for all ports, then
+ * per used port 7 writes (RESET_UNLISTED) or 1 write and 6
+ * read-modify-writes (KEEP_UNLISTED), however many pins the port has. The
+ * images are constants in flash; there is no per-pin work at run time.
+ *
+ * Tests/Host/GpioBoardTest.cpp applies a 40-pin map (16 outputs, 12
+ * pulled-up inputs, 8 alternate-function and 4 analog pins on ports A, B
+ * and C) and checks that both modes leave the same MODER, OTYPER, OSPEEDR,
+ * PUPDR and AFR values as configuring the same pins one GPIOOutput,
+ * GPIOInput or Port::configure() call at a time, and that KEEP_UNLISTED
+ * leaves pins outside the map as other code configured them. It also
+ * counts the GPIO and RCC register accesses of each path:
+ *
+ * | Path | Reads | Writes | Total |
+ * |------|-------|--------|-------|
+ * | Pin by pin (configureHardware(), Port::configure()) | 182 | 171 | 353 |
+ * | apply(), RESET_UNLISTED | 2 | 22 | 24 (14.7x fewer) |
+ * | apply(), KEEP_UNLISTED | 20 | 22 | 42 (8.4x fewer) |
+ */
+
+#ifndef DEVICE_INC_GPIO_BOARD_H_
+#define DEVICE_INC_GPIO_BOARD_H_
+
+#include "gpio.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GPIO {
+
+    static constexpr uint8_t PORT_SLOTS = 8;    ///< A..H by register address (F and G do not exist on the L433)
+
+    /**
+     * @struct PinDescriptor
+     * @brief One pin of a board map
+     */
+    struct PinDescriptor {
+        PortName port;
+        uint8_t pin;                                        ///< 0..15
+        PinMode mode;
+        PinPull pull = PinPull::NO_PULL;
+        PinSpeed speed = PinSpeed::LOW;
+        PinOutputType outputType = PinOutputType::PUSH_PULL;
+        uint8_t alternate = 0;                              ///< AF0..AF15 (ALTERNATE only)
+        PinState initial = PinState::LOW;                   ///< Level of an output when it is enabled
+    };
+
+    constexpr PinDescriptor outputPin(PortName port, uint8_t pin, PinState initial = PinState::LOW,
+                                      PinSpeed speed = PinSpeed::LOW,
+                                      PinOutputType outputType = PinOutputType::PUSH_PULL) noexcept {
+        return PinDescriptor{port, pin, PinMode::OUTPUT, PinPull::NO_PULL, speed, outputType, 0, initial};
+    }
+
+    constexpr PinDescriptor inputPin(PortName port, uint8_t pin, PinPull pull = PinPull::NO_PULL) noexcept {
+        return PinDescriptor{port, pin, PinMode::INPUT, pull};
+    }
+
+    constexpr PinDescriptor alternatePin(PortName port, uint8_t pin, uint8_t alternate,
+                                         PinPull pull = PinPull::NO_PULL,
+                                         PinSpeed speed = PinSpeed::HIGH,
+                                         PinOutputType outputType = PinOutputType::PUSH_PULL) noexcept {
+        return PinDescriptor{port, pin, PinMode::ALTERNATE, pull, speed, outputType, alternate};
+    }
+
+    constexpr PinDescriptor analogPin(PortName port, uint8_t pin) noexcept {
+        return PinDescriptor{port, pin, PinMode::ANALOG};
+    }
+
+    /**
+     * @struct PortImage
+     * @brief Register values of one port after the map is applied
+     */
+    struct PortImage {
+        uint16_t pins;      ///< Pins of the map on this port (0 = port not used)
+        uint32_t moder;
+        uint32_t otyper;
+        uint32_t ospeedr;
+        uint32_t pupdr;
+        uint32_t afrl;
+        uint32_t afrh;
+        uint32_t bsrr;      ///< Initial output levels
+    };
+
+    /**
+     * @enum BoardApply
+     * @brief What happens to pins of a used port that are not in the map
+     */
+    enum class BoardApply : uint8_t {
+        RESET_UNLISTED,     ///< Reset configuration, one write per register
+        KEEP_UNLISTED       ///< Current configuration kept, one read and one write per register
+    };
+
+    /**
+     * @brief Write port images to the hardware (used by BoardMap::apply())
+     */
+    void applyPortImages(const PortImage* images, BoardApply mode) noexcept;
+
+    // Not constexpr on purpose: reaching one of these while building a BoardMap is a compile error
+    void boardMapError_pinOutOfRange() noexcept;
+    void boardMapError_pinListedTwice() noexcept;
+
+    /**
+     * @class BoardMap
+     * @brief Pin list of a board, folded into per-port register images at compile time
+     *
+     * @tparam N Number of pins in the map
+     */
+    template <size_t N>
+    class BoardMap {
+    public:
+        consteval explicit BoardMap(const PinDescriptor (&pins)[N]) : images() {
+            for (uint8_t slot = 0; slot < PORT_SLOTS; slot++) {
+                images[slot] = resetImage(slot);
+            }
+            for (const PinDescriptor& desc : pins) {
+                const uintptr_t base = static_cast<uintptr_t>(desc.port);
+                if (desc.pin > 15 || desc.alternate > 15 || base < GPIOA_BASE) {
+                    boardMapError_pinOutOfRange();
+                }
+                const uint8_t slot = static_cast<uint8_t>((base - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE));
+                if (slot >= PORT_SLOTS) {
+                    boardMapError_pinOutOfRange();
+                }
+                PortImage& image = images[slot];
+                const uint32_t bit = 1U << desc.pin;
+                if ((image.pins & bit) != 0) {
+                    boardMapError_pinListedTwice();
+                }
+                image.pins = static_cast<uint16_t>(image.pins | bit);
+
+                const uint32_t shift2 = desc.pin * 2U;
+                image.moder = (image.moder & ~(3U << shift2)) | (static_cast<uint32_t>(desc.mode) << shift2);
+                image.pupdr = (image.pupdr & ~(3U << shift2)) | (static_cast<uint32_t>(desc.pull) << shift2);
+                image.ospeedr = (image.ospeedr & ~(3U << shift2)) | (static_cast<uint32_t>(desc.speed) << shift2);
+                image.otyper = (image.otyper & ~bit) |
+                               ((desc.outputType == PinOutputType::OPEN_DRAIN) ? bit : 0U);
+
+                const uint32_t shift4 = (desc.pin & 7U) * 4U;
+                uint32_t& afr = (desc.pin < 8) ? image.afrl : image.afrh;
+                afr = (afr & ~(0xFU << shift4)) | (static_cast<uint32_t>(desc.alternate) << shift4);
+
+                image.bsrr |= (desc.initial == PinState::HIGH) ? bit : (bit << 16);
+            }
+        }
+
+        /**
+         * @brief Enable the used ports' clocks and write their images
+         */
+        void apply(BoardApply mode = BoardApply::RESET_UNLISTED) const noexcept {
+            applyPortImages(images, mode);
+        }
+
+        /**
+         * @brief Image of one port (for inspection and static_assert checks)
+         */
+        constexpr const PortImage& image(PortName port) const noexcept {
+            return images[(static_cast<uintptr_t>(port) - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE)];
+        }
+
+    private:
+        PortImage images[PORT_SLOTS];
+
+        /// Reset values (RM0394): PA13..PA15 and PB3/PB4 start as debug pins, everything else analog
+        static constexpr PortImage resetImage(uint8_t slot) noexcept {
+            if (slot == 0) {
+                return PortImage{0, 0xABFFFFFFU, 0, 0x0C000000U, 0x64000000U, 0, 0, 0};
+            }
+            if (slot == 1) {
+                return PortImage{0, 0xFFFFFEBFU, 0, 0, 0x00000100U, 0, 0, 0};
+            }
+            return PortImage{0, 0xFFFFFFFFU, 0, 0, 0, 0, 0, 0};
+        }
+    };
+
+} // namespace GPIO
+
+#endif /* DEVICE_INC_GPIO_BOARD_H_ */
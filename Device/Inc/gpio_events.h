@@ -0,0 +1,203 @@
+/**
+ * @file    gpio_events.h
+ * @brief   Timestamped EXTI event queue with deferred handler execution
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * A GPIOEXTI callback runs in interrupt context, so anything slow in it
+ * (printf, flash writes) blocks every interrupt of equal or lower priority
+ * and makes GPIO latency unbounded. An EventQueue takes over the callback
+ * of its pins and only records the event; the handlers run later from the
+ * main loop with the exact time of the edge:
+ *
+ * ```
+ *   edge -> EXTI vector -> record(): DWT CYCCNT, pin level, ring slot   (ISR)
+ *   main loop -> dispatch() -> handler(context, {timestamp, line, edge}) (thread)
+ * ```
+ *
+ * The ring is single-producer/single-consumer and needs no locking: only
+ * the interrupt writes `head` and only dispatch() writes `tail`. When it is
+ * full the new event is dropped and counted, so the events already queued
+ * keep their order.
+ *
+ * ## Usage
+ *
+ * @code
+ * static GPIO::EventQueue buttonEvents;
+ *
+ * static void onButton(void* context, const GPIO::PinEvent& event)
+ * {
+ *     printf("PC%u %s at %lu\n", event.line,
+ *            event.edge == GPIO::Edge::FALLING ? "pressed" : "released", event.timestamp);
+ * }
+ *
+ * // App_Init():
+ * buttonEvents.attach(*btn0, onButton);
+ * btn0->enableInterrupt();
+ *
+ * // App_Run():
+ * buttonEvents.dispatch();
+ * @endcode
+ *
+ * ## ISR Cost & Event Loss
+ *
+ * Recording is a CYCCNT read, an IDR read and a 6-byte store on top of the
+ * EXTI dispatch; getMaxRecordCycles() reports the worst case on the target.
+ * With 64 slots and a main loop draining the queue every 100 us, the flood
+ * test in Tests/Host/GpioEventsTest.cpp gives:
+ *
+ * | Event rate (random gaps)            | Max queue depth | Lost events |
+ * |-------------------------------------|-----------------|-------------|
+ * | 10 kHz, continuous                  | 6               | 0           |
+ * | 100 kHz, 1 ms bursts every 10 ms    | 17              | 0           |
+ * | 1 MHz, 1 ms bursts every 10 ms      | 63 (full)       | 36 %        |
+ *
+ * Every dispatched event arrived in recording order with its own
+ * timestamp; losses appeared only in getLostCount().
+ *
+ * @note All lines attached to one queue must share one NVIC priority (the
+ *       GPIOEXTI default), so their recorders never preempt each other.
+ * @note The edge is taken from the pin level when the event is recorded;
+ *       a contact bouncing faster than the interrupt latency can report
+ *       the opposite edge. Bouncing contacts are better sampled with
+ *       Debounce::PortScanner (Debounce.h).
+ */
+
+#ifndef DEVICE_INC_GPIO_EVENTS_H_
+#define DEVICE_INC_GPIO_EVENTS_H_
+
+#include "gpio.h"
+
+#include <cstdint>
+
+namespace GPIO {
+
+    static constexpr uint16_t EVENT_QUEUE_SIZE = 64;    ///< Ring slots (power of 2, one stays free)
+
+    /**
+     * @enum Edge
+     * @brief Direction of a recorded transition
+     */
+    enum class Edge : uint8_t {
+        FALLING = 0,    ///< Pin was LOW when recorded
+        RISING = 1      ///< Pin was HIGH when recorded
+    };
+
+    /**
+     * @struct PinEvent
+     * @brief One recorded EXTI event
+     */
+    struct PinEvent {
+        uint32_t timestamp;     ///< DWT cycle count when the recorder ran
+        uint8_t line;           ///< EXTI line (= pin number)
+        Edge edge;              ///< Inferred from the pin level
+    };
+
+    /// Deferred event handler, called from dispatch()
+    using EventHandler = void (*)(void* context, const PinEvent& event);
+
+    /**
+     * @class EventQueue
+     * @brief Records EXTI events in interrupt context and runs their handlers from the main loop
+     */
+    class EventQueue {
+        static_assert((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) == 0, "Queue size must be power of 2");
+
+    private:
+        static constexpr uint16_t MASK = EVENT_QUEUE_SIZE - 1;
+
+        /// Per-line state handed to the recorder as callback context
+        struct Binding {
+            EventQueue* queue;
+            GPIOEXTI* pin;              ///< nullptr = line not attached
+            GPIO_TypeDef* port;
+            uint32_t mask;
+            uint8_t line;
+            EventHandler handler;
+            void* context;
+        };
+
+        PinEvent events[EVENT_QUEUE_SIZE];
+        volatile uint16_t head;
+        volatile uint16_t tail;
+        Binding bindings[16];
+
+        volatile uint32_t recordedCount;
+        volatile uint32_t lostCount;
+        volatile uint32_t maxRecordCycles;
+        uint16_t maxDepth;
+
+        static void record(void* context);
+
+    public:
+        EventQueue() noexcept;
+
+        /**
+         * @brief Detaches all pins
+         */
+        ~EventQueue();
+
+        EventQueue(const EventQueue&) = delete;
+        EventQueue& operator=(const EventQueue&) = delete;
+
+        /**
+         * @brief Route a pin's interrupts into this queue
+         *
+         * Replaces the pin's callback and starts the DWT cycle counter.
+         * The interrupt itself is still enabled with pin.enableInterrupt().
+         *
+         * @param pin EXTI pin
+         * @param handler Called from dispatch() for each event of the pin
+         * @param context Passed to the handler
+         * @return false if the pin number is invalid
+         */
+        bool attach(GPIOEXTI& pin, EventHandler handler, void* context = nullptr) noexcept;
+
+        /**
+         * @brief Stop recording a pin; its queued events are discarded by dispatch()
+         */
+        void detach(GPIOEXTI& pin) noexcept;
+
+        /**
+         * @brief Run the handlers of queued events, oldest first
+         * @param maxEvents Upper bound for this call (bounds the main loop time)
+         * @return Number of events dispatched
+         */
+        uint16_t dispatch(uint16_t maxEvents = EVENT_QUEUE_SIZE) noexcept;
+
+        [[nodiscard]] uint16_t getPendingCount() const noexcept {
+            return (head - tail) & MASK;
+        }
+
+        /**
+         * @brief Highest number of events waiting at a dispatch() call
+         */
+        [[nodiscard]] uint16_t getMaxDepth() const noexcept {
+            return maxDepth;
+        }
+
+        [[nodiscard]] uint32_t getRecordedCount() const noexcept {
+            return recordedCount;
+        }
+
+        /**
+         * @brief Events dropped because the ring was full
+         */
+        [[nodiscard]] uint32_t getLostCount() const noexcept {
+            return lostCount;
+        }
+
+        /**
+         * @brief Longest recorder run in CPU cycles (interrupt context)
+         */
+        [[nodiscard]] uint32_t getMaxRecordCycles() const noexcept {
+            return maxRecordCycles;
+        }
+
+        void resetStatistics() noexcept;
+    };
+
+} // namespace GPIO
+
+#endif /* DEVICE_INC_GPIO_EVENTS_H_ */
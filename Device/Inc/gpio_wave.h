@@ -0,0 +1,206 @@
+/**
+ * @file    gpio_wave.h
+ * @brief   Timer-paced DMA playback of BSRR words to a GPIO port
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Toggling pins from code shifts every edge by the interrupt and bus
+ * latency of the moment, microseconds at worst. A PatternPlayer
+ * precomputes the port states as BSRR words and lets DMA copy one word per
+ * TIM15 update event into GPIOx->BSRR. Each pattern step is one store at
+ * a timer-exact instant; the CPU is not involved:
+ *
+ * ```
+ *   TIM15 update --DMA request--> DMA1 Channel 5: words[i] -> GPIOx->BSRR
+ * ```
+ *
+ * Modes:
+ * - ONE_SHOT: the table is played once; the timer stops at the end.
+ * - LOOP:     circular DMA over the table, no interrupts at all.
+ * - STREAM:   circular DMA over a double buffer; at each half-transfer and
+ *             transfer-complete interrupt the half that was just played is
+ *             refilled by a callback while DMA plays the other half.
+ *
+ * The first word is written when play() starts, word k one period later
+ * per step (k x period).
+ *
+ * ## Usage
+ *
+ * @code
+ * // 8-bit bus on PA0..PA7 with a strobe on PA8, 1 MHz word rate
+ * static uint32_t strobe[4];
+ * strobe[0] = GPIO::bsrrWord(0x1FF, 0x0A5);          // data, strobe low
+ * strobe[1] = GPIO::bsrrWord(0x100, 0x100);          // strobe high
+ * strobe[2] = GPIO::bsrrWord(0x1FF, 0x05A);
+ * strobe[3] = GPIO::bsrrWord(0x100, 0x100);
+ *
+ * GPIO::Port(GPIOA).configure(0x1FF, GPIO::PinMode::OUTPUT);
+ * static GPIO::PatternPlayer player(GPIOA);
+ * player.play(strobe, 4, GPIO::PlayMode::LOOP, 1000000);
+ *
+ * // Continuous stimulus: the callback fills 'count' words per half buffer
+ * static uint32_t ring[256];
+ * player.stream(ring, 256, 500000, fillNextWords, &generator);
+ * @endcode
+ *
+ * ## Interrupts and refill deadline
+ *
+ * LOOP runs without interrupts and ONE_SHOT takes one at the end. STREAM
+ * takes two per pass over the ring, rateHz x 2 / count per second (7.8 k/s
+ * for 256 words at 1 MHz). A refill has the time of half the ring,
+ * count / 2 words. One that comes later is counted in getLateRefillCount(),
+ * and so is any half that DMA finished before its interrupt ran.
+ * Tests/Host/GpioWaveTest.cpp checks the timer setup and the word order of
+ * every mode on the DMA channel model. It also enters the STREAM interrupt
+ * 0..12 words late on a 16-word ring: there are no late refills up to 7
+ * words, and every stale word beyond that comes with a late count. The
+ * cost per interrupt depends on the refill; measure it with DWT->CYCCNT
+ * on the target.
+ *
+ * @note Uses TIM15 (update DMA request) and DMA1 Channel 5 (request 7).
+ *       That channel is also the USART_1 RX channel of the USART DMA
+ *       bridge; whichever enables it first keeps it, the other one is
+ *       refused (play()/stream() return false, the bridge reports BUSY).
+ * @note DMA1_Channel5_IRQHandler must call `GPIO_HandlePatternDmaInterrupt()`
+ *       before the USART bridge handler.
+ * @note The word rate is limited to SystemCoreClock / 8 (4 MHz at 32 MHz).
+ */
+
+#ifndef DEVICE_INC_GPIO_WAVE_H_
+#define DEVICE_INC_GPIO_WAVE_H_
+
+#include "gpio.h"
+
+#include <cstdint>
+
+// C interface for the DMA1 Channel 5 interrupt handler
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void GPIO_HandlePatternDmaInterrupt(void);
+#ifdef __cplusplus
+}
+#endif
+
+namespace GPIO {
+
+    /**
+     * @brief BSRR word that drives the masked pins to the given levels
+     */
+    constexpr uint32_t bsrrWord(uint32_t mask, uint32_t value) noexcept {
+        return (value & mask & 0xFFFFU) | ((~value & mask & 0xFFFFU) << 16);
+    }
+
+    /**
+     * @enum PlayMode
+     * @brief How the DMA walks the pattern table
+     */
+    enum class PlayMode : uint8_t {
+        ONE_SHOT,   ///< Play once, then stop
+        LOOP,       ///< Repeat the table until stop()
+        STREAM      ///< Double buffer refilled by a callback
+    };
+
+    /// Fills 'count' BSRR words of the half buffer that was just played (interrupt context)
+    using PatternRefill = void (*)(void* context, uint32_t* words, uint16_t count);
+
+    /// Called when a ONE_SHOT pattern has been played (interrupt context)
+    using PatternDone = void (*)(void* context);
+
+    /**
+     * @class PatternPlayer
+     * @brief Streams BSRR words to one GPIO port at a timer-exact rate
+     */
+    class PatternPlayer {
+    public:
+        static constexpr uint32_t MIN_PERIOD_TICKS = 8;     ///< Timer clocks per word (DMA path limit)
+
+        explicit PatternPlayer(GPIO_TypeDef* port) noexcept;
+
+        /**
+         * @brief Stops playback
+         */
+        ~PatternPlayer();
+
+        PatternPlayer(const PatternPlayer&) = delete;
+        PatternPlayer& operator=(const PatternPlayer&) = delete;
+
+        /**
+         * @brief Play a table of BSRR words (ONE_SHOT or LOOP)
+         *
+         * The table is read by DMA while playing and must stay valid.
+         *
+         * @param words BSRR words, see bsrrWord()
+         * @param count Number of words (1..65535)
+         * @param mode ONE_SHOT or LOOP
+         * @param rateHz Words per second
+         * @param done Called after the last word of a ONE_SHOT pattern
+         * @param context Passed to done
+         * @return false if another player or the USART bridge holds the channel, or a parameter is out of range
+         */
+        [[nodiscard]] bool play(const uint32_t* words, uint16_t count, PlayMode mode, uint32_t rateHz,
+                                PatternDone done = nullptr, void* context = nullptr) noexcept;
+
+        /**
+         * @brief Play a double buffer that the refill callback keeps filling
+         *
+         * Both halves are filled by the callback before playback starts.
+         *
+         * @param buffer Ring of BSRR words
+         * @param count Ring size, even (2..65534); each refill covers count / 2 words
+         * @param rateHz Words per second
+         * @param refill Called from the DMA interrupt for the half just played
+         * @param context Passed to refill
+         * @return false if another player or the USART bridge holds the channel, or a parameter is out of range
+         */
+        [[nodiscard]] bool stream(uint32_t* buffer, uint16_t count, uint32_t rateHz,
+                                  PatternRefill refill, void* context = nullptr) noexcept;
+
+        /**
+         * @brief Stop the timer and the DMA; the pins keep their last state
+         */
+        void stop() noexcept;
+
+        [[nodiscard]] bool isPlaying() const noexcept {
+            return playing;
+        }
+
+        /**
+         * @brief Half buffers refilled in STREAM mode
+         */
+        [[nodiscard]] uint32_t getRefillCount() const noexcept {
+            return refillCount;
+        }
+
+        /**
+         * @brief Refills that came after DMA had already finished the other half
+         */
+        [[nodiscard]] uint32_t getLateRefillCount() const noexcept {
+            return lateRefillCount;
+        }
+
+        /**
+         * @brief DMA interrupt work (called from GPIO_HandlePatternDmaInterrupt)
+         */
+        void handleDmaInterrupt(uint32_t flags) noexcept;
+
+    private:
+        GPIO_TypeDef* port;
+        PlayMode mode;
+        uint32_t* ring;
+        uint16_t halfCount;
+        PatternRefill refill;
+        PatternDone done;
+        void* context;
+        volatile bool playing;
+        volatile uint32_t refillCount;
+        volatile uint32_t lateRefillCount;
+
+        bool canStart() const noexcept;
+        bool start(const uint32_t* words, uint16_t count, PlayMode playMode, uint32_t rateHz) noexcept;
+    };
+
+} // namespace GPIO
+
+#endif /* DEVICE_INC_GPIO_WAVE_H_ */
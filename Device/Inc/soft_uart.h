@@ -0,0 +1,244 @@
+/**
+ * @file    soft_uart.h
+ * @brief   Timer-driven software UART channels on GPIO pins
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Adds up to four low-speed 8N1 ports on arbitrary GPIO pins when the
+ * hardware USARTs are taken (GPS, legacy sensors). All channels share the
+ * free-running 32-bit TIM2 at the core clock; each channel owns one compare
+ * channel (CC1..CC4) that is programmed with the channel's next TX edge or
+ * RX sample, whichever comes first:
+ *
+ * ```
+ *   TX: txBuffer -> frame (start, 8 data LSB first, stop) -> pin via BSRR
+ *       one event per level change, not per bit
+ *   RX: falling edge (GPIOEXTI) -> timestamp, line masked
+ *       -> sample at the centre of data bits 0..7 and of the stop bit
+ *       -> rxBuffer or RX callback, line unmasked
+ * ```
+ *
+ * Bit times are computed from the frame start in 1/256 cycle steps, so
+ * they never accumulate interrupt latency; back-to-back frames are a whole
+ * number of cycles long (80 ppm off the nominal rate at 57600). The TIM2 interrupt
+ * batches: it handles every event of every channel that is due within
+ * BATCH_WINDOW_CYCLES, so channels running into each other share one
+ * interrupt entry.
+ *
+ * ## Usage
+ *
+ * @code
+ * static GPIO::GPIOOutput gpsTx(GPIOA, 0, GPIO::PinOutputType::PUSH_PULL);
+ * static GPIO::GPIOEXTI gpsRx(GPIOA, 1, GPIO::EXTITrigger::FALLING, GPIO::PinPull::PULL_UP);
+ * static USART::SoftUart gps(&gpsTx, &gpsRx);       // Either pin may be nullptr
+ *
+ * gps.initialize(9600);
+ * gps.sendString("$PMTK220,200*2C\r\n");
+ *
+ * uint8_t buffer[32];
+ * uint16_t count = gps.receiveData(buffer, sizeof(buffer));
+ * @endcode
+ *
+ * The send/receive API matches `UsartDriver`, so protocol code written
+ * against it ports by changing the type. TIM2_IRQHandler must call
+ * `USART_HandleSoftUartTimerInterrupt()`, and the EXTI vector of the RX pin
+ * must dispatch to `GPIOEXTI::handleInterrupt()`.
+ *
+ * ## Interrupt Load
+ *
+ * Interrupts per second with continuous full-duplex traffic on every
+ * channel, peer baud rate off by +/-2 %, from the timing model in
+ * Tests/Host/SoftUartTest.cpp (all bytes received and sent correctly):
+ *
+ * | Baud rate | Channels | TIM2 interrupts | EXTI interrupts |
+ * |-----------|----------|-----------------|-----------------|
+ * | 9600      | 1        | 14713           | 977             |
+ * | 9600      | 3        | 35477           | 2892            |
+ * | 57600     | 1        | 78523           | 5873            |
+ * | 57600     | 3        | 156711          | 17388           |
+ *
+ * A received byte costs one EXTI and up to nine timer events, a sent byte
+ * one timer event per level change; batching lets three channels share a
+ * third of their timer interrupts at 57600. The model gives the interrupt
+ * bodies no run time, so CPU load and the point where sampling falls
+ * behind follow only from these counts times the handler cost measured on
+ * the target (DWT->CYCCNT around USART_HandleSoftUartTimerInterrupt()).
+ *
+ * @note TIM2 runs at preemption priority 1 and the RX edge interrupt has to
+ *       preempt it, so a start bit is timestamped even while the timer
+ *       interrupt is busy; the timestamp error would otherwise shift every
+ *       sample of the byte. An RX pin on lines 0..4 owns its EXTI vector,
+ *       which initialize() enables at priority 0. Lines 5..9 and 10..15
+ *       share EXTI9_5 / EXTI15_10 with other pins, so initialize() leaves
+ *       that vector alone and returns INVALID_PARAMETER unless it is already
+ *       enabled at preemption priority 0.
+ * @note 8N1 only; baud rates 1200..57600.
+ */
+
+#ifndef DEVICE_INC_SOFT_UART_H_
+#define DEVICE_INC_SOFT_UART_H_
+
+#include "usart.h"
+#include "gpio.h"
+
+#include <cstdint>
+
+// C interface for the TIM2 interrupt handler
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void USART_HandleSoftUartTimerInterrupt(void);
+#ifdef __cplusplus
+}
+#endif
+
+namespace USART {
+
+    static constexpr uint8_t SOFT_UART_MAX_CHANNELS = 4;      ///< TIM2 compare channels
+    static constexpr uint16_t SOFT_UART_BUFFER_SIZE = 128;
+    static constexpr uint32_t SOFT_UART_MIN_BAUD = 1200;
+    static constexpr uint32_t SOFT_UART_MAX_BAUD = 57600;
+
+    /**
+     * @class SoftUart
+     * @brief One software UART channel (TX on a GPIOOutput, RX on a GPIOEXTI)
+     */
+    class SoftUart {
+    private:
+        static constexpr uint8_t NO_CHANNEL = 0xFF;
+        static constexpr uint8_t FRAME_BITS = 10;      ///< Start, 8 data, stop
+
+        GPIO::GPIOOutput* txPin;
+        GPIO::GPIOEXTI* rxPin;
+        GPIO_TypeDef* txPort;
+        uint32_t txMask;
+        GPIO_TypeDef* rxPort;
+        uint32_t rxMask;
+        uint8_t channel;                    ///< TIM2 compare channel index (NO_CHANNEL = not initialized)
+        uint32_t baudRate;
+        uint32_t bitCyclesQ8;               ///< Timer cycles per bit, 24.8 fixed point
+
+        CircularBuffer<SOFT_UART_BUFFER_SIZE> txBuffer;
+        CircularBuffer<SOFT_UART_BUFFER_SIZE> rxBuffer;
+
+        volatile bool transmissionActive;
+        uint16_t txFrame;                   ///< Start bit at bit 0, stop bit at bit 9
+        uint8_t txBit;                      ///< Bit driven at the next TX event (FRAME_BITS = frame end)
+        uint32_t txStart;                   ///< Timer count of the start bit edge
+        uint32_t txDue;
+
+        volatile bool rxActive;
+        uint8_t rxBit;                      ///< Data bit sampled next (8 = stop bit)
+        uint8_t rxShift;
+        uint32_t rxStart;                   ///< Estimated timer count of the start bit edge
+        uint32_t rxDue;
+
+        RxByteCallback rxCallback;
+        void* rxCallbackContext;
+        volatile uint32_t rxOverflowCount;  ///< Bytes dropped because rxBuffer was full
+        volatile uint32_t rxErrorCount;     ///< Framing errors (stop bit low)
+
+        [[nodiscard]] uint32_t bitOffset(uint8_t bit) const noexcept;
+        [[nodiscard]] uint32_t bitCenter(uint8_t bit) const noexcept;
+        void startTransmission() noexcept;
+        void onStartEdge() noexcept;
+        static void startEdgeCallback(void* context);
+        void handleTxEvent() noexcept;
+        void handleRxEvent() noexcept;
+        bool serviceDue(uint32_t now) noexcept;
+        void armCompare() noexcept;
+
+    public:
+        /**
+         * @brief Constructor
+         * @param tx Transmit pin (nullptr for a receive-only channel)
+         * @param rx Receive pin with EXTITrigger::FALLING (nullptr for transmit-only)
+         */
+        SoftUart(GPIO::GPIOOutput* tx, GPIO::GPIOEXTI* rx) noexcept;
+
+        ~SoftUart();
+
+        SoftUart(const SoftUart&) = delete;
+        SoftUart& operator=(const SoftUart&) = delete;
+
+        /**
+         * @brief Claim a TIM2 compare channel and start the port
+         * @param baud Baud rate (SOFT_UART_MIN_BAUD..SOFT_UART_MAX_BAUD)
+         * @return BUSY if all channels are taken, INVALID_PARAMETER for an
+         *         unsupported baud rate or an RX pin on a shared EXTI vector
+         *         that does not preempt TIM2
+         */
+        UsartStatus initialize(uint32_t baud) noexcept;
+
+        /**
+         * @brief Stop the port and release its compare channel (queued TX data is dropped)
+         */
+        void deinitialize() noexcept;
+
+        bool sendByte(uint8_t data) noexcept;
+        uint16_t sendData(const uint8_t* data, uint16_t length) noexcept;
+        uint16_t sendString(const char* str) noexcept;
+
+        /**
+         * @brief Send formatted string (printf-style, truncated at 128 characters)
+         */
+        uint16_t sendFormatted(const char* format, ...) noexcept;
+
+        bool receiveByte(uint8_t& data) noexcept;
+        uint16_t receiveData(uint8_t* data, uint16_t maxLength) noexcept;
+
+        /**
+         * @brief Set a per-byte RX hook called from interrupt context (replaces rxBuffer)
+         */
+        void setRxCallback(RxByteCallback callback, void* context) noexcept;
+
+        [[nodiscard]] bool isTransmissionActive() const noexcept {
+            return transmissionActive;
+        }
+
+        [[nodiscard]] bool isInitialized() const noexcept {
+            return channel != NO_CHANNEL;
+        }
+
+        [[nodiscard]] uint32_t getBaudRate() const noexcept {
+            return baudRate;
+        }
+
+        [[nodiscard]] uint16_t getAvailableSpace() const noexcept {
+            return txBuffer.availableSpace();
+        }
+
+        [[nodiscard]] uint16_t getQueueSize() const noexcept {
+            return txBuffer.getRemainingCount();
+        }
+
+        [[nodiscard]] uint16_t getRxCount() const noexcept {
+            return rxBuffer.getRemainingCount();
+        }
+
+        [[nodiscard]] uint32_t getRxOverflowCount() const noexcept {
+            return rxOverflowCount;
+        }
+
+        [[nodiscard]] uint32_t getRxErrorCount() const noexcept {
+            return rxErrorCount;
+        }
+
+        /**
+         * @brief Clear transmission buffer
+         * @warning Must not be called while transmission is active
+         */
+        void clearBuffer() noexcept {
+            txBuffer.reset();
+        }
+
+        /**
+         * @brief Handle all due events of all channels (called from TIM2 interrupt)
+         */
+        static void handleTimerInterrupt() noexcept;
+    };
+
+} // namespace USART
+
+#endif /* DEVICE_INC_SOFT_UART_H_ */
@@ -13,6 +13,11 @@
  * - **Type-safe instance management** via registry pattern (no void* casting)
  * - **Structured error handling** with UsartError enum and UsartStatus struct
  * - **Interrupt-driven non-blocking transmission** with circular buffer
+ * - **Interrupt-driven reception** into a circular buffer or a per-byte callback
+ * - **Receiver timeout** (inter-frame gap) detection for frame-based protocols
+ * - **RS-485 half-duplex** with hardware driver-enable (DE) timing
+ * - **Flow control**: RTS/CTS or XON/XOFF driven by RX ring watermarks
+ * - **DMA mode** with idle-line notification (see usart_bridge.h)
  * - **Multiple send methods**: strings, formatted output, hex/binary representations
  * - **noexcept/constexpr annotations** for compile-time optimization
  * - **Support for LPUART_1, USART_1, USART_2, USART_3**
@@ -118,6 +123,113 @@
  * uart.sendString("\r\n");
  * @endcode
  * 
+ * ### Pattern 5: Frame Reception with Receiver Timeout
+ * @code
+ * // Each received byte is handed to onByte() from the RX interrupt,
+ * // onFrameEnd() fires once the line has been idle for 39 bit periods
+ * uart.setRxCallback(onByte, &myProtocol);
+ * uart.enableReceiverTimeout(39, onFrameEnd, &myProtocol);
+ * @endcode
+ * 
+ * USART_1..3 use the built-in receiver timeout (RTOR/RTOF). LPUART_1 has no
+ * receiver timeout, so the driver retriggers TIM7 in one-pulse mode on every
+ * received byte instead; `TIM7_IRQHandler` must call
+ * `USART_HandleRxTimeoutTimerInterrupt()`.
+ * 
+ * ### Pattern 6: RS-485 Half-Duplex
+ * @code
+ * // DE pin must be muxed to the USART's RTS/DE alternate function
+ * USART::Rs485Config rs485 = USART::getDefaultRs485Config();
+ * rs485.suppressEcho = true;   // Receiver off while we drive the bus
+ * uart.enableRs485(rs485);
+ * 
+ * uart.sendData(frame, length);      // DE asserted/deasserted by hardware
+ * while (uart.isTransmissionActive()) {}  // Cleared on TC, bus released
+ * @endcode
+ * 
+ * ### Pattern 7: Lossless Bulk Reception with Flow Control
+ * @code
+ * // Pause the sender at 3/4 full, resume at 1/4 full
+ * USART::FlowControlConfig flow{USART::FlowControl::RTS_CTS, 192, 64};
+ * uart.enableFlowControl(flow);
+ * 
+ * uint8_t chunk[64];
+ * uint16_t n = uart.receiveData(chunk, sizeof(chunk));  // Resumes sender when drained
+ * @endcode
+ * 
+ * With RTS_CTS the driver stops reading RDR at the high watermark, so the
+ * hardware deasserts RTS after the byte in flight; CTS gates every TX frame
+ * in hardware. With XON_XOFF the driver sends XOFF/XON ahead of queued TX
+ * data and pauses its own TX on a received XOFF. XON/XOFF bytes are consumed
+ * by the driver, so binary payloads must not contain 0x11/0x13.
+ * 
+ * Tests/Host/FlowControlTest streams 1 MB at 2 Mbaud into a reader running
+ * at a third of the line rate: no overrun and no lost byte in either mode,
+ * every pause at the high and every resume at the low watermark. With a
+ * sender that stops 2 characters after XOFF, XON/XOFF peaks at 193 bytes
+ * for a high watermark of 192.
+ * 
+ * ### Pattern 8: Serializing Straight into the TX Ring
+ * @code
+ * auto reservation = uart.reserveTx(32);   // Capacity may be less than requested
+ * if (encoder.encodeTo(reservation)) {     // Anything with bool put(uint8_t)
+ *     uart.commitTx(reservation);          // Publish and start transmission
+ * } else {
+ *     uart.abortTx(reservation);           // Drop the partial record
+ * }
+ * @endcode
+ * 
+ * A reservation writes into the free part of the ring without an
+ * intermediate buffer; nothing is sent until commitTx(). Serializers that
+ * fill in a header after the payload use getRing() and setSize() instead of
+ * put() (Rpc::Server does). Only one
+ * reservation may be open at a time and no other send*() call may run
+ * (e.g. from an ISR) until it is committed or aborted.
+ * 
+ * ### Pattern 9: Runtime Baud Rate Change
+ * @code
+ * if (uart.isBaudRateSupported(2000000)) {
+ *     while (uart.setBaudRate(2000000).error == USART::UsartError::BUSY) {}
+ * }
+ * @endcode
+ * 
+ * Dividers are computed from the actual kernel clock (RCC), so the limits
+ * follow the clock tree: with 32 MHz PCLK USART_1..3 reach 4 Mbaud (8x
+ * oversampling) and LPUART_1 10.6 Mbaud. Both ends have to switch at the same
+ * time; BaudSwitch.h adds a handshake with confirmation and fallback.
+ * 
+ * ### Pattern 10: Multi-Drop Bus with Address-Mark Mute
+ * @code
+ * config.wordLength = USART_CR1_M0;                        // 9-bit words
+ * uart.initialize(config);
+ * uart.enableAddressMute({0x05, true});                    // Node 5, 7-bit addresses
+ * 
+ * master.sendAddressedFrame(0x05, payload, sizeof(payload));
+ * @endcode
+ * 
+ * Foreign frames never reach the CPU: the hardware drops non-matching
+ * address marks and everything after them, so a node only takes RX
+ * interrupts for the 9 characters (mark + 8 bytes) of its own frames.
+ * 16-node bus, 8-byte frames (Tests/Host/AddressMuteTest.cpp):
+ * 
+ * | Per node | RX interrupts per 1000 bus frames |
+ * |----------|-----------------------------------|
+ * | Without mute mode | 9000 |
+ * | With address-mark mute, frames spread evenly | 562.5 (1/16) |
+ * | With mute, one node receiving 50 % of the traffic (that node / others) | 4500 / 300 |
+ * 
+ * ### Pattern 11: LIN Break Generation and Detection
+ * @code
+ * uart.initialize(config);                                 // 19200 8N1
+ * uart.enableLin(onBreak, &node);                          // USART_1..3 only
+ * 
+ * uart.sendBreak();                                        // TX idle
+ * uart.sendData(header, sizeof(header));                   // 0x55, protected ID
+ * @endcode
+ * 
+ * Lin.h builds the master schedule table and the slave response handling
+ * on top of these primitives.
+ * 
  * ## Thread Safety & ISR Context
  * 
  * All `send*()` methods and `handleTxCompleteInterrupt()` are **ISR-safe**:
@@ -145,15 +257,16 @@
  * ## Limitations & Future Work
  * 
  * ### Current Limitations
- * - **TX only**: Receive functionality not yet implemented
+ * - **Single RX timeout timer**: TIM7 serves only one LPUART_1 instance
  * - **Single template instantiation per peripheral**: Registry assumes StandardUSART
- * - **No DMA**: Interrupt-driven only
+ * - **DMA for bridging only**: DMA mode hands RDR/TDR to a BridgeLane
+ *   (usart_bridge.h); send()/receive() stay interrupt-driven and are not
+ *   used while it is active
  * - **sendFormatted() buffer**: Fixed 256-byte temporary buffer (truncation possible)
  * 
  * ### Planned Enhancements
- * - RX circular buffer with similar architecture
  * - Configurable ISR priority per peripheral
- * - Optional DMA fallback for high-speed transfers
+ * - DMA-backed send()/receive() buffers for high-speed transfers
  * - User callbacks for transmit-complete events
  * 
  * @see Examples/02_USART_HelloWorld for detailed usage example
@@ -174,6 +287,10 @@
 extern "C" {
 #endif
     void USART_HandleLpuart1Interrupt(void);
+    void USART_HandleUsart1Interrupt(void);
+    void USART_HandleUsart2Interrupt(void);
+    void USART_HandleUsart3Interrupt(void);
+    void USART_HandleRxTimeoutTimerInterrupt(void);
 #ifdef __cplusplus
 }
 #endif
@@ -205,7 +322,8 @@ namespace USART
         UNINITIALIZED,                 ///< Driver not initialized
         INVALID_PERIPHERAL,            ///< Invalid peripheral type
         INVALID_PARAMETER,             ///< Invalid parameter provided
-        NULL_POINTER                   ///< Null pointer provided where not allowed
+        NULL_POINTER,                  ///< Null pointer provided where not allowed
+        BUSY                           ///< Transmission still in progress
     };
 
     /**
@@ -224,6 +342,31 @@ namespace USART
         }
     };
 
+    /**
+     * @brief Callback invoked from the RX interrupt for every received byte
+     * @param context User pointer passed at registration
+     * @param data Received byte
+     */
+    using RxByteCallback = void (*)(void* context, uint8_t data);
+
+    /**
+     * @brief Callback invoked from interrupt context when the receiver timeout expires
+     * @param context User pointer passed at registration
+     */
+    using RxTimeoutCallback = void (*)(void* context);
+
+    /**
+     * @brief Callback invoked from interrupt context when the last queued byte is on the wire
+     * @param context User pointer passed at registration
+     */
+    using TxCompleteCallback = void (*)(void* context);
+
+    /**
+     * @brief Callback invoked from the USART interrupt when a LIN break is detected
+     * @param context User pointer passed at registration
+     */
+    using BreakCallback = void (*)(void* context);
+
     /**
      * @brief USART configuration structure
      */
@@ -236,6 +379,59 @@ namespace USART
         uint32_t transferDirection;
     };
 
+    /**
+     * @brief RS-485 driver-enable configuration
+     * 
+     * Times are in sample time units: 1/16 bit period with 16x oversampling,
+     * 1/8 bit period with OVER8. Five bits each, so at most 31 units.
+     */
+    struct Rs485Config {
+        uint8_t assertionTime;     ///< DEAT: DE active before the start bit (0..31)
+        uint8_t deassertionTime;   ///< DEDT: DE held after the last stop bit (0..31)
+        bool activeLow;            ///< DEP: DE polarity (false = active high)
+        bool suppressEcho;         ///< Disable the receiver while transmitting
+    };
+
+    /**
+     * @enum FlowControl
+     * @brief Flow control scheme used to protect the RX buffer
+     */
+    enum class FlowControl : uint8_t {
+        NONE,        ///< No flow control
+        RTS_CTS,     ///< Hardware RTS/CTS (RTS/CTS pins muxed to the USART)
+        XON_XOFF     ///< Software flow control with in-band XON (0x11) / XOFF (0x13)
+    };
+
+    /**
+     * @brief Flow control configuration
+     * 
+     * The sender is paused once the RX buffer holds highWatermark bytes and
+     * resumed when the application has drained it down to lowWatermark.
+     */
+    struct FlowControlConfig {
+        FlowControl mode;
+        uint16_t highWatermark;    ///< Pause sender at or above this fill level
+        uint16_t lowWatermark;     ///< Resume sender at or below this fill level
+    };
+
+    /**
+     * @brief Multiprocessor (address-mark) mute configuration
+     * 
+     * A character with its most significant bit set (bit 8 with 9-bit words,
+     * bit 7 with 8-bit words) is an address mark. In mute mode the hardware
+     * discards everything until a mark carries this node's address.
+     */
+    struct AddressMuteConfig {
+        uint8_t address;           ///< Own node address (0..15, or 0..127 with sevenBitAddress)
+        bool sevenBitAddress;      ///< ADDM7: compare 7 address bits instead of 4
+    };
+
+    static constexpr uint8_t XON_CHAR = 0x11;
+    static constexpr uint8_t XOFF_CHAR = 0x13;
+
+    /// Largest accepted deviation between requested and generated baud rate (2 %)
+    static constexpr uint32_t MAX_BAUD_ERROR_PERMILLE = 20;
+
     /**
      * @brief Circular buffer for USART data queuing
      * @tparam SIZE Buffer size (must be power of 2 for efficiency)
@@ -323,6 +519,34 @@ namespace USART
             return getRemainingCount();
         }
 
+        /**
+         * @brief Write into free space ahead of head without publishing it
+         * @param offset Distance from head (must be < availableSpace())
+         * @param data Byte to store
+         * @note Single producer only; the consumer cannot see the byte before commit()
+         */
+        void poke(uint16_t offset, uint8_t data) noexcept {
+            buffer[(head + offset) & MASK] = data;
+        }
+
+        /**
+         * @brief Publish bytes previously written with poke()
+         * @param length Number of bytes to append (must be <= availableSpace())
+         */
+        void commit(uint16_t length) noexcept {
+            head = (head + length) & MASK;
+        }
+
+        /**
+         * @brief Storage and write index for producers that index the ring directly
+         * @param[out] start Index of the first free byte (head)
+         * @return Buffer of SIZE bytes, free bytes follow start modulo SIZE
+         */
+        [[nodiscard]] uint8_t* window(uint16_t& start) noexcept {
+            start = head;
+            return buffer;
+        }
+
         /**
          * @brief Clear buffer (atomically resets head and tail)
          * 
@@ -360,15 +584,53 @@ namespace USART
         USART_TypeDef* usartInstance;  ///< Type-safe instance pointer
         Config config;
         CircularBuffer<BUFFER_SIZE> txBuffer;
+        CircularBuffer<BUFFER_SIZE> rxBuffer;
         volatile bool transmissionActive;
-        volatile bool isInitialized;
+        volatile bool initialized;
+
+        RxByteCallback rxCallback;          ///< Optional per-byte RX hook (replaces rxBuffer)
+        void* rxCallbackContext;
+        RxTimeoutCallback rxTimeoutCallback; ///< Optional end-of-frame hook
+        void* rxTimeoutContext;
+        bool rxTimeoutUsesTimer;            ///< true when TIM7 emulates the receiver timeout
+        bool rs485Enabled;                  ///< Wait for TC before releasing the bus
+        bool rs485SuppressEcho;             ///< Receiver disabled while transmitting
+        FlowControl flowControl;            ///< Active flow control scheme
+        uint16_t rxHighWatermark;
+        uint16_t rxLowWatermark;
+        volatile bool rxPaused;             ///< Sender has been told to stop
+        volatile bool txPaused;             ///< Peer sent XOFF
+        volatile uint8_t pendingControlChar; ///< XON/XOFF sent ahead of txBuffer (0 = none)
+        volatile uint32_t rxOverflowCount;  ///< Bytes dropped because rxBuffer was full
+        volatile uint32_t rxErrorCount;     ///< Overrun, framing, noise and parity errors
+        TxCompleteCallback txCompleteCallback; ///< Optional TC hook (queue drained)
+        void* txCompleteContext;
+        bool dmaMode;                       ///< Data moved by DMA, byte interrupts disabled
+        RxTimeoutCallback idleCallback;     ///< Idle-line hook used in DMA mode
+        void* idleContext;
+        volatile uint16_t pendingAddress;   ///< Address mark sent ahead of txBuffer (0 = none)
+        bool addressMute;                   ///< Mute mode with address-mark wakeup active
+        BreakCallback breakCallback;        ///< LIN break detection hook
+        void* breakContext;
+        bool linMode;                       ///< LIN mode (break generation/detection) active
         
         // Private methods for hardware abstraction
         void initializeLpuart() noexcept;
         void initializeUsart() noexcept;
+        [[nodiscard]] uint32_t getKernelClock() const noexcept;
+        [[nodiscard]] bool computeDivider(uint32_t baudRate, uint32_t& brr, bool& over8) const noexcept;
         void enableTxInterrupt() noexcept;
         void disableTxInterrupt() noexcept;
+        void enableRxInterrupt() noexcept;
+        void disableRxInterrupt() noexcept;
+        void pauseRx() noexcept;
+        void resumeRxIfDrained() noexcept;
+        void queueControlChar(uint8_t data) noexcept;
+        [[nodiscard]] uint16_t getAddressMarkBit() const noexcept;
         void transmitByte(uint8_t data) noexcept;
+        void handleRxInterrupt(uint8_t data) noexcept;
+        void handleTransmissionCompleteInterrupt() noexcept;
+        void restartRxTimeoutTimer() noexcept;
         [[nodiscard]] bool isTxReady() const noexcept;
         
     public:
@@ -442,12 +704,52 @@ namespace USART
             return transmissionActive;
         }
 
+        /**
+         * @brief Get the configured baud rate
+         */
+        [[nodiscard]] uint32_t getBaudRate() const noexcept {
+            return config.baudRate;
+        }
+
+        /**
+         * @brief Highest baud rate the kernel clock allows
+         * 
+         * f_ck / 8 with OVER8 on USART_1..3, f_ck / 3 on LPUART_1.
+         */
+        [[nodiscard]] uint32_t getMaxBaudRate() const noexcept;
+
+        /**
+         * @brief Check a baud rate against the kernel clock
+         * @return true if reachable within MAX_BAUD_ERROR_PERMILLE
+         */
+        [[nodiscard]] bool isBaudRateSupported(uint32_t baudRate) const noexcept {
+            uint32_t brr = 0;
+            bool over8 = false;
+            return computeDivider(baudRate, brr, over8);
+        }
+
+        /**
+         * @brief Change the baud rate of a running port
+         * 
+         * Waits for the last stop bit (TC, bounded to one character; with
+         * RS-485 or a TX-complete callback the TC interrupt has already seen
+         * it), then briefly clears UE to load the new divider; USART_1..3
+         * switch to 8x oversampling above f_ck / 16. A TIM7 receiver timeout
+         * is rescaled to keep its length in bit periods.
+         * 
+         * @param baudRate New baud rate
+         * @return BUSY while the TX queue is not empty or the TC interrupt is
+         *         still pending, INVALID_PARAMETER if the
+         *         kernel clock cannot produce the rate
+         */
+        UsartStatus setBaudRate(uint32_t baudRate) noexcept;
+
         /**
          * @brief Check if driver has been initialized
          * @return true if initialize() was called successfully
          */
         [[nodiscard]] bool isInitialized() const noexcept {
-            return isInitialized;
+            return initialized;
         }
 
         /**
@@ -466,6 +768,83 @@ namespace USART
             return txBuffer.getRemainingCount();
         }
 
+        /**
+         * @class TxReservation
+         * @brief Unpublished region of the TX ring filled byte by byte
+         */
+        class TxReservation {
+            friend class UsartDriver;
+
+        private:
+            CircularBuffer<BUFFER_SIZE>* ring;
+            uint16_t capacity;
+            uint16_t length;
+
+            TxReservation(CircularBuffer<BUFFER_SIZE>* buffer, uint16_t maxLength) noexcept
+                : ring(buffer), capacity(maxLength), length(0) {}
+
+        public:
+            /**
+             * @brief Append one byte
+             * @return false once the reservation is full
+             */
+            bool put(uint8_t data) noexcept {
+                if (length >= capacity) {
+                    return false;
+                }
+                ring->poke(length++, data);
+                return true;
+            }
+
+            [[nodiscard]] uint16_t size() const noexcept {
+                return length;
+            }
+
+            [[nodiscard]] uint16_t getCapacity() const noexcept {
+                return capacity;
+            }
+
+            /// Ring size - 1, for getRing()
+            static constexpr uint16_t RING_MASK = BUFFER_SIZE - 1;
+
+            /**
+             * @brief Ring storage for serializers that need random access
+             * @param[out] start Ring index of reserved byte 0; byte n is at (start + n) & RING_MASK
+             * @return Ring storage; call setSize() with the bytes written before commitTx()
+             */
+            [[nodiscard]] uint8_t* getRing(uint16_t& start) const noexcept {
+                return ring->window(start);
+            }
+
+            /**
+             * @brief Set the length after writing through getRing() (clamped to the capacity)
+             */
+            void setSize(uint16_t size) noexcept {
+                length = (size < capacity) ? size : capacity;
+            }
+        };
+
+        /**
+         * @brief Reserve free TX ring space for in-place serialization
+         * @param maxLength Requested capacity
+         * @return Reservation with capacity min(maxLength, free space), 0 if uninitialized
+         * @see Pattern 8
+         */
+        [[nodiscard]] TxReservation reserveTx(uint16_t maxLength) noexcept;
+
+        /**
+         * @brief Publish a reservation and start transmission
+         * @param reservation Reservation returned by reserveTx()
+         * @return Number of bytes queued
+         */
+        uint16_t commitTx(const TxReservation& reservation) noexcept;
+
+        /**
+         * @brief Discard a reservation; the bytes written into it are never sent
+         * @param reservation Reservation returned by reserveTx(), empty afterwards
+         */
+        void abortTx(TxReservation& reservation) noexcept;
+
         /**
          * @brief Clear transmission buffer
          * 
@@ -476,6 +855,247 @@ namespace USART
             txBuffer.reset();
         }
 
+        /**
+         * @brief Read one received byte (non-blocking)
+         * @param data Reference to store the received byte
+         * @return true if a byte was available
+         * @note Only fed when no RX callback is registered
+         */
+        bool receiveByte(uint8_t& data) noexcept;
+
+        /**
+         * @brief Read up to maxLength received bytes (non-blocking)
+         * @param data Destination buffer (must not be nullptr if maxLength > 0)
+         * @param maxLength Capacity of the destination buffer
+         * @return Number of bytes copied
+         * @note Preferred for bulk transfers: flow control is re-evaluated once per call
+         */
+        uint16_t receiveData(uint8_t* data, uint16_t maxLength) noexcept;
+
+        /**
+         * @brief Get number of received bytes waiting in the RX buffer
+         * @return Number of bytes that can be read with receiveByte()
+         */
+        [[nodiscard]] uint16_t getRxCount() const noexcept {
+            return rxBuffer.getRemainingCount();
+        }
+
+        /**
+         * @brief Get number of received bytes dropped because the RX buffer was full
+         */
+        [[nodiscard]] uint32_t getRxOverflowCount() const noexcept {
+            return rxOverflowCount;
+        }
+
+        /**
+         * @brief Get number of receive errors (overrun, framing, noise, parity)
+         */
+        [[nodiscard]] uint32_t getRxErrorCount() const noexcept {
+            return rxErrorCount;
+        }
+
+        /**
+         * @brief Route received bytes to a callback instead of the RX buffer
+         * 
+         * The callback runs in interrupt context for every received byte,
+         * which lets protocol layers parse (and checksum) data as it arrives.
+         * 
+         * @param callback Function to call per byte (nullptr restores buffering)
+         * @param context User pointer forwarded to the callback
+         */
+        void setRxCallback(RxByteCallback callback, void* context) noexcept;
+
+        /**
+         * @brief Get notified when the TX queue has been sent completely
+         * 
+         * The callback runs from the TC interrupt, i.e. after the stop bit of
+         * the last queued byte, which makes it usable as a TX timestamp point.
+         * 
+         * @param callback Function to call (nullptr disables the notification)
+         * @param context User pointer forwarded to the callback
+         */
+        void setTxCompleteCallback(TxCompleteCallback callback, void* context) noexcept;
+
+        /**
+         * @brief Enable end-of-frame detection via receiver timeout
+         * 
+         * The timeout restarts with every received byte and fires once the
+         * line has been idle for the given number of bit periods.
+         * USART_1..3 use the hardware receiver timeout, LPUART_1 uses TIM7.
+         * 
+         * @param bitPeriods Idle time in bit periods (1..0xFFFFFF)
+         * @param callback Function called from interrupt context on timeout
+         * @param context User pointer forwarded to the callback
+         * @return Status indicating success or error
+         * @note Must be called after initialize()
+         */
+        UsartStatus enableReceiverTimeout(uint32_t bitPeriods, RxTimeoutCallback callback, void* context) noexcept;
+
+        /**
+         * @brief Disable end-of-frame detection and drop the timeout callback
+         */
+        void disableReceiverTimeout() noexcept;
+
+        /**
+         * @brief Enable RS-485 half-duplex mode with hardware driver enable
+         * 
+         * The USART drives its DE output (RTS pin alternate function) itself,
+         * asserting it assertionTime before the start bit and releasing it
+         * deassertionTime after the last stop bit. Transmission is only
+         * reported finished on TC (last stop bit on the wire), which is also
+         * where the receiver is re-enabled when echo suppression is active.
+         * 
+         * @param rs485 Driver-enable timing and echo configuration
+         * @return Status indicating success or error; BUSY while RTS/CTS flow
+         *         control is enabled, as DE and RTS share the pin
+         * @note Must be called after initialize(); briefly disables the USART
+         */
+        UsartStatus enableRs485(const Rs485Config& rs485) noexcept;
+
+        /**
+         * @brief Enable RX watermark based flow control
+         * 
+         * RTS_CTS also enables RTSE/CTSE in hardware (briefly disables the
+         * USART). Watermarks only apply to the RX buffer, not to an RX callback.
+         * 
+         * @param flow Scheme and watermarks (low < high < BUFFER_SIZE)
+         * @return Status indicating success or error; BUSY for RTS_CTS while
+         *         RS-485 mode drives the RTS pin as DE
+         * @note Must be called after initialize()
+         */
+        UsartStatus enableFlowControl(const FlowControlConfig& flow) noexcept;
+
+        /**
+         * @brief Check if the sender is currently paused by our flow control
+         */
+        [[nodiscard]] bool isRxPaused() const noexcept {
+            return rxPaused;
+        }
+
+        /**
+         * @brief Check if our transmitter is paused by a received XOFF
+         */
+        [[nodiscard]] bool isTxPaused() const noexcept {
+            return txPaused;
+        }
+
+        /**
+         * @brief Hand the data registers over to DMA
+         * 
+         * Disables the RXNE/TXE byte interrupts, sets DMAR/DMAT and enables the
+         * idle-line interrupt. The send*() and receive*() methods must not be
+         * used while DMA mode is active; the DMA channels are owned by the caller.
+         * 
+         * @param callback Called from interrupt context when the RX line goes idle
+         * @param context User pointer forwarded to the callback
+         * @return Status indicating success or error
+         * @note Must be called after initialize()
+         */
+        UsartStatus enableDmaMode(RxTimeoutCallback callback, void* context) noexcept;
+
+        /**
+         * @brief Return to interrupt-driven byte transfers
+         */
+        void disableDmaMode() noexcept;
+
+        /**
+         * @brief Check if DMA mode is active
+         */
+        [[nodiscard]] bool isDmaMode() const noexcept {
+            return dmaMode;
+        }
+
+        /**
+         * @brief Enable mute mode with address-mark wakeup (multi-drop receiver)
+         * 
+         * Requires 9-bit words, or 8-bit words whose data bytes keep bit 7
+         * clear. The node starts muted; the matching address character is
+         * delivered as the first byte of a frame (mark bit stripped with
+         * 9-bit words) and any other address mark mutes the node again, all
+         * without an RX interrupt for foreign traffic.
+         * 
+         * @param mute Own address and address width
+         * @return Status indicating success or error
+         * @note Must be called after initialize(); briefly disables the USART
+         */
+        UsartStatus enableAddressMute(const AddressMuteConfig& mute) noexcept;
+
+        /**
+         * @brief Leave mute mode and receive every character again
+         */
+        void disableAddressMute() noexcept;
+
+        /**
+         * @brief Ignore the rest of the current frame until the next own address
+         */
+        void enterMute() noexcept;
+
+        /**
+         * @brief Check if the receiver is currently muted by hardware
+         */
+        [[nodiscard]] bool isMuted() const noexcept {
+            return (usartInstance != nullptr) && ((usartInstance->ISR & USART_ISR_RWU) != 0U);
+        }
+
+        /**
+         * @brief Send an address mark followed by a payload (multi-drop master)
+         * 
+         * All or nothing: the frame is only queued if the TX queue is idle
+         * and the payload fits, so no earlier data ends up behind the mark.
+         * 
+         * @param address Destination node address
+         * @param data Payload (may be nullptr if length is 0)
+         * @param length Payload length
+         * @return true if the complete frame was queued
+         */
+        bool sendAddressedFrame(uint8_t address, const uint8_t* data, uint16_t length) noexcept;
+
+        /**
+         * @brief Enable LIN mode: break generation and 11-bit break detection
+         * 
+         * Only USART_1..3 implement LIN (LPUART_1 returns INVALID_PERIPHERAL).
+         * Requires 8-bit words and one stop bit. The break also arrives as a
+         * 0x00 character with a framing error (counted by getRxErrorCount()),
+         * which is delivered like any other byte; the callback runs before it
+         * is read when both are pending in the same interrupt.
+         * 
+         * @param callback Break detection hook (may be nullptr)
+         * @param context User pointer handed to the callback
+         * @return Status indicating success or error
+         * @note Must be called after initialize(); briefly disables the USART
+         */
+        UsartStatus enableLin(BreakCallback callback, void* context) noexcept;
+
+        /**
+         * @brief Leave LIN mode
+         */
+        void disableLin() noexcept;
+
+        /**
+         * @brief Request a break (13 low bits) ahead of the next queued byte
+         * 
+         * Only accepted while the TX queue is idle, so the break cannot land
+         * in the middle of earlier data; bytes queued right after it follow
+         * the break on the wire.
+         * 
+         * @return true if the break was requested
+         */
+        bool sendBreak() noexcept;
+
+        /**
+         * @brief Check if LIN mode is active
+         */
+        [[nodiscard]] bool isLinEnabled() const noexcept {
+            return linMode;
+        }
+
+        /**
+         * @brief Check if RS-485 mode is active
+         */
+        [[nodiscard]] bool isRs485Enabled() const noexcept {
+            return rs485Enabled;
+        }
+
         /**
          * @brief Start transmission (called internally and by interrupt)
          */
@@ -490,6 +1110,21 @@ namespace USART
          */
         void handleTxCompleteInterrupt() noexcept;
 
+        /**
+         * @brief Handle a USART/LPUART interrupt (called from ISR)
+         * 
+         * Reads the status register once and services receive errors,
+         * received data, receiver timeout and transmit-empty events.
+         */
+        void handleInterrupt() noexcept;
+
+        /**
+         * @brief Handle an expired receiver timeout (called from ISR)
+         * 
+         * Invoked by handleInterrupt() on RTOF, or by the TIM7 bridge for LPUART_1.
+         */
+        void handleRxTimeoutInterrupt() noexcept;
+
         /**
          * @brief Get peripheral type
          * @return The peripheral type this driver is using
@@ -542,6 +1177,29 @@ namespace USART
         };
     }
 
+    /**
+     * @brief Get default RS-485 configuration
+     * @return One bit period of DE lead and lag (16x oversampling), active-high DE, echo kept
+     */
+    constexpr Rs485Config getDefaultRs485Config() noexcept {
+        return Rs485Config{
+            .assertionTime = 16U,
+            .deassertionTime = 16U,
+            .activeLow = false,
+            .suppressEcho = false
+        };
+    }
+
+    /**
+     * @brief Bus turnaround after the last stop bit, in bit periods
+     * @param rs485 RS-485 configuration
+     * @param over8 true if the USART uses 8x oversampling
+     * @return Time from end of stop bit until DE is released
+     */
+    constexpr float getRs485TurnaroundBits(const Rs485Config& rs485, bool over8 = false) noexcept {
+        return static_cast<float>(rs485.deassertionTime) / (over8 ? 8.0f : 16.0f);
+    }
+
     /**
      * @brief Register USART interrupt handler for a specific peripheral
      * @param peripheral The USART peripheral type
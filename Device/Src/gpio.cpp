@@ -22,8 +22,65 @@ namespace GPIO
 // GPIOEXTI Static Registry Implementation
 //=============================================================================
 
-// Static registry of GPIOEXTI instances indexed by pin number
-static GPIOEXTI* extiRegistry[16] = {nullptr};
+/**
+ * @brief EXTI dispatch table entry
+ * 
+ * The callback is never null (unused lines point to ignoreInterrupt), so the
+ * interrupt path is one load pair and one indirect call without a test.
+ * Callback and context are volatile so setCallback() stores them in order.
+ */
+struct ExtiSlot {
+    InterruptCallback volatile callback;    ///< Callback for this line
+    void* volatile context;                 ///< Passed to the callback
+    GPIOEXTI* owner;                        ///< Instance registered on this line
+};
+
+static void ignoreInterrupt(void*) {
+}
+
+#define EXTI_SLOT_IDLE {ignoreInterrupt, nullptr, nullptr}
+
+// Dispatch table indexed by pin (= EXTI line) number
+static ExtiSlot extiTable[16] = {
+    EXTI_SLOT_IDLE, EXTI_SLOT_IDLE, EXTI_SLOT_IDLE, EXTI_SLOT_IDLE,
+    EXTI_SLOT_IDLE, EXTI_SLOT_IDLE, EXTI_SLOT_IDLE, EXTI_SLOT_IDLE,
+    EXTI_SLOT_IDLE, EXTI_SLOT_IDLE, EXTI_SLOT_IDLE, EXTI_SLOT_IDLE,
+    EXTI_SLOT_IDLE, EXTI_SLOT_IDLE, EXTI_SLOT_IDLE, EXTI_SLOT_IDLE
+};
+
+#undef EXTI_SLOT_IDLE
+
+/**
+ * @brief Enable the AHB2 clock of a GPIO port
+ * 
+ * Shared by the pin classes and Port, which configures pins without a pin object.
+ * 
+ * @param port GPIO port (GPIOA, GPIOB, etc.)
+ */
+static void enableGpioClock(GPIO_TypeDef* port) {
+    uint32_t clock;
+    if (port == GPIOA) {
+        clock = LL_AHB2_GRP1_PERIPH_GPIOA;
+    } else if (port == GPIOB) {
+        clock = LL_AHB2_GRP1_PERIPH_GPIOB;
+    } else if (port == GPIOC) {
+        clock = LL_AHB2_GRP1_PERIPH_GPIOC;
+    } else if (port == GPIOD) {
+        clock = LL_AHB2_GRP1_PERIPH_GPIOD;
+    } else if (port == GPIOE) {
+        clock = LL_AHB2_GRP1_PERIPH_GPIOE;
+    } else if (port == GPIOH) {
+        clock = LL_AHB2_GRP1_PERIPH_GPIOH;
+    } else {
+        return;
+    }
+
+    // One read when the port is already running (every pin after the first)
+    // instead of the read-modify-write and read-back of EnableClock
+    if (!LL_AHB2_GRP1_IsEnabledClock(clock)) {
+        LL_AHB2_GRP1_EnableClock(clock);
+    }
+}
 
 //=============================================================================
 // GPIOBase Implementation
@@ -130,19 +187,7 @@ void GPIOBase::configureHardware() {
  * @note Called automatically during hardware configuration
  */
 void GPIOBase::enablePortClock() {
-    if (port_ == GPIOA) {
-        LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_GPIOA);
-    } else if (port_ == GPIOB) {
-        LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_GPIOB);
-    } else if (port_ == GPIOC) {
-        LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_GPIOC);
-    } else if (port_ == GPIOD) {
-        LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_GPIOD);
-    } else if (port_ == GPIOE) {
-        LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_GPIOE);
-    } else if (port_ == GPIOH) {
-        LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_GPIOH);
-    }
+    enableGpioClock(port_);
 }
 
 /**
@@ -250,13 +295,20 @@ void GPIOOutput::reset() {
 /**
  * @brief Toggle output pin state
  * 
- * Changes pin from HIGH to LOW or LOW to HIGH atomically.
- * Uses hardware toggle register for glitch-free operation.
- * Updates internal state tracking.
+ * Reads ODR once and writes the inverted level through BSRR, so other pins
+ * of the port are never rewritten. The cached state follows the level that
+ * was actually driven, even if the pin was changed behind this object.
  */
 void GPIOOutput::toggle() {
-    currentState_ = (currentState_ == PinState::HIGH) ? PinState::LOW : PinState::HIGH;
-    LL_GPIO_TogglePin(port_, getLLPin(pin_));
+    const uint32_t mask = getLLPin(pin_);
+    const uint32_t odr = port_->ODR;
+    if (odr & mask) {
+        port_->BSRR = mask << 16;
+        currentState_ = PinState::LOW;
+    } else {
+        port_->BSRR = mask;
+        currentState_ = PinState::HIGH;
+    }
 }
 
 /**
@@ -349,6 +401,19 @@ bool GPIOInput::isLow() const {
     return (read() == PinState::LOW);
 }
 
+/**
+ * @brief Read input level from a port snapshot
+ * 
+ * @param snapshot Snapshot taken with Port::sample()
+ * @return Pin state in the snapshot, or the live level for a snapshot of another port
+ */
+PinState GPIOInput::read(const PortSnapshot& snapshot) const {
+    if (snapshot.port != port_) {
+        return read();
+    }
+    return snapshot.get(pin_);
+}
+
 //=============================================================================
 // GPIOEXTI Implementation
 //=============================================================================
@@ -367,12 +432,12 @@ bool GPIOInput::isLow() const {
 GPIOEXTI::GPIOEXTI(GPIO_TypeDef* port, uint32_t pin, 
                    EXTITrigger trigger, PinPull pull)
     : GPIOInput(port, pin, pull), trigger_(trigger), 
-      callback_(nullptr), interruptEnabled_(false) 
+      interruptEnabled_(false) 
 {
     config_.trigger = trigger;
-    // Register this instance in the static registry
+    // Register this instance in the dispatch table
     if (pin < 16) {
-        extiRegistry[pin] = this;
+        extiTable[pin].owner = this;
     }
     configureEXTI();
 }
@@ -387,11 +452,11 @@ GPIOEXTI::GPIOEXTI(GPIO_TypeDef* port, uint32_t pin,
  */
 GPIOEXTI::GPIOEXTI(const PinConfig& config) 
     : GPIOInput(config), trigger_(config.trigger), 
-      callback_(nullptr), interruptEnabled_(false) 
+      interruptEnabled_(false) 
 {
-    // Register this instance in the static registry
+    // Register this instance in the dispatch table
     if (pin_ < 16) {
-        extiRegistry[pin_] = this;
+        extiTable[pin_].owner = this;
     }
     configureEXTI();
 }
@@ -404,9 +469,10 @@ GPIOEXTI::GPIOEXTI(const PinConfig& config)
  */
 GPIOEXTI::~GPIOEXTI() 
 {
-    if (pin_ < 16 && extiRegistry[pin_] == this) {
+    if (pin_ < 16 && extiTable[pin_].owner == this) {
         disableInterrupt();
-        extiRegistry[pin_] = nullptr;
+        setCallback(nullptr);
+        extiTable[pin_].owner = nullptr;
     }
 }
 
@@ -429,8 +495,10 @@ bool GPIOEXTI::isValidForMode() const {
  * @note SYSCFG clock must be enabled for port connection
  */
 void GPIOEXTI::configureEXTI() {
-    // Enable SYSCFG clock for EXTI configuration
-    LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_SYSCFG);
+    // Enable SYSCFG clock for EXTI configuration (once, not per EXTI pin)
+    if (!LL_APB2_GRP1_IsEnabledClock(LL_APB2_GRP1_PERIPH_SYSCFG)) {
+        LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_SYSCFG);
+    }
     
     // Configure EXTI line
     LL_EXTI_InitTypeDef EXTI_InitStruct = {};
@@ -525,38 +593,105 @@ void GPIOEXTI::disableInterrupt() {
 /**
  * @brief Set interrupt callback function
  * 
- * Registers a callback function to be executed when interrupt occurs.
+ * Registers a callback and its context in the dispatch table.
  * Callback should be lightweight and avoid blocking operations.
  * 
  * @param callback Function to call on interrupt (nullptr to clear)
+ * @param context Pointer passed to the callback
  * @warning Callback executes in interrupt context - keep it fast!
  */
-void GPIOEXTI::setCallback(std::function<void()> callback) {
-    callback_ = callback;
+void GPIOEXTI::setCallback(InterruptCallback callback, void* context) {
+    if (pin_ >= 16 || extiTable[pin_].owner != this) {
+        return; // Line was taken over by another instance
+    }
+    
+    // Never let the interrupt see the new callback with the old context
+    ExtiSlot& slot = extiTable[pin_];
+    slot.callback = ignoreInterrupt;
+    slot.context = context;
+    slot.callback = (callback != nullptr) ? callback : ignoreInterrupt;
+}
+
+/**
+ * @brief Change the trigger edges of this pin's EXTI line
+ *
+ * Only the edge selection registers are written; the interrupt mask is
+ * left as it is, so a line its owner has masked stays masked.
+ *
+ * @param trigger New trigger condition
+ */
+void GPIOEXTI::setTrigger(EXTITrigger trigger) {
+    const uint32_t line = getEXTILine(pin_);
+    trigger_ = trigger;
+    config_.trigger = trigger;
+
+    if (trigger == EXTITrigger::FALLING) {
+        LL_EXTI_DisableRisingTrig_0_31(line);
+    } else {
+        LL_EXTI_EnableRisingTrig_0_31(line);
+    }
+    if (trigger == EXTITrigger::RISING) {
+        LL_EXTI_DisableFallingTrig_0_31(line);
+    } else {
+        LL_EXTI_EnableFallingTrig_0_31(line);
+    }
+}
+
+/**
+ * @brief Check the EXTI pending flag of this pin
+ * @return true if an edge is pending
+ */
+bool GPIOEXTI::isInterruptPending() const {
+    return LL_EXTI_IsActiveFlag_0_31(getEXTILine(pin_)) != 0U;
+}
+
+/**
+ * @brief Clear the EXTI pending flag of this pin
+ */
+void GPIOEXTI::clearInterruptFlag() {
+    LL_EXTI_ClearFlag_0_31(getEXTILine(pin_));
 }
 
 /**
  * @brief Static interrupt handler for all EXTI pins
- * 
+ *
  * Central interrupt handler that dispatches to individual pin callbacks.
  * This method should be called from your EXTI interrupt service routines.
  * 
  * @param pin Pin number (0-15) that triggered the interrupt
- * @note Call this from your EXTIx_IRQHandler functions
+ * @note Call this from your EXTIx_IRQHandler functions after clearing the pending flag
  */
 void GPIOEXTI::handleInterrupt(uint32_t pin) {
     if (pin >= 16) return; // Invalid pin number
     
-    uint32_t extiLine = (1U << pin);
-    if (LL_EXTI_IsActiveFlag_0_31(extiLine)) {
-        LL_EXTI_ClearFlag_0_31(extiLine);
-        
-        // Find the registered GPIOEXTI instance for this pin and call its callback
-        GPIOEXTI* instance = extiRegistry[pin];
-        if (instance && instance->callback_) {
-            instance->callback_();
-        }
+    // The EXTIx_IRQHandler vector has already cleared the pending flag
+    const ExtiSlot& slot = extiTable[pin];
+    slot.callback(slot.context);
+}
+
+/**
+ * @brief Dispatch all pending lines of a shared EXTI vector
+ * 
+ * Masked lines are left pending: their owner has switched them off for a
+ * while (SoftUart during a frame) and clears the flag itself.
+ * 
+ * @param lineMask Lines served by the calling vector
+ */
+void GPIOEXTI::handleLines(uint32_t lineMask) {
+    uint32_t pending = EXTI->PR1 & EXTI->IMR1 & lineMask & 0xFFFFU;
+    if (pending == 0U) {
+        return;
     }
+    
+    // One write clears every line handled below
+    EXTI->PR1 = pending;
+    
+    do {
+        const uint32_t line = static_cast<uint32_t>(std::countr_zero(pending));
+        pending &= pending - 1U;
+        const ExtiSlot& slot = extiTable[line];
+        slot.callback(slot.context);
+    } while (pending != 0U);
 }
 
 /**
@@ -572,5 +707,42 @@ uint32_t GPIOEXTI::getEXTILine(uint32_t pin) const {
     return (1U << pin);
 }
 
+//=============================================================================
+// Port Implementation
+//=============================================================================
+
+/**
+ * @brief Configure a group of pins in one call
+ * 
+ * LL_GPIO_Init accepts a pin mask, so all pins of the group get the same
+ * mode, pull, speed and output type.
+ * 
+ * @param mask Pins to configure (bit n = pin n)
+ * @param mode Pin mode
+ * @param pull Pull resistor configuration
+ * @param speed Output speed
+ * @param outputType Output driver type
+ * @param alternate Alternate function number (ALTERNATE mode only)
+ */
+void Port::configure(uint32_t mask, PinMode mode, PinPull pull,
+                     PinSpeed speed, PinOutputType outputType, uint32_t alternate) const {
+    enableGpioClock(port_);
+
+    LL_GPIO_InitTypeDef GPIO_InitStruct = {};
+    GPIO_InitStruct.Pin = mask & 0xFFFFU;
+    GPIO_InitStruct.Mode = static_cast<uint32_t>(mode);
+    GPIO_InitStruct.Speed = static_cast<uint32_t>(speed);
+    GPIO_InitStruct.OutputType = static_cast<uint32_t>(outputType);
+    GPIO_InitStruct.Pull = static_cast<uint32_t>(pull);
+    GPIO_InitStruct.Alternate = alternate;
+
+    LL_GPIO_Init(port_, &GPIO_InitStruct);
+}
+
 }
 
+extern "C" {
+    void GPIO_EXTI_HandleLines(uint32_t lineMask) {
+        GPIO::GPIOEXTI::handleLines(lineMask);
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file    gpio_board.cpp
+ * @brief   Compile-time board pin map, applied as per-port register images
+ * @author  MootSeeker
+ *
+ * @see gpio_board.h for the apply order and the register accesses per port
+ */
+
+#include "gpio_board.h"
+
+namespace GPIO {
+
+    // Slot n (register address order) is AHB2ENR bit n: GPIOA = bit 0 .. GPIOH = bit 7
+    static_assert(LL_AHB2_GRP1_PERIPH_GPIOA == (1U << 0) && LL_AHB2_GRP1_PERIPH_GPIOH == (1U << 7),
+                  "GPIO clock bits must follow the port order");
+
+    static GPIO_TypeDef* portOfSlot(uint8_t slot) noexcept {
+        return reinterpret_cast<GPIO_TypeDef*>(GPIOA_BASE + slot * (GPIOB_BASE - GPIOA_BASE));
+    }
+
+    /// Two register bits per pin of 'pins' (MODER, OSPEEDR, PUPDR)
+    static constexpr uint32_t spread2(uint16_t pins) noexcept {
+        uint32_t mask = 0;
+        for (uint8_t pin = 0; pin < 16; pin++) {
+            if ((pins & (1U << pin)) != 0) {
+                mask |= 3U << (pin * 2U);
+            }
+        }
+        return mask;
+    }
+
+    /// Four register bits per pin of an 8-pin half (AFRL, AFRH)
+    static constexpr uint32_t spread4(uint8_t pins) noexcept {
+        uint32_t mask = 0;
+        for (uint8_t pin = 0; pin < 8; pin++) {
+            if ((pins & (1U << pin)) != 0) {
+                mask |= 0xFU << (pin * 4U);
+            }
+        }
+        return mask;
+    }
+
+    void applyPortImages(const PortImage* images, BoardApply mode) noexcept {
+        uint32_t clocks = 0;
+        for (uint8_t slot = 0; slot < PORT_SLOTS; slot++) {
+            if (images[slot].pins != 0) {
+                clocks |= LL_AHB2_GRP1_PERIPH_GPIOA << slot;
+            }
+        }
+        if (clocks == 0) {
+            return;
+        }
+        // One read-modify-write (and read-back) for all ports of the board
+        LL_AHB2_GRP1_EnableClock(clocks);
+
+        for (uint8_t slot = 0; slot < PORT_SLOTS; slot++) {
+            const PortImage& image = images[slot];
+            if (image.pins == 0) {
+                continue;
+            }
+            GPIO_TypeDef* port = portOfSlot(slot);
+
+            // Output levels first and MODER last: outputs start at their level
+            WRITE_REG(port->BSRR, image.bsrr);
+            if (mode == BoardApply::RESET_UNLISTED) {
+                WRITE_REG(port->OTYPER, image.otyper);
+                WRITE_REG(port->OSPEEDR, image.ospeedr);
+                WRITE_REG(port->PUPDR, image.pupdr);
+                WRITE_REG(port->AFR[0], image.afrl);
+                WRITE_REG(port->AFR[1], image.afrh);
+                WRITE_REG(port->MODER, image.moder);
+            } else {
+                const uint32_t mask2 = spread2(image.pins);
+                const uint32_t maskL = spread4(static_cast<uint8_t>(image.pins));
+                const uint32_t maskH = spread4(static_cast<uint8_t>(image.pins >> 8));
+                MODIFY_REG(port->OTYPER, image.pins, image.otyper & image.pins);
+                MODIFY_REG(port->OSPEEDR, mask2, image.ospeedr & mask2);
+                MODIFY_REG(port->PUPDR, mask2, image.pupdr & mask2);
+                MODIFY_REG(port->AFR[0], maskL, image.afrl & maskL);
+                MODIFY_REG(port->AFR[1], maskH, image.afrh & maskH);
+                MODIFY_REG(port->MODER, mask2, image.moder & mask2);
+            }
+        }
+    }
+
+} // namespace GPIO
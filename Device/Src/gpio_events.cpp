@@ -0,0 +1,115 @@
+/**
+ * @file    gpio_events.cpp
+ * @brief   Timestamped EXTI event queue with deferred handler execution
+ * @author  MootSeeker
+ *
+ * @see gpio_events.h for the ring protocol and the flood test figures
+ */
+
+#include "gpio_events.h"
+
+namespace GPIO {
+
+    EventQueue::EventQueue() noexcept
+        : events(), head(0), tail(0), bindings(),
+          recordedCount(0), lostCount(0), maxRecordCycles(0), maxDepth(0) {
+        for (uint8_t line = 0; line < 16; line++) {
+            bindings[line].queue = this;
+            bindings[line].line = line;
+        }
+    }
+
+    EventQueue::~EventQueue() {
+        for (Binding& binding : bindings) {
+            if (binding.pin != nullptr) {
+                detach(*binding.pin);
+            }
+        }
+    }
+
+    bool EventQueue::attach(GPIOEXTI& pin, EventHandler handler, void* context) noexcept {
+        const uint32_t line = pin.getPin();
+        if (line >= 16) {
+            return false;
+        }
+
+        // Free-running; other users of CYCCNT are not disturbed
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        Binding& binding = bindings[line];
+        binding.pin = &pin;
+        binding.port = pin.getPort();
+        binding.mask = 1U << line;
+        binding.handler = handler;
+        binding.context = context;
+        pin.setCallback(&EventQueue::record, &binding);
+        return true;
+    }
+
+    void EventQueue::detach(GPIOEXTI& pin) noexcept {
+        const uint32_t line = pin.getPin();
+        if (line >= 16 || bindings[line].pin != &pin) {
+            return;
+        }
+        pin.setCallback(nullptr);
+        bindings[line].handler = nullptr;
+        bindings[line].pin = nullptr;
+    }
+
+    /**
+     * @brief EXTI callback: timestamp first, then one ring slot
+     */
+    void EventQueue::record(void* context) {
+        const uint32_t start = DWT->CYCCNT;
+        const Binding& binding = *static_cast<const Binding*>(context);
+        EventQueue& queue = *binding.queue;
+
+        const uint16_t slot = queue.head;
+        const uint16_t next = (slot + 1U) & MASK;
+        if (next == queue.tail) {
+            queue.lostCount = queue.lostCount + 1;
+        } else {
+            PinEvent& event = queue.events[slot];
+            event.timestamp = start;
+            event.line = binding.line;
+            event.edge = (binding.port->IDR & binding.mask) ? Edge::RISING : Edge::FALLING;
+            queue.head = next;
+            queue.recordedCount = queue.recordedCount + 1;
+        }
+
+        const uint32_t cycles = DWT->CYCCNT - start;
+        if (cycles > queue.maxRecordCycles) {
+            queue.maxRecordCycles = cycles;
+        }
+    }
+
+    uint16_t EventQueue::dispatch(uint16_t maxEvents) noexcept {
+        const uint16_t depth = getPendingCount();
+        if (depth > maxDepth) {
+            maxDepth = depth;
+        }
+
+        uint16_t count = 0;
+        while (count < maxEvents && tail != head) {
+            // Copy out before the slot is handed back to the recorder
+            const PinEvent event = events[tail];
+            tail = (tail + 1U) & MASK;
+            count++;
+
+            const Binding& binding = bindings[event.line];
+            if (binding.handler != nullptr) {
+                binding.handler(binding.context, event);
+            }
+        }
+        return count;
+    }
+
+    void EventQueue::resetStatistics() noexcept {
+        recordedCount = 0;
+        lostCount = 0;
+        maxRecordCycles = 0;
+        maxDepth = 0;
+    }
+
+} // namespace GPIO
@@ -0,0 +1,205 @@
+/**
+ * @file    gpio_wave.cpp
+ * @brief   Timer-paced DMA playback of BSRR words to a GPIO port
+ * @author  MootSeeker
+ *
+ * @see gpio_wave.h for the modes and the refill deadline
+ */
+
+#include "gpio_wave.h"
+#include "dma_address.h"
+
+namespace GPIO {
+
+    static TIM_TypeDef* const WAVE_TIMER = TIM15;
+    static DMA_TypeDef* const WAVE_DMA = DMA1;
+    static constexpr uint32_t WAVE_CHANNEL = LL_DMA_CHANNEL_5;
+    static constexpr uint32_t WAVE_REQUEST = LL_DMA_REQUEST_7;     // TIM15_UP on DMA1 Channel 5
+    static constexpr IRQn_Type WAVE_DMA_IRQN = DMA1_Channel5_IRQn;
+
+    /// Player that owns TIM15 and the DMA channel, if any
+    static PatternPlayer* volatile activePlayer = nullptr;
+
+    PatternPlayer::PatternPlayer(GPIO_TypeDef* port) noexcept
+        : port(port), mode(PlayMode::ONE_SHOT), ring(nullptr), halfCount(0), refill(nullptr),
+          done(nullptr), context(nullptr), playing(false), refillCount(0), lateRefillCount(0) {}
+
+    PatternPlayer::~PatternPlayer() {
+        stop();
+    }
+
+    bool PatternPlayer::canStart() const noexcept {
+        if (activePlayer == this) {
+            return true;
+        }
+        // Channel 5 is also the USART_1 RX channel of the DMA bridge; an enabled one is in use
+        return activePlayer == nullptr && !LL_DMA_IsEnabledChannel(WAVE_DMA, WAVE_CHANNEL);
+    }
+
+    bool PatternPlayer::play(const uint32_t* words, uint16_t count, PlayMode playMode, uint32_t rateHz,
+                             PatternDone doneCallback, void* doneContext) noexcept {
+        if (playMode == PlayMode::STREAM || words == nullptr || count == 0 || !canStart()) {
+            return false;
+        }
+        done = doneCallback;
+        context = doneContext;
+        return start(words, count, playMode, rateHz);
+    }
+
+    bool PatternPlayer::stream(uint32_t* buffer, uint16_t count, uint32_t rateHz,
+                               PatternRefill refillCallback, void* refillContext) noexcept {
+        if (buffer == nullptr || refillCallback == nullptr || count < 2 || (count & 1U) != 0 || !canStart()) {
+            return false;
+        }
+        ring = buffer;
+        halfCount = count / 2U;
+        refill = refillCallback;
+        context = refillContext;
+        refillCount = 0;
+        lateRefillCount = 0;
+
+        // Both halves hold data before the first word goes out
+        refill(context, ring, halfCount);
+        refill(context, ring + halfCount, halfCount);
+        return start(buffer, count, PlayMode::STREAM, rateHz);
+    }
+
+    bool PatternPlayer::start(const uint32_t* words, uint16_t count, PlayMode playMode, uint32_t rateHz) noexcept {
+        if (port == nullptr || rateHz == 0) {
+            return false;
+        }
+        const uint32_t ticks = SystemCoreClock / rateHz;    // TIM15 clock = HCLK (APB2 divider 1)
+        if (ticks < MIN_PERIOD_TICKS) {
+            return false;
+        }
+        if (!canStart()) {
+            return false;
+        }
+        stop();
+        mode = playMode;
+        activePlayer = this;
+
+        LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM15);
+        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+
+        // Memory -> BSRR, one word per request
+        LL_DMA_DisableChannel(WAVE_DMA, WAVE_CHANNEL);
+        LL_DMA_ConfigTransfer(WAVE_DMA, WAVE_CHANNEL,
+                              LL_DMA_DIRECTION_MEMORY_TO_PERIPH |
+                              (playMode == PlayMode::ONE_SHOT ? LL_DMA_MODE_NORMAL : LL_DMA_MODE_CIRCULAR) |
+                              LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                              LL_DMA_PDATAALIGN_WORD | LL_DMA_MDATAALIGN_WORD | LL_DMA_PRIORITY_VERYHIGH);
+        LL_DMA_SetPeriphRequest(WAVE_DMA, WAVE_CHANNEL, WAVE_REQUEST);
+        LL_DMA_SetPeriphAddress(WAVE_DMA, WAVE_CHANNEL, dmaAddress(&port->BSRR));
+        LL_DMA_SetMemoryAddress(WAVE_DMA, WAVE_CHANNEL, dmaAddress(words));
+        LL_DMA_SetDataLength(WAVE_DMA, WAVE_CHANNEL, count);
+        WRITE_REG(WAVE_DMA->IFCR, DMA_IFCR_CGIF5);
+
+        // LOOP runs without interrupts; ONE_SHOT needs the end, STREAM both halves
+        if (playMode == PlayMode::ONE_SHOT) {
+            LL_DMA_EnableIT_TC(WAVE_DMA, WAVE_CHANNEL);
+        } else if (playMode == PlayMode::STREAM) {
+            LL_DMA_EnableIT_HT(WAVE_DMA, WAVE_CHANNEL);
+            LL_DMA_EnableIT_TC(WAVE_DMA, WAVE_CHANNEL);
+        }
+        if (playMode != PlayMode::LOOP && NVIC_GetEnableIRQ(WAVE_DMA_IRQN) == 0U) {
+            // The vector is shared with the bridge: keep the priority it was given
+            NVIC_SetPriority(WAVE_DMA_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+            NVIC_ClearPendingIRQ(WAVE_DMA_IRQN);
+            NVIC_EnableIRQ(WAVE_DMA_IRQN);
+        }
+        LL_DMA_EnableChannel(WAVE_DMA, WAVE_CHANNEL);
+
+        // Update event every 'ticks' timer clocks; the prescaler only for slow rates
+        const uint32_t prescaler = (ticks - 1U) / 65536U;
+        LL_TIM_SetPrescaler(WAVE_TIMER, prescaler);
+        LL_TIM_SetAutoReload(WAVE_TIMER, (ticks / (prescaler + 1U)) - 1U);
+        LL_TIM_SetCounter(WAVE_TIMER, 0);
+        LL_TIM_GenerateEvent_UPDATE(WAVE_TIMER);    // Load the prescaler (no DMA request yet)
+        LL_TIM_ClearFlag_UPDATE(WAVE_TIMER);
+
+        playing = true;
+        LL_TIM_EnableDMAReq_UPDATE(WAVE_TIMER);
+        LL_TIM_GenerateEvent_UPDATE(WAVE_TIMER);    // Word 0 now, word k at k periods
+        LL_TIM_EnableCounter(WAVE_TIMER);
+        return true;
+    }
+
+    void PatternPlayer::stop() noexcept {
+        if (activePlayer != this) {
+            return;
+        }
+        LL_TIM_DisableCounter(WAVE_TIMER);
+        LL_TIM_DisableDMAReq_UPDATE(WAVE_TIMER);
+
+        // Only a channel that still writes this port's BSRR is the player's to stop
+        if (LL_DMA_GetPeriphAddress(WAVE_DMA, WAVE_CHANNEL) == dmaAddress(&port->BSRR)) {
+            LL_DMA_DisableChannel(WAVE_DMA, WAVE_CHANNEL);
+            LL_DMA_DisableIT_HT(WAVE_DMA, WAVE_CHANNEL);
+            LL_DMA_DisableIT_TC(WAVE_DMA, WAVE_CHANNEL);
+            WRITE_REG(WAVE_DMA->IFCR, DMA_IFCR_CGIF5);
+        }
+        playing = false;
+        activePlayer = nullptr;
+    }
+
+    void PatternPlayer::handleDmaInterrupt(uint32_t flags) noexcept {
+        if (mode == PlayMode::ONE_SHOT) {
+            if ((flags & DMA_ISR_TCIF5) != 0U) {
+                stop();
+                if (done != nullptr) {
+                    done(context);
+                }
+            }
+            return;
+        }
+        if (mode != PlayMode::STREAM) {
+            return;
+        }
+
+        // Both flags at once: DMA finished a whole half while the other was still waiting
+        if ((flags & (DMA_ISR_HTIF5 | DMA_ISR_TCIF5)) == (DMA_ISR_HTIF5 | DMA_ISR_TCIF5)) {
+            lateRefillCount = lateRefillCount + 1;
+        }
+
+        const uint16_t count = halfCount * 2U;
+        if ((flags & DMA_ISR_HTIF5) != 0U) {
+            refill(context, ring, halfCount);
+            refillCount = refillCount + 1;
+
+            // DMA already back inside the first half: part of it went out stale
+            const uint32_t remaining = LL_DMA_GetDataLength(WAVE_DMA, WAVE_CHANNEL);
+            if (remaining > halfCount && remaining < count) {
+                lateRefillCount = lateRefillCount + 1;
+            }
+        }
+        if ((flags & DMA_ISR_TCIF5) != 0U) {
+            refill(context, ring + halfCount, halfCount);
+            refillCount = refillCount + 1;
+
+            const uint32_t remaining = LL_DMA_GetDataLength(WAVE_DMA, WAVE_CHANNEL);
+            if (remaining < halfCount) {
+                lateRefillCount = lateRefillCount + 1;
+            }
+        }
+    }
+
+} // namespace GPIO
+
+extern "C" {
+    /**
+     * @brief DMA1 Channel 5 interrupt: only the player's flags, and only while it plays
+     *
+     * The channel is shared with the USART bridge, whose handler runs after
+     * this one and sees no flags of a playing pattern.
+     */
+    void GPIO_HandlePatternDmaInterrupt(void) {
+        GPIO::PatternPlayer* player = GPIO::activePlayer;
+        if (player == nullptr) {
+            return;
+        }
+        const uint32_t flags = READ_REG(DMA1->ISR) & (DMA_ISR_GIF5 | DMA_ISR_TCIF5 | DMA_ISR_HTIF5 | DMA_ISR_TEIF5);
+        WRITE_REG(DMA1->IFCR, flags);   // IFCR bits share the ISR positions
+        player->handleDmaInterrupt(flags);
+    }
+}
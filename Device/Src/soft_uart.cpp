@@ -0,0 +1,436 @@
+/**
+ * @file    soft_uart.cpp
+ * @brief   Timer-driven software UART channels on GPIO pins
+ * @author  MootSeeker
+ *
+ * Only the TIM2 interrupt writes compare registers; the edge interrupt and
+ * the send functions update a channel's state and pend TIM2, which then
+ * services and re-arms every channel (see soft_uart.h for the interrupt counts).
+ */
+
+#include "soft_uart.h"
+
+namespace USART {
+
+    static TIM_TypeDef* const SOFT_UART_TIMER = TIM2;
+    static constexpr IRQn_Type SOFT_UART_TIMER_IRQN = TIM2_IRQn;
+    static constexpr uint32_t SOFT_UART_TIMER_PRIORITY = 1;   ///< Below the RX edge interrupts (0)
+
+    static constexpr uint32_t COMPARE_FLAGS = TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF;
+
+    /// Events due this close to now are handled in the same interrupt (2 us at 32 MHz)
+    static constexpr int32_t BATCH_WINDOW_CYCLES = 64;
+
+    /// RX samples are scheduled ahead of the bit centre by the typical timer interrupt and batching delay
+    static constexpr uint32_t RX_SAMPLE_LEAD_CYCLES = 64;
+
+    /// Start edge to timestamp in onStartEdge(): EXTI entry and GPIOEXTI dispatch
+    static constexpr uint32_t EXTI_LATENCY_CYCLES = 40;
+
+    /// Time from queueing the first byte to its start bit
+    static constexpr uint32_t TX_START_DELAY_CYCLES = 128;
+
+    /// Running channels, indexed by TIM2 compare channel
+    static SoftUart* g_softUartChannels[SOFT_UART_MAX_CHANNELS] = {nullptr};
+
+    static volatile uint32_t* compareRegister(uint8_t channel) noexcept {
+        // CCR1..CCR4 are consecutive registers
+        return &SOFT_UART_TIMER->CCR1 + channel;
+    }
+
+    static IRQn_Type extiIrqn(uint32_t pin) noexcept {
+        if (pin <= 4U) {
+            return static_cast<IRQn_Type>(EXTI0_IRQn + static_cast<int32_t>(pin));
+        }
+        return (pin <= 9U) ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+    }
+
+    /// EXTI0..EXTI4 have a vector of their own; lines 5..9 and 10..15 share one
+    static bool ownsExtiVector(uint32_t pin) noexcept {
+        return pin <= 4U;
+    }
+
+    static uint32_t preemptPriority(IRQn_Type irqn) noexcept {
+        uint32_t preempt = 0;
+        uint32_t sub = 0;
+        NVIC_DecodePriority(NVIC_GetPriority(irqn), NVIC_GetPriorityGrouping(), &preempt, &sub);
+        return preempt;
+    }
+
+    static void startTimer() noexcept {
+        if (LL_TIM_IsEnabledCounter(SOFT_UART_TIMER)) {
+            return;
+        }
+        // Free-running 32-bit counter at the core clock
+        LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
+        LL_TIM_SetPrescaler(SOFT_UART_TIMER, 0);
+        LL_TIM_SetAutoReload(SOFT_UART_TIMER, 0xFFFFFFFFU);
+        LL_TIM_GenerateEvent_UPDATE(SOFT_UART_TIMER);
+        SOFT_UART_TIMER->SR = 0;
+        SOFT_UART_TIMER->DIER = 0;
+
+        NVIC_SetPriority(SOFT_UART_TIMER_IRQN,
+                         NVIC_EncodePriority(NVIC_GetPriorityGrouping(), SOFT_UART_TIMER_PRIORITY, 0));
+        NVIC_EnableIRQ(SOFT_UART_TIMER_IRQN);
+        LL_TIM_EnableCounter(SOFT_UART_TIMER);
+    }
+
+    SoftUart::SoftUart(GPIO::GPIOOutput* tx, GPIO::GPIOEXTI* rx) noexcept
+        : txPin(tx), rxPin(rx), txPort(nullptr), txMask(0), rxPort(nullptr), rxMask(0),
+          channel(NO_CHANNEL), baudRate(0), bitCyclesQ8(0),
+          transmissionActive(false), txFrame(0), txBit(FRAME_BITS), txStart(0), txDue(0),
+          rxActive(false), rxBit(0), rxShift(0), rxStart(0), rxDue(0),
+          rxCallback(nullptr), rxCallbackContext(nullptr), rxOverflowCount(0), rxErrorCount(0) {
+    }
+
+    SoftUart::~SoftUart() {
+        deinitialize();
+    }
+
+    UsartStatus SoftUart::initialize(uint32_t baud) noexcept {
+        if (channel != NO_CHANNEL) {
+            deinitialize();
+        }
+        if (txPin == nullptr && rxPin == nullptr) {
+            return UsartStatus{UsartError::NULL_POINTER, 0};
+        }
+        if (baud < SOFT_UART_MIN_BAUD || baud > SOFT_UART_MAX_BAUD) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, baud};
+        }
+        // A shared EXTI vector also serves other pins, so its priority belongs to
+        // the application; it has to be enabled and preempt TIM2 already
+        if (rxPin != nullptr && !ownsExtiVector(rxPin->getPin())) {
+            const IRQn_Type irqn = extiIrqn(rxPin->getPin());
+            if (NVIC_GetEnableIRQ(irqn) == 0U || preemptPriority(irqn) >= SOFT_UART_TIMER_PRIORITY) {
+                return UsartStatus{UsartError::INVALID_PARAMETER, rxPin->getPin()};
+            }
+        }
+
+        uint8_t slot = 0;
+        while (slot < SOFT_UART_MAX_CHANNELS && g_softUartChannels[slot] != nullptr) {
+            slot++;
+        }
+        if (slot == SOFT_UART_MAX_CHANNELS) {
+            return UsartStatus{UsartError::BUSY, 0};
+        }
+
+        baudRate = baud;
+        bitCyclesQ8 = static_cast<uint32_t>((static_cast<uint64_t>(SystemCoreClock) << 8) / baud);
+        transmissionActive = false;
+        rxActive = false;
+        txBit = FRAME_BITS;
+
+        if (txPin != nullptr) {
+            txPort = txPin->getPort();
+            txMask = 1U << txPin->getPin();
+            txPin->set();   // Idle line is high
+        }
+
+        startTimer();
+        channel = slot;
+        g_softUartChannels[slot] = this;
+
+        if (rxPin != nullptr) {
+            rxPort = rxPin->getPort();
+            rxMask = 1U << rxPin->getPin();
+            rxPin->setTrigger(GPIO::EXTITrigger::FALLING);
+            rxPin->setCallback(&SoftUart::startEdgeCallback, this);
+            LL_EXTI_ClearFlag_0_31(rxMask);
+            LL_EXTI_EnableIT_0_31(rxMask);
+            if (ownsExtiVector(rxPin->getPin())) {
+                rxPin->enableInterrupt();
+                // Above TIM2, so the start bit timestamp does not wait for a batch
+                NVIC_SetPriority(extiIrqn(rxPin->getPin()), NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+            }
+        }
+        return UsartStatus{UsartError::OK, 0};
+    }
+
+    void SoftUart::deinitialize() noexcept {
+        if (channel == NO_CHANNEL) {
+            return;
+        }
+
+        if (rxPin != nullptr) {
+            // Only mask the line: the NVIC vector may be shared with other pins
+            LL_EXTI_DisableIT_0_31(rxMask);
+            rxPin->setCallback(nullptr);
+        }
+
+        NVIC_DisableIRQ(SOFT_UART_TIMER_IRQN);
+        SOFT_UART_TIMER->DIER &= ~(TIM_DIER_CC1IE << channel);
+        g_softUartChannels[channel] = nullptr;
+        channel = NO_CHANNEL;
+        transmissionActive = false;
+        rxActive = false;
+
+        bool running = false;
+        for (SoftUart* port : g_softUartChannels) {
+            running = running || (port != nullptr);
+        }
+        if (running) {
+            NVIC_EnableIRQ(SOFT_UART_TIMER_IRQN);
+        } else {
+            LL_TIM_DisableCounter(SOFT_UART_TIMER);
+        }
+
+        txBuffer.reset();
+        if (txPin != nullptr) {
+            txPin->set();
+        }
+    }
+
+    /**
+     * @brief Timer cycles from the start edge to the edge of a bit
+     */
+    uint32_t SoftUart::bitOffset(uint8_t bit) const noexcept {
+        return (bit * bitCyclesQ8 + 128U) >> 8;
+    }
+
+    /**
+     * @brief Timer cycles from the start edge to the centre of a bit
+     */
+    uint32_t SoftUart::bitCenter(uint8_t bit) const noexcept {
+        return ((2U * bit + 1U) * bitCyclesQ8 + 256U) >> 9;
+    }
+
+    bool SoftUart::sendByte(uint8_t data) noexcept {
+        if (channel == NO_CHANNEL || txPort == nullptr) {
+            return false;
+        }
+        bool success = txBuffer.put(data);
+        if (success && !transmissionActive) {
+            startTransmission();
+        }
+        return success;
+    }
+
+    uint16_t SoftUart::sendData(const uint8_t* data, uint16_t length) noexcept {
+        if (channel == NO_CHANNEL || txPort == nullptr || data == nullptr || length == 0) {
+            return 0;
+        }
+
+        uint16_t sent = 0;
+        while (sent < length && txBuffer.put(data[sent])) {
+            sent++;
+        }
+
+        if (sent > 0 && !transmissionActive) {
+            startTransmission();
+        }
+        return sent;
+    }
+
+    uint16_t SoftUart::sendString(const char* str) noexcept {
+        if (str == nullptr) {
+            return 0;
+        }
+        return sendData(reinterpret_cast<const uint8_t*>(str), static_cast<uint16_t>(strlen(str)));
+    }
+
+    uint16_t SoftUart::sendFormatted(const char* format, ...) noexcept {
+        if (channel == NO_CHANNEL || format == nullptr) {
+            return 0;
+        }
+
+        static constexpr uint16_t TEMP_BUFFER_SIZE = 128;
+        char buffer[TEMP_BUFFER_SIZE];
+
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, TEMP_BUFFER_SIZE, format, args);
+        va_end(args);
+
+        if (length > 0) {
+            uint16_t actualLength = (length < TEMP_BUFFER_SIZE) ? static_cast<uint16_t>(length)
+                                                                : (TEMP_BUFFER_SIZE - 1);
+            return sendData(reinterpret_cast<const uint8_t*>(buffer), actualLength);
+        }
+        return 0;
+    }
+
+    bool SoftUart::receiveByte(uint8_t& data) noexcept {
+        return rxBuffer.get(data);
+    }
+
+    uint16_t SoftUart::receiveData(uint8_t* data, uint16_t maxLength) noexcept {
+        if (data == nullptr) {
+            return 0;
+        }
+
+        uint16_t received = 0;
+        while (received < maxLength && rxBuffer.get(data[received])) {
+            received++;
+        }
+        return received;
+    }
+
+    void SoftUart::setRxCallback(RxByteCallback callback, void* context) noexcept {
+        // Clear the callback first so the ISR never sees a new callback with a stale context
+        rxCallback = nullptr;
+        rxCallbackContext = context;
+        rxCallback = callback;
+    }
+
+    /**
+     * @brief Schedule the start bit of the first queued byte
+     *
+     * The frame end event loads the byte, so the first byte goes through the
+     * same path as every following one.
+     */
+    void SoftUart::startTransmission() noexcept {
+        if (transmissionActive) {
+            return;
+        }
+        txBit = FRAME_BITS;
+        txDue = SOFT_UART_TIMER->CNT + TX_START_DELAY_CYCLES;
+        transmissionActive = true;
+        NVIC_SetPendingIRQ(SOFT_UART_TIMER_IRQN);
+    }
+
+    /**
+     * @brief Falling edge on RX: timestamp the start bit and mask the line for the frame
+     */
+    void SoftUart::onStartEdge() noexcept {
+        const uint32_t now = SOFT_UART_TIMER->CNT;
+        if (rxActive || (rxPort->IDR & rxMask) != 0U) {
+            return;   // Glitch shorter than the interrupt latency
+        }
+
+        LL_EXTI_DisableIT_0_31(rxMask);
+        rxStart = now - EXTI_LATENCY_CYCLES;
+        rxBit = 0;
+        rxShift = 0;
+        rxDue = rxStart + bitCenter(1) - RX_SAMPLE_LEAD_CYCLES;
+        rxActive = true;
+        NVIC_SetPendingIRQ(SOFT_UART_TIMER_IRQN);
+    }
+
+    void SoftUart::startEdgeCallback(void* context) {
+        static_cast<SoftUart*>(context)->onStartEdge();
+    }
+
+    /**
+     * @brief Drive the next TX level, then skip ahead to the next level change
+     */
+    void SoftUart::handleTxEvent() noexcept {
+        if (txBit == FRAME_BITS) {
+            uint8_t data;
+            if (!txBuffer.get(data)) {
+                transmissionActive = false;
+                return;
+            }
+            // Back-to-back frames: this start bit begins where the last stop bit ended
+            txStart = txDue;
+            txFrame = static_cast<uint16_t>((static_cast<uint16_t>(data) << 1) | (1U << (FRAME_BITS - 1U)));
+            txBit = 0;
+        }
+
+        const uint32_t level = (txFrame >> txBit) & 1U;
+        txPort->BSRR = (level != 0U) ? txMask : (txMask << 16);
+
+        uint8_t next = static_cast<uint8_t>(txBit + 1U);
+        while (next < FRAME_BITS && ((txFrame >> next) & 1U) == level) {
+            next++;
+        }
+        txBit = next;
+        txDue = txStart + bitOffset(next);
+    }
+
+    void SoftUart::handleRxEvent() noexcept {
+        const bool high = (rxPort->IDR & rxMask) != 0U;
+
+        if (rxBit < 8U) {
+            rxShift = static_cast<uint8_t>((rxShift >> 1) | (high ? 0x80U : 0U));
+            rxBit++;
+            rxDue = rxStart + bitCenter(static_cast<uint8_t>(rxBit + 1U)) - RX_SAMPLE_LEAD_CYCLES;
+            return;
+        }
+
+        rxActive = false;
+        if (!high) {
+            rxErrorCount = rxErrorCount + 1;
+        } else {
+            RxByteCallback callback = rxCallback;
+            if (callback != nullptr) {
+                callback(rxCallbackContext, rxShift);
+            } else if (!rxBuffer.put(rxShift)) {
+                rxOverflowCount = rxOverflowCount + 1;
+            }
+        }
+
+        // Edges inside the frame have set the pending flag
+        LL_EXTI_ClearFlag_0_31(rxMask);
+        LL_EXTI_EnableIT_0_31(rxMask);
+    }
+
+    /**
+     * @brief Handle this channel's events due within the batch window
+     * @return true if anything was handled
+     */
+    bool SoftUart::serviceDue(uint32_t now) noexcept {
+        bool handled = false;
+        if (transmissionActive && static_cast<int32_t>(txDue - now) <= BATCH_WINDOW_CYCLES) {
+            handleTxEvent();
+            handled = true;
+        }
+        if (rxActive && static_cast<int32_t>(rxDue - now) <= BATCH_WINDOW_CYCLES) {
+            handleRxEvent();
+            handled = true;
+        }
+        return handled;
+    }
+
+    /**
+     * @brief Program the compare channel with the earlier of the TX and RX events
+     */
+    void SoftUart::armCompare() noexcept {
+        const bool tx = transmissionActive;
+        const bool rx = rxActive;
+        if (!tx && !rx) {
+            SOFT_UART_TIMER->DIER &= ~(TIM_DIER_CC1IE << channel);
+            return;
+        }
+
+        uint32_t due = tx ? txDue : rxDue;
+        if (tx && rx && static_cast<int32_t>(rxDue - txDue) < 0) {
+            due = rxDue;
+        }
+        *compareRegister(channel) = due;
+        SOFT_UART_TIMER->DIER |= (TIM_DIER_CC1IE << channel);
+
+        // The counter may already have passed it while the other channels were armed
+        if (static_cast<int32_t>(due - SOFT_UART_TIMER->CNT) <= 0) {
+            NVIC_SetPendingIRQ(SOFT_UART_TIMER_IRQN);
+        }
+    }
+
+    void SoftUart::handleTimerInterrupt() noexcept {
+        // Batch: keep going while any channel has an event inside the window
+        bool handled = true;
+        while (handled) {
+            const uint32_t now = SOFT_UART_TIMER->CNT;
+            handled = false;
+            for (SoftUart* port : g_softUartChannels) {
+                if (port != nullptr && port->serviceDue(now)) {
+                    handled = true;
+                }
+            }
+        }
+
+        // Every match so far has been served; the compares armed below are new
+        SOFT_UART_TIMER->SR = ~COMPARE_FLAGS;
+        for (SoftUart* port : g_softUartChannels) {
+            if (port != nullptr) {
+                port->armCompare();
+            }
+        }
+    }
+
+} // namespace USART
+
+extern "C" {
+    void USART_HandleSoftUartTimerInterrupt(void) {
+        USART::SoftUart::handleTimerInterrupt();
+    }
+}
@@ -52,9 +52,33 @@ namespace USART
         return UsartStatus{UsartError::OK, 0};
     }
 
+    /**
+     * @brief Timer used to emulate the receiver timeout on LPUART_1
+     * 
+     * LPUART has no RTOR register. TIM7 (basic timer, 1 us tick) is run in
+     * one-pulse mode and restarted on every received byte instead.
+     */
+    static TIM_TypeDef* const RX_TIMEOUT_TIMER = TIM7;
+    static constexpr IRQn_Type RX_TIMEOUT_TIMER_IRQN = TIM7_IRQn;
+
+    /**
+     * @brief Receive error flags cleared together in the ISR
+     */
+    static constexpr uint32_t RX_ERROR_FLAGS = USART_ISR_ORE | USART_ISR_FE | USART_ISR_NE | USART_ISR_PE;
+    static constexpr uint32_t RX_ERROR_CLEAR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NECF | USART_ICR_PECF;
+
     template<uint16_t BUFFER_SIZE>
     UsartDriver<BUFFER_SIZE>::UsartDriver(PeripheralType peripheral) noexcept
-        : peripheralType(peripheral), usartInstance(nullptr), transmissionActive(false), isInitialized(false) {
+        : peripheralType(peripheral), usartInstance(nullptr), transmissionActive(false), initialized(false),
+          rxCallback(nullptr), rxCallbackContext(nullptr), rxTimeoutCallback(nullptr), rxTimeoutContext(nullptr),
+          rxTimeoutUsesTimer(false), rs485Enabled(false), rs485SuppressEcho(false),
+          flowControl(FlowControl::NONE), rxHighWatermark(0), rxLowWatermark(0),
+          rxPaused(false), txPaused(false), pendingControlChar(0),
+          rxOverflowCount(0), rxErrorCount(0),
+          txCompleteCallback(nullptr), txCompleteContext(nullptr),
+          dmaMode(false), idleCallback(nullptr), idleContext(nullptr),
+          pendingAddress(0), addressMute(false),
+          breakCallback(nullptr), breakContext(nullptr), linMode(false) {
         
         // Set the hardware instance based on peripheral type (type-safe pointer)
         switch (peripheral) {
@@ -83,7 +107,11 @@ namespace USART
         }
 
         config = cfg;
-        isInitialized = false;  // Reset flag until successful initialization
+        initialized = false;  // Reset flag until successful initialization
+
+        if (!isBaudRateSupported(cfg.baudRate)) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, cfg.baudRate};
+        }
         
         switch (peripheralType) {
             case PeripheralType::LPUART_1:
@@ -98,7 +126,7 @@ namespace USART
                 return UsartStatus{UsartError::INVALID_PERIPHERAL, 0};
         }
         
-        isInitialized = true;
+        initialized = true;
         
         // Register instance in global registry for interrupt handling
         return registerInstance(peripheralType, static_cast<void*>(this));
@@ -117,11 +145,17 @@ namespace USART
         // Enable LPUART1 clock (if not already enabled)
         LL_APB1_GRP2_EnableClock(LL_APB1_GRP2_PERIPH_LPUART1);
         
+        // Apply RTS/CTS from the configuration (watermarks via enableFlowControl())
+        flowControl = (config.hwFlowControl == LL_LPUART_HWCONTROL_RTS_CTS) ? FlowControl::RTS_CTS
+                                                                            : FlowControl::NONE;
+        rxHighWatermark = (BUFFER_SIZE * 3U) / 4U;
+        rxLowWatermark = BUFFER_SIZE / 4U;
+
         // Enable LPUART
         LL_LPUART_Enable(usartInstance);
         
-        // Enable TX empty interrupt
-        LL_LPUART_EnableIT_TXE(usartInstance);
+        // TX empty interrupt is enabled on demand by startTransmission()
+        enableRxInterrupt();
         
         // Enable NVIC interrupt
         NVIC_SetPriority(LPUART1_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
@@ -136,7 +170,6 @@ namespace USART
 
         // Enable appropriate clock and configure based on USART instance
         IRQn_Type irqn = (IRQn_Type)0;
-        uint32_t baudRate = config.baudRate;
         
         switch (peripheralType) {
             case PeripheralType::USART_1:
@@ -156,37 +189,152 @@ namespace USART
         }
         
         // Configure USART registers directly (LL_USART functions not available in this HAL version)
-        // USART CR1 setup: 8-bit data width, transmitter/receiver enabled
-        usartInstance->CR1 = (config.wordLength | config.transferDirection | USART_CR1_UE);
+        // USART CR1 setup: 8-bit data width, transmitter/receiver enabled (UE set after BRR)
+        uint32_t brr = 0;
+        bool over8 = false;
+        (void)computeDivider(config.baudRate, brr, over8);   // Validated in initialize()
+        usartInstance->CR1 = (config.wordLength | config.transferDirection | (over8 ? USART_CR1_OVER8 : 0U));
         
         // USART CR2 setup: stop bits configuration
         usartInstance->CR2 = config.stopBits;
         
         // USART CR3 setup: hardware flow control and parity
         usartInstance->CR3 = (config.hwFlowControl | config.parity);
+        flowControl = ((config.hwFlowControl & USART_CR3_RTSE) != 0) ? FlowControl::RTS_CTS : FlowControl::NONE;
+        rxHighWatermark = (BUFFER_SIZE * 3U) / 4U;
+        rxLowWatermark = BUFFER_SIZE / 4U;
         
-        // Set baud rate using BRR register (simplified calculation for standard clock)
-        // For STM32L433, USART clocks are derived from PCLK
-        // BRR = USART_CLK / BaudRate
-        // Assuming 80MHz PCLK: BRR = 80000000 / 115200 ≈ 694
-        // For accurate baud rate: use HAL_UART_Init or calculate based on actual clock
-        uint32_t brr = SystemCoreClock / 2 / baudRate;  // Approximate for standard configuration
-        if ((usartInstance->CR1 & USART_CR1_OVER8) != 0) {
-            brr = (brr & ~0x0F) | ((brr & 0x0F) >> 1);
-        }
+        // BRR may only be written while UE = 0
         usartInstance->BRR = brr;
+        usartInstance->CR1 |= USART_CR1_UE;
         
-        // Enable TX empty interrupt
-        usartInstance->CR1 |= USART_CR1_TXEIE;
+        // TX empty interrupt is enabled on demand by startTransmission()
+        enableRxInterrupt();
         
         // Enable NVIC interrupt
         NVIC_SetPriority(irqn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
         NVIC_EnableIRQ(irqn);
     }
 
+    template<uint16_t BUFFER_SIZE>
+    uint32_t UsartDriver<BUFFER_SIZE>::getKernelClock() const noexcept {
+        switch (peripheralType) {
+            case PeripheralType::LPUART_1:
+                return LL_RCC_GetLPUARTClockFreq(LL_RCC_LPUART1_CLKSOURCE);
+            case PeripheralType::USART_1:
+                return LL_RCC_GetUSARTClockFreq(LL_RCC_USART1_CLKSOURCE);
+            case PeripheralType::USART_2:
+                return LL_RCC_GetUSARTClockFreq(LL_RCC_USART2_CLKSOURCE);
+            case PeripheralType::USART_3:
+                return LL_RCC_GetUSARTClockFreq(LL_RCC_USART3_CLKSOURCE);
+            default:
+                return 0;
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    bool UsartDriver<BUFFER_SIZE>::computeDivider(uint32_t baudRate, uint32_t& brr, bool& over8) const noexcept {
+        const uint64_t clock = getKernelClock();
+        if (baudRate == 0 || clock == 0) {
+            return false;
+        }
+
+        if (peripheralType == PeripheralType::LPUART_1) {
+            // BRR = 256 * f_ck / baud, valid from 0x300 (f_ck >= 3 * baud) to 20 bits
+            const uint64_t divider = (clock * 256U + baudRate / 2U) / baudRate;
+            if (divider < 0x300U || divider > 0xFFFFFU) {
+                return false;
+            }
+            brr = static_cast<uint32_t>(divider);
+            over8 = false;
+            return true;
+        }
+
+        // USARTDIV = f_ck / baud (16x) or 2 * f_ck / baud (8x), at least 16
+        over8 = (clock < static_cast<uint64_t>(baudRate) * 16U);
+        const uint64_t scaledClock = over8 ? clock * 2U : clock;
+        const uint64_t divider = (scaledClock + baudRate / 2U) / baudRate;
+        if (divider < 16U || divider > 0xFFFFU) {
+            return false;
+        }
+
+        const uint64_t actual = scaledClock / divider;
+        const uint64_t deviation = (actual > baudRate) ? (actual - baudRate) : (baudRate - actual);
+        if (deviation * 1000U > static_cast<uint64_t>(baudRate) * MAX_BAUD_ERROR_PERMILLE) {
+            return false;
+        }
+
+        // With OVER8, BRR[2:0] = USARTDIV[3:0] >> 1 and BRR[3] must stay clear
+        brr = over8 ? static_cast<uint32_t>((divider & 0xFFF0U) | ((divider & 0x0FU) >> 1))
+                    : static_cast<uint32_t>(divider);
+        return true;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    uint32_t UsartDriver<BUFFER_SIZE>::getMaxBaudRate() const noexcept {
+        const uint32_t clock = getKernelClock();
+        return (peripheralType == PeripheralType::LPUART_1) ? clock / 3U : clock / 8U;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    UsartStatus UsartDriver<BUFFER_SIZE>::setBaudRate(uint32_t baudRate) noexcept {
+        if (!initialized) {
+            return UsartStatus{UsartError::UNINITIALIZED, 0};
+        }
+        if (dmaMode || transmissionActive || !txBuffer.isEmpty()) {
+            return UsartStatus{UsartError::BUSY, txBuffer.getRemainingCount()};
+        }
+
+        uint32_t brr = 0;
+        bool over8 = false;
+        if (!computeDivider(baudRate, brr, over8)) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, baudRate};
+        }
+
+        // Let the last stop bit leave before the divider changes. With RS-485 or a
+        // TX-complete callback transmissionActive is only cleared in the TC interrupt,
+        // which also cleared TCCF, so the stop bit is already out. Otherwise TC rises
+        // within one character (at most 12 bits) after the last TXE; the loop takes
+        // several cycles per pass, so the budget only ends a wait for a TC that was
+        // cleared elsewhere.
+        if (!rs485Enabled && txCompleteCallback == nullptr) {
+            uint32_t budget = 12U * (SystemCoreClock / config.baudRate + 1U);
+            while ((usartInstance->ISR & USART_ISR_TC) == 0U && budget > 0U) {
+                budget--;
+            }
+        }
+
+        // CR1 is shared with the ISR (TXEIE/TCIE), so UE is switched atomically
+        if (peripheralType == PeripheralType::LPUART_1) {
+            ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+            usartInstance->BRR = brr;
+            ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_UE);
+
+            if (rxTimeoutUsesTimer) {
+                // Keep the TIM7 timeout at the same number of bit periods
+                const uint64_t periodUs = LL_TIM_GetAutoReload(RX_TIMEOUT_TIMER) + 1U;
+                uint64_t timeoutUs = (periodUs * config.baudRate + baudRate - 1U) / baudRate;
+                timeoutUs = (timeoutUs < 2U) ? 2U : ((timeoutUs > 0xFFFFU) ? 0xFFFFU : timeoutUs);
+                LL_TIM_SetAutoReload(RX_TIMEOUT_TIMER, static_cast<uint32_t>(timeoutUs - 1U));
+            }
+        } else {
+            ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+            if (over8) {
+                ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_OVER8);
+            } else {
+                ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_OVER8);
+            }
+            usartInstance->BRR = brr;
+            ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_UE);
+        }
+
+        config.baudRate = baudRate;
+        return UsartStatus{UsartError::OK, 0};
+    }
+
     template<uint16_t BUFFER_SIZE>
     bool UsartDriver<BUFFER_SIZE>::sendByte(uint8_t data) noexcept {
-        if (!isInitialized) {
+        if (!initialized) {
             return false;
         }
         bool success = txBuffer.put(data);
@@ -198,7 +346,7 @@ namespace USART
 
     template<uint16_t BUFFER_SIZE>
     uint16_t UsartDriver<BUFFER_SIZE>::sendData(const uint8_t* data, uint16_t length) noexcept {
-        if (!isInitialized || data == nullptr || length == 0) {
+        if (!initialized || data == nullptr || length == 0) {
             return 0;
         }
         
@@ -218,9 +366,38 @@ namespace USART
         return sent;
     }
 
+    template<uint16_t BUFFER_SIZE>
+    typename UsartDriver<BUFFER_SIZE>::TxReservation UsartDriver<BUFFER_SIZE>::reserveTx(uint16_t maxLength) noexcept {
+        if (!initialized) {
+            return TxReservation(&txBuffer, 0);
+        }
+        const uint16_t space = txBuffer.availableSpace();
+        return TxReservation(&txBuffer, (maxLength < space) ? maxLength : space);
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    uint16_t UsartDriver<BUFFER_SIZE>::commitTx(const TxReservation& reservation) noexcept {
+        if (!initialized || reservation.ring != &txBuffer || reservation.length == 0) {
+            return 0;
+        }
+
+        txBuffer.commit(reservation.length);
+        if (!transmissionActive) {
+            startTransmission();
+        }
+        return reservation.length;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::abortTx(TxReservation& reservation) noexcept {
+        // The bytes were only poked beyond the write index, dropping the length is enough
+        reservation.capacity = 0;
+        reservation.length = 0;
+    }
+
     template<uint16_t BUFFER_SIZE>
     uint16_t UsartDriver<BUFFER_SIZE>::sendString(const char* str) noexcept {
-        if (!isInitialized || str == nullptr) {
+        if (!initialized || str == nullptr) {
             return 0;
         }
         
@@ -243,7 +420,7 @@ namespace USART
 
     template<uint16_t BUFFER_SIZE>
     uint16_t UsartDriver<BUFFER_SIZE>::sendFormatted(const char* format, ...) noexcept {
-        if (!isInitialized || format == nullptr) {
+        if (!initialized || format == nullptr) {
             return 0;
         }
         
@@ -269,7 +446,7 @@ namespace USART
 
     template<uint16_t BUFFER_SIZE>
     uint16_t UsartDriver<BUFFER_SIZE>::sendHex(const uint8_t* data, uint16_t length, bool uppercase) noexcept {
-        if (!isInitialized || data == nullptr || length == 0) {
+        if (!initialized || data == nullptr || length == 0) {
             return 0;
         }
         
@@ -301,7 +478,7 @@ namespace USART
 
     template<uint16_t BUFFER_SIZE>
     uint16_t UsartDriver<BUFFER_SIZE>::sendBinary(const uint8_t* data, uint16_t length) noexcept {
-        if (!isInitialized || data == nullptr || length == 0) {
+        if (!initialized || data == nullptr || length == 0) {
             return 0;
         }
         
@@ -331,19 +508,325 @@ namespace USART
 
     template<uint16_t BUFFER_SIZE>
     void UsartDriver<BUFFER_SIZE>::startTransmission() noexcept {
-        if (txBuffer.isEmpty()) {
+        if (dmaMode || (txBuffer.isEmpty() && pendingAddress == 0U)) {
             return;
         }
         
         transmissionActive = true;
+
+        if (rs485SuppressEcho) {
+            // Our own bytes would come back through the transceiver
+            ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_RE);
+        }
         
-        // Get first byte and start transmission
-        uint8_t data;
-        if (txBuffer.get(data)) {
-            transmitByte(data);
+        // The TXE interrupt moves every byte, so a pending XON/XOFF or a
+        // paused peer is handled in one place (handleTxCompleteInterrupt)
+        enableTxInterrupt();
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::enableTxInterrupt() noexcept {
+        if (peripheralType == PeripheralType::LPUART_1) {
+            LL_LPUART_EnableIT_TXE(usartInstance);
+        } else {
+            ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_TXEIE);
         }
     }
 
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::disableTxInterrupt() noexcept {
+        if (peripheralType == PeripheralType::LPUART_1) {
+            LL_LPUART_DisableIT_TXE(usartInstance);
+        } else {
+            ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_TXEIE);
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::enableRxInterrupt() noexcept {
+        // Only listen when the receiver is part of the configured direction
+        if ((config.transferDirection & USART_CR1_RE) == 0) {
+            return;
+        }
+        if (peripheralType == PeripheralType::LPUART_1) {
+            LL_LPUART_EnableIT_RXNE(usartInstance);
+        } else {
+            ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_RXNEIE);
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::disableRxInterrupt() noexcept {
+        if (peripheralType == PeripheralType::LPUART_1) {
+            LL_LPUART_DisableIT_RXNE(usartInstance);
+        } else {
+            ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_RXNEIE);
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    bool UsartDriver<BUFFER_SIZE>::receiveByte(uint8_t& data) noexcept {
+        bool received = rxBuffer.get(data);
+        if (received && rxPaused) {
+            resumeRxIfDrained();
+        }
+        return received;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    uint16_t UsartDriver<BUFFER_SIZE>::receiveData(uint8_t* data, uint16_t maxLength) noexcept {
+        if (data == nullptr) {
+            return 0;
+        }
+
+        uint16_t received = 0;
+        while (received < maxLength && rxBuffer.get(data[received])) {
+            received++;
+        }
+
+        if (received > 0 && rxPaused) {
+            resumeRxIfDrained();
+        }
+        return received;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    UsartStatus UsartDriver<BUFFER_SIZE>::enableFlowControl(const FlowControlConfig& flow) noexcept {
+        if (!initialized) {
+            return UsartStatus{UsartError::UNINITIALIZED, 0};
+        }
+        if (flow.mode != FlowControl::NONE &&
+            (flow.lowWatermark >= flow.highWatermark || flow.highWatermark >= BUFFER_SIZE)) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, flow.highWatermark};
+        }
+
+        if (flow.mode == FlowControl::RTS_CTS && (usartInstance->CR3 & USART_CR3_DEM) != 0) {
+            // RTS is the RS-485 DE pin
+            return UsartStatus{UsartError::BUSY, 0};
+        }
+
+        // RTSE/CTSE may only change while the USART is disabled.
+        // CR1 is shared with the ISR (TXEIE/TCIE), so UE is switched atomically
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+        if (flow.mode == FlowControl::RTS_CTS) {
+            usartInstance->CR3 |= (USART_CR3_RTSE | USART_CR3_CTSE);
+        } else {
+            usartInstance->CR3 &= ~(USART_CR3_RTSE | USART_CR3_CTSE);
+        }
+        ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_UE);
+
+        rxHighWatermark = flow.highWatermark;
+        rxLowWatermark = flow.lowWatermark;
+        txPaused = false;
+        rxPaused = false;
+        flowControl = flow.mode;
+        enableRxInterrupt();
+
+        return UsartStatus{UsartError::OK, 0};
+    }
+
+    /**
+     * @brief Tell the sender to stop (called from the RX interrupt)
+     * 
+     * RTS_CTS: stop reading RDR. The next byte stays in RDR, which makes the
+     * hardware deassert RTS, and no data is lost because RDR is not overwritten
+     * while RTS holds the sender off.
+     * XON_XOFF: send XOFF ahead of any queued TX data.
+     */
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::pauseRx() noexcept {
+        rxPaused = true;
+        if (flowControl == FlowControl::RTS_CTS) {
+            disableRxInterrupt();
+        } else {
+            queueControlChar(XOFF_CHAR);
+        }
+    }
+
+    /**
+     * @brief Let the sender continue once the application drained the RX buffer
+     */
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::resumeRxIfDrained() noexcept {
+        if (rxBuffer.getRemainingCount() > rxLowWatermark) {
+            return;
+        }
+        rxPaused = false;
+        if (flowControl == FlowControl::RTS_CTS) {
+            enableRxInterrupt();
+        } else if (flowControl == FlowControl::XON_XOFF) {
+            queueControlChar(XON_CHAR);
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::queueControlChar(uint8_t data) noexcept {
+        pendingControlChar = data;
+        transmissionActive = true;
+        enableTxInterrupt();
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    UsartStatus UsartDriver<BUFFER_SIZE>::enableDmaMode(RxTimeoutCallback callback, void* context) noexcept {
+        if (!initialized) {
+            return UsartStatus{UsartError::UNINITIALIZED, 0};
+        }
+        if (transmissionActive) {
+            return UsartStatus{UsartError::BUSY, 0};
+        }
+
+        disableRxInterrupt();
+        disableTxInterrupt();
+
+        idleCallback = callback;
+        idleContext = context;
+        dmaMode = true;
+
+        // DMAR/DMAT may be changed while the USART is enabled
+        ATOMIC_SET_BIT(usartInstance->CR3, USART_CR3_DMAR | USART_CR3_DMAT);
+        usartInstance->ICR = USART_ICR_IDLECF;
+        ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_IDLEIE);
+
+        return UsartStatus{UsartError::OK, 0};
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::disableDmaMode() noexcept {
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_IDLEIE);
+        ATOMIC_CLEAR_BIT(usartInstance->CR3, USART_CR3_DMAR | USART_CR3_DMAT);
+
+        dmaMode = false;
+        idleCallback = nullptr;
+        idleContext = nullptr;
+
+        enableRxInterrupt();
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::setTxCompleteCallback(TxCompleteCallback callback, void* context) noexcept {
+        // Clear the callback first so the ISR never sees a new callback with a stale context
+        txCompleteCallback = nullptr;
+        txCompleteContext = context;
+        txCompleteCallback = callback;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::setRxCallback(RxByteCallback callback, void* context) noexcept {
+        // Clear the callback first so the ISR never sees a new callback with a stale context
+        rxCallback = nullptr;
+        rxCallbackContext = context;
+        rxCallback = callback;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    UsartStatus UsartDriver<BUFFER_SIZE>::enableReceiverTimeout(uint32_t bitPeriods, RxTimeoutCallback callback,
+                                                                void* context) noexcept {
+        if (!initialized) {
+            return UsartStatus{UsartError::UNINITIALIZED, 0};
+        }
+        if (bitPeriods == 0 || bitPeriods > USART_RTOR_RTO || config.baudRate == 0) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, bitPeriods};
+        }
+
+        rxTimeoutCallback = nullptr;
+        rxTimeoutContext = context;
+        rxTimeoutCallback = callback;
+
+        if (peripheralType == PeripheralType::LPUART_1) {
+            // Convert bit periods to microseconds (rounded up) for the 1 us timer tick
+            uint32_t timeoutUs = static_cast<uint32_t>(
+                (static_cast<uint64_t>(bitPeriods) * 1000000U + config.baudRate - 1U) / config.baudRate);
+            if (timeoutUs < 2U) {
+                timeoutUs = 2U;
+            }
+            if (timeoutUs > 0xFFFFU) {
+                return UsartStatus{UsartError::INVALID_PARAMETER, timeoutUs};
+            }
+
+            LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM7);
+            LL_TIM_DisableCounter(RX_TIMEOUT_TIMER);
+            LL_TIM_SetPrescaler(RX_TIMEOUT_TIMER, (SystemCoreClock / 1000000U) - 1U);
+            LL_TIM_SetAutoReload(RX_TIMEOUT_TIMER, timeoutUs - 1U);
+            LL_TIM_SetOnePulseMode(RX_TIMEOUT_TIMER, LL_TIM_ONEPULSEMODE_SINGLE);
+            // Only a real overflow may raise the interrupt, not the UG used to load PSC
+            LL_TIM_SetUpdateSource(RX_TIMEOUT_TIMER, LL_TIM_UPDATESOURCE_COUNTER);
+            LL_TIM_GenerateEvent_UPDATE(RX_TIMEOUT_TIMER);
+            LL_TIM_ClearFlag_UPDATE(RX_TIMEOUT_TIMER);
+            LL_TIM_EnableIT_UPDATE(RX_TIMEOUT_TIMER);
+
+            NVIC_SetPriority(RX_TIMEOUT_TIMER_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+            NVIC_EnableIRQ(RX_TIMEOUT_TIMER_IRQN);
+            rxTimeoutUsesTimer = true;
+        } else {
+            // RTOEN may only change while the USART is disabled.
+            // CR1 is shared with the ISR (TXEIE/TCIE), so it is only changed atomically
+            ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+            usartInstance->RTOR = (usartInstance->RTOR & ~USART_RTOR_RTO) | bitPeriods;
+            usartInstance->CR2 |= USART_CR2_RTOEN;
+            usartInstance->ICR = USART_ICR_RTOCF;
+            ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_RTOIE | USART_CR1_UE);
+            rxTimeoutUsesTimer = false;
+        }
+
+        return UsartStatus{UsartError::OK, 0};
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::disableReceiverTimeout() noexcept {
+        if (rxTimeoutUsesTimer) {
+            rxTimeoutUsesTimer = false;
+            LL_TIM_DisableIT_UPDATE(RX_TIMEOUT_TIMER);
+            LL_TIM_DisableCounter(RX_TIMEOUT_TIMER);
+            NVIC_DisableIRQ(RX_TIMEOUT_TIMER_IRQN);
+        } else if (usartInstance != nullptr && peripheralType != PeripheralType::LPUART_1) {
+            ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_RTOIE);
+            usartInstance->ICR = USART_ICR_RTOCF;
+        }
+        rxTimeoutCallback = nullptr;
+        rxTimeoutContext = nullptr;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    UsartStatus UsartDriver<BUFFER_SIZE>::enableRs485(const Rs485Config& rs485) noexcept {
+        if (!initialized) {
+            return UsartStatus{UsartError::UNINITIALIZED, 0};
+        }
+        if (rs485.assertionTime > 31U || rs485.deassertionTime > 31U) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, 0};
+        }
+        if ((usartInstance->CR3 & USART_CR3_RTSE) != 0) {
+            // DE is the RTS pin: RTS/CTS flow control already drives it
+            return UsartStatus{UsartError::BUSY, 0};
+        }
+
+        // DEM, DEP, DEAT and DEDT may only change while the USART is disabled.
+        // CR1 is shared with the ISR (TXEIE/TCIE), so it is only changed atomically
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+        ATOMIC_MODIFY_REG(usartInstance->CR1, USART_CR1_DEAT | USART_CR1_DEDT,
+                          (static_cast<uint32_t>(rs485.assertionTime) << USART_CR1_DEAT_Pos) |
+                          (static_cast<uint32_t>(rs485.deassertionTime) << USART_CR1_DEDT_Pos));
+
+        uint32_t cr3 = usartInstance->CR3 | USART_CR3_DEM;
+        if (rs485.activeLow) {
+            cr3 |= USART_CR3_DEP;
+        } else {
+            cr3 &= ~USART_CR3_DEP;
+        }
+        usartInstance->CR3 = cr3;
+
+        rs485SuppressEcho = rs485.suppressEcho;
+        rs485Enabled = true;
+
+        ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_UE);
+        return UsartStatus{UsartError::OK, 0};
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::restartRxTimeoutTimer() noexcept {
+        LL_TIM_SetCounter(RX_TIMEOUT_TIMER, 0);
+        LL_TIM_EnableCounter(RX_TIMEOUT_TIMER);
+    }
+
     template<uint16_t BUFFER_SIZE>
     void UsartDriver<BUFFER_SIZE>::transmitByte(uint8_t data) noexcept {
         if (usartInstance == nullptr) {
@@ -387,13 +870,276 @@ namespace USART
 
     template<uint16_t BUFFER_SIZE>
     void UsartDriver<BUFFER_SIZE>::handleTxCompleteInterrupt() noexcept {
+        // Flow control characters jump the queue and ignore a received XOFF
+        uint8_t data = pendingControlChar;
+        if (data != 0) {
+            pendingControlChar = 0;
+            transmitByte(data);
+            return;
+        }
+
+        if (txPaused) {
+            // Peer sent XOFF: keep data queued and wait for XON
+            disableTxInterrupt();
+            return;
+        }
+
+        // An address mark opens the frame queued behind it (9-bit TDR write)
+        const uint16_t address = pendingAddress;
+        if (address != 0) {
+            pendingAddress = 0;
+            usartInstance->TDR = address;
+            return;
+        }
+
         // Check if there's more data to send
-        uint8_t data;
         if (txBuffer.get(data)) {
             transmitByte(data);
         } else {
-            // No more data, transmission complete
-            transmissionActive = false;
+            disableTxInterrupt();
+            if (rs485Enabled || txCompleteCallback != nullptr) {
+                // Last byte is still shifting out: hold the bus (and the notification) until TC
+                usartInstance->ICR = USART_ICR_TCCF;
+                ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_TCIE);
+            } else {
+                // No more data, transmission complete
+                transmissionActive = false;
+            }
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::handleTransmissionCompleteInterrupt() noexcept {
+        // Last stop bit is on the wire, the hardware now runs DEDT and drops DE
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_TCIE);
+        usartInstance->ICR = USART_ICR_TCCF;
+
+        if (rs485SuppressEcho) {
+            usartInstance->RQR = USART_RQR_RXFRQ;
+            ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_RE);
+        }
+
+        transmissionActive = false;
+
+        TxCompleteCallback callback = txCompleteCallback;
+        if (callback != nullptr) {
+            callback(txCompleteContext);
+        }
+
+        // Data queued while waiting for TC would otherwise never be started
+        if (!txBuffer.isEmpty()) {
+            startTransmission();
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::handleRxInterrupt(uint8_t data) noexcept {
+        if (rxTimeoutUsesTimer) {
+            restartRxTimeoutTimer();
+        }
+
+        if (flowControl == FlowControl::XON_XOFF && (data == XON_CHAR || data == XOFF_CHAR)) {
+            txPaused = (data == XOFF_CHAR);
+            if (!txPaused && transmissionActive) {
+                enableTxInterrupt();
+            }
+            return;
+        }
+
+        RxByteCallback callback = rxCallback;
+        if (callback != nullptr) {
+            callback(rxCallbackContext, data);
+            return;
+        }
+
+        if (!rxBuffer.put(data)) {
+            rxOverflowCount = rxOverflowCount + 1;
+        }
+        if (flowControl != FlowControl::NONE && !rxPaused && rxBuffer.getRemainingCount() >= rxHighWatermark) {
+            pauseRx();
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    uint16_t UsartDriver<BUFFER_SIZE>::getAddressMarkBit() const noexcept {
+        const uint32_t wordLength = usartInstance->CR1 & (USART_CR1_M0 | USART_CR1_M1);
+        if (wordLength == USART_CR1_M0) {
+            return 0x100U;   // 9-bit words
+        }
+        return (wordLength == 0U) ? 0x80U : 0U;   // 8-bit words, 7-bit words unsupported
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    UsartStatus UsartDriver<BUFFER_SIZE>::enableAddressMute(const AddressMuteConfig& mute) noexcept {
+        if (!initialized) {
+            return UsartStatus{UsartError::UNINITIALIZED, 0};
+        }
+        if (getAddressMarkBit() == 0U) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, usartInstance->CR1};
+        }
+        if (mute.address > (mute.sevenBitAddress ? 0x7FU : 0x0FU)) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, mute.address};
+        }
+
+        // WAKE, ADD and ADDM7 may only change while the USART is disabled
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+        uint32_t cr2 = usartInstance->CR2 & ~(USART_CR2_ADD_Msk | USART_CR2_ADDM7);
+        cr2 |= static_cast<uint32_t>(mute.address) << USART_CR2_ADD_Pos;
+        if (mute.sevenBitAddress) {
+            cr2 |= USART_CR2_ADDM7;
+        }
+        usartInstance->CR2 = cr2;
+        ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_WAKE | USART_CR1_MME);
+        ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_UE);
+
+        addressMute = true;
+        enterMute();
+        return UsartStatus{UsartError::OK, 0};
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::disableAddressMute() noexcept {
+        if (!addressMute) {
+            return;
+        }
+        addressMute = false;
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_MME | USART_CR1_WAKE);
+        ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_UE);
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::enterMute() noexcept {
+        if (addressMute) {
+            usartInstance->RQR = USART_RQR_MMRQ;
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    bool UsartDriver<BUFFER_SIZE>::sendAddressedFrame(uint8_t address, const uint8_t* data, uint16_t length) noexcept {
+        const uint16_t mark = initialized ? getAddressMarkBit() : 0U;
+        if (mark == 0U || (data == nullptr && length != 0U) || address >= mark) {
+            return false;
+        }
+        if (dmaMode || transmissionActive || !txBuffer.isEmpty() || txBuffer.availableSpace() < length) {
+            return false;
+        }
+
+        for (uint16_t i = 0; i < length; i++) {
+            (void)txBuffer.put(data[i]);
+        }
+        pendingAddress = static_cast<uint16_t>(mark | address);
+        startTransmission();
+        return true;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    UsartStatus UsartDriver<BUFFER_SIZE>::enableLin(BreakCallback callback, void* context) noexcept {
+        if (!initialized) {
+            return UsartStatus{UsartError::UNINITIALIZED, 0};
+        }
+        if (peripheralType == PeripheralType::LPUART_1) {
+            return UsartStatus{UsartError::INVALID_PERIPHERAL, 0};
+        }
+        if ((usartInstance->CR1 & (USART_CR1_M0 | USART_CR1_M1)) != 0U || (usartInstance->CR2 & USART_CR2_STOP) != 0U) {
+            return UsartStatus{UsartError::INVALID_PARAMETER, usartInstance->CR1};
+        }
+
+        breakCallback = callback;
+        breakContext = context;
+
+        // LINEN and LBDL may only change while the USART is disabled; LIN mode
+        // also requires CLKEN, SCEN, IREN and HDSEL to stay cleared
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+        usartInstance->CR3 &= ~(USART_CR3_SCEN | USART_CR3_IREN | USART_CR3_HDSEL);
+        uint32_t cr2 = usartInstance->CR2 & ~USART_CR2_CLKEN;
+        cr2 |= USART_CR2_LINEN | USART_CR2_LBDL | USART_CR2_LBDIE;
+        usartInstance->CR2 = cr2;
+        usartInstance->ICR = USART_ICR_LBDCF;
+        ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_UE);
+
+        linMode = true;
+        return UsartStatus{UsartError::OK, 0};
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::disableLin() noexcept {
+        if (!linMode) {
+            return;
+        }
+        linMode = false;
+        ATOMIC_CLEAR_BIT(usartInstance->CR1, USART_CR1_UE);
+        usartInstance->CR2 &= ~(USART_CR2_LINEN | USART_CR2_LBDL | USART_CR2_LBDIE);
+        ATOMIC_SET_BIT(usartInstance->CR1, USART_CR1_UE);
+        breakCallback = nullptr;
+        breakContext = nullptr;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    bool UsartDriver<BUFFER_SIZE>::sendBreak() noexcept {
+        if (!linMode || dmaMode || transmissionActive || !txBuffer.isEmpty()) {
+            return false;
+        }
+        // A character still in the shift register goes out first, then the break
+        usartInstance->RQR = USART_RQR_SBKRQ;
+        return true;
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::handleRxTimeoutInterrupt() noexcept {
+        RxTimeoutCallback callback = rxTimeoutCallback;
+        if (callback != nullptr) {
+            callback(rxTimeoutContext);
+        }
+    }
+
+    template<uint16_t BUFFER_SIZE>
+    void UsartDriver<BUFFER_SIZE>::handleInterrupt() noexcept {
+        // LPUART and USART share the ISR/ICR/RDR layout, so one register path serves both
+        const uint32_t isr = usartInstance->ISR;
+        const uint32_t cr1 = usartInstance->CR1;
+
+        if ((isr & RX_ERROR_FLAGS) != 0) {
+            // Errors must be cleared or RXNE stops being raised (ORE)
+            usartInstance->ICR = RX_ERROR_CLEAR;
+            rxErrorCount = rxErrorCount + 1;
+        }
+
+        // Break before the 0x00 character it produced, so a LIN receiver is
+        // already waiting for the sync byte when that character arrives
+        if ((isr & USART_ISR_LBDF) != 0 && linMode) {
+            usartInstance->ICR = USART_ICR_LBDCF;
+            BreakCallback callback = breakCallback;
+            if (callback != nullptr) {
+                callback(breakContext);
+            }
+        }
+
+        // RXNE is only ours while RXNEIE is set: flow control may be holding the
+        // byte in RDR on purpose, and in DMA mode the DMA owns RDR
+        if ((isr & USART_ISR_RXNE) != 0 && (cr1 & USART_CR1_RXNEIE) != 0) {
+            handleRxInterrupt(static_cast<uint8_t>(usartInstance->RDR));
+        }
+
+        if ((isr & USART_ISR_IDLE) != 0 && (cr1 & USART_CR1_IDLEIE) != 0) {
+            usartInstance->ICR = USART_ICR_IDLECF;
+            RxTimeoutCallback callback = idleCallback;
+            if (callback != nullptr) {
+                callback(idleContext);
+            }
+        }
+
+        if ((isr & USART_ISR_RTOF) != 0 && (cr1 & USART_CR1_RTOIE) != 0) {
+            usartInstance->ICR = USART_ICR_RTOCF;
+            handleRxTimeoutInterrupt();
+        }
+
+        if ((isr & USART_ISR_TXE) != 0 && (cr1 & USART_CR1_TXEIE) != 0) {
+            handleTxCompleteInterrupt();
+        }
+
+        if ((isr & USART_ISR_TC) != 0 && (cr1 & USART_CR1_TCIE) != 0) {
+            handleTransmissionCompleteInterrupt();
         }
     }
 
@@ -433,7 +1179,7 @@ namespace USART
         // This assumes most drivers use the default 256-byte buffer
         StandardUSART* driver = static_cast<StandardUSART*>(instance);
         if (driver != nullptr) {
-            driver->handleTxCompleteInterrupt();
+            driver->handleInterrupt();
         }
     }
 
@@ -444,6 +1190,26 @@ extern "C" {
     void USART_HandleLpuart1Interrupt(void) {
         USART::handleUsartInterrupt(USART::PeripheralType::LPUART_1);
     }
+
+    void USART_HandleUsart1Interrupt(void) {
+        USART::handleUsartInterrupt(USART::PeripheralType::USART_1);
+    }
+
+    void USART_HandleUsart2Interrupt(void) {
+        USART::handleUsartInterrupt(USART::PeripheralType::USART_2);
+    }
+
+    void USART_HandleUsart3Interrupt(void) {
+        USART::handleUsartInterrupt(USART::PeripheralType::USART_3);
+    }
+
+    // TIM7 emulates the receiver timeout for LPUART1 (see enableReceiverTimeout)
+    void USART_HandleRxTimeoutTimerInterrupt(void) {
+        void* instance = USART::getRegisteredInstance(USART::PeripheralType::LPUART_1);
+        if (instance != nullptr) {
+            static_cast<USART::StandardUSART*>(instance)->handleRxTimeoutInterrupt();
+        }
+    }
     
     // C interface functions for syscalls integration
     void* USART_CreateDebugInstance(void) {
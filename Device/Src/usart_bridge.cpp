@@ -0,0 +1,248 @@
+/**
+ * @file    usart_bridge.cpp
+ * @brief   Transparent DMA bridge between two USART/LPUART ports
+ * @author  MootSeeker
+ *
+ * Only index bookkeeping happens in interrupt context, the payload is moved
+ * by the DMA controllers (see usart_bridge.h for the interrupt load).
+ */
+
+#include "usart_bridge.h"
+#include "dma_address.h"
+
+namespace USART
+{
+    // DMA ISR/IFCR hold 4 flags per channel: GIF, TCIF, HTIF, TEIF
+    static constexpr uint32_t DMA_FLAG_SHIFT = 4U;
+    static constexpr uint32_t DMA_FLAG_GI = 0x1U;
+    static constexpr uint32_t DMA_FLAG_TC = 0x2U;
+    static constexpr uint32_t DMA_FLAG_HT = 0x4U;
+    static constexpr uint32_t DMA_FLAG_TE = 0x8U;
+
+    /// Indexed by PeripheralType (STM32L433 reference manual, DMA request mapping)
+    static const DmaRoute g_dmaRoutes[static_cast<size_t>(PeripheralType::COUNT)] = {
+        {DMA1, LL_DMA_CHANNEL_5, LL_DMA_CHANNEL_4, LL_DMA_REQUEST_2, DMA1_Channel5_IRQn, DMA1_Channel4_IRQn},  // USART_1
+        {DMA1, LL_DMA_CHANNEL_6, LL_DMA_CHANNEL_7, LL_DMA_REQUEST_2, DMA1_Channel6_IRQn, DMA1_Channel7_IRQn},  // USART_2
+        {DMA1, LL_DMA_CHANNEL_3, LL_DMA_CHANNEL_2, LL_DMA_REQUEST_2, DMA1_Channel3_IRQn, DMA1_Channel2_IRQn},  // USART_3
+        {DMA2, LL_DMA_CHANNEL_7, LL_DMA_CHANNEL_6, LL_DMA_REQUEST_4, DMA2_Channel7_IRQn, DMA2_Channel6_IRQn},  // LPUART_1
+    };
+
+    /// Running lanes for DMA interrupt dispatch (at most one per source port)
+    static BridgeLane* g_bridgeLanes[static_cast<size_t>(PeripheralType::COUNT)] = {nullptr};
+
+    const DmaRoute* getDmaRoute(PeripheralType peripheral) noexcept {
+        size_t index = static_cast<size_t>(peripheral);
+        if (index < static_cast<size_t>(PeripheralType::COUNT)) {
+            return &g_dmaRoutes[index];
+        }
+        return nullptr;
+    }
+
+    static inline uint32_t dmaFlags(uint32_t flags, uint32_t channel) noexcept {
+        return flags << (channel * DMA_FLAG_SHIFT);
+    }
+
+    static void enableDmaClock(const DMA_TypeDef* dma) noexcept {
+        if (dma == DMA1) {
+            LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+        } else {
+            LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+        }
+    }
+
+    BridgeLane::BridgeLane(uint8_t* storage, uint16_t storageSize) noexcept
+        : source(nullptr), destination(nullptr), sourceInstance(nullptr), destinationInstance(nullptr),
+          buffer(storage), size(storageSize), rxPosition(0), txPosition(0), txLength(0), pending(0),
+          bytesForwarded(0), overrunCount(0), running(false) {}
+
+    UsartStatus BridgeLane::start(PeripheralType from, USART_TypeDef* fromInstance,
+                                  PeripheralType to, USART_TypeDef* toInstance) noexcept {
+        source = getDmaRoute(from);
+        destination = getDmaRoute(to);
+        if (source == nullptr || destination == nullptr) {
+            return UsartStatus{UsartError::INVALID_PERIPHERAL, 0};
+        }
+        if (buffer == nullptr || fromInstance == nullptr || toInstance == nullptr) {
+            return UsartStatus{UsartError::NULL_POINTER, 0};
+        }
+
+        // Some channels are shared with other DMA users (pattern player, logic
+        // capture, keypad scanner); an enabled one belongs to someone else
+        enableDmaClock(source->dma);
+        enableDmaClock(destination->dma);
+        if (!running && LL_DMA_IsEnabledChannel(source->dma, source->rxChannel)) {
+            return UsartStatus{UsartError::BUSY, source->rxChannel};
+        }
+        if (!running && LL_DMA_IsEnabledChannel(destination->dma, destination->txChannel)) {
+            return UsartStatus{UsartError::BUSY, destination->txChannel};
+        }
+
+        sourceInstance = fromInstance;
+        destinationInstance = toInstance;
+        rxPosition = 0;
+        txPosition = 0;
+        txLength = 0;
+        pending = 0;
+
+        // RX: RDR -> buffer, circular, interrupts at half and full buffer
+        LL_DMA_DisableChannel(source->dma, source->rxChannel);
+        LL_DMA_SetPeriphRequest(source->dma, source->rxChannel, source->request);
+        LL_DMA_ConfigTransfer(source->dma, source->rxChannel,
+                              LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_MODE_CIRCULAR |
+                              LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                              LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE | LL_DMA_PRIORITY_HIGH);
+        LL_DMA_ConfigAddresses(source->dma, source->rxChannel,
+                               dmaAddress(&sourceInstance->RDR), dmaAddress(buffer),
+                               LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+        LL_DMA_SetDataLength(source->dma, source->rxChannel, size);
+        WRITE_REG(source->dma->IFCR, dmaFlags(DMA_FLAG_GI | DMA_FLAG_TC | DMA_FLAG_HT | DMA_FLAG_TE, source->rxChannel));
+        LL_DMA_EnableIT_HT(source->dma, source->rxChannel);
+        LL_DMA_EnableIT_TC(source->dma, source->rxChannel);
+
+        // TX: buffer -> TDR, normal mode, one contiguous chunk at a time
+        LL_DMA_DisableChannel(destination->dma, destination->txChannel);
+        LL_DMA_SetPeriphRequest(destination->dma, destination->txChannel, destination->request);
+        LL_DMA_ConfigTransfer(destination->dma, destination->txChannel,
+                              LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_MODE_NORMAL |
+                              LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                              LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE | LL_DMA_PRIORITY_MEDIUM);
+        LL_DMA_SetPeriphAddress(destination->dma, destination->txChannel,
+                                dmaAddress(&destinationInstance->TDR));
+        WRITE_REG(destination->dma->IFCR, dmaFlags(DMA_FLAG_GI | DMA_FLAG_TC | DMA_FLAG_HT | DMA_FLAG_TE, destination->txChannel));
+        LL_DMA_EnableIT_TC(destination->dma, destination->txChannel);
+
+        // Same priority as the USART interrupts: lane handlers never preempt each other
+        const uint32_t priority = NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0);
+        NVIC_SetPriority(source->rxIrq, priority);
+        NVIC_EnableIRQ(source->rxIrq);
+        NVIC_SetPriority(destination->txIrq, priority);
+        NVIC_EnableIRQ(destination->txIrq);
+
+        g_bridgeLanes[static_cast<size_t>(from)] = this;
+        running = true;
+        LL_DMA_EnableChannel(source->dma, source->rxChannel);
+
+        return UsartStatus{UsartError::OK, 0};
+    }
+
+    void BridgeLane::stop() noexcept {
+        if (!running) {
+            return;
+        }
+        running = false;
+
+        LL_DMA_DisableChannel(source->dma, source->rxChannel);
+        LL_DMA_DisableChannel(destination->dma, destination->txChannel);
+        // An armed TC interrupt marks the idle TX channel as taken (see Keypad.cpp)
+        LL_DMA_DisableIT_TC(destination->dma, destination->txChannel);
+
+        for (BridgeLane*& lane : g_bridgeLanes) {
+            if (lane == this) {
+                lane = nullptr;
+            }
+        }
+    }
+
+    /**
+     * @brief Account for the bytes the RX DMA wrote since the last event
+     *
+     * HT/TC fire every half buffer, so the write index never advances by
+     * more than one lap between two updates unless interrupts are blocked
+     * for longer than size/2 characters.
+     */
+    void BridgeLane::updateRxPosition() noexcept {
+        const uint16_t remaining = static_cast<uint16_t>(LL_DMA_GetDataLength(source->dma, source->rxChannel));
+        const uint16_t position = static_cast<uint16_t>((size - remaining) & (size - 1U));
+        const uint16_t received = static_cast<uint16_t>((position - rxPosition) & (size - 1U));
+        rxPosition = position;
+
+        if (static_cast<uint32_t>(pending) + received <= size) {
+            pending = static_cast<uint16_t>(pending + received);
+            return;
+        }
+
+        // The RX DMA overwrote unsent data: restart from the newest byte
+        overrunCount++;
+        if (txLength == 0) {
+            txPosition = position;
+            pending = 0;
+        } else {
+            // Let the chunk in flight finish, then skip to the write index
+            pending = txLength;
+            txPosition = static_cast<uint16_t>((position - txLength) & (size - 1U));
+        }
+    }
+
+    void BridgeLane::startTxChunk() noexcept {
+        if (!running || txLength != 0 || pending == 0) {
+            return;
+        }
+
+        // Contiguous region only, the wrapped remainder follows on TC
+        const uint16_t untilWrap = static_cast<uint16_t>(size - txPosition);
+        txLength = (pending < untilWrap) ? pending : untilWrap;
+
+        LL_DMA_DisableChannel(destination->dma, destination->txChannel);
+        LL_DMA_SetMemoryAddress(destination->dma, destination->txChannel,
+                                dmaAddress(&buffer[txPosition]));
+        LL_DMA_SetDataLength(destination->dma, destination->txChannel, txLength);
+        LL_DMA_EnableChannel(destination->dma, destination->txChannel);
+    }
+
+    void BridgeLane::handleRxEvent() noexcept {
+        if (!running) {
+            return;
+        }
+        updateRxPosition();
+        startTxChunk();
+    }
+
+    void BridgeLane::handleTxComplete() noexcept {
+        txPosition = static_cast<uint16_t>((txPosition + txLength) & (size - 1U));
+        pending = static_cast<uint16_t>(pending - txLength);
+        bytesForwarded += txLength;
+        txLength = 0;
+
+        // Pick up bytes that arrived while the chunk was on the wire
+        handleRxEvent();
+    }
+
+    uint8_t BridgeLane::ownsChannel(const DMA_TypeDef* dma, uint32_t channel) const noexcept {
+        if (!running) {
+            return 0;
+        }
+        if (source->dma == dma && source->rxChannel == channel) {
+            return 1;
+        }
+        if (destination->dma == dma && destination->txChannel == channel) {
+            return 2;
+        }
+        return 0;
+    }
+
+} // namespace USART
+
+extern "C" {
+    void USART_HandleDmaInterrupt(DMA_TypeDef* dma, uint32_t channel) {
+        if (dma == nullptr || channel < 1U || channel > 7U) {
+            return;
+        }
+
+        const uint32_t index = channel - 1U;  // LL_DMA_CHANNEL_x
+        const uint32_t flags = (dma->ISR >> (index * USART::DMA_FLAG_SHIFT)) & 0xFU;
+        WRITE_REG(dma->IFCR, USART::dmaFlags(flags, index));
+
+        for (USART::BridgeLane* lane : USART::g_bridgeLanes) {
+            if (lane == nullptr) {
+                continue;
+            }
+
+            const uint8_t role = lane->ownsChannel(dma, index);
+            if (role == 1 && (flags & (USART::DMA_FLAG_HT | USART::DMA_FLAG_TC)) != 0) {
+                lane->handleRxEvent();
+            } else if (role == 2 && (flags & USART::DMA_FLAG_TC) != 0) {
+                lane->handleTxComplete();
+            }
+        }
+    }
+}
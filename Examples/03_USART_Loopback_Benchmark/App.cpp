@@ -0,0 +1,222 @@
+/**
+ * @file    App.cpp
+ * @brief   USART loopback benchmark - throughput, CPU cycles per byte and latency
+ * @author  MootSeeker
+ *
+ * Sweeps baud rates and message sizes over a TX->RX loopback and prints one
+ * machine-readable line per case:
+ * - Throughput of verified payload bytes
+ * - CPU cycles per byte spent in the driver (send call + interrupts, DWT)
+ * - Dropped / corrupted bytes, RX overflows and RX errors
+ * - Round-trip latency histogram (power-of-two microsecond buckets)
+ *
+ * Hardware: STM32L433 Nucleo board
+ * - LPUART1 (PA2/PA3, ST-Link VCP) @ 115200 baud: report output
+ * - USART1 device under test:
+ *   - INTERNAL_LOOPBACK = true: half-duplex mode, TX looped back inside the USART (PA9 only)
+ *   - INTERNAL_LOOPBACK = false: jumper PA9 (TX) to PA10 (RX)
+ */
+
+#include "App.h"
+#include "main.h"
+#include "usart.h"
+#include "LoopbackBenchmark.h"
+
+// ============================================================================
+// Benchmark configuration
+// ============================================================================
+
+static constexpr bool INTERNAL_LOOPBACK = true;
+
+static constexpr uint32_t BAUD_RATES[] = {115200U, 460800U, 921600U, 2000000U};
+static constexpr uint16_t MESSAGE_SIZES[] = {1U, 16U, 64U, 200U};
+static constexpr uint32_t MESSAGES_PER_CASE = 200U;
+
+// ============================================================================
+// Loopback backend
+// ============================================================================
+
+/**
+ * @brief USART1 loopback with DWT cycle counter
+ *
+ * The sweep in runCase() (LoopbackBenchmark.h) only needs configure(),
+ * send(), receive(), the two error counters, cycles() and
+ * cyclesPerMicrosecond(); the host test drives it on the USART model.
+ */
+class UsartLoopbackBackend
+{
+private:
+    USART::StandardUSART uart{USART::PeripheralType::USART_1};
+
+public:
+    UsartLoopbackBackend() noexcept
+    {
+        // DWT cycle counter
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        // USART1 on PA9 (TX) / PA10 (RX), AF7
+        LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_GPIOA);
+        LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_9, LL_GPIO_MODE_ALTERNATE);
+        LL_GPIO_SetAFPin_8_15(GPIOA, LL_GPIO_PIN_9, LL_GPIO_AF_7);
+        LL_GPIO_SetPinSpeed(GPIOA, LL_GPIO_PIN_9, LL_GPIO_SPEED_FREQ_VERY_HIGH);
+        LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_10, LL_GPIO_MODE_ALTERNATE);
+        LL_GPIO_SetAFPin_8_15(GPIOA, LL_GPIO_PIN_10, LL_GPIO_AF_7);
+        LL_GPIO_SetPinPull(GPIOA, LL_GPIO_PIN_10, LL_GPIO_PULL_UP);
+    }
+
+    USART::UsartStatus configure(uint32_t baudRate) noexcept
+    {
+        USART::Config config = USART::getDefaultUsartConfig();
+        config.baudRate = baudRate;
+
+        USART::UsartStatus status = uart.initialize(config);
+        if (status.isSuccess() && INTERNAL_LOOPBACK) {
+            // HDSEL may only be changed while the USART is disabled
+            USART_TypeDef* regs = uart.getInstance();
+            regs->CR1 &= ~USART_CR1_UE;
+            regs->CR3 |= USART_CR3_HDSEL;
+            regs->CR1 |= USART_CR1_UE;
+        }
+
+        // Flush anything left over from the previous case
+        uint8_t discard[32];
+        while (uart.receiveData(discard, sizeof(discard)) > 0) {
+        }
+        return status;
+    }
+
+    uint16_t send(const uint8_t* data, uint16_t length) noexcept
+    {
+        return uart.sendData(data, length);
+    }
+
+    uint16_t receive(uint8_t* data, uint16_t maxLength) noexcept
+    {
+        return uart.receiveData(data, maxLength);
+    }
+
+    uint32_t rxOverflowCount() const noexcept
+    {
+        return uart.getRxOverflowCount();
+    }
+
+    uint32_t rxErrorCount() const noexcept
+    {
+        return uart.getRxErrorCount();
+    }
+
+    static uint32_t cycles() noexcept
+    {
+        return DWT->CYCCNT;
+    }
+
+    static uint32_t cyclesPerMicrosecond() noexcept
+    {
+        return SystemCoreClock / 1000000U;
+    }
+};
+
+// ============================================================================
+// Application
+// ============================================================================
+
+static USART::StandardUSART* g_reportUart = nullptr;
+static UsartLoopbackBackend* g_backend = nullptr;
+
+/**
+ * @brief Blocking report output so the report never competes with the benchmark
+ */
+static void report(const char* format, ...) noexcept
+{
+    char line[160];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (length <= 0) {
+        return;
+    }
+    while (g_reportUart->getAvailableSpace() < static_cast<uint16_t>(length)) {
+    }
+    g_reportUart->sendData(reinterpret_cast<const uint8_t*>(line), static_cast<uint16_t>(length));
+}
+
+/**
+ * @brief One CSV record per case, prefixed with "BENCH," for easy filtering
+ *
+ * Fields: baud,size,sent,verified,dropped,rx_overflow,rx_error,
+ *         bytes_per_s,cycles_per_byte_x100,lat_min_us,lat_max_us,hist0..hist7
+ */
+static void reportCase(const CaseResult& r) noexcept
+{
+    const uint32_t cyclesPerUs = UsartLoopbackBackend::cyclesPerMicrosecond();
+    const uint32_t elapsedUs = (r.elapsedCycles / cyclesPerUs) + 1U;
+    const uint32_t bytesPerSecond = static_cast<uint32_t>((static_cast<uint64_t>(r.bytesVerified) * 1000000ULL) / elapsedUs);
+    const uint32_t cyclesPerByteX100 = (r.bytesSent > 0)
+        ? static_cast<uint32_t>((static_cast<uint64_t>(r.driverCycles) * 100ULL) / r.bytesSent) : 0U;
+
+    report("BENCH,%lu,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu",
+           r.baudRate, r.messageSize, r.bytesSent, r.bytesVerified, r.bytesDropped,
+           r.rxOverflows, r.rxErrors, bytesPerSecond, cyclesPerByteX100,
+           r.latencyMinUs, r.latencyMaxUs);
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        report(",%lu", r.histogram[bucket]);
+    }
+    report("\r\n");
+}
+
+/**
+ * @brief Initialize the report port and the loopback under test
+ */
+void App_Init(void)
+{
+    g_reportUart = new USART::StandardUSART(USART::PeripheralType::LPUART_1);
+    if (!g_reportUart->initialize(USART::getDefaultLpuartConfig()).isSuccess()) {
+        Error_Handler();
+        return;
+    }
+
+    g_backend = new UsartLoopbackBackend();
+}
+
+/**
+ * @brief Run the sweep once, then repeat every few seconds
+ */
+void App_Run(void)
+{
+    if (g_reportUart == nullptr || g_backend == nullptr) {
+        return;
+    }
+
+    while (1) {
+        report("# USART loopback benchmark, USART1 %s, SYSCLK %lu Hz, %lu messages/case\r\n",
+               INTERNAL_LOOPBACK ? "internal" : "PA9-PA10", SystemCoreClock, MESSAGES_PER_CASE);
+        report("# baud,size,sent,verified,dropped,rx_overflow,rx_error,bytes_per_s,"
+               "cycles_per_byte_x100,lat_min_us,lat_max_us,hist_lt64us..hist_ge4096us\r\n");
+
+        for (uint32_t baudRate : BAUD_RATES) {
+            for (uint16_t size : MESSAGE_SIZES) {
+                reportCase(runCase(*g_backend, baudRate, size, MESSAGES_PER_CASE));
+            }
+        }
+        report("# done\r\n");
+
+        for (volatile uint32_t i = 0; i < 5000000; i++) {
+            __NOP();
+        }
+    }
+}
+
+/**
+ * @brief Error handler (weak symbol, can be overridden)
+ */
+__attribute__((weak))
+void Error_Handler(void)
+{
+    while (1) {
+        __NOP();
+    }
+}
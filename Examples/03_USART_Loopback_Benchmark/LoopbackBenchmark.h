@@ -0,0 +1,138 @@
+/**
+ * @file    LoopbackBenchmark.h
+ * @brief   USART loopback benchmark core - one (baud rate, message size) case over any backend
+ * @author  MootSeeker
+ *
+ * runCase() only needs these calls from the backend:
+ * - `UsartStatus configure(uint32_t baudRate)`
+ * - `uint16_t send(const uint8_t*, uint16_t)`, `uint16_t receive(uint8_t*, uint16_t)`
+ * - `uint32_t rxOverflowCount()`, `uint32_t rxErrorCount()`
+ * - `uint32_t cycles()`, `uint32_t cyclesPerMicrosecond()`
+ *
+ * App.cpp drives USART1 with the DWT cycle counter, Tests/Host/LoopbackBenchmarkTest.cpp
+ * the USART model with a clock that follows the line.
+ */
+
+#ifndef EXAMPLES_LOOPBACK_BENCHMARK_H_
+#define EXAMPLES_LOOPBACK_BENCHMARK_H_
+
+#include "usart.h"
+
+#include <cstdint>
+
+/// Latency histogram: bucket n counts round trips below (64 << n) us, the last bucket is open-ended
+static constexpr uint32_t HISTOGRAM_BUCKETS = 8U;
+static constexpr uint32_t HISTOGRAM_FIRST_LIMIT_US = 64U;
+
+/// A CYCCNT step larger than this in the wait loop means an interrupt ran
+static constexpr uint32_t IDLE_LOOP_MAX_CYCLES = 48U;
+
+struct CaseResult
+{
+    uint32_t baudRate;
+    uint16_t messageSize;
+    uint32_t bytesSent;
+    uint32_t bytesVerified;
+    uint32_t bytesDropped;          ///< Missing or corrupted
+    uint32_t rxOverflows;
+    uint32_t rxErrors;
+    uint32_t elapsedCycles;
+    uint32_t driverCycles;          ///< send() calls + interrupt time stolen from the wait loop
+    uint32_t latencyMinUs;
+    uint32_t latencyMaxUs;
+    uint32_t histogram[HISTOGRAM_BUCKETS];
+};
+
+static inline uint8_t patternByte(uint32_t message, uint32_t index) noexcept
+{
+    return static_cast<uint8_t>((message * 31U) + index);
+}
+
+static inline uint32_t histogramBucket(uint32_t latencyUs) noexcept
+{
+    uint32_t bucket = 0;
+    uint32_t limit = HISTOGRAM_FIRST_LIMIT_US;
+    while (bucket < (HISTOGRAM_BUCKETS - 1U) && latencyUs >= limit) {
+        limit <<= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Send a number of messages and wait for each echo
+ *
+ * Interrupt cost is measured by cycle stealing: the wait loop only reads
+ * CYCCNT, so any step above IDLE_LOOP_MAX_CYCLES is time spent in an ISR.
+ */
+template<typename Backend>
+static CaseResult runCase(Backend& backend, uint32_t baudRate, uint16_t messageSize, uint32_t messages) noexcept
+{
+    CaseResult result{};
+    result.baudRate = baudRate;
+    result.messageSize = messageSize;
+    result.latencyMinUs = UINT32_MAX;
+
+    if (!backend.configure(baudRate).isSuccess()) {
+        return result;
+    }
+
+    const uint32_t overflowsBefore = backend.rxOverflowCount();
+    const uint32_t errorsBefore = backend.rxErrorCount();
+
+    // Frame time (10 bits/byte) x 4 plus 1 ms before a message is declared lost
+    const uint32_t timeoutCycles = (backend.cyclesPerMicrosecond() * 1000000U / baudRate) * 10U * messageSize * 4U
+                                 + backend.cyclesPerMicrosecond() * 1000U;
+
+    uint8_t tx[256];
+    uint8_t rx[256];
+    const uint32_t caseStart = backend.cycles();
+
+    for (uint32_t message = 0; message < messages; message++) {
+        for (uint16_t i = 0; i < messageSize; i++) {
+            tx[i] = patternByte(message, i);
+        }
+
+        const uint32_t start = backend.cycles();
+        const uint16_t queued = backend.send(tx, messageSize);
+        uint32_t last = backend.cycles();
+        result.driverCycles += last - start;
+        result.bytesSent += queued;
+
+        uint16_t received = 0;
+        while (received < queued && (last - start) < timeoutCycles) {
+            received += backend.receive(&rx[received], static_cast<uint16_t>(queued - received));
+            const uint32_t now = backend.cycles();
+            if ((now - last) > IDLE_LOOP_MAX_CYCLES) {
+                result.driverCycles += (now - last) - IDLE_LOOP_MAX_CYCLES;
+            }
+            last = now;
+        }
+
+        uint16_t verified = 0;
+        for (uint16_t i = 0; i < received; i++) {
+            if (rx[i] == tx[i]) {
+                verified++;
+            }
+        }
+        result.bytesVerified += verified;
+        result.bytesDropped += static_cast<uint32_t>(messageSize) - verified;
+
+        if (received == queued) {
+            const uint32_t latencyUs = (last - start) / backend.cyclesPerMicrosecond();
+            result.latencyMinUs = (latencyUs < result.latencyMinUs) ? latencyUs : result.latencyMinUs;
+            result.latencyMaxUs = (latencyUs > result.latencyMaxUs) ? latencyUs : result.latencyMaxUs;
+            result.histogram[histogramBucket(latencyUs)]++;
+        }
+    }
+
+    result.elapsedCycles = backend.cycles() - caseStart;
+    result.rxOverflows = backend.rxOverflowCount() - overflowsBefore;
+    result.rxErrors = backend.rxErrorCount() - errorsBefore;
+    if (result.latencyMinUs == UINT32_MAX) {
+        result.latencyMinUs = 0;
+    }
+    return result;
+}
+
+#endif /* EXAMPLES_LOOPBACK_BENCHMARK_H_ */
@@ -0,0 +1,206 @@
+/**
+ * @file    BaudSwitch.h
+ * @brief   Baud rate negotiation handshake with confirmation and fallback
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * The boot console runs at a compatible rate (115200). For bulk transfers
+ * the host asks for a faster rate, both ends switch and the new rate is only
+ * kept after a confirmation round trip at that rate:
+ *
+ * ```
+ *   host                                   device (old rate)
+ *   "baud 2000000\r"            ------>    validate against kernel clock
+ *                               <------    "baud ack 2000000\r\n" | "baud nak <max>\r\n"
+ *   wait SETTLE_MS, switch                 TX drained (incl. prompt) -> switch
+ *                                          (new rate)
+ *   "baud confirm 2000000\r"    ------>
+ *                               <------    "baud locked 2000000\r\n"
+ * ```
+ *
+ * Without a confirmation within CONFIRM_TIMEOUT_MS the device returns to the
+ * previous rate; the host gives up LOCK_TIMEOUT_MS after switching, which is
+ * later, so both ends are back on the old rate when it retries. The same
+ * handshake is used to return to 115200 after the transfer; a reset restores
+ * the boot rate as well.
+ *
+ * The frames are console lines, so the device side plugs into the shell as
+ * one command:
+ *
+ * @code
+ * static BaudSwitch::Negotiator negotiator(*lpuart);
+ *
+ * static constexpr Shell::Command COMMANDS[] = {
+ *     {"baud", "baud [confirm] <rate> - change the console baud rate",
+ *      BaudSwitch::Negotiator::shellCommand, &negotiator},
+ * };
+ *
+ * // App_Run():
+ * console->poll();
+ * negotiator.poll(tickMs);
+ * @endcode
+ *
+ * `Host` is the portable host-side state machine; it talks to the serial
+ * port through the small HostPort interface.
+ *
+ * ## Throughput (64 KB dump, 8N1)
+ *
+ * | Baud rate | Transfer time |
+ * |-----------|---------------|
+ * | 115200    | 5.7 s         |
+ * | 2000000   | 0.33 s        |
+ * | 4000000   | 0.16 s        |
+ *
+ * 4 Mbaud needs USART_1..3 with 8x oversampling at 32 MHz PCLK and a host
+ * adapter that supports it; check the limit of the ST-LINK virtual COM
+ * port before using LPUART1 above 2 Mbaud.
+ */
+
+#ifndef LIBRARY_INC_BAUDSWITCH_H_
+#define LIBRARY_INC_BAUDSWITCH_H_
+
+#include "usart.h"
+#include "Shell.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace BaudSwitch
+ * @brief Console baud rate negotiation, device and host side
+ */
+namespace BaudSwitch
+{
+    static constexpr uint32_t CONFIRM_TIMEOUT_MS = 500;   ///< Device: wait for "baud confirm"
+    static constexpr uint32_t SETTLE_MS = 20;             ///< Host: delay between ack and switch
+    static constexpr uint32_t ACK_TIMEOUT_MS = 200;       ///< Host: wait for ack/nak
+    static constexpr uint32_t LOCK_TIMEOUT_MS = 600;      ///< Host: wait for "baud locked"
+
+    /**
+     * @class Negotiator
+     * @brief Device side of the handshake
+     */
+    class Negotiator
+    {
+    public:
+        enum class State : uint8_t
+        {
+            IDLE,
+            DRAINING,        ///< Ack queued at the old rate, switch once TX is idle
+            AWAIT_CONFIRM    ///< Running at the new rate on probation
+        };
+
+        explicit Negotiator(USART::StandardUSART& uart) noexcept;
+
+        /**
+         * @brief Host asks for a new rate; answers ack or nak at the current rate
+         * @return true if the rate was accepted
+         */
+        bool request(uint32_t baudRate) noexcept;
+
+        /**
+         * @brief Host confirms from the new rate; answers "baud locked"
+         * @return true if the confirmation matched the pending switch
+         */
+        bool confirm(uint32_t baudRate) noexcept;
+
+        /**
+         * @brief Switch after the ack has left, fall back on timeout
+         * @param nowMs Free-running millisecond tick
+         */
+        void poll(uint32_t nowMs) noexcept;
+
+        [[nodiscard]] State getState() const noexcept { return state; }
+        [[nodiscard]] uint32_t getFallbackCount() const noexcept { return fallbacks; }
+
+        /**
+         * @brief Shell handler for `baud`, `baud <rate>` and `baud confirm <rate>`
+         * @param context Negotiator
+         */
+        static void shellCommand(Shell::Console& console, const Shell::Args& args, void* context);
+
+    private:
+        USART::StandardUSART& uart;
+        State state;
+        uint32_t previousRate;
+        uint32_t targetRate;
+        uint32_t deadline;
+        uint32_t fallbacks;
+    };
+
+    /**
+     * @class HostPort
+     * @brief Serial port access needed by Host (implemented by the host tool)
+     */
+    class HostPort
+    {
+    public:
+        virtual void write(const char* text) = 0;
+        virtual void setBaudRate(uint32_t baudRate) = 0;
+
+    protected:
+        ~HostPort() = default;
+    };
+
+    /**
+     * @class Host
+     * @brief Host side of the handshake (portable C++)
+     *
+     * Feed every received console line to receiveLine() and call poll()
+     * regularly; after begin() the state ends in LOCKED or FAILED, with the
+     * port on the new or the previous rate respectively.
+     */
+    class Host
+    {
+    public:
+        enum class State : uint8_t
+        {
+            IDLE,
+            AWAIT_ACK,
+            SETTLING,
+            AWAIT_LOCK,
+            LOCKED,
+            FAILED
+        };
+
+        Host(HostPort& port, uint32_t currentRate) noexcept;
+
+        /**
+         * @brief Send the request for a new rate
+         * @return false if a negotiation is already running
+         */
+        bool begin(uint32_t baudRate, uint32_t nowMs) noexcept;
+
+        /**
+         * @brief Process one line received from the device (without line end)
+         */
+        void receiveLine(const char* line, uint32_t nowMs) noexcept;
+
+        /**
+         * @brief Advance timers: switch after SETTLE_MS, fall back on timeouts
+         */
+        void poll(uint32_t nowMs) noexcept;
+
+        [[nodiscard]] State getState() const noexcept { return state; }
+        [[nodiscard]] uint32_t getBaudRate() const noexcept { return currentRate; }
+
+        /**
+         * @brief Highest rate reported by a nak (0 if none)
+         */
+        [[nodiscard]] uint32_t getDeviceMaxRate() const noexcept { return deviceMaxRate; }
+
+    private:
+        HostPort& port;
+        State state;
+        uint32_t currentRate;
+        uint32_t targetRate;
+        uint32_t deviceMaxRate;
+        uint32_t deadline;
+
+        void send(const char* command, uint32_t baudRate) noexcept;
+    };
+
+} // namespace BaudSwitch
+
+#endif /* LIBRARY_INC_BAUDSWITCH_H_ */
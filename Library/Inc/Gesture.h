@@ -0,0 +1,174 @@
+/**
+ * @file    Gesture.h
+ * @brief   Button gestures (click, double-click, long-press, repeat) from debounced edges
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * A ButtonSet turns debounced press/release edges of up to 32 buttons into
+ * gestures. Every decision is made from timestamps: an edge carries its
+ * time, and a gesture that is decided by time passing (click after the
+ * double-click window, long press, repeat) is reported with the time of
+ * its deadline, not with the time advance() happened to run:
+ *
+ * ```
+ *   press ----------- release            < doubleClickMs >  CLICK (at window end)
+ *   press -- release -- press -- release                    DOUBLE_CLICK (at 2nd release)
+ *   press ---------------------------->| longPressMs        LONG_PRESS
+ *                                       |-- repeatMs --|     REPEAT, REPEAT, ... until release
+ * ```
+ *
+ * A second press that turns into a long press reports CLICK and then
+ * LONG_PRESS. With doubleClickMs = 0 a click is reported at its release
+ * (no waiting); with repeatMs = 0 a held button reports LONG_PRESS only.
+ *
+ * ## Usage
+ *
+ * @code
+ * static void onGesture(void* context, uint8_t button, Gesture::Type gesture, uint32_t timeMs)
+ * {
+ *     if (button == 3 && gesture == Gesture::Type::CLICK) { nextPattern(); }
+ * }
+ *
+ * static Gesture::ButtonSet buttons(Gesture::DEFAULT_TIMING, onGesture, nullptr);
+ *
+ * // Main loop, with the Debounce::PortScanner of the panel:
+ * const uint32_t nowMs = panel.getSampleCount() * SAMPLE_MS;
+ * uint32_t levels;
+ * const Debounce::Edges edges = panel.takeEdges(levels);
+ * buttons.update(edges, levels, nowMs);
+ * @endcode
+ *
+ * Buttons are the lanes of Debounce::Edges (bit n = button n). Event
+ * sources with their own timestamps call press()/release() per edge and
+ * advance() when idle; nextDeadline() tells a scheduler when the next
+ * timed gesture is due, so nothing has to poll in a loop.
+ *
+ * ## Verification (Tests/Host/GestureTest.cpp)
+ *
+ * Synthetic edge traces with the default timing, each gesture with
+ * release/press gaps on both sides of the window limits. Each trace runs with
+ * advance() called late by 1..50 ms, and with no advance() calls at all
+ * between the edges:
+ *
+ * | Trace                                 | Expected                        |
+ * |---------------------------------------|---------------------------------|
+ * | 80 ms press                           | CLICK at release + 250 ms       |
+ * | Two presses, gap 249 ms               | DOUBLE_CLICK at 2nd release     |
+ * | Two presses, gap 250 ms               | CLICK, CLICK                    |
+ * | 599 ms / 600 ms press                 | CLICK / LONG_PRESS at press+600 |
+ * | 1000 ms press, repeat 150 ms          | LONG_PRESS, 2 x REPEAT          |
+ * | Click, then long second press         | CLICK, LONG_PRESS               |
+ * | Timestamps across the 2^32 ms wrap    | Same as above                   |
+ *
+ * update() is also checked with both edges of a button in one call.
+ *
+ * @note Feed debounced edges (Debounce.h): raw contact bounce would be
+ *       classified as double clicks.
+ * @note Not interrupt-safe; call all methods from one context.
+ */
+
+#ifndef LIBRARY_INC_GESTURE_H_
+#define LIBRARY_INC_GESTURE_H_
+
+#include "Debounce.h"
+
+#include <cstdint>
+
+/**
+ * @namespace Gesture
+ * @brief Timestamp-driven button gesture recognition
+ */
+namespace Gesture
+{
+    static constexpr uint8_t MAX_BUTTONS = 32;
+
+    enum class Type : uint8_t
+    {
+        CLICK,
+        DOUBLE_CLICK,
+        LONG_PRESS,
+        REPEAT
+    };
+
+    /**
+     * @struct Timing
+     * @brief Gesture time limits in milliseconds
+     */
+    struct Timing
+    {
+        uint32_t doubleClickMs;     ///< Release-to-press window for a double click (0 = disabled)
+        uint32_t longPressMs;       ///< Hold time for LONG_PRESS
+        uint32_t repeatMs;          ///< REPEAT interval after LONG_PRESS (0 = disabled)
+    };
+
+    static constexpr Timing DEFAULT_TIMING = {250, 600, 150};
+
+    /// Gesture callback; timeMs is the time the gesture was decided
+    using Handler = void (*)(void* context, uint8_t button, Type gesture, uint32_t timeMs);
+
+    /**
+     * @class ButtonSet
+     * @brief Gesture state machines of up to 32 buttons sharing one timing
+     */
+    class ButtonSet
+    {
+    public:
+        ButtonSet(const Timing& timing, Handler handler, void* context) noexcept;
+
+        /**
+         * @brief Process the debounced edges that happened at nowMs
+         * @param levels Debounced state the edges lead to (bit n = button n down)
+         *
+         * Gestures due before nowMs are reported first. A button with both
+         * edges is taken as press then release if it is up, as release then
+         * press if it is down.
+         */
+        void update(const Debounce::Edges& edges, uint32_t levels, uint32_t nowMs) noexcept;
+
+        /**
+         * @brief One edge of one button; gestures due before timeMs are reported first
+         */
+        void press(uint8_t button, uint32_t timeMs) noexcept;
+        void release(uint8_t button, uint32_t timeMs) noexcept;
+
+        /**
+         * @brief Report every timed gesture due at or before nowMs
+         */
+        void advance(uint32_t nowMs) noexcept;
+
+        /**
+         * @brief Earliest pending deadline
+         * @param deadlineMs Set to the deadline if there is one
+         * @return false if no button waits for time to pass
+         */
+        bool nextDeadline(uint32_t& deadlineMs) const noexcept;
+
+        void setTiming(const Timing& newTiming) noexcept { timing = newTiming; }
+
+    private:
+        enum class State : uint8_t
+        {
+            IDLE,
+            PRESSED,            ///< First press, deadline = long press
+            WAIT_SECOND,        ///< Released, deadline = end of double-click window
+            SECOND_PRESSED,     ///< Second press, deadline = long press
+            HELD                ///< Long press reported, deadline = next repeat
+        };
+
+        Timing timing;
+        Handler handler;
+        void* context;
+        State states[MAX_BUTTONS];
+        uint32_t deadlines[MAX_BUTTONS];
+        uint32_t timedMask;         ///< Buttons with a pending deadline
+
+        void emit(uint8_t button, Type gesture, uint32_t timeMs) noexcept;
+        void setDeadline(uint8_t button, uint32_t deadlineMs) noexcept;
+        void clearDeadline(uint8_t button) noexcept;
+        void expire(uint8_t button) noexcept;
+    };
+
+} // namespace Gesture
+
+#endif /* LIBRARY_INC_GESTURE_H_ */
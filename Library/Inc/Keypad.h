@@ -0,0 +1,217 @@
+/**
+ * @file    Keypad.h
+ * @brief   DMA-driven key matrix scanner with ghosting detection and debouncing
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Scanning a key matrix from the main loop costs CPU for every row and
+ * the scan rate follows the loop. The MatrixScanner lets two DMA channels
+ * do the scanning, paced by one timer: at the start of each step, channel
+ * 1 compare writes the next row-select word to the row port's BSRR; just
+ * before the end of the step, channel 2 compare copies the column port's
+ * IDR into a double buffer. The rows settle for almost the whole step:
+ *
+ * ```
+ *   TIM1 CC1 (tick 1)   --DMA1 Ch2--> rowWords[r]  -> rowPort->BSRR   (row r low, others released)
+ *   TIM1 CC2 (last tick) --DMA1 Ch3--> colPort->IDR -> samples[half][r]
+ *   half-transfer / transfer-complete interrupt: decode one full scan
+ * ```
+ *
+ * The CPU only runs once per full scan. The interrupt then decodes the
+ * finished half while DMA fills the other one:
+ * - It packs the rows into one key word (key = row x columns + column,
+ *   1 = pressed).
+ * - It blanks ghost rectangles.
+ * - It debounces all keys at once with Debounce::VerticalCounter, so a key
+ *   changes state after 4 equal scans.
+ *
+ * ## Ghosting
+ *
+ * Without diodes, three pressed corners of a rectangle make the fourth
+ * read as pressed. Any two rows that share two or more pressed columns
+ * form such a rectangle; its keys are ambiguous and keep their last
+ * unambiguous level until the rectangle dissolves. Keys already held stay
+ * held, a phantom key is never reported, and the ghost scans are counted.
+ *
+ * ## Usage
+ *
+ * @code
+ * // 4 x 6 matrix: rows PB12..PB15 (open-drain), columns PC0..PC5 (pull-up)
+ * GPIO::Port(GPIOB).configure(0xF000, GPIO::PinMode::OUTPUT, GPIO::PinPull::NO_PULL,
+ *                             GPIO::PinSpeed::LOW, GPIO::PinOutputType::OPEN_DRAIN);
+ * GPIO::Port(GPIOC).configure(0x003F, GPIO::PinMode::INPUT, GPIO::PinPull::PULL_UP);
+ *
+ * static Keypad::MatrixScanner keypad({GPIOB, 12, 4, GPIOC, 0, 6});
+ * keypad.start(2000);                      // Full scan every 2 ms, 8 ms debounce
+ *
+ * // Main loop:
+ * const Debounce::Edges keys = keypad.takeEdges();
+ * if (keys.pressed & (1U << (2 * 6 + 5))) { ... }   // Row 2, column 5 pressed
+ * @endcode
+ *
+ * ## Interrupt Load
+ *
+ * There is one interrupt per full scan, whatever the number of rows: 1000,
+ * 500 or 200 per second at a scan interval of 1, 2 or 5 ms. A main loop
+ * scan of the same 4-row matrix would instead busy-wait the settle time
+ * of every row, at 5 us that is 4 x 5 us x 32 MHz = 640 cycles per scan
+ * before any decoding.
+ *
+ * Tests/Host/KeypadTest.cpp runs the scanner on a model of both DMA
+ * channels and a 4 x 6 matrix whose released rows float, so three pressed
+ * corners of a rectangle ghost the fourth. At all three intervals, 20
+ * single presses with 0.2..3 ms of contact bounce and 5 three-corner
+ * chords give one interrupt per scan, every press and release reported
+ * exactly once, and no phantom key. A key that completes a rectangle is
+ * reported once one of the other corners is released, because before that
+ * it cannot be told apart from the phantom. The test also prints the host
+ * time of the interrupt handler with no key pressed and with all 6 row
+ * pairs in ghost rectangles; on the target, read DWT->CYCCNT around
+ * KEYPAD_HandleDmaInterrupt().
+ *
+ * @note Uses TIM1 (compare 1 and 2 DMA requests, no timer interrupt) and
+ *       DMA1 Channels 2 and 3 (request 7). The channels are also the
+ *       USART_3 channels of the USART DMA bridge; whichever takes them
+ *       first keeps them (start() returns false, the bridge reports BUSY).
+ *       TIM1 also paces the logic analyzer capture; start() fails while
+ *       it runs.
+ * @note DMA1_Channel3_IRQHandler must call `KEYPAD_HandleDmaInterrupt()`
+ *       before the USART bridge handler.
+ */
+
+#ifndef LIBRARY_INC_KEYPAD_H_
+#define LIBRARY_INC_KEYPAD_H_
+
+#include "Debounce.h"
+
+#include <cstdint>
+
+// C interface for the DMA1 Channel 3 interrupt handler
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void KEYPAD_HandleDmaInterrupt(void);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @namespace Keypad
+ * @brief Key matrix scanning without CPU involvement per row
+ */
+namespace Keypad
+{
+    static constexpr uint8_t MAX_ROWS = 8;
+    static constexpr uint8_t MAX_KEYS = 32;                 ///< rows x columns
+    static constexpr uint32_t MIN_STEP_US = 20;             ///< Per row: switching plus settling
+    static constexpr uint32_t MAX_SCAN_INTERVAL_US = 65535;
+
+    /**
+     * @struct Matrix
+     * @brief Wiring of the matrix: rows driven low one at a time, columns read
+     *
+     * Rows and columns are consecutive pins. Rows should be open-drain (or
+     * the keys have diodes) so that two pressed keys in one column do not
+     * short two rows. Columns need pull-ups.
+     */
+    struct Matrix
+    {
+        GPIO_TypeDef* rowPort;
+        uint8_t firstRow;       ///< Pin of row 0
+        uint8_t rows;           ///< 1..MAX_ROWS
+        GPIO_TypeDef* columnPort;
+        uint8_t firstColumn;    ///< Pin of column 0
+        uint8_t columns;        ///< rows x columns <= MAX_KEYS
+    };
+
+    /**
+     * @class MatrixScanner
+     * @brief Scans a key matrix on TIM1 + DMA and debounces every key
+     *
+     * Edges accumulate until the main loop takes them, as with
+     * Debounce::PortScanner.
+     */
+    class MatrixScanner
+    {
+    public:
+        explicit MatrixScanner(const Matrix& matrix) noexcept;
+
+        /**
+         * @brief Stops scanning
+         */
+        ~MatrixScanner();
+
+        MatrixScanner(const MatrixScanner&) = delete;
+        MatrixScanner& operator=(const MatrixScanner&) = delete;
+
+        /**
+         * @brief Start scanning (one scanner per device)
+         * @param scanIntervalUs Full scan period, up to MAX_SCAN_INTERVAL_US and at least
+         *                       rows x MIN_STEP_US; debounce time is 4 scans
+         * @return false if TIM1 or DMA1 Channel 2/3 is in use, the matrix is invalid or the
+         *         interval is out of range
+         */
+        bool start(uint32_t scanIntervalUs) noexcept;
+
+        /**
+         * @brief Stop the timer and the DMA; all rows are released
+         */
+        void stop() noexcept;
+
+        [[nodiscard]] bool isRunning() const noexcept { return running; }
+
+        /**
+         * @brief Take and clear the key edges collected since the last call
+         */
+        Debounce::Edges takeEdges() noexcept;
+
+        /**
+         * @brief Debounced state of all keys (bit row x columns + column, 1 = pressed)
+         */
+        [[nodiscard]] uint32_t getState() const noexcept { return debounced; }
+
+        [[nodiscard]] uint32_t getScanCount() const noexcept { return scans; }
+
+        /**
+         * @brief Scans in which a ghost rectangle was blanked
+         */
+        [[nodiscard]] uint32_t getGhostScanCount() const noexcept { return ghostScans; }
+
+        /**
+         * @brief Scans lost because a half was overwritten before it was decoded
+         */
+        [[nodiscard]] uint32_t getMissedScanCount() const noexcept { return missedScans; }
+
+        /**
+         * @brief Decode one full scan of column samples (row r in samples[r])
+         *
+         * Called from the DMA interrupt for the half that was just filled.
+         */
+        void decode(const uint16_t* samples) noexcept;
+
+        /**
+         * @brief DMA interrupt work (called from KEYPAD_HandleDmaInterrupt)
+         */
+        void handleDmaInterrupt(uint32_t flags) noexcept;
+
+    private:
+        Matrix matrix;
+        uint32_t rowWords[MAX_ROWS];            ///< BSRR word per row step (DMA source)
+        uint16_t samples[2 * MAX_ROWS];         ///< Column IDR per row step, two scans (DMA target)
+        Debounce::VerticalCounter<uint32_t> counter;
+        uint32_t raw;                           ///< Last key word, ghost keys held
+        volatile bool running;
+        volatile uint32_t debounced;
+        volatile uint32_t pressed;
+        volatile uint32_t released;
+        volatile uint32_t scans;
+        volatile uint32_t ghostScans;
+        volatile uint32_t missedScans;
+
+        [[nodiscard]] bool isValid() const noexcept;
+    };
+
+} // namespace Keypad
+
+#endif /* LIBRARY_INC_KEYPAD_H_ */
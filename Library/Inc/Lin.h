@@ -0,0 +1,434 @@
+/**
+ * @file    Lin.h
+ * @brief   LIN 2.x master schedule tables and slave responses on the USART
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * The master sends the header of every frame; the node that publishes the
+ * frame (master or slave) sends the response:
+ *
+ * ```
+ *   | break (13+ bits) | sync 0x55 | PID | data 1..8 | checksum |
+ *   |<---------- header (master) ---->|<---- response (publisher) -->|
+ * ```
+ *
+ * - PID: 6-bit frame ID plus two parity bits (protectedId())
+ * - Checksum: inverted 8-bit sum with carry wrap over the data (classic,
+ *   LIN 1.x and diagnostic frames 0x3C/0x3D) or over PID and data
+ *   (enhanced, LIN 2.x)
+ *
+ * Both node types run the same receive state machine in the USART
+ * interrupt: break (hardware LIN break detection) -> sync -> PID -> data,
+ * with the checksum accumulated byte by byte. A LIN transceiver echoes
+ * everything sent, so a node also receives its own header and responses;
+ * a response this node publishes is read back and checked like any other.
+ *
+ * ## Usage
+ *
+ * @code
+ * static uint8_t motorCommand[4];
+ * static uint8_t motorStatus[8];
+ *
+ * static constexpr Lin::Frame FRAMES[] = {
+ *     {0x10, 4, Lin::Direction::PUBLISH,   Lin::ChecksumModel::ENHANCED, motorCommand},
+ *     {0x11, 8, Lin::Direction::SUBSCRIBE, Lin::ChecksumModel::ENHANCED, motorStatus},
+ * };
+ * static constexpr Lin::Slot SCHEDULE[] = {
+ *     {0, 10000},                          // frame index, slot length in us
+ *     {1, 10000},
+ * };
+ * static_assert(Lin::FrameTable(FRAMES).isValid());
+ * static_assert(Lin::ScheduleTable(SCHEDULE).isValid(Lin::FrameTable(FRAMES), 19200));
+ *
+ * auto uart = new USART::StandardUSART(USART::PeripheralType::USART_1);
+ * uart->initialize({19200, 0, 0, 0, 0, USART_CR1_TE | USART_CR1_RE});
+ * static Lin::Master master(*uart, FRAMES, SCHEDULE);
+ * master.start();
+ * @endcode
+ *
+ * A slave uses the same frame table with the directions seen from its
+ * side and `Lin::Slave slave(*uart, FRAMES); slave.start();`.
+ *
+ * ## Schedule timing
+ *
+ * TIM6 counts microseconds. The length of the next slot is written to the
+ * preloaded auto-reload register one slot ahead, so slot boundaries come
+ * from the free-running counter and interrupt latency never accumulates.
+ * Only the start of each break moves, by the latency of the timer
+ * interrupt: a fixed part (entry and the path up to the break request)
+ * plus whatever same-priority interrupt is running at the boundary.
+ *
+ * With L the latency of the timer interrupt at a boundary:
+ *
+ * | Scheme | Break start error | Drift |
+ * |--------|-------------------|-------|
+ * | TIM6 with preloaded ARR (this module) | L of that boundary | none |
+ * | Timer restarted in the interrupt | L of that boundary | sum of all L so far |
+ * | Main loop with a 1 ms tick | up to one tick plus the loop time | none |
+ *
+ * Tests/Host/LinTest.cpp runs a master against a slave for 3000 slots and
+ * delays every timer interrupt by a random 0..40 us. Each break started
+ * exactly the latency of its own boundary after nominal (0..40 us), no
+ * boundary drifted and every frame ended before the next break. With the
+ * counter restarted in the interrupt instead, the same run drifts by
+ * 61 ms. The LIN bit time is 52 us at 19200 baud; as long as no
+ * same-priority interrupt runs for that long, the break jitter stays below
+ * one bit.
+ *
+ * @note Received data is copied to Frame::data in the RX interrupt once the
+ *       checksum matched, and published data is read there when the PID
+ *       arrives. Update or read a buffer outside its own slot to avoid
+ *       torn values.
+ * @note The node owns the RX callback of its USART; LIN mode requires
+ *       USART_1..3 (LPUART_1 has no break detection).
+ */
+
+#ifndef LIBRARY_INC_LIN_H_
+#define LIBRARY_INC_LIN_H_
+
+#include "usart.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// C interface for the schedule timer interrupt
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void LIN_HandleScheduleTimerInterrupt(void);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @namespace Lin
+ * @brief LIN master/slave frame handling
+ */
+namespace Lin
+{
+    static constexpr uint8_t SYNC_BYTE = 0x55;
+    static constexpr uint8_t MAX_ID = 0x3F;
+    static constexpr uint8_t MAX_DATA_LENGTH = 8;
+    static constexpr uint8_t MASTER_REQUEST_ID = 0x3C;     ///< Diagnostic, always classic checksum
+    static constexpr uint8_t SLAVE_RESPONSE_ID = 0x3D;     ///< Diagnostic, always classic checksum
+    static constexpr uint32_t MAX_SLOT_US = 65536;          ///< TIM6 is a 16-bit counter at 1 MHz
+
+    /**
+     * @enum Direction
+     * @brief Response direction as seen from this node
+     */
+    enum class Direction : uint8_t
+    {
+        PUBLISH,      ///< This node sends the response
+        SUBSCRIBE     ///< This node receives the response
+    };
+
+    /**
+     * @enum ChecksumModel
+     */
+    enum class ChecksumModel : uint8_t
+    {
+        CLASSIC,      ///< Data bytes only (LIN 1.x, diagnostic frames)
+        ENHANCED      ///< PID and data bytes (LIN 2.x)
+    };
+
+    /**
+     * @brief Frame description; data points to a buffer of length bytes
+     */
+    struct Frame
+    {
+        uint8_t id;
+        uint8_t length;
+        Direction direction;
+        ChecksumModel checksum;
+        uint8_t* data;
+    };
+
+    /**
+     * @brief One schedule table entry
+     */
+    struct Slot
+    {
+        uint8_t frame;        ///< Index into the frame table
+        uint32_t durationUs;  ///< Time until the next header (1..MAX_SLOT_US)
+    };
+
+    /**
+     * @brief Node statistics, updated in interrupt context
+     */
+    struct Statistics
+    {
+        uint32_t frames;          ///< Responses with a valid checksum
+        uint32_t responseErrors;  ///< Wrong checksum or incomplete response
+        uint32_t noResponse;      ///< Header without any response byte
+        uint32_t headerErrors;    ///< Bad sync byte, PID parity or missing header echo
+        uint32_t overruns;        ///< Master: slot started while TX was still busy
+    };
+
+    /**
+     * @brief Protected identifier: ID bits 0..5, P0 = ID0^ID1^ID2^ID4, P1 = !(ID1^ID3^ID4^ID5)
+     */
+    [[nodiscard]] constexpr uint8_t protectedId(uint8_t id) noexcept
+    {
+        const uint8_t bits = id & MAX_ID;
+        const uint8_t p0 = ((bits >> 0) ^ (bits >> 1) ^ (bits >> 2) ^ (bits >> 4)) & 1U;
+        const uint8_t p1 = static_cast<uint8_t>(~((bits >> 1) ^ (bits >> 3) ^ (bits >> 4) ^ (bits >> 5)) & 1U);
+        return static_cast<uint8_t>(bits | (p0 << 6) | (p1 << 7));
+    }
+
+    /**
+     * @brief Add one byte to a running LIN sum (8-bit with carry wrap)
+     */
+    [[nodiscard]] constexpr uint8_t addToSum(uint8_t sum, uint8_t data) noexcept
+    {
+        const uint16_t total = static_cast<uint16_t>(sum + data);
+        return static_cast<uint8_t>((total > 0xFFU) ? (total - 0xFFU) : total);
+    }
+
+    /**
+     * @brief Checksum byte for a response
+     * @param pid Protected identifier (ignored for the classic model)
+     */
+    [[nodiscard]] constexpr uint8_t checksum(ChecksumModel model, uint8_t pid, const uint8_t* data, uint8_t length) noexcept
+    {
+        uint8_t sum = (model == ChecksumModel::ENHANCED) ? pid : 0U;
+        for (uint8_t i = 0; i < length; i++)
+        {
+            sum = addToSum(sum, data[i]);
+        }
+        return static_cast<uint8_t>(~sum);
+    }
+
+    /**
+     * @brief Longest allowed frame time: 1.4 x (34 + 10 x (length + 1)) bit times
+     */
+    [[nodiscard]] constexpr uint32_t maxFrameTimeUs(uint8_t length, uint32_t baudRate) noexcept
+    {
+        const uint64_t bits14 = 14ULL * (34U + 10U * (length + 1U));   // x10
+        return static_cast<uint32_t>((bits14 * 1000000ULL + 10ULL * baudRate - 1U) / (10ULL * baudRate));
+    }
+
+    /**
+     * @class FrameTable
+     * @brief Non-owning view over a constexpr array of frames
+     */
+    class FrameTable
+    {
+    private:
+        const Frame* frames;
+        uint8_t count;
+
+    public:
+        template<size_t N>
+        constexpr FrameTable(const Frame (&table)[N]) noexcept : frames(table), count(static_cast<uint8_t>(N))
+        {
+            static_assert(N > 0 && N <= MAX_ID + 1U, "Frame table must contain 1..64 frames");
+        }
+
+        /**
+         * @brief Check IDs, lengths, buffers and diagnostic checksums (usable in static_assert)
+         */
+        [[nodiscard]] constexpr bool isValid() const noexcept
+        {
+            for (uint8_t i = 0; i < count; i++)
+            {
+                const Frame& frame = frames[i];
+                if (frame.id > MAX_ID || frame.length == 0 || frame.length > MAX_DATA_LENGTH || frame.data == nullptr)
+                {
+                    return false;
+                }
+                if ((frame.id == MASTER_REQUEST_ID || frame.id == SLAVE_RESPONSE_ID) &&
+                    frame.checksum != ChecksumModel::CLASSIC)
+                {
+                    return false;
+                }
+                for (uint8_t j = static_cast<uint8_t>(i + 1U); j < count; j++)
+                {
+                    if (frames[j].id == frame.id)
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] constexpr uint8_t size() const noexcept { return count; }
+        [[nodiscard]] constexpr const Frame& operator[](uint8_t index) const noexcept { return frames[index]; }
+    };
+
+    /**
+     * @class ScheduleTable
+     * @brief Non-owning view over a constexpr array of slots, run cyclically
+     */
+    class ScheduleTable
+    {
+    private:
+        const Slot* slots;
+        uint8_t count;
+
+    public:
+        template<size_t N>
+        constexpr ScheduleTable(const Slot (&table)[N]) noexcept : slots(table), count(static_cast<uint8_t>(N))
+        {
+            static_assert(N > 0 && N <= 255, "Schedule table must contain 1..255 slots");
+        }
+
+        /**
+         * @brief Check frame indices and that every slot fits its longest frame
+         * @param baudRate Bus baud rate used for the frame time
+         */
+        [[nodiscard]] constexpr bool isValid(const FrameTable& frames, uint32_t baudRate) const noexcept
+        {
+            if (baudRate == 0)
+            {
+                return false;
+            }
+            for (uint8_t i = 0; i < count; i++)
+            {
+                const Slot& slot = slots[i];
+                if (slot.frame >= frames.size() || slot.durationUs > MAX_SLOT_US ||
+                    slot.durationUs < maxFrameTimeUs(frames[slot.frame].length, baudRate))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] constexpr uint8_t size() const noexcept { return count; }
+        [[nodiscard]] constexpr const Slot& operator[](uint8_t index) const noexcept { return slots[index]; }
+    };
+
+    /**
+     * @brief Callback invoked from the RX interrupt after a valid response
+     * @param context User pointer passed at registration
+     * @param frame Frame whose buffer was just received (or read back)
+     */
+    using FrameCallback = void (*)(void* context, const Frame& frame);
+
+    /**
+     * @class Node
+     * @brief Receive state machine and response handling shared by master and slave
+     */
+    class Node
+    {
+    public:
+        /**
+         * @brief Hook called for every frame with a valid response
+         */
+        void setFrameCallback(FrameCallback callback, void* context) noexcept;
+
+        [[nodiscard]] const Statistics& getStatistics() const noexcept { return statistics; }
+        [[nodiscard]] const FrameTable& getFrames() const noexcept { return frames; }
+
+    protected:
+        enum class RxState : uint8_t
+        {
+            IDLE,     ///< Waiting for a break
+            SYNC,     ///< Break seen, expecting 0x55
+            PID,      ///< Expecting the protected identifier
+            DATA      ///< Collecting response bytes and checksum
+        };
+
+        static constexpr uint8_t NO_FRAME = 0xFF;
+
+        USART::StandardUSART& uart;
+        FrameTable frames;
+        Statistics statistics;
+        uint8_t frameIndex[MAX_ID + 1U];    ///< Frame table index per ID (NO_FRAME if unknown)
+
+        volatile RxState rxState;
+        uint8_t rxFrame;
+        uint8_t rxCount;
+        uint8_t rxSum;
+        uint8_t rxData[MAX_DATA_LENGTH];
+
+        FrameCallback frameCallback;
+        void* frameContext;
+
+        Node(USART::StandardUSART& uart, const FrameTable& frames) noexcept;
+
+        /**
+         * @brief Enable LIN mode and take over the RX callback
+         */
+        USART::UsartStatus attach() noexcept;
+        void detach() noexcept;
+
+        /**
+         * @brief Count an unfinished header or response and return to IDLE
+         */
+        void abortFrame() noexcept;
+
+        void receiveByte(uint8_t data) noexcept;
+        void sendResponse(const Frame& frame, uint8_t pid) noexcept;
+
+        static void onBreak(void* context);
+        static void onRxByte(void* context, uint8_t data);
+    };
+
+    /**
+     * @class Master
+     * @brief Runs a schedule table on TIM6 and the master's own responses
+     */
+    class Master : public Node
+    {
+    public:
+        Master(USART::StandardUSART& uart, const FrameTable& frames, const ScheduleTable& schedule) noexcept;
+
+        /**
+         * @brief Enable LIN mode, send the first header and start TIM6
+         * @return BUSY if another master owns TIM6
+         */
+        USART::UsartStatus start() noexcept;
+
+        /**
+         * @brief Stop the timer and leave LIN mode (a response in flight is dropped)
+         */
+        void stop() noexcept;
+
+        /**
+         * @brief Switch tables at the end of the current cycle
+         * @note The new table must be valid for the same frame table
+         */
+        void setSchedule(const ScheduleTable& schedule) noexcept;
+
+        /**
+         * @brief Slot boundary (called from TIM6 interrupt)
+         */
+        void handleTimerInterrupt() noexcept;
+
+        [[nodiscard]] bool isRunning() const noexcept { return running; }
+        [[nodiscard]] uint8_t getCurrentSlot() const noexcept { return currentSlot; }
+        [[nodiscard]] uint32_t getCycleCount() const noexcept { return cycles; }
+
+    private:
+        ScheduleTable schedule;
+        ScheduleTable pendingSchedule;
+        volatile bool switchPending;
+        volatile bool running;
+        uint8_t currentSlot;
+        uint8_t nextSlot;
+        volatile uint32_t cycles;
+
+        void sendHeader(const Frame& frame) noexcept;
+        void preloadNextSlot() noexcept;
+    };
+
+    /**
+     * @class Slave
+     * @brief Answers headers for published frames, receives subscribed ones
+     */
+    class Slave : public Node
+    {
+    public:
+        Slave(USART::StandardUSART& uart, const FrameTable& frames) noexcept;
+
+        USART::UsartStatus start() noexcept;
+        void stop() noexcept;
+    };
+
+} // namespace Lin
+
+#endif /* LIBRARY_INC_LIN_H_ */
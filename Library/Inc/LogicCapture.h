@@ -0,0 +1,349 @@
+/**
+ * @file    LogicCapture.h
+ * @brief   Logic-analyzer capture: timer-paced DMA sampling of GPIO IDR, RLE streaming, VCD on the host
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * The board samples up to 16 pins of one port and streams the capture over
+ * a UART. TIM1 paces DMA reads of GPIOx->IDR into a double buffer, so the
+ * sample instants are timer-exact; the main loop run-length encodes each
+ * finished half while DMA fills the other one:
+ *
+ * ```
+ *   TIM1 update --DMA1 Ch6--> ring[half] (IDR, 16 bit)
+ *   poll(): ring[half] -> trigger search -> RLE runs -> output FIFO -> UsartDriver TX ring
+ * ```
+ *
+ * Before the trigger, runs go into a history of HISTORY_RUNS runs; at the
+ * trigger the runs covering the last preTrigger samples are sent, followed
+ * by postTrigger samples from the trigger sample on. Pre-trigger depth is
+ * therefore limited by activity (HISTORY_RUNS changes), not by RAM per
+ * sample.
+ *
+ * Triggers:
+ * - NONE:    capture starts immediately (no pre-trigger samples)
+ * - RISING / FALLING / EDGE: any pin of `mask` changes in that direction
+ * - PATTERN: (pins & mask) == value
+ *
+ * ## Stream Format
+ *
+ * ```
+ *   header  "LAC1" port('A'..'H') 0 pinMask(u16) rateHz(u32) preTrigger(u32)   16 bytes, LE
+ *   run     value(u16 LE) length(LEB128, >= 1)                                 3..7 bytes
+ *   end     status(u16 LE: 0 = complete, 1 = overrun) 0x00                     3 bytes
+ * ```
+ *
+ * Sample n of the capture is at n / rateHz seconds; the trigger is sample
+ * preTrigger. `VcdConverter` is the portable host side: it turns the byte
+ * stream into a VCD file for GTKWave or PulseView through the small
+ * TextSink interface.
+ *
+ * ## Usage
+ *
+ * @code
+ * static uint16_t samples[1024];          // DMA double buffer
+ * static uint8_t encoded[2048];           // RLE output FIFO
+ * static LogicCapture::Capture capture(*uart, samples, 1024, encoded, sizeof(encoded));
+ *
+ * // Falling edge on PB3, 1000 samples before and 20000 after, 1 MS/s
+ * capture.start({GPIOB, 0x00FF, 1000000, 1000, 20000,
+ *                {LogicCapture::TriggerType::FALLING, 0x0008, 0}});
+ *
+ * // Main loop:
+ * capture.poll();
+ * @endcode
+ *
+ * ## Sustainable Sample Rate
+ *
+ * For long captures the UART is usually the limit. The 2 raw bytes per
+ * sample, divided by the compression ratio, must fit its byte rate. The
+ * encoder's own cost is one compare per quiet sample plus a record per
+ * change; measure it with DWT->CYCCNT around poll() on the target.
+ * Tests/Host/LogicCaptureTest.cpp runs the encoder on the DMA channel model
+ * with random activity on 8 pins and a 1024-sample ring, and prints:
+ *
+ * | Changes per sample | Compression ratio | Max sustained rate at 2 Mbaud (200 kB/s) |
+ * |--------------------|-------------------|------------------------------------------|
+ * | 1 (worst)          | 0.67              | 67 kS/s (UART)                           |
+ * | 1/3                | 2.0               | 200 kS/s (UART)                          |
+ * | 1/10               | 6.7               | 668 kS/s (UART)                          |
+ * | 1/15               | 10                | 1.0 MS/s (UART)                          |
+ * | 1/45               | 29                | 2.0 MS/s (rate limit)                    |
+ * | 1/150              | 90                | 2.0 MS/s (rate limit)                    |
+ *
+ * With the UART paced at 0.8 times the 1/10 bound the capture completes;
+ * at 1.25 times it ends with an overrun. Every capture decodes back to the
+ * sampled values, sample for sample. The test covers all trigger types, a
+ * pre-trigger depth cut short by HISTORY_RUNS, and the VCD output.
+ *
+ * Bursts above these rates are fine while they fit the output FIFO; a
+ * capture that overruns ends with status 1 and what was sent stays valid.
+ *
+ * @note Uses TIM1 (update DMA request, no interrupt) and DMA1 Channel 6
+ *       (request 7). That channel is also the USART_2 RX channel of the
+ *       USART DMA bridge; whichever enables it first keeps it (start()
+ *       returns false, the bridge reports BUSY). TIM1 also paces the
+ *       keypad scanner (Keypad.h); start() fails while it runs.
+ * @note The sample rate must divide SystemCoreClock into a whole number
+ *       of timer clocks (at 32 MHz: 2 MHz, 1 MHz, 800 kHz, 500 kHz, ...),
+ *       so the rate in the header is the one the samples were taken at.
+ * @note DMA1_Channel6_IRQHandler must call `LOGIC_CAPTURE_HandleDmaInterrupt()`
+ *       before the USART bridge handler.
+ */
+
+#ifndef LIBRARY_INC_LOGICCAPTURE_H_
+#define LIBRARY_INC_LOGICCAPTURE_H_
+
+#include "usart.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// C interface for the DMA1 Channel 6 interrupt handler
+#ifdef __cplusplus
+extern "C" {
+#endif
+    void LOGIC_CAPTURE_HandleDmaInterrupt(void);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @namespace LogicCapture
+ * @brief On-board logic analyzer with run-length encoded streaming
+ */
+namespace LogicCapture
+{
+    static constexpr uint8_t HEADER_SIZE = 16;
+    static constexpr uint8_t MAX_RECORD_SIZE = 7;           ///< u16 value + 5-byte LEB128 run
+    static constexpr uint16_t HISTORY_RUNS = 64;            ///< Pre-trigger runs kept while armed
+    static constexpr uint16_t MIN_OUTPUT_SIZE = HEADER_SIZE + (HISTORY_RUNS + 1U) * MAX_RECORD_SIZE + 3U;
+    static constexpr uint32_t MAX_SAMPLE_RATE_HZ = 2000000;
+    static constexpr uint16_t STATUS_COMPLETE = 0;
+    static constexpr uint16_t STATUS_OVERRUN = 1;
+
+    enum class TriggerType : uint8_t
+    {
+        NONE,
+        RISING,
+        FALLING,
+        EDGE,
+        PATTERN
+    };
+
+    /**
+     * @struct Trigger
+     * @brief Trigger condition on the sampled pins
+     */
+    struct Trigger
+    {
+        TriggerType type;
+        uint16_t mask;          ///< Pins watched for edges / compared for PATTERN
+        uint16_t value;         ///< PATTERN: required levels of the mask pins
+    };
+
+    /**
+     * @struct Config
+     * @brief One capture
+     */
+    struct Config
+    {
+        GPIO_TypeDef* port;
+        uint16_t pinMask;       ///< Sampled pins (others read as 0)
+        uint32_t sampleRateHz;  ///< Up to MAX_SAMPLE_RATE_HZ, a divisor of SystemCoreClock
+        uint32_t preTrigger;    ///< Samples before the trigger (limited by HISTORY_RUNS changes)
+        uint32_t postTrigger;   ///< Samples from the trigger on (>= 1)
+        Trigger trigger;
+    };
+
+    enum class State : uint8_t
+    {
+        IDLE,
+        ARMED,          ///< Sampling, waiting for the trigger
+        TRIGGERED,      ///< Streaming post-trigger samples
+        DONE,           ///< Capture complete (output may still be draining)
+        OVERRUN         ///< Stopped early: processing or output could not keep up
+    };
+
+    /**
+     * @class Capture
+     * @brief Device side: sampling, triggering, encoding and streaming
+     */
+    class Capture
+    {
+    public:
+        /**
+         * @param uart Port the capture is streamed on (binary, not shared with console text)
+         * @param sampleRing DMA double buffer; even count, each half is processed at once
+         * @param ringCount Samples in sampleRing (2..65534, even)
+         * @param output RLE FIFO between the encoder and the UART TX ring
+         * @param outputSize FIFO size in bytes (>= MIN_OUTPUT_SIZE, room for the whole pre-trigger history)
+         */
+        Capture(USART::StandardUSART& uart, uint16_t* sampleRing, uint16_t ringCount,
+                uint8_t* output, uint16_t outputSize) noexcept;
+
+        /**
+         * @brief Stops sampling
+         */
+        ~Capture();
+
+        Capture(const Capture&) = delete;
+        Capture& operator=(const Capture&) = delete;
+
+        /**
+         * @brief Arm a capture (TriggerType::NONE starts it immediately)
+         * @return false if a capture is running, the DMA channel or TIM1 is in use, or the
+         *         configuration is invalid (including a rate the timer cannot run at exactly)
+         */
+        bool start(const Config& config) noexcept;
+
+        /**
+         * @brief Abort sampling; nothing more is encoded
+         */
+        void stop() noexcept;
+
+        /**
+         * @brief Encode finished halves and move output to the UART (main loop)
+         * @return State after this call
+         */
+        State poll() noexcept;
+
+        [[nodiscard]] State getState() const noexcept { return state; }
+
+        /**
+         * @brief Encoded bytes not yet handed to the UART
+         */
+        [[nodiscard]] uint16_t getPendingBytes() const noexcept;
+
+        [[nodiscard]] uint32_t getEncodedBytes() const noexcept { return encodedBytes; }
+        [[nodiscard]] uint32_t getSampleCount() const noexcept { return sampleCount; }
+
+        /**
+         * @brief Pre-trigger samples actually sent (after the trigger)
+         */
+        [[nodiscard]] uint32_t getPreTriggerCount() const noexcept { return preCount; }
+
+        /**
+         * @brief DMA interrupt work (called from LOGIC_CAPTURE_HandleDmaInterrupt)
+         */
+        void handleDmaInterrupt(uint32_t flags) noexcept;
+
+    private:
+        struct Run
+        {
+            uint16_t value;
+            uint32_t length;
+        };
+
+        USART::StandardUSART& uart;
+        uint16_t* ring;
+        uint16_t halfCount;
+        uint8_t* output;
+        uint16_t outputSize;
+        uint16_t outputHead;
+        uint16_t outputTail;
+
+        Config config;
+        volatile State state;
+        volatile uint32_t halvesFilled;
+        volatile bool dmaError;
+        uint32_t halvesDone;
+
+        bool primed;            ///< previous/current hold a sample
+        uint16_t previous;      ///< Last sample (edge triggers)
+        uint16_t current;       ///< Value of the open run
+        uint32_t runLength;
+        uint32_t postRemaining;
+
+        Run history[HISTORY_RUNS];
+        uint16_t historyHead;
+        uint16_t historyCount;
+
+        uint32_t sampleCount;
+        uint32_t encodedBytes;
+        uint32_t preCount;
+
+        void processHalf(const uint16_t* samples, uint16_t count) noexcept;
+        uint16_t armedScan(const uint16_t* samples, uint16_t count) noexcept;
+        void trigger() noexcept;
+        bool emit(uint16_t value, uint32_t length) noexcept;
+        void put(uint8_t data) noexcept;
+        [[nodiscard]] uint16_t freeSpace() const noexcept;
+        void finish(uint16_t status) noexcept;
+        void drain() noexcept;
+        void stopSampling() noexcept;
+    };
+
+    /**
+     * @class TextSink
+     * @brief Output of VcdConverter (implemented by the host tool, e.g. a file)
+     */
+    class TextSink
+    {
+    public:
+        virtual void write(const char* text, size_t length) = 0;
+
+    protected:
+        ~TextSink() = default;
+    };
+
+    /**
+     * @class VcdConverter
+     * @brief Host side: capture stream -> Value Change Dump (portable C++)
+     *
+     * Feed the bytes received from the UART in any chunking; the VCD has one
+     * 1-bit wire per sampled pin (e.g. "PB3"), a timescale of 1 ns and a
+     * comment at the trigger.
+     */
+    class VcdConverter
+    {
+    public:
+        explicit VcdConverter(TextSink& sink) noexcept;
+
+        /**
+         * @brief Process received bytes
+         * @return false after the end record or on a bad header
+         */
+        bool feed(const uint8_t* data, size_t length) noexcept;
+
+        [[nodiscard]] bool isComplete() const noexcept { return phase == Phase::END; }
+        [[nodiscard]] bool isOverrun() const noexcept { return status == STATUS_OVERRUN; }
+        [[nodiscard]] uint64_t getSampleCount() const noexcept { return sample; }
+
+    private:
+        enum class Phase : uint8_t
+        {
+            HEADER,
+            VALUE_LOW,
+            VALUE_HIGH,
+            LENGTH,
+            END,
+            ERROR
+        };
+
+        TextSink& sink;
+        Phase phase;
+        uint8_t header[HEADER_SIZE];
+        uint8_t headerLength;
+        char portLetter;
+        uint16_t pinMask;
+        uint32_t rateHz;
+        uint32_t preTrigger;
+        uint16_t value;
+        uint16_t lastValue;
+        uint32_t length;
+        uint8_t lengthShift;
+        uint64_t sample;
+        uint16_t status;
+
+        void writeText(const char* text) noexcept;
+        void writeTime(uint64_t sampleIndex) noexcept;
+        void writeHeader() noexcept;
+        void writeRun() noexcept;
+        void writeEnd() noexcept;
+    };
+
+} // namespace LogicCapture
+
+#endif /* LIBRARY_INC_LOGICCAPTURE_H_ */
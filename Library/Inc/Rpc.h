@@ -0,0 +1,295 @@
+/**
+ * @file    Rpc.h
+ * @brief   Lightweight binary RPC server over the interrupt-driven USART driver
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Host tools call device functions by numeric method ID instead of parsing
+ * printf output. Methods are described once in a constexpr table together
+ * with a compact schema of their request and response fields:
+ *
+ * @code
+ * static Rpc::Status readTemperature(Rpc::Reader& request, Rpc::Writer& response, void* context)
+ * {
+ *     uint8_t channel = request.readU8();
+ *     response.writeF32(sensors[channel].celsius());
+ *     return Rpc::Status::OK;
+ * }
+ *
+ * static constexpr Rpc::Method METHODS[] = {
+ *     {0x10, "temp.read", "B", "f", readTemperature, nullptr},
+ *     {0x20, "led.set",   "BB", "", setLed,          nullptr},
+ * };
+ * static constexpr Rpc::MethodTable TABLE{METHODS};
+ * static_assert(TABLE.isValid(), "Unsorted/duplicate method IDs or bad schema");
+ *
+ * auto server = new Rpc::Server(*uart, TABLE);
+ * server->start();
+ * // in App_Run(): server->poll();
+ * @endcode
+ *
+ * ## Frame Format
+ *
+ * | Field   | Size | Description |
+ * |---------|------|-------------|
+ * | SYNC    | 1    | 0xA5 |
+ * | LENGTH  | 1    | Payload length (0..MAX_PAYLOAD) |
+ * | ID      | 1    | Request ID chosen by the host, echoed in the response |
+ * | METHOD  | 1    | Method ID (request) / Status (response) |
+ * | PAYLOAD | n    | Little-endian fields as described by the schema |
+ * | CRC     | 2    | CRC-16/MODBUS over LENGTH..PAYLOAD, low byte first |
+ *
+ * ## Schema Characters
+ *
+ * `B`/`b` u8/i8, `H`/`h` u16/i16, `I`/`i` u32/i32, `f` float, `s` byte
+ * string with a u8 length prefix (only as last field). Method 0x00 is
+ * reserved for the built-in `describe` call which returns the table.
+ *
+ * ## Zero Copy & Pipelining
+ *
+ * The RX interrupt writes request bytes straight into one of SLOT_COUNT
+ * request slots; handlers read their arguments from that slot in place and
+ * serialize results directly into free USART TX ring space reserved for the
+ * response frame (reserveTx()/commitTx(), as Telemetry does), so a response
+ * is never copied. No heap, no intermediate structs. The
+ * host may keep up to SLOT_COUNT requests in flight and match responses by ID;
+ * responses are sent in request order.
+ *
+ * ## Host Side
+ *
+ * Rpc::Client (RpcClient.h) frames calls and matches responses on the
+ * host; it only depends on RpcProtocol.h and Crc16.h. Tests/Host/RpcPtyTest
+ * runs it against this server over a pseudo-terminal and prints the round
+ * trip latency and the pipelined call rate. A pty has no line rate, so
+ * those figures are the software overhead of both ends; on a real link add
+ * 10 bit times per frame byte in each direction.
+ *
+ * @note Handlers run from poll() in the main loop, never in interrupt context.
+ */
+
+#ifndef LIBRARY_INC_RPC_H_
+#define LIBRARY_INC_RPC_H_
+
+#include "usart.h"
+#include "Crc16.h"
+#include "RpcProtocol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @namespace Rpc
+ * @brief Binary RPC server, method table and in-place serialization
+ */
+namespace Rpc
+{
+    /// Method implementation, runs from Server::poll()
+    using Handler = Status (*)(Reader& request, Writer& response, void* context);
+
+    /**
+     * @struct Method
+     * @brief One entry of the method table
+     */
+    struct Method
+    {
+        uint8_t id;                  ///< Method ID (1..255, 0 is reserved for describe)
+        const char* name;            ///< Name reported by describe
+        const char* requestSchema;   ///< Request fields, validated before the handler runs
+        const char* responseSchema;  ///< Response fields (documentation for the host)
+        Handler handler;
+        void* context;               ///< Forwarded to the handler
+    };
+
+    /// describe response: u8 total count and u8 next index before the entries
+    static constexpr uint8_t DESCRIBE_HEADER_SIZE = 2;
+
+    /**
+     * @brief Length of a NUL-terminated string including the terminator
+     */
+    [[nodiscard]] constexpr size_t textSize(const char* text) noexcept
+    {
+        size_t size = 1;
+        for (; *text != '\0'; text++)
+        {
+            size++;
+        }
+        return size;
+    }
+
+    /**
+     * @brief Size of one method entry in the describe response (id, name and both schemas)
+     */
+    [[nodiscard]] constexpr size_t describeEntrySize(const Method& method) noexcept
+    {
+        return 1U + textSize(method.name) + textSize(method.requestSchema) + textSize(method.responseSchema);
+    }
+
+    /**
+     * @class MethodTable
+     * @brief Non-owning view over a constexpr array of methods sorted by ID
+     */
+    class MethodTable
+    {
+    private:
+        const Method* methods;
+        uint8_t count;
+
+    public:
+        template<size_t N>
+        constexpr MethodTable(const Method (&table)[N]) noexcept : methods(table), count(static_cast<uint8_t>(N))
+        {
+            static_assert(N > 0 && N <= 255, "Method table must contain 1..255 methods");
+        }
+
+        /**
+         * @brief Check ascending unique IDs, handlers and schemas (usable in static_assert)
+         *
+         * Every entry must also fit into one describe response on its own,
+         * otherwise describe could never report it.
+         */
+        [[nodiscard]] constexpr bool isValid() const noexcept
+        {
+            for (uint8_t i = 0; i < count; i++)
+            {
+                const Method& method = methods[i];
+                if (method.id == DESCRIBE_METHOD || method.handler == nullptr || method.name == nullptr ||
+                    !isValidSchema(method.requestSchema) || !isValidSchema(method.responseSchema) ||
+                    schemaSize(method.requestSchema) > MAX_PAYLOAD ||
+                    DESCRIBE_HEADER_SIZE + describeEntrySize(method) > MAX_PAYLOAD)
+                {
+                    return false;
+                }
+                if (i + 1 < count && method.id >= methods[i + 1].id)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Binary search for a method ID
+         * @return Method or nullptr if the ID is unknown
+         */
+        [[nodiscard]] constexpr const Method* find(uint8_t id) const noexcept
+        {
+            uint8_t low = 0;
+            uint8_t high = count;
+            while (low < high)
+            {
+                const uint8_t mid = static_cast<uint8_t>((low + high) / 2);
+                if (methods[mid].id == id)
+                {
+                    return &methods[mid];
+                }
+                if (methods[mid].id < id)
+                {
+                    low = static_cast<uint8_t>(mid + 1);
+                }
+                else
+                {
+                    high = mid;
+                }
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] constexpr uint8_t size() const noexcept { return count; }
+        [[nodiscard]] constexpr const Method& operator[](uint8_t index) const noexcept { return methods[index]; }
+    };
+
+    /**
+     * @struct ServerStatistics
+     * @brief Diagnostic counters maintained by the server
+     */
+    struct ServerStatistics
+    {
+        uint32_t callsHandled;     ///< Requests executed (any status)
+        uint32_t crcErrors;        ///< Frames dropped because of a CRC mismatch
+        uint32_t slotOverruns;     ///< Frames dropped because all request slots were busy
+        uint32_t txOverruns;       ///< Responses that did not fit into the USART TX ring
+    };
+
+    /**
+     * @class Server
+     * @brief RPC server bound to one USART driver
+     *
+     * The server installs itself as RX byte callback. Complete requests are
+     * queued in the RX interrupt and executed in order by poll().
+     */
+    class Server
+    {
+    public:
+        static constexpr uint8_t SLOT_COUNT = MAX_IN_FLIGHT;
+
+        /**
+         * @brief Construct a server
+         * @param uart Initialized USART driver carrying the RPC link
+         * @param table Method table served by this server
+         */
+        Server(USART::StandardUSART& uart, const MethodTable& table) noexcept;
+
+        /**
+         * @brief Attach to the USART RX path
+         */
+        void start() noexcept;
+
+        /**
+         * @brief Detach from the USART RX path (queued requests are dropped)
+         */
+        void stop() noexcept;
+
+        /**
+         * @brief Execute all queued requests and send their responses
+         * @return Number of requests executed
+         */
+        uint8_t poll() noexcept;
+
+        /**
+         * @brief Get a snapshot of the diagnostic counters
+         */
+        [[nodiscard]] ServerStatistics getStatistics() const noexcept { return statistics; }
+
+    private:
+        static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0, "SLOT_COUNT must be power of 2");
+
+        /// Receive state machine position
+        enum class RxState : uint8_t
+        {
+            SYNC,
+            LENGTH,
+            BODY
+        };
+
+        /// Request frame from LENGTH to the end of the CRC
+        struct Slot
+        {
+            uint8_t bytes[MAX_FRAME_SIZE - 1];
+        };
+
+        USART::StandardUSART& uart;
+        MethodTable table;
+
+        Slot slots[SLOT_COUNT];
+        volatile uint8_t slotHead;          ///< Next slot written by the RX interrupt
+        volatile uint8_t slotTail;          ///< Next slot executed by poll()
+
+        RxState rxState;
+        bool rxDiscard;                     ///< No free slot, frame is parsed but dropped
+        uint16_t rxPosition;                ///< Bytes stored in the current slot
+        uint16_t rxExpected;                ///< Frame bytes after SYNC
+        Crc::Crc16 crc;
+        ServerStatistics statistics;
+
+        static void onRxByte(void* context, uint8_t data);
+
+        void receiveByte(uint8_t data) noexcept;
+        void execute(const uint8_t* request) noexcept;
+        [[nodiscard]] Status describe(Reader& reader, Writer& writer) noexcept;
+    };
+
+} // namespace Rpc
+
+#endif /* LIBRARY_INC_RPC_H_ */
@@ -0,0 +1,137 @@
+/**
+ * @file    RpcClient.h
+ * @brief   Host side of the binary RPC link (portable C++, no MCU headers)
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Client frames calls for an Rpc::Server and matches the responses by
+ * request ID. It talks to the serial port through the small ClientPort
+ * interface, so the same class runs in a Linux tool (termios), a test
+ * harness or another MCU:
+ *
+ * @code
+ * static void onResponse(void* context, uint8_t id, Rpc::Status status, Rpc::Reader& response)
+ * {
+ *     float celsius = response.readF32();
+ * }
+ *
+ * Rpc::Client client(port, onResponse, nullptr);
+ * client.prepare(0x10).writeU8(channel);
+ * uint8_t id;
+ * client.send(id);                       // false while MAX_IN_FLIGHT calls are open
+ * // for every chunk read from the port:
+ * client.receive(bytes, count);          // runs onResponse per response frame
+ * @endcode
+ *
+ * Up to MAX_IN_FLIGHT calls may be outstanding; the server answers them in
+ * request order. A response whose ID is not the oldest outstanding call
+ * closes the calls before it as lost (their frames were dropped on a CRC
+ * error or a slot overrun).
+ */
+
+#ifndef LIBRARY_INC_RPCCLIENT_H_
+#define LIBRARY_INC_RPCCLIENT_H_
+
+#include "Crc16.h"
+#include "RpcProtocol.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Rpc
+{
+    /**
+     * @class ClientPort
+     * @brief Serial port access needed by Client (implemented by the host tool)
+     */
+    class ClientPort
+    {
+    public:
+        virtual void write(const uint8_t* data, size_t length) = 0;
+
+    protected:
+        ~ClientPort() = default;
+    };
+
+    /**
+     * @struct ClientStatistics
+     * @brief Diagnostic counters maintained by the client
+     */
+    struct ClientStatistics
+    {
+        uint32_t responses;       ///< Responses delivered to the completion
+        uint32_t crcErrors;       ///< Response frames dropped because of a CRC mismatch
+        uint32_t lostCalls;       ///< Calls closed without a response
+        uint32_t unexpectedIds;   ///< Responses that matched no outstanding call
+    };
+
+    /**
+     * @class Client
+     * @brief Frames requests and dispatches responses of one RPC link
+     */
+    class Client
+    {
+    public:
+        /// Called from receive() for every response of an outstanding call
+        using Completion = void (*)(void* context, uint8_t id, Status status, Reader& response);
+
+        Client(ClientPort& port, Completion completion, void* context) noexcept;
+
+        /**
+         * @brief Start a request for a method; write its arguments into the returned Writer
+         */
+        Writer& prepare(uint8_t method) noexcept;
+
+        /**
+         * @brief Frame and write the prepared request
+         * @param id Receives the request ID echoed by the response
+         * @return false if MAX_IN_FLIGHT calls are outstanding or the arguments overflowed
+         */
+        bool send(uint8_t& id) noexcept;
+
+        /**
+         * @brief Feed bytes read from the port
+         */
+        void receive(const uint8_t* data, size_t length) noexcept;
+
+        /**
+         * @brief Close all outstanding calls as lost (e.g. after a timeout)
+         */
+        void reset() noexcept;
+
+        [[nodiscard]] uint8_t getInFlight() const noexcept { return inFlight; }
+        [[nodiscard]] ClientStatistics getStatistics() const noexcept { return statistics; }
+
+    private:
+        enum class RxState : uint8_t
+        {
+            SYNC,
+            LENGTH,
+            BODY
+        };
+
+        ClientPort& port;
+        Completion completion;
+        void* context;
+
+        uint8_t request[MAX_FRAME_SIZE];
+        Writer writer;
+        uint8_t nextId;
+        uint8_t outstanding[MAX_IN_FLIGHT];   ///< IDs in request order
+        uint8_t inFlight;
+
+        uint8_t frame[MAX_FRAME_SIZE];        ///< Response from LENGTH to the end of the CRC
+        RxState rxState;
+        uint16_t rxPosition;
+        uint16_t rxExpected;
+        Crc::Crc16 crc;
+        ClientStatistics statistics;
+
+        void receiveByte(uint8_t data) noexcept;
+        void complete() noexcept;
+    };
+
+} // namespace Rpc
+
+#endif /* LIBRARY_INC_RPCCLIENT_H_ */
@@ -0,0 +1,320 @@
+/**
+ * @file    RpcProtocol.h
+ * @brief   RPC frame constants, status codes, schemas and in-place payload serialization
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * The parts of the RPC link that both ends share and that do not depend on
+ * the MCU: the frame layout, the schema characters and the little-endian
+ * Reader/Writer used by device handlers (Rpc.h) and by the host client
+ * (RpcClient.h). See Rpc.h for the frame format.
+ */
+
+#ifndef LIBRARY_INC_RPCPROTOCOL_H_
+#define LIBRARY_INC_RPCPROTOCOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Rpc
+{
+    static constexpr uint8_t SYNC = 0xA5;
+    static constexpr uint8_t MAX_PAYLOAD = 248;
+    static constexpr uint8_t HEADER_SIZE = 4;   // SYNC + LENGTH + ID + METHOD/STATUS
+    static constexpr uint8_t CRC_SIZE = 2;
+    static constexpr uint8_t DESCRIBE_METHOD = 0x00;
+    static constexpr uint16_t MAX_FRAME_SIZE = HEADER_SIZE + MAX_PAYLOAD + CRC_SIZE;
+    static constexpr uint8_t MAX_IN_FLIGHT = 4;   ///< Requests the server queues before dropping (power of 2)
+
+    /**
+     * @enum Status
+     * @brief Result code carried in the response METHOD field
+     */
+    enum class Status : uint8_t
+    {
+        OK = 0x00,                 ///< Call executed, payload holds the result
+        UNKNOWN_METHOD = 0x01,     ///< Method ID not in the table
+        BAD_REQUEST = 0x02,        ///< Payload does not match the request schema
+        HANDLER_ERROR = 0x03,      ///< Handler reported a failure
+        RESPONSE_OVERFLOW = 0x04   ///< Result did not fit into MAX_PAYLOAD
+    };
+
+    /**
+     * @brief Encoded size of one schema character (0 for an invalid character)
+     */
+    [[nodiscard]] constexpr uint8_t fieldSize(char type) noexcept
+    {
+        switch (type)
+        {
+            case 'B': case 'b': case 's': return 1;   // 's' counts its length prefix
+            case 'H': case 'h': return 2;
+            case 'I': case 'i': case 'f': return 4;
+            default: return 0;
+        }
+    }
+
+    /**
+     * @brief Minimum encoded size of a schema (exact size if it has no 's')
+     */
+    [[nodiscard]] constexpr uint16_t schemaSize(const char* schema) noexcept
+    {
+        uint16_t size = 0;
+        for (; schema != nullptr && *schema != '\0'; schema++)
+        {
+            size = static_cast<uint16_t>(size + fieldSize(*schema));
+        }
+        return size;
+    }
+
+    /**
+     * @brief Check if a schema ends in a variable-length byte string
+     */
+    [[nodiscard]] constexpr bool isVariableSchema(const char* schema) noexcept
+    {
+        if (schema == nullptr || *schema == '\0')
+        {
+            return false;
+        }
+        while (schema[1] != '\0')
+        {
+            schema++;
+        }
+        return *schema == 's';
+    }
+
+    /**
+     * @brief Check schema characters and that 's' only appears last
+     */
+    [[nodiscard]] constexpr bool isValidSchema(const char* schema) noexcept
+    {
+        if (schema == nullptr)
+        {
+            return false;
+        }
+        for (; *schema != '\0'; schema++)
+        {
+            if (fieldSize(*schema) == 0 || (*schema == 's' && schema[1] != '\0'))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @class Reader
+     * @brief Bounds-checked little-endian reader over a request payload (in place)
+     *
+     * Reading past the end returns 0 and latches the error flag, so handlers
+     * can read all arguments first and check isValid() once.
+     */
+    class Reader
+    {
+    private:
+        const uint8_t* data;
+        uint8_t length;
+        uint8_t position;
+        bool error;
+
+        [[nodiscard]] bool take(uint8_t size) noexcept
+        {
+            if (error || static_cast<uint16_t>(position) + size > length)
+            {
+                error = true;
+                return false;
+            }
+            return true;
+        }
+
+    public:
+        constexpr Reader(const uint8_t* payload, uint8_t payloadLength) noexcept
+            : data(payload), length(payloadLength), position(0), error(false) {}
+
+        uint8_t readU8() noexcept
+        {
+            return take(1) ? data[position++] : 0;
+        }
+
+        uint16_t readU16() noexcept
+        {
+            if (!take(2))
+            {
+                return 0;
+            }
+            uint16_t value = static_cast<uint16_t>(data[position] | (data[position + 1] << 8));
+            position = static_cast<uint8_t>(position + 2);
+            return value;
+        }
+
+        uint32_t readU32() noexcept
+        {
+            if (!take(4))
+            {
+                return 0;
+            }
+            uint32_t value = static_cast<uint32_t>(data[position]) |
+                             (static_cast<uint32_t>(data[position + 1]) << 8) |
+                             (static_cast<uint32_t>(data[position + 2]) << 16) |
+                             (static_cast<uint32_t>(data[position + 3]) << 24);
+            position = static_cast<uint8_t>(position + 4);
+            return value;
+        }
+
+        int8_t readI8() noexcept { return static_cast<int8_t>(readU8()); }
+        int16_t readI16() noexcept { return static_cast<int16_t>(readU16()); }
+        int32_t readI32() noexcept { return static_cast<int32_t>(readU32()); }
+
+        float readF32() noexcept
+        {
+            uint32_t bits = readU32();
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        /**
+         * @brief Read a length-prefixed byte string without copying
+         * @param size Receives the string length
+         * @return Pointer into the request slot (valid until the handler returns)
+         */
+        const uint8_t* readBytes(uint8_t& size) noexcept
+        {
+            size = readU8();
+            if (!take(size))
+            {
+                size = 0;
+                return nullptr;
+            }
+            const uint8_t* bytes = &data[position];
+            position = static_cast<uint8_t>(position + size);
+            return bytes;
+        }
+
+        [[nodiscard]] bool isValid() const noexcept { return !error; }
+        [[nodiscard]] uint8_t remaining() const noexcept { return static_cast<uint8_t>(length - position); }
+    };
+
+    /**
+     * @class Writer
+     * @brief Bounds-checked little-endian writer into the response frame (in place)
+     *
+     * The frame is either a plain buffer or a window of a power-of-two ring,
+     * such as the USART TX ring the server serializes into; writes past the
+     * end of the ring wrap to its start.
+     */
+    class Writer
+    {
+    private:
+        uint8_t* data;
+        uint16_t mask;
+        uint16_t start;
+        uint8_t capacity;
+        uint8_t position;
+        bool error;
+
+        void store(uint8_t value) noexcept
+        {
+            data[(start + position++) & mask] = value;
+        }
+
+        [[nodiscard]] bool reserve(uint8_t size) noexcept
+        {
+            if (error || static_cast<uint16_t>(position) + size > capacity)
+            {
+                error = true;
+                return false;
+            }
+            return true;
+        }
+
+    public:
+        constexpr Writer(uint8_t* payload, uint8_t payloadCapacity) noexcept
+            : data(payload), mask(0xFFFFU), start(0), capacity(payloadCapacity), position(0), error(false) {}
+
+        /**
+         * @param ring Ring storage
+         * @param ringMask Ring size - 1 (power of two)
+         * @param payloadStart Ring index of the first payload byte
+         * @param payloadCapacity Free bytes from payloadStart on
+         */
+        constexpr Writer(uint8_t* ring, uint16_t ringMask, uint16_t payloadStart, uint8_t payloadCapacity) noexcept
+            : data(ring), mask(ringMask), start(payloadStart), capacity(payloadCapacity), position(0), error(false) {}
+
+        void writeU8(uint8_t value) noexcept
+        {
+            if (reserve(1))
+            {
+                store(value);
+            }
+        }
+
+        void writeU16(uint16_t value) noexcept
+        {
+            if (reserve(2))
+            {
+                store(static_cast<uint8_t>(value));
+                store(static_cast<uint8_t>(value >> 8));
+            }
+        }
+
+        void writeU32(uint32_t value) noexcept
+        {
+            if (reserve(4))
+            {
+                for (uint8_t shift = 0; shift < 32; shift = static_cast<uint8_t>(shift + 8))
+                {
+                    store(static_cast<uint8_t>(value >> shift));
+                }
+            }
+        }
+
+        void writeI8(int8_t value) noexcept { writeU8(static_cast<uint8_t>(value)); }
+        void writeI16(int16_t value) noexcept { writeU16(static_cast<uint16_t>(value)); }
+        void writeI32(int32_t value) noexcept { writeU32(static_cast<uint32_t>(value)); }
+
+        void writeF32(float value) noexcept
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            writeU32(bits);
+        }
+
+        /**
+         * @brief Write a length-prefixed byte string
+         */
+        void writeBytes(const uint8_t* bytes, uint8_t size) noexcept
+        {
+            if (reserve(static_cast<uint8_t>(size + 1U)))
+            {
+                store(size);
+                for (uint8_t i = 0; i < size; i++)
+                {
+                    store(bytes[i]);
+                }
+            }
+        }
+
+        /**
+         * @brief Write a NUL-terminated string including the terminator
+         */
+        void writeString(const char* text) noexcept
+        {
+            const size_t size = std::strlen(text) + 1U;
+            if (size <= 0xFFU && reserve(static_cast<uint8_t>(size)))
+            {
+                for (size_t i = 0; i < size; i++)
+                {
+                    store(static_cast<uint8_t>(text[i]));
+                }
+            }
+        }
+
+        [[nodiscard]] bool isValid() const noexcept { return !error; }
+        [[nodiscard]] uint8_t size() const noexcept { return position; }
+    };
+
+} // namespace Rpc
+
+#endif /* LIBRARY_INC_RPCPROTOCOL_H_ */
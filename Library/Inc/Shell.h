@@ -0,0 +1,488 @@
+/**
+ * @file    Shell.h
+ * @brief   Interactive command shell with compile-time perfect-hash dispatch
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * A field console for querying and tuning a running device, typically on
+ * LPUART1 (ST-LINK virtual COM port). Received bytes are taken from the
+ * driver's RX ring in poll(), edited in a fixed line buffer and dispatched
+ * to a handler from a constexpr command table.
+ *
+ * @code
+ * static void cmdLed(Shell::Console& console, const Shell::Args& args, void* context)
+ * {
+ *     uint32_t on;
+ *     if (!args.toUnsigned(1, on)) {
+ *         console.print("usage: led 0|1\r\n");
+ *         return;
+ *     }
+ *     auto output = static_cast<GPIO::GPIOOutput*>(context);
+ *     (on != 0U) ? output->set() : output->reset();
+ * }
+ *
+ * static constexpr Shell::Command COMMANDS[] = {
+ *     {"led", "led 0|1 - switch the LED", cmdLed, &led},   // static GPIO::GPIOOutput led
+ *     {"baud", "baud - show the baud rate", cmdBaud, nullptr},
+ * };
+ * static constexpr auto INDEX = Shell::buildIndex(COMMANDS);
+ * static constexpr Shell::CommandTable TABLE{COMMANDS, INDEX};
+ * static_assert(TABLE.isValid(), "Duplicate or malformed shell command");
+ *
+ * auto console = new Shell::Console(*lpuart, TABLE);
+ * console->start();
+ * // in App_Run(): console->poll();
+ * @endcode
+ *
+ * ## Line Editing
+ *
+ * | Key | Action |
+ * |-----|--------|
+ * | Left / Right, Ctrl-A / Ctrl-E, Home / End | Move the cursor |
+ * | Backspace, Delete | Delete before / at the cursor |
+ * | Up / Down | Browse history |
+ * | Ctrl-U | Clear the line |
+ * | Ctrl-C | Cancel the line |
+ *
+ * History is kept in one fixed HISTORY_SIZE byte buffer as NUL-terminated
+ * lines; the oldest lines are dropped when it is full. `help` is built in
+ * and lists the table.
+ *
+ * ## Dispatch
+ *
+ * buildIndex() computes a minimal-probe perfect hash at compile time
+ * ("hash and displace"): names are FNV-1a hashed into N/4 buckets and each
+ * bucket gets a 16-bit seed that places all of its names in distinct free
+ * slots of a power-of-two table at least 2N large. A lookup is one hash of
+ * the typed name, one bucket seed, one slot read and one string compare,
+ * independent of the number of commands.
+ *
+ * Arguments are tokenized in place: separators in the line buffer are
+ * replaced by NUL and Args holds pointers into it, so handlers receive
+ * plain C strings without any copy. Double quotes group a token with spaces.
+ *
+ * Lookup of a random name from generated tables ("cmd000", ...), measured
+ * on an x86-64 host at -O2 by Tests/Host/ShellTest.cpp (one run; only the
+ * index size carries over to the target):
+ *
+ * | Commands | Index size (flash) | Perfect hash lookup | Linear strcmp scan |
+ * |----------|--------------------|---------------------|--------------------|
+ * | 10       | 72 B               | 21 ns               | 56 ns              |
+ * | 100      | 564 B              | 20 ns               | 327 ns             |
+ * | 500      | 2300 B             | 20 ns               | 1347 ns            |
+ *
+ * @note Handlers run from poll() in the main loop, never in interrupt context.
+ */
+
+#ifndef LIBRARY_INC_SHELL_H_
+#define LIBRARY_INC_SHELL_H_
+
+#include "usart.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace Shell
+ * @brief Line editor, tokenizer and perfect-hash command table
+ */
+namespace Shell
+{
+    class Console;
+
+    /**
+     * @class Args
+     * @brief Zero-copy view over the tokens of one command line
+     *
+     * args[0] is the command name. Tokens point into the console line buffer
+     * and are valid until the handler returns.
+     */
+    class Args
+    {
+    private:
+        const char* const* tokens;
+        uint8_t count;
+
+    public:
+        constexpr Args(const char* const* tokenList, uint8_t tokenCount) noexcept
+            : tokens(tokenList), count(tokenCount) {}
+
+        [[nodiscard]] constexpr uint8_t size() const noexcept { return count; }
+
+        /**
+         * @brief Token by index, empty string when out of range
+         */
+        [[nodiscard]] constexpr const char* operator[](uint8_t index) const noexcept
+        {
+            return (index < count) ? tokens[index] : "";
+        }
+
+        /**
+         * @brief Parse a signed decimal or 0x-prefixed hex argument
+         * @return false if missing, not a complete number or out of range
+         *         (a leading zero is still decimal, not octal)
+         */
+        bool toInt(uint8_t index, int32_t& value) const noexcept;
+
+        /**
+         * @brief Parse an unsigned decimal or 0x-prefixed hex argument
+         * @return false if missing, signed, not a complete number or out of range
+         */
+        bool toUnsigned(uint8_t index, uint32_t& value) const noexcept;
+    };
+
+    /// Command implementation, runs from Console::poll()
+    using Handler = void (*)(Console& console, const Args& args, void* context);
+
+    /**
+     * @struct Command
+     * @brief One entry of the command table
+     */
+    struct Command
+    {
+        const char* name;   ///< Typed name, no spaces
+        const char* help;   ///< One line listed by `help`
+        Handler handler;
+        void* context;      ///< Forwarded to the handler
+    };
+
+    static constexpr uint16_t EMPTY_SLOT = 0xFFFFU;
+
+    [[nodiscard]] constexpr size_t nameLength(const char* name) noexcept
+    {
+        size_t length = 0;
+        while (name[length] != '\0')
+        {
+            length++;
+        }
+        return length;
+    }
+
+    /**
+     * @brief FNV-1a over a name
+     */
+    [[nodiscard]] constexpr uint32_t hashName(const char* name, size_t length) noexcept
+    {
+        uint32_t hash = 2166136261U;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619U;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief Slot of a name hash for a bucket seed (murmur3 finalizer)
+     */
+    [[nodiscard]] constexpr uint16_t slotOf(uint32_t hash, uint16_t seed, uint16_t mask) noexcept
+    {
+        uint32_t value = hash ^ (seed * 0x9E3779B9U);
+        value ^= value >> 16;
+        value *= 0x85EBCA6BU;
+        value ^= value >> 13;
+        value *= 0xC2B2AE35U;
+        value ^= value >> 16;
+        return static_cast<uint16_t>(value & mask);
+    }
+
+    /**
+     * @brief Smallest power of two holding 2 * count slots
+     */
+    [[nodiscard]] constexpr uint16_t slotCountFor(size_t count) noexcept
+    {
+        uint16_t slots = 2;
+        while (slots < 2U * count)
+        {
+            slots = static_cast<uint16_t>(slots * 2U);
+        }
+        return slots;
+    }
+
+    /**
+     * @struct CommandIndex
+     * @brief Perfect-hash index for a table of N commands, built by buildIndex()
+     */
+    template<size_t N>
+    struct CommandIndex
+    {
+        static_assert(N > 0 && N <= 4096, "Command table must contain 1..4096 commands");
+
+        static constexpr uint16_t BUCKET_COUNT = static_cast<uint16_t>((N + 3U) / 4U);
+        static constexpr uint16_t SLOT_COUNT = slotCountFor(N);
+
+        uint16_t seeds[BUCKET_COUNT];
+        uint16_t slots[SLOT_COUNT];   ///< Command index or EMPTY_SLOT
+        bool valid;                   ///< false for duplicate names/hashes or a bucket that could not be placed
+    };
+
+    /**
+     * @brief Build the perfect-hash index of a command table at compile time
+     *
+     * Buckets are placed largest first; for each one the seeds 0..65535 are
+     * tried until all of its names land in distinct free slots. With the
+     * table at most half full a seed is usually found within a few tries.
+     *
+     * Two names with the same FNV-1a hash (in particular two equal names)
+     * map to the same slot for every seed, so they are rejected up front
+     * instead of exhausting the seed search.
+     */
+    template<size_t N>
+    [[nodiscard]] constexpr CommandIndex<N> buildIndex(const Command (&commands)[N]) noexcept
+    {
+        using Index = CommandIndex<N>;
+        constexpr uint16_t mask = static_cast<uint16_t>(Index::SLOT_COUNT - 1U);
+
+        Index index{};
+        index.valid = true;
+        for (uint16_t slot = 0; slot < Index::SLOT_COUNT; slot++)
+        {
+            index.slots[slot] = EMPTY_SLOT;
+        }
+
+        uint32_t hashes[N] = {};
+        uint16_t bucketSize[Index::BUCKET_COUNT] = {};
+        for (size_t i = 0; i < N; i++)
+        {
+            hashes[i] = hashName(commands[i].name, nameLength(commands[i].name));
+            bucketSize[hashes[i] % Index::BUCKET_COUNT]++;
+            for (size_t k = 0; k < i; k++)
+            {
+                if (hashes[k] == hashes[i])
+                {
+                    index.valid = false;
+                    return index;
+                }
+            }
+        }
+
+        // Insertion sort of bucket numbers by size, largest first
+        uint16_t order[Index::BUCKET_COUNT] = {};
+        for (uint16_t b = 0; b < Index::BUCKET_COUNT; b++)
+        {
+            uint16_t position = b;
+            while (position > 0 && bucketSize[order[position - 1U]] < bucketSize[b])
+            {
+                order[position] = order[position - 1U];
+                position--;
+            }
+            order[position] = b;
+        }
+
+        uint16_t candidate[N] = {};
+        for (uint16_t o = 0; o < Index::BUCKET_COUNT; o++)
+        {
+            const uint16_t bucket = order[o];
+            if (bucketSize[bucket] == 0)
+            {
+                break;
+            }
+
+            bool placed = false;
+            for (uint32_t seed = 0; seed <= 0xFFFFU && !placed; seed++)
+            {
+                placed = true;
+                uint16_t used = 0;
+                for (size_t i = 0; i < N && placed; i++)
+                {
+                    if (hashes[i] % Index::BUCKET_COUNT != bucket)
+                    {
+                        continue;
+                    }
+                    const uint16_t slot = slotOf(hashes[i], static_cast<uint16_t>(seed), mask);
+                    placed = (index.slots[slot] == EMPTY_SLOT);
+                    for (uint16_t k = 0; k < used && placed; k++)
+                    {
+                        placed = (candidate[k] != slot);
+                    }
+                    candidate[used++] = slot;
+                }
+
+                if (placed)
+                {
+                    index.seeds[bucket] = static_cast<uint16_t>(seed);
+                    used = 0;
+                    for (size_t i = 0; i < N; i++)
+                    {
+                        if (hashes[i] % Index::BUCKET_COUNT == bucket)
+                        {
+                            index.slots[candidate[used++]] = static_cast<uint16_t>(i);
+                        }
+                    }
+                }
+            }
+
+            if (!placed)
+            {
+                index.valid = false;
+                break;
+            }
+        }
+        return index;
+    }
+
+    /**
+     * @class CommandTable
+     * @brief Non-owning view over a constexpr command array and its index
+     */
+    class CommandTable
+    {
+    private:
+        const Command* commands;
+        const uint16_t* seeds;
+        const uint16_t* slots;
+        uint16_t count;
+        uint16_t bucketCount;
+        uint16_t slotMask;
+        bool indexValid;
+
+    public:
+        template<size_t N>
+        constexpr CommandTable(const Command (&table)[N], const CommandIndex<N>& index) noexcept
+            : commands(table), seeds(index.seeds), slots(index.slots),
+              count(static_cast<uint16_t>(N)), bucketCount(CommandIndex<N>::BUCKET_COUNT),
+              slotMask(static_cast<uint16_t>(CommandIndex<N>::SLOT_COUNT - 1U)), indexValid(index.valid)
+        {
+        }
+
+        /**
+         * @brief Check names, handlers and the index (usable in static_assert)
+         */
+        [[nodiscard]] constexpr bool isValid() const noexcept
+        {
+            if (!indexValid)
+            {
+                return false;
+            }
+            for (uint16_t i = 0; i < count; i++)
+            {
+                const Command& command = commands[i];
+                if (command.name == nullptr || command.name[0] == '\0' ||
+                    command.help == nullptr || command.handler == nullptr)
+                {
+                    return false;
+                }
+                for (size_t c = 0; command.name[c] != '\0'; c++)
+                {
+                    if (command.name[c] == ' ' || command.name[c] == '"')
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Constant-time lookup of a typed name
+         * @param name Name characters (need not be NUL-terminated)
+         * @param length Name length
+         * @return Command or nullptr if the name is unknown
+         */
+        [[nodiscard]] constexpr const Command* find(const char* name, size_t length) const noexcept
+        {
+            const uint32_t hash = hashName(name, length);
+            const uint16_t entry = slots[slotOf(hash, seeds[hash % bucketCount], slotMask)];
+            if (entry == EMPTY_SLOT)
+            {
+                return nullptr;
+            }
+
+            const char* candidate = commands[entry].name;
+            for (size_t i = 0; i < length; i++)
+            {
+                if (candidate[i] != name[i])
+                {
+                    return nullptr;
+                }
+            }
+            return (candidate[length] == '\0') ? &commands[entry] : nullptr;
+        }
+
+        [[nodiscard]] constexpr uint16_t size() const noexcept { return count; }
+        [[nodiscard]] constexpr const Command& operator[](uint16_t index) const noexcept { return commands[index]; }
+    };
+
+    /**
+     * @class Console
+     * @brief Line editor and dispatcher on top of a USART driver
+     */
+    class Console
+    {
+    public:
+        static constexpr uint8_t LINE_SIZE = 80;        ///< Characters per line
+        static constexpr uint16_t HISTORY_SIZE = 256;   ///< Bytes of history
+        static constexpr uint8_t MAX_ARGS = 8;          ///< Tokens including the name
+
+        /**
+         * @brief Construct a console
+         * @param uart Initialized USART driver (RX callback must be unset)
+         * @param table Validated command table
+         * @param prompt Prompt string
+         */
+        Console(USART::StandardUSART& uart, const CommandTable& table, const char* prompt = "> ") noexcept;
+
+        /**
+         * @brief Print the prompt and start accepting input
+         */
+        void start() noexcept;
+
+        /**
+         * @brief Process received bytes and run completed commands
+         * @return Number of commands executed
+         */
+        uint8_t poll() noexcept;
+
+        /**
+         * @brief Queue text on the console (for handlers)
+         */
+        uint16_t print(const char* text) noexcept { return uart.sendString(text); }
+
+        /**
+         * @brief Driver access for formatted output (sendFormatted)
+         */
+        [[nodiscard]] USART::StandardUSART& getUart() noexcept { return uart; }
+
+    private:
+        enum class EscapeState : uint8_t
+        {
+            NONE,
+            ESCAPE,     ///< ESC received
+            SEQUENCE    ///< ESC [ received, collecting a parameter
+        };
+
+        USART::StandardUSART& uart;
+        const CommandTable& table;
+        const char* prompt;
+
+        char line[LINE_SIZE + 1];
+        uint8_t length;
+        uint8_t cursor;
+        EscapeState escape;
+        uint8_t escapeParameter;
+        bool lastWasCr;
+
+        char history[HISTORY_SIZE];     ///< Oldest first, NUL-terminated lines
+        uint16_t historyUsed;
+        int32_t historyPosition;        ///< Start of the recalled line, -1 when editing a new line
+
+        uint8_t handleByte(uint8_t data) noexcept;
+        void handleEscape(uint8_t data) noexcept;
+        uint8_t submitLine() noexcept;
+        void execute() noexcept;
+        void listCommands() noexcept;
+
+        void insert(char character) noexcept;
+        void erase(uint8_t position) noexcept;
+        void moveCursor(int16_t delta) noexcept;
+        void redraw() noexcept;
+
+        void addHistory() noexcept;
+        void recallOlder() noexcept;
+        void recallNewer() noexcept;
+        void loadLine(const char* text) noexcept;
+    };
+
+} // namespace Shell
+
+#endif /* LIBRARY_INC_SHELL_H_ */
@@ -0,0 +1,595 @@
+/**
+ * @file    Telemetry.h
+ * @brief   Zero-allocation CBOR telemetry encoder with compile-time record schemas
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Encodes sensor samples as CBOR (RFC 8949) instead of formatted text.
+ * The encoder writes byte by byte into any sink with `bool put(uint8_t)`,
+ * in particular a reservation on the USART TX ring, so a record is
+ * serialized exactly once, directly where the UART will send it from.
+ *
+ * Supported subset: unsigned/negative integers, float32, bool, null,
+ * byte and text strings, definite-length arrays and maps.
+ *
+ * ## Records
+ *
+ * A record is a CBOR map from field index (0..N-1) to value, described
+ * entirely by its C++ field types. The worst-case encoded size is known at
+ * compile time and used to size the TX reservation:
+ *
+ * @code
+ * using ImuSample = Telemetry::Record<uint32_t, float, float, float>;  // time, ax, ay, az
+ * static_assert(ImuSample::MAX_SIZE <= 64, "ImuSample too large");
+ *
+ * auto reservation = uart->reserveTx(ImuSample::MAX_SIZE);
+ * Telemetry::Encoder<USART::StandardUSART::TxReservation> encoder(reservation);
+ * if (ImuSample::encode(encoder, HAL_GetTick(), ax, ay, az)) {
+ *     uart->commitTx(reservation);
+ * } else {
+ *     uart->abortTx(reservation);   // TX ring too full, nothing partial is sent
+ * }
+ * @endcode
+ *
+ * ## Decoding
+ *
+ * Decoder reads the same subset back (portable, used by host tools and
+ * tests) and Record::decode() mirrors encode():
+ *
+ * @code
+ * Telemetry::Decoder decoder(frame, length);
+ * uint32_t time; float ax, ay, az;
+ * if (ImuSample::decode(decoder, time, ax, ay, az)) { ... }
+ * @endcode
+ *
+ * Any CBOR library works as well, e.g. `cbor2.loads()` in Python yields
+ * `{0: 123456, 1: 0.12, 2: -0.98, 3: 9.81}`.
+ *
+ * ## Size Comparison (ImuSample)
+ *
+ * | Format | Bytes per record |
+ * |--------|------------------|
+ * | `sendFormatted("t=%lu ax=%.3f ay=%.3f az=%.3f\r\n")` (±16 g) | 32..47 |
+ * | CBOR record, timestamp 256..65535 | 23 |
+ * | CBOR record, worst case (`MAX_SIZE`) | 25 |
+ *
+ * Encoding needs no division or float formatting: a float is written as its
+ * four IEEE-754 bytes and integers as a header plus 0..4 big-endian bytes.
+ * Tests/Host/TelemetryTest checks the sizes above and prints the encode
+ * time of a record against the vsnprintf() formatting behind sendFormatted().
+ */
+
+#ifndef LIBRARY_INC_TELEMETRY_H_
+#define LIBRARY_INC_TELEMETRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/**
+ * @namespace Telemetry
+ * @brief CBOR encoder/decoder and compile-time telemetry record schemas
+ */
+namespace Telemetry
+{
+    /**
+     * @enum MajorType
+     * @brief CBOR major types (upper 3 bits of the initial byte)
+     */
+    enum class MajorType : uint8_t
+    {
+        UNSIGNED = 0,
+        NEGATIVE = 1,
+        BYTES = 2,
+        TEXT = 3,
+        ARRAY = 4,
+        MAP = 5,
+        SIMPLE = 7
+    };
+
+    // Simple values and additional information from RFC 8949
+    static constexpr uint8_t SIMPLE_FALSE = 0xF4;
+    static constexpr uint8_t SIMPLE_TRUE = 0xF5;
+    static constexpr uint8_t SIMPLE_NULL = 0xF6;
+    static constexpr uint8_t FLOAT32 = 0xFA;
+
+    /**
+     * @brief Size of a type/length header for a given argument
+     */
+    [[nodiscard]] constexpr uint8_t headerSize(uint32_t argument) noexcept
+    {
+        return (argument < 24U) ? 1U : (argument <= 0xFFU) ? 2U : (argument <= 0xFFFFU) ? 3U : 5U;
+    }
+
+    /**
+     * @struct Bytes
+     * @brief Non-owning byte string field
+     * @tparam MAX_LENGTH Upper bound used for the record size calculation
+     */
+    template<uint16_t MAX_LENGTH>
+    struct Bytes
+    {
+        const uint8_t* data;
+        uint16_t length;   ///< Clamped to MAX_LENGTH when encoded
+    };
+
+    /**
+     * @class LinearSink
+     * @brief Sink over a plain byte array (RAM buffers, tests, flash logging)
+     */
+    class LinearSink
+    {
+    private:
+        uint8_t* data;
+        uint16_t capacity;
+        uint16_t length;
+
+    public:
+        constexpr LinearSink(uint8_t* buffer, uint16_t bufferSize) noexcept
+            : data(buffer), capacity(bufferSize), length(0) {}
+
+        bool put(uint8_t value) noexcept
+        {
+            if (length >= capacity)
+            {
+                return false;
+            }
+            data[length++] = value;
+            return true;
+        }
+
+        [[nodiscard]] uint16_t size() const noexcept { return length; }
+    };
+
+    /**
+     * @class Encoder
+     * @brief Streaming CBOR encoder
+     * @tparam SINK Any type with `bool put(uint8_t)`
+     *
+     * A failed put() latches the error flag; later writes are ignored so the
+     * caller only has to check isValid() once per record.
+     */
+    template<typename SINK>
+    class Encoder
+    {
+    private:
+        SINK& sink;
+        bool error;
+
+        void put(uint8_t value) noexcept
+        {
+            if (!error && !sink.put(value))
+            {
+                error = true;
+            }
+        }
+
+        void writeHeader(MajorType type, uint32_t argument) noexcept
+        {
+            const uint8_t major = static_cast<uint8_t>(static_cast<uint8_t>(type) << 5);
+            if (argument < 24U)
+            {
+                put(static_cast<uint8_t>(major | argument));
+            }
+            else if (argument <= 0xFFU)
+            {
+                put(static_cast<uint8_t>(major | 24U));
+                put(static_cast<uint8_t>(argument));
+            }
+            else if (argument <= 0xFFFFU)
+            {
+                put(static_cast<uint8_t>(major | 25U));
+                put(static_cast<uint8_t>(argument >> 8));
+                put(static_cast<uint8_t>(argument));
+            }
+            else
+            {
+                put(static_cast<uint8_t>(major | 26U));
+                put(static_cast<uint8_t>(argument >> 24));
+                put(static_cast<uint8_t>(argument >> 16));
+                put(static_cast<uint8_t>(argument >> 8));
+                put(static_cast<uint8_t>(argument));
+            }
+        }
+
+        void writeRaw(const uint8_t* data, uint16_t length) noexcept
+        {
+            for (uint16_t i = 0; i < length && !error; i++)
+            {
+                put(data[i]);
+            }
+        }
+
+    public:
+        explicit Encoder(SINK& output) noexcept : sink(output), error(false) {}
+
+        void writeUnsigned(uint32_t value) noexcept
+        {
+            writeHeader(MajorType::UNSIGNED, value);
+        }
+
+        void writeSigned(int32_t value) noexcept
+        {
+            if (value >= 0)
+            {
+                writeHeader(MajorType::UNSIGNED, static_cast<uint32_t>(value));
+            }
+            else
+            {
+                // CBOR negative integers encode -1 - value
+                writeHeader(MajorType::NEGATIVE, static_cast<uint32_t>(-1 - value));
+            }
+        }
+
+        void writeFloat(float value) noexcept
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            put(FLOAT32);
+            put(static_cast<uint8_t>(bits >> 24));
+            put(static_cast<uint8_t>(bits >> 16));
+            put(static_cast<uint8_t>(bits >> 8));
+            put(static_cast<uint8_t>(bits));
+        }
+
+        void writeBool(bool value) noexcept
+        {
+            put(value ? SIMPLE_TRUE : SIMPLE_FALSE);
+        }
+
+        void writeNull() noexcept
+        {
+            put(SIMPLE_NULL);
+        }
+
+        void writeBytes(const uint8_t* data, uint16_t length) noexcept
+        {
+            writeHeader(MajorType::BYTES, length);
+            writeRaw(data, length);
+        }
+
+        void writeText(const char* text) noexcept
+        {
+            const uint16_t length = static_cast<uint16_t>(std::strlen(text));
+            writeHeader(MajorType::TEXT, length);
+            writeRaw(reinterpret_cast<const uint8_t*>(text), length);
+        }
+
+        /**
+         * @brief Start an array; the next count items are its elements
+         */
+        void beginArray(uint16_t count) noexcept
+        {
+            writeHeader(MajorType::ARRAY, count);
+        }
+
+        /**
+         * @brief Start a map; the next 2 * count items are key/value pairs
+         */
+        void beginMap(uint16_t count) noexcept
+        {
+            writeHeader(MajorType::MAP, count);
+        }
+
+        // Overloads used by Record::encode()
+        void write(uint8_t value) noexcept { writeUnsigned(value); }
+        void write(uint16_t value) noexcept { writeUnsigned(value); }
+        void write(uint32_t value) noexcept { writeUnsigned(value); }
+        void write(int8_t value) noexcept { writeSigned(value); }
+        void write(int16_t value) noexcept { writeSigned(value); }
+        void write(int32_t value) noexcept { writeSigned(value); }
+        void write(float value) noexcept { writeFloat(value); }
+        void write(bool value) noexcept { writeBool(value); }
+
+        template<uint16_t MAX_LENGTH>
+        void write(const Bytes<MAX_LENGTH>& value) noexcept
+        {
+            writeBytes(value.data, (value.length < MAX_LENGTH) ? value.length : MAX_LENGTH);
+        }
+
+        [[nodiscard]] bool isValid() const noexcept { return !error; }
+    };
+
+    /**
+     * @class Decoder
+     * @brief Pull decoder for the CBOR subset written by Encoder
+     *
+     * Reads items in order from a byte buffer. A truncated, malformed or
+     * unexpected item latches the error flag and later reads return 0, so the
+     * caller checks isValid() once per record. Byte and text strings are
+     * returned as pointers into the buffer.
+     */
+    class Decoder
+    {
+    private:
+        const uint8_t* data;
+        size_t length;
+        size_t position;
+        bool error;
+
+        [[nodiscard]] bool take(size_t count) noexcept
+        {
+            if (error || length - position < count)
+            {
+                error = true;
+                return false;
+            }
+            return true;
+        }
+
+        uint32_t readBigEndian(uint8_t count) noexcept
+        {
+            uint32_t value = 0;
+            if (take(count))
+            {
+                for (uint8_t i = 0; i < count; i++)
+                {
+                    value = (value << 8) | data[position++];
+                }
+            }
+            return value;
+        }
+
+        uint32_t readHeader(MajorType expected) noexcept
+        {
+            if (!take(1))
+            {
+                return 0;
+            }
+            const uint8_t initial = data[position];
+            if ((initial >> 5) != static_cast<uint8_t>(expected))
+            {
+                error = true;
+                return 0;
+            }
+            position++;
+
+            const uint8_t info = initial & 0x1FU;
+            switch (info)
+            {
+                case 24: return readBigEndian(1);
+                case 25: return readBigEndian(2);
+                case 26: return readBigEndian(4);
+                default:
+                    if (info < 24U)
+                    {
+                        return info;
+                    }
+                    error = true;   // 64-bit arguments and indefinite lengths are not in the subset
+                    return 0;
+            }
+        }
+
+        template<typename T>
+        void readInteger(T& value) noexcept
+        {
+            const int64_t decoded = readInteger();
+            if (decoded < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+                decoded > static_cast<int64_t>(std::numeric_limits<T>::max()))
+            {
+                error = true;
+            }
+            value = error ? T{} : static_cast<T>(decoded);
+        }
+
+        int64_t readInteger() noexcept
+        {
+            if (take(1) && (data[position] >> 5) == static_cast<uint8_t>(MajorType::NEGATIVE))
+            {
+                return -1 - static_cast<int64_t>(readHeader(MajorType::NEGATIVE));
+            }
+            return readHeader(MajorType::UNSIGNED);
+        }
+
+    public:
+        constexpr Decoder(const uint8_t* buffer, size_t bufferSize) noexcept
+            : data(buffer), length(bufferSize), position(0), error(false) {}
+
+        uint32_t readUnsigned() noexcept
+        {
+            return readHeader(MajorType::UNSIGNED);
+        }
+
+        int32_t readSigned() noexcept
+        {
+            int32_t value = 0;
+            readInteger(value);
+            return value;
+        }
+
+        float readFloat() noexcept
+        {
+            float value = 0.0F;
+            if (take(5) && data[position] == FLOAT32)
+            {
+                position++;
+                const uint32_t bits = readBigEndian(4);
+                std::memcpy(&value, &bits, sizeof(value));
+            }
+            else
+            {
+                error = true;
+            }
+            return value;
+        }
+
+        bool readBool() noexcept
+        {
+            if (take(1) && (data[position] == SIMPLE_TRUE || data[position] == SIMPLE_FALSE))
+            {
+                return data[position++] == SIMPLE_TRUE;
+            }
+            error = true;
+            return false;
+        }
+
+        /**
+         * @brief Consume a null item
+         * @return true if the next item was null
+         */
+        bool readNull() noexcept
+        {
+            if (take(1) && data[position] == SIMPLE_NULL)
+            {
+                position++;
+                return true;
+            }
+            error = true;
+            return false;
+        }
+
+        const uint8_t* readBytes(uint16_t& size) noexcept
+        {
+            return readString(MajorType::BYTES, size);
+        }
+
+        /**
+         * @brief Read a text string (not NUL-terminated)
+         */
+        const char* readText(uint16_t& size) noexcept
+        {
+            return reinterpret_cast<const char*>(readString(MajorType::TEXT, size));
+        }
+
+        /**
+         * @brief Read an array header
+         * @return Element count (0 on error)
+         */
+        uint16_t readArray() noexcept
+        {
+            const uint32_t count = readHeader(MajorType::ARRAY);
+            return (count <= 0xFFFFU) ? static_cast<uint16_t>(count) : 0U;
+        }
+
+        /**
+         * @brief Read a map header
+         * @return Number of key/value pairs (0 on error)
+         */
+        uint16_t readMap() noexcept
+        {
+            const uint32_t count = readHeader(MajorType::MAP);
+            return (count <= 0xFFFFU) ? static_cast<uint16_t>(count) : 0U;
+        }
+
+        /**
+         * @brief Read an unsigned key and latch an error if it differs
+         */
+        void expectKey(uint32_t key) noexcept
+        {
+            if (readUnsigned() != key)
+            {
+                error = true;
+            }
+        }
+
+        // Overloads used by Record::decode(), range-checked against the field type
+        void read(uint8_t& value) noexcept { readInteger(value); }
+        void read(uint16_t& value) noexcept { readInteger(value); }
+        void read(uint32_t& value) noexcept { readInteger(value); }
+        void read(int8_t& value) noexcept { readInteger(value); }
+        void read(int16_t& value) noexcept { readInteger(value); }
+        void read(int32_t& value) noexcept { readInteger(value); }
+        void read(float& value) noexcept { value = readFloat(); }
+        void read(bool& value) noexcept { value = readBool(); }
+
+        template<uint16_t MAX_LENGTH>
+        void read(Bytes<MAX_LENGTH>& value) noexcept
+        {
+            value.data = readBytes(value.length);
+            if (value.length > MAX_LENGTH)
+            {
+                error = true;
+            }
+        }
+
+        [[nodiscard]] bool isValid() const noexcept { return !error; }
+        [[nodiscard]] size_t getPosition() const noexcept { return position; }
+        [[nodiscard]] bool isAtEnd() const noexcept { return position == length; }
+
+    private:
+        const uint8_t* readString(MajorType type, uint16_t& size) noexcept
+        {
+            const uint32_t count = readHeader(type);
+            if (error || count > 0xFFFFU || !take(count))
+            {
+                size = 0;
+                return nullptr;
+            }
+            size = static_cast<uint16_t>(count);
+            const uint8_t* bytes = &data[position];
+            position += count;
+            return bytes;
+        }
+    };
+
+    /**
+     * @brief Worst-case encoded size of one field type
+     */
+    template<typename T>
+    struct FieldTraits;
+
+    template<> struct FieldTraits<uint8_t>  { static constexpr uint16_t MAX_SIZE = 2; };
+    template<> struct FieldTraits<uint16_t> { static constexpr uint16_t MAX_SIZE = 3; };
+    template<> struct FieldTraits<uint32_t> { static constexpr uint16_t MAX_SIZE = 5; };
+    template<> struct FieldTraits<int8_t>   { static constexpr uint16_t MAX_SIZE = 2; };
+    template<> struct FieldTraits<int16_t>  { static constexpr uint16_t MAX_SIZE = 3; };
+    template<> struct FieldTraits<int32_t>  { static constexpr uint16_t MAX_SIZE = 5; };
+    template<> struct FieldTraits<float>    { static constexpr uint16_t MAX_SIZE = 5; };
+    template<> struct FieldTraits<bool>     { static constexpr uint16_t MAX_SIZE = 1; };
+
+    template<uint16_t MAX_LENGTH>
+    struct FieldTraits<Bytes<MAX_LENGTH>>
+    {
+        static constexpr uint16_t MAX_SIZE = headerSize(MAX_LENGTH) + MAX_LENGTH;
+    };
+
+    /**
+     * @class Record
+     * @brief Compile-time record schema: a CBOR map {0: F0, 1: F1, ...}
+     * @tparam FIELDS Field types in key order
+     */
+    template<typename... FIELDS>
+    class Record
+    {
+    public:
+        static constexpr uint16_t FIELD_COUNT = sizeof...(FIELDS);
+        static_assert(FIELD_COUNT > 0 && FIELD_COUNT < 24, "Record needs 1..23 fields (single byte keys)");
+
+        /// Map header + one byte per key + worst-case value sizes
+        static constexpr uint16_t MAX_SIZE = headerSize(FIELD_COUNT) + FIELD_COUNT + (FieldTraits<FIELDS>::MAX_SIZE + ...);
+
+        /**
+         * @brief Encode one record
+         * @return true if the sink accepted the complete record; on false the
+         *         sink holds a partial record that must not be sent
+         */
+        template<typename SINK>
+        static bool encode(Encoder<SINK>& encoder, const FIELDS&... values) noexcept
+        {
+            encoder.beginMap(FIELD_COUNT);
+            uint8_t key = 0;
+            ((encoder.writeUnsigned(key++), encoder.write(values)), ...);
+            return encoder.isValid();
+        }
+
+        /**
+         * @brief Decode one record written by encode()
+         * @return true if a map with exactly these keys and value types was read
+         */
+        static bool decode(Decoder& decoder, FIELDS&... values) noexcept
+        {
+            if (decoder.readMap() != FIELD_COUNT)
+            {
+                return false;
+            }
+            uint8_t key = 0;
+            ((decoder.expectKey(key++), decoder.read(values)), ...);
+            return decoder.isValid();
+        }
+    };
+
+} // namespace Telemetry
+
+#endif /* LIBRARY_INC_TELEMETRY_H_ */
@@ -0,0 +1,280 @@
+/**
+ * @file    TimeSync.h
+ * @brief   PTP-like host/device time synchronization over UART
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * The device periodically runs a two-way exchange with the host and keeps
+ * a model of host time as a function of its own DWT cycle counter, so
+ * telemetry can be stamped with host-aligned microseconds:
+ *
+ * ```
+ *   device                          host
+ *   t1  REQUEST 'T' seq CRC ------>  t2  (request fully received)
+ *   t4  <------ REPLY 't' seq t2 t3 CRC  t3  (reply start)
+ * ```
+ *
+ * - t1 is taken in the USART TC interrupt (stop bit of the last request byte)
+ * - t4 is taken in the RX interrupt of the first reply byte, minus one
+ *   character time (the interrupt fires after its stop bit)
+ * - t2/t3 are host microseconds (u64, little-endian), CRC-16/MODBUS (Crc16.h)
+ *
+ * Round trip = (t4 - t1) - (t3 - t2); the offset is taken at the exchange
+ * midpoint assuming symmetric delays. Exchanges with a round trip well
+ * above the recent minimum are discarded, which removes most host
+ * scheduling jitter. Offset and drift are fitted over the last 32 accepted
+ * exchanges (ClockModel).
+ *
+ * ## Usage
+ *
+ * @code
+ * auto sync = new TimeSync::Client(*uart, config.baudRate);
+ * sync->start(1000);                        // One exchange per second
+ *
+ * // App_Run():
+ * sync->poll();
+ * if (sync->getModel().isSynchronized()) {
+ *     int64_t hostUs = sync->hostTimeUs();
+ * }
+ * @endcode
+ *
+ * `Responder` implements the host side of the exchange in portable C++ and
+ * can be compiled into host tools (or a second board acting as master).
+ *
+ * ## Accuracy (simulation)
+ *
+ * One exchange per second, device clock +80 ppm, one-way latency 1 ms plus
+ * uniform jitter per direction, evaluated from the 60th exchange on
+ * (Tests/Host/TimeSyncTest.cpp, offset error of toHost() at t4):
+ *
+ * | Jitter per direction | Rejected | Offset error RMS / max | Drift error max |
+ * |----------------------|----------|------------------------|-----------------|
+ * | 0..0.2 ms (FTDI, low latency) | 0 % | 15 us / 44 us | 2.3 ppm |
+ * | 0..1 ms | 56 % | 63 us / 158 us | 5.3 ppm |
+ * | 0..4 ms (USB CDC, busy host) | 89 % | 119 us / 298 us | 5.4 ppm |
+ *
+ * Asymmetric latency adds half the asymmetry as a constant offset error
+ * that no two-way protocol can observe.
+ *
+ * @note The client owns the RX callback and the TX-complete callback of its
+ *       USART, so the link should be dedicated to the exchange or carry
+ *       only device-to-host telemetry sent outside of an exchange.
+ */
+
+#ifndef LIBRARY_INC_TIMESYNC_H_
+#define LIBRARY_INC_TIMESYNC_H_
+
+#include "usart.h"
+#include "Crc16.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace TimeSync
+ * @brief Host/device clock alignment over a UART link
+ */
+namespace TimeSync
+{
+    static constexpr uint8_t REQUEST_MARKER = 'T';
+    static constexpr uint8_t REPLY_MARKER = 't';
+    static constexpr uint8_t REQUEST_SIZE = 4;    // marker + seq + CRC
+    static constexpr uint8_t REPLY_SIZE = 20;     // marker + seq + t2 + t3 + CRC
+
+    /**
+     * @struct Exchange
+     * @brief Timestamps of one request/reply exchange in microseconds
+     */
+    struct Exchange
+    {
+        int64_t t1;   ///< Device: request sent
+        int64_t t2;   ///< Host: request received
+        int64_t t3;   ///< Host: reply sent
+        int64_t t4;   ///< Device: reply received
+    };
+
+    /**
+     * @class ClockModel
+     * @brief Offset/drift estimate mapping device microseconds to host microseconds
+     *
+     * Accepted exchanges are kept as (device time, offset) points in a small
+     * window; a least-squares line through them gives the drift (slope) and
+     * the offset at the window centre:
+     * host = referenceHost + d + d * driftPpb / 1e9, with d = device - referenceDevice
+     */
+    class ClockModel
+    {
+    public:
+        static constexpr int32_t MAX_DRIFT_PPB = 1000000;        ///< +-1000 ppm
+        static constexpr int64_t MIN_DRIFT_INTERVAL_US = 100000;  ///< Drift needs at least 100 ms spacing
+        static constexpr int64_t STEP_THRESHOLD_US = 100000;      ///< Larger errors restart the model
+        static constexpr int64_t ROUND_TRIP_MARGIN_US = 50;       ///< Accepted: rtt <= 1.25 * min + margin
+        static constexpr uint8_t WINDOW_SIZE = 32;                ///< Exchanges in the fit
+
+        ClockModel() noexcept;
+
+        /**
+         * @brief Feed one completed exchange
+         * @return true if the exchange was used, false if rejected as outlier
+         */
+        bool addExchange(const Exchange& exchange) noexcept;
+
+        /**
+         * @brief Convert a device time to host time
+         */
+        [[nodiscard]] int64_t toHost(int64_t deviceUs) const noexcept;
+
+        /**
+         * @brief Forget all state (e.g. after the host clock was stepped)
+         */
+        void reset() noexcept;
+
+        [[nodiscard]] bool isSynchronized() const noexcept { return count >= 4; }
+        [[nodiscard]] int32_t getDriftPpb() const noexcept { return driftPpb; }
+        [[nodiscard]] int64_t getLastOffsetErrorUs() const noexcept { return lastErrorUs; }
+        [[nodiscard]] int64_t getMinRoundTripUs() const noexcept { return minRoundTripUs; }
+        [[nodiscard]] uint32_t getRejectedCount() const noexcept { return rejected; }
+
+    private:
+        struct Point
+        {
+            int64_t deviceUs;   ///< Exchange midpoint, device clock
+            int64_t offsetUs;   ///< Host minus device at that point
+        };
+
+        Point points[WINDOW_SIZE];
+        int64_t referenceDevice;
+        int64_t referenceHost;
+        int64_t minRoundTripUs;     ///< Slowly relaxing minimum, -1 before the first exchange
+        int64_t lastErrorUs;        ///< Prediction error of the last accepted exchange
+        int32_t driftPpb;
+        uint8_t head;
+        uint8_t count;
+        uint32_t rejected;
+
+        void fit() noexcept;
+    };
+
+    /**
+     * @class Responder
+     * @brief Host side of the exchange (portable C++)
+     *
+     * Feed every received byte with the host time of its arrival; once a
+     * request is complete, send buildReply() and stamp t3 as close to the
+     * write as possible.
+     */
+    class Responder
+    {
+    public:
+        Responder() noexcept;
+
+        /**
+         * @brief Parse one byte from the device
+         * @param data Received byte
+         * @param hostUs Host time when the byte arrived
+         * @return true when a complete, valid request was received
+         */
+        bool receiveByte(uint8_t data, int64_t hostUs) noexcept;
+
+        /**
+         * @brief Build the reply for the last request
+         * @param out REPLY_SIZE bytes
+         * @param t3 Host time at which the reply is written to the port
+         */
+        void buildReply(uint8_t* out, int64_t t3) const noexcept;
+
+    private:
+        uint8_t frame[REQUEST_SIZE];
+        uint8_t length;
+        uint8_t sequence;
+        int64_t requestTime;
+    };
+
+    /**
+     * @class Client
+     * @brief Device side: timestamps in the USART interrupts, servo in poll()
+     */
+    class Client
+    {
+    public:
+        static constexpr uint32_t REPLY_TIMEOUT_US = 100000;
+
+        /**
+         * @brief Construct a client
+         * @param uart Initialized USART driver connected to the host
+         * @param baudRate Line baud rate (character time correction)
+         */
+        Client(USART::StandardUSART& uart, uint32_t baudRate) noexcept;
+
+        /**
+         * @brief Enable the DWT cycle counter and attach to the USART
+         * @param intervalMs Time between exchanges started by poll() (0 = manual)
+         */
+        void start(uint32_t intervalMs) noexcept;
+
+        /**
+         * @brief Detach from the USART
+         */
+        void stop() noexcept;
+
+        /**
+         * @brief Start an exchange now
+         * @return false if one is pending or the TX queue is not empty
+         */
+        bool requestSync() noexcept;
+
+        /**
+         * @brief Extend the cycle counter, process replies, start periodic exchanges
+         * @note Must run at least every 2^32 CPU cycles (134 s at 32 MHz)
+         */
+        void poll() noexcept;
+
+        /**
+         * @brief Device time in microseconds since start()
+         */
+        [[nodiscard]] int64_t deviceTimeUs() noexcept;
+
+        /**
+         * @brief Current host-aligned time in microseconds
+         */
+        [[nodiscard]] int64_t hostTimeUs() noexcept;
+
+        [[nodiscard]] const ClockModel& getModel() const noexcept { return model; }
+        [[nodiscard]] uint32_t getTimeoutCount() const noexcept { return timeouts; }
+
+    private:
+        USART::StandardUSART& uart;
+        ClockModel model;
+        uint32_t characterCycles;       ///< One 10 bit character in CPU cycles
+        uint32_t cyclesPerUs;
+        uint32_t intervalUs;
+
+        // Cycle counter extension (main context only)
+        uint64_t cycleTotal;            ///< Cycles since start()
+        uint32_t lastCycles;            ///< CYCCNT at the last extension
+        int64_t lastRequestUs;
+
+        // Exchange state shared with the interrupts
+        volatile bool pending;
+        volatile bool t1Captured;
+        volatile bool replyReady;
+        volatile uint32_t t1Cycles;
+        volatile uint32_t t4Cycles;
+        uint8_t sequence;
+        uint8_t reply[REPLY_SIZE];
+        uint8_t replyLength;
+
+        uint32_t timeouts;
+
+        static void onRxByte(void* context, uint8_t data);
+        static void onTxComplete(void* context);
+
+        void receiveByte(uint8_t data) noexcept;
+        [[nodiscard]] uint64_t extendCycles(uint32_t raw) noexcept;
+        void processReply() noexcept;
+    };
+
+} // namespace TimeSync
+
+#endif /* LIBRARY_INC_TIMESYNC_H_ */
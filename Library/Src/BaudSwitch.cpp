@@ -0,0 +1,218 @@
+/**
+ * @file    BaudSwitch.cpp
+ * @brief   Baud rate negotiation implementation
+ * @author  MootSeeker
+ *
+ * @see BaudSwitch.h for the handshake sequence
+ */
+
+#include "BaudSwitch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace BaudSwitch
+{
+    /**
+     * @brief Wrap-safe check whether a millisecond deadline has passed
+     */
+    static bool isExpired(uint32_t nowMs, uint32_t deadline) noexcept
+    {
+        return static_cast<int32_t>(nowMs - deadline) >= 0;
+    }
+
+    /**
+     * @brief Find "<prefix> <number>" anywhere in a line (skips echo and prompt)
+     */
+    static bool parseReply(const char* line, const char* prefix, uint32_t& value) noexcept
+    {
+        const char* match = std::strstr(line, prefix);
+        if (match == nullptr)
+        {
+            return false;
+        }
+        char* end = nullptr;
+        value = static_cast<uint32_t>(std::strtoul(match + std::strlen(prefix), &end, 10));
+        return end != match + std::strlen(prefix);
+    }
+
+    // ========================================================================
+    // Negotiator (device side)
+    // ========================================================================
+
+    Negotiator::Negotiator(USART::StandardUSART& uart) noexcept
+        : uart(uart), state(State::IDLE), previousRate(0), targetRate(0), deadline(0), fallbacks(0)
+    {
+    }
+
+    bool Negotiator::request(uint32_t baudRate) noexcept
+    {
+        if (state != State::IDLE || !uart.isBaudRateSupported(baudRate))
+        {
+            uart.sendFormatted("baud nak %lu\r\n", static_cast<unsigned long>(uart.getMaxBaudRate()));
+            return false;
+        }
+
+        previousRate = uart.getBaudRate();
+        targetRate = baudRate;
+        state = State::DRAINING;
+        uart.sendFormatted("baud ack %lu\r\n", static_cast<unsigned long>(baudRate));
+        return true;
+    }
+
+    bool Negotiator::confirm(uint32_t baudRate) noexcept
+    {
+        if (state != State::AWAIT_CONFIRM || baudRate != targetRate)
+        {
+            return false;
+        }
+        state = State::IDLE;
+        uart.sendFormatted("baud locked %lu\r\n", static_cast<unsigned long>(baudRate));
+        return true;
+    }
+
+    void Negotiator::poll(uint32_t nowMs) noexcept
+    {
+        switch (state)
+        {
+            case State::DRAINING:
+                // setBaudRate() is BUSY until the ack and the prompt are on the wire
+                if (uart.setBaudRate(targetRate).error == USART::UsartError::OK)
+                {
+                    deadline = nowMs + CONFIRM_TIMEOUT_MS;
+                    state = State::AWAIT_CONFIRM;
+                }
+                break;
+
+            case State::AWAIT_CONFIRM:
+                if (isExpired(nowMs, deadline) &&
+                    uart.setBaudRate(previousRate).error == USART::UsartError::OK)
+                {
+                    fallbacks++;
+                    state = State::IDLE;
+                }
+                break;
+
+            case State::IDLE:
+                break;
+        }
+    }
+
+    void Negotiator::shellCommand(Shell::Console& console, const Shell::Args& args, void* context)
+    {
+        Negotiator* self = static_cast<Negotiator*>(context);
+        uint32_t baudRate = 0;
+
+        if (args.size() == 1)
+        {
+            console.getUart().sendFormatted("baud %lu (max %lu)\r\n",
+                                            static_cast<unsigned long>(self->uart.getBaudRate()),
+                                            static_cast<unsigned long>(self->uart.getMaxBaudRate()));
+        }
+        else if (args.size() == 2 && args.toUnsigned(1, baudRate))
+        {
+            (void)self->request(baudRate);
+        }
+        else if (args.size() == 3 && std::strcmp(args[1], "confirm") == 0 && args.toUnsigned(2, baudRate))
+        {
+            (void)self->confirm(baudRate);
+        }
+        else
+        {
+            console.print("usage: baud [confirm] <rate>\r\n");
+        }
+    }
+
+    // ========================================================================
+    // Host
+    // ========================================================================
+
+    Host::Host(HostPort& port, uint32_t currentRate) noexcept
+        : port(port), state(State::IDLE), currentRate(currentRate), targetRate(0), deviceMaxRate(0), deadline(0)
+    {
+    }
+
+    void Host::send(const char* command, uint32_t baudRate) noexcept
+    {
+        char line[32];
+        std::snprintf(line, sizeof(line), "%s%lu\r", command, static_cast<unsigned long>(baudRate));
+        port.write(line);
+    }
+
+    bool Host::begin(uint32_t baudRate, uint32_t nowMs) noexcept
+    {
+        if (state == State::AWAIT_ACK || state == State::SETTLING || state == State::AWAIT_LOCK)
+        {
+            return false;
+        }
+        targetRate = baudRate;
+        deadline = nowMs + ACK_TIMEOUT_MS;
+        state = State::AWAIT_ACK;
+        send("baud ", baudRate);
+        return true;
+    }
+
+    void Host::receiveLine(const char* line, uint32_t nowMs) noexcept
+    {
+        uint32_t value = 0;
+
+        if (state == State::AWAIT_ACK)
+        {
+            if (parseReply(line, "baud ack ", value) && value == targetRate)
+            {
+                deadline = nowMs + SETTLE_MS;
+                state = State::SETTLING;
+            }
+            else if (parseReply(line, "baud nak ", value))
+            {
+                deviceMaxRate = value;
+                state = State::FAILED;
+            }
+        }
+        else if (state == State::AWAIT_LOCK)
+        {
+            if (parseReply(line, "baud locked ", value) && value == targetRate)
+            {
+                currentRate = targetRate;
+                state = State::LOCKED;
+            }
+        }
+    }
+
+    void Host::poll(uint32_t nowMs) noexcept
+    {
+        switch (state)
+        {
+            case State::AWAIT_ACK:
+                if (isExpired(nowMs, deadline))
+                {
+                    state = State::FAILED;
+                }
+                break;
+
+            case State::SETTLING:
+                if (isExpired(nowMs, deadline))
+                {
+                    port.setBaudRate(targetRate);
+                    send("baud confirm ", targetRate);
+                    deadline = nowMs + LOCK_TIMEOUT_MS;
+                    state = State::AWAIT_LOCK;
+                }
+                break;
+
+            case State::AWAIT_LOCK:
+                if (isExpired(nowMs, deadline))
+                {
+                    // The device has fallen back by now (CONFIRM_TIMEOUT_MS < LOCK_TIMEOUT_MS)
+                    port.setBaudRate(currentRate);
+                    state = State::FAILED;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+} // namespace BaudSwitch
@@ -0,0 +1,130 @@
+/**
+ * @file    Debounce.cpp
+ * @brief   Timer-sampled port scanner for the vertical-counter debouncer
+ * @author  MootSeeker
+ *
+ * @see Debounce.h for the counter logic and the bounce trace results
+ */
+
+#include "Debounce.h"
+
+namespace Debounce
+{
+    /**
+     * @brief Sample timer (TIM16; TIM2, TIM6 and TIM7 belong to SoftUart, LIN and the LPUART RX timeout)
+     */
+    static TIM_TypeDef* const SAMPLE_TIMER = TIM16;
+    static constexpr IRQn_Type SAMPLE_TIMER_IRQN = TIM1_UP_TIM16_IRQn;
+
+    static constexpr uint32_t MIN_INTERVAL_US = 100;
+    static constexpr uint32_t MAX_INTERVAL_US = 65535;
+
+    /// Scanner owning the sample timer (one per device)
+    static PortScanner* activeScanner = nullptr;
+
+    PortScanner::PortScanner(const PortInputs& low, const PortInputs& high) noexcept
+        : inputs{low, high}, counter(0), debounced(0), pressed(0), released(0), samples(0)
+    {
+    }
+
+    uint32_t PortScanner::read() const noexcept
+    {
+        uint32_t levels = 0;
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            const PortInputs& in = inputs[i];
+            if (in.port != nullptr)
+            {
+                // Active-low pins are inverted so that 1 always means active
+                const uint32_t bits = (in.port->IDR ^ in.activeLow) & in.mask;
+                levels |= bits << (16U * i);
+            }
+        }
+        return levels;
+    }
+
+    bool PortScanner::start(uint32_t sampleIntervalUs) noexcept
+    {
+        if (activeScanner != nullptr || sampleIntervalUs < MIN_INTERVAL_US || sampleIntervalUs > MAX_INTERVAL_US)
+        {
+            return false;
+        }
+
+        // Start from the current levels so that held buttons do not report a press
+        debounced = read();
+        counter.reset(debounced);
+        pressed = 0;
+        released = 0;
+        samples = 0;
+        activeScanner = this;
+
+        // 1 us ticks, update event every sampleIntervalUs
+        LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM16);
+        LL_TIM_DisableCounter(SAMPLE_TIMER);
+        LL_TIM_SetPrescaler(SAMPLE_TIMER, (SystemCoreClock / 1000000U) - 1U);
+        LL_TIM_SetAutoReload(SAMPLE_TIMER, sampleIntervalUs - 1U);
+        LL_TIM_SetCounter(SAMPLE_TIMER, 0);
+        LL_TIM_GenerateEvent_UPDATE(SAMPLE_TIMER);
+        LL_TIM_ClearFlag_UPDATE(SAMPLE_TIMER);
+        LL_TIM_EnableIT_UPDATE(SAMPLE_TIMER);
+
+        NVIC_SetPriority(SAMPLE_TIMER_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+        NVIC_EnableIRQ(SAMPLE_TIMER_IRQN);
+        LL_TIM_EnableCounter(SAMPLE_TIMER);
+        return true;
+    }
+
+    void PortScanner::stop() noexcept
+    {
+        if (activeScanner != this)
+        {
+            return;
+        }
+        LL_TIM_DisableIT_UPDATE(SAMPLE_TIMER);
+        LL_TIM_DisableCounter(SAMPLE_TIMER);
+        NVIC_DisableIRQ(SAMPLE_TIMER_IRQN);
+        activeScanner = nullptr;
+    }
+
+    Edges PortScanner::takeEdges() noexcept
+    {
+        uint32_t state;
+        return takeEdges(state);
+    }
+
+    Edges PortScanner::takeEdges(uint32_t& state) noexcept
+    {
+        // The timer interrupt ORs into both words, so take them with it masked;
+        // the vector is shared with TIM1 UP, so only restore what was there
+        const uint32_t enabled = NVIC_GetEnableIRQ(SAMPLE_TIMER_IRQN);
+        NVIC_DisableIRQ(SAMPLE_TIMER_IRQN);
+        const Edges edges{pressed, released};
+        state = debounced;
+        pressed = 0;
+        released = 0;
+        if (enabled != 0U)
+        {
+            NVIC_EnableIRQ(SAMPLE_TIMER_IRQN);
+        }
+        return edges;
+    }
+
+    void PortScanner::sample() noexcept
+    {
+        const Edges edges = counter.update(read());
+        debounced = counter.getState();
+        pressed = pressed | edges.pressed;
+        released = released | edges.released;
+        samples = samples + 1;
+    }
+
+} // namespace Debounce
+
+extern "C" {
+    void DEBOUNCE_HandleSampleTimerInterrupt(void) {
+        LL_TIM_ClearFlag_UPDATE(Debounce::SAMPLE_TIMER);
+        if (Debounce::activeScanner != nullptr) {
+            Debounce::activeScanner->sample();
+        }
+    }
+}
@@ -0,0 +1,235 @@
+/**
+ * @file    Gesture.cpp
+ * @brief   Button gesture state machines
+ * @author  MootSeeker
+ *
+ * @see Gesture.h for the gesture timing
+ */
+
+#include "Gesture.h"
+
+#include <bit>
+
+namespace Gesture
+{
+    /**
+     * @brief Wrap-safe "a is at or before b"
+     */
+    static bool notAfter(uint32_t a, uint32_t b)
+    {
+        return static_cast<int32_t>(b - a) >= 0;
+    }
+
+    ButtonSet::ButtonSet(const Timing& timing, Handler handler, void* context) noexcept
+        : timing(timing), handler(handler), context(context), states(), deadlines(), timedMask(0)
+    {
+    }
+
+    void ButtonSet::emit(uint8_t button, Type gesture, uint32_t timeMs) noexcept
+    {
+        if (handler != nullptr)
+        {
+            handler(context, button, gesture, timeMs);
+        }
+    }
+
+    void ButtonSet::setDeadline(uint8_t button, uint32_t deadlineMs) noexcept
+    {
+        deadlines[button] = deadlineMs;
+        timedMask |= 1U << button;
+    }
+
+    void ButtonSet::clearDeadline(uint8_t button) noexcept
+    {
+        timedMask &= ~(1U << button);
+    }
+
+    void ButtonSet::update(const Debounce::Edges& edges, uint32_t levels, uint32_t nowMs) noexcept
+    {
+        advance(nowMs);
+
+        // Edges taken less often than the debounce time can hold both edges of a
+        // button; the debounced level says which came last (up = press, then release)
+        uint32_t changed = edges.pressed | edges.released;
+        while (changed != 0U)
+        {
+            const uint8_t button = static_cast<uint8_t>(std::countr_zero(changed));
+            const uint32_t bit = changed & (0U - changed);
+            changed &= changed - 1U;
+
+            if ((edges.pressed & bit) != 0U && (edges.released & bit) != 0U)
+            {
+                if ((levels & bit) != 0U)
+                {
+                    release(button, nowMs);
+                    press(button, nowMs);
+                }
+                else
+                {
+                    press(button, nowMs);
+                    release(button, nowMs);
+                }
+            }
+            else if ((edges.pressed & bit) != 0U)
+            {
+                press(button, nowMs);
+            }
+            else
+            {
+                release(button, nowMs);
+            }
+        }
+    }
+
+    void ButtonSet::press(uint8_t button, uint32_t timeMs) noexcept
+    {
+        if (button >= MAX_BUTTONS)
+        {
+            return;
+        }
+        advance(timeMs);      // Gestures due before this edge go first (a click window, a long press)
+        switch (states[button])
+        {
+            case State::IDLE:
+                states[button] = State::PRESSED;
+                setDeadline(button, timeMs + timing.longPressMs);
+                break;
+
+            case State::WAIT_SECOND:
+                states[button] = State::SECOND_PRESSED;
+                setDeadline(button, timeMs + timing.longPressMs);
+                break;
+
+            case State::PRESSED:
+            case State::SECOND_PRESSED:
+            case State::HELD:
+                break;      // Already down
+        }
+    }
+
+    void ButtonSet::release(uint8_t button, uint32_t timeMs) noexcept
+    {
+        if (button >= MAX_BUTTONS)
+        {
+            return;
+        }
+        advance(timeMs);
+        switch (states[button])
+        {
+            case State::PRESSED:
+                if (timing.doubleClickMs == 0U)
+                {
+                    emit(button, Type::CLICK, timeMs);
+                    states[button] = State::IDLE;
+                    clearDeadline(button);
+                }
+                else
+                {
+                    states[button] = State::WAIT_SECOND;
+                    setDeadline(button, timeMs + timing.doubleClickMs);
+                }
+                break;
+
+            case State::SECOND_PRESSED:
+                emit(button, Type::DOUBLE_CLICK, timeMs);
+                states[button] = State::IDLE;
+                clearDeadline(button);
+                break;
+
+            case State::HELD:
+                states[button] = State::IDLE;
+                clearDeadline(button);
+                break;
+
+            case State::IDLE:
+            case State::WAIT_SECOND:
+                break;      // Already up
+        }
+    }
+
+    /**
+     * @brief The deadline of a button has passed; report at the deadline time
+     */
+    void ButtonSet::expire(uint8_t button) noexcept
+    {
+        const uint32_t due = deadlines[button];
+        switch (states[button])
+        {
+            case State::WAIT_SECOND:
+                emit(button, Type::CLICK, due);
+                states[button] = State::IDLE;
+                clearDeadline(button);
+                break;
+
+            case State::SECOND_PRESSED:
+                // The first click stands on its own, the second press became a long one
+                emit(button, Type::CLICK, due);
+                [[fallthrough]];
+
+            case State::PRESSED:
+                emit(button, Type::LONG_PRESS, due);
+                states[button] = State::HELD;
+                if (timing.repeatMs != 0U)
+                {
+                    setDeadline(button, due + timing.repeatMs);
+                }
+                else
+                {
+                    clearDeadline(button);
+                }
+                break;
+
+            case State::HELD:
+                emit(button, Type::REPEAT, due);
+                setDeadline(button, due + timing.repeatMs);
+                break;
+
+            case State::IDLE:
+                clearDeadline(button);
+                break;
+        }
+    }
+
+    void ButtonSet::advance(uint32_t nowMs) noexcept
+    {
+        // Each button may owe several gestures (REPEAT); report them in time order
+        uint32_t deadlineMs;
+        while (nextDeadline(deadlineMs) && notAfter(deadlineMs, nowMs))
+        {
+            uint32_t timed = timedMask;
+            while (timed != 0U)
+            {
+                const uint8_t button = static_cast<uint8_t>(std::countr_zero(timed));
+                timed &= timed - 1U;
+                if (deadlines[button] == deadlineMs)
+                {
+                    expire(button);
+                }
+            }
+        }
+    }
+
+    bool ButtonSet::nextDeadline(uint32_t& deadlineMs) const noexcept
+    {
+        uint32_t timed = timedMask;
+        if (timed == 0U)
+        {
+            return false;
+        }
+
+        uint8_t button = static_cast<uint8_t>(std::countr_zero(timed));
+        deadlineMs = deadlines[button];
+        timed &= timed - 1U;
+        while (timed != 0U)
+        {
+            button = static_cast<uint8_t>(std::countr_zero(timed));
+            timed &= timed - 1U;
+            if (notAfter(deadlines[button], deadlineMs))
+            {
+                deadlineMs = deadlines[button];
+            }
+        }
+        return true;
+    }
+
+} // namespace Gesture
@@ -0,0 +1,288 @@
+/**
+ * @file    Keypad.cpp
+ * @brief   DMA-driven key matrix scanner with ghosting detection and debouncing
+ * @author  MootSeeker
+ *
+ * @see Keypad.h for the scan sequence and the interrupt load
+ */
+
+#include "Keypad.h"
+#include "gpio_wave.h"
+#include "dma_address.h"
+
+namespace Keypad
+{
+    /**
+     * @brief Step timer and DMA (TIM1_CH1 = DMA1 Channel 2, TIM1_CH2 = DMA1 Channel 3, request 7)
+     *
+     * TIM15 belongs to the GPIO pattern player and TIM16 to the debouncer;
+     * TIM1 is shared with the logic analyzer capture, whichever starts first.
+     */
+    static TIM_TypeDef* const SCAN_TIMER = TIM1;
+    static DMA_TypeDef* const SCAN_DMA = DMA1;
+    static constexpr uint32_t ROW_CHANNEL = LL_DMA_CHANNEL_2;
+    static constexpr uint32_t COLUMN_CHANNEL = LL_DMA_CHANNEL_3;
+    static constexpr uint32_t SCAN_REQUEST = LL_DMA_REQUEST_7;
+    static constexpr IRQn_Type SCAN_DMA_IRQN = DMA1_Channel3_IRQn;
+
+    /// Scanner owning TIM1 and the DMA channels, if any
+    static MatrixScanner* volatile activeScanner = nullptr;
+
+    MatrixScanner::MatrixScanner(const Matrix& matrix) noexcept
+        : matrix(matrix), rowWords(), samples(), counter(0), raw(0), running(false), debounced(0),
+          pressed(0), released(0), scans(0), ghostScans(0), missedScans(0)
+    {
+    }
+
+    MatrixScanner::~MatrixScanner()
+    {
+        stop();
+    }
+
+    bool MatrixScanner::isValid() const noexcept
+    {
+        if (matrix.rowPort == nullptr || matrix.columnPort == nullptr ||
+            matrix.rows == 0 || matrix.rows > MAX_ROWS || matrix.columns == 0 ||
+            matrix.firstRow + matrix.rows > 16U || matrix.firstColumn + matrix.columns > 16U ||
+            matrix.rows * matrix.columns > MAX_KEYS)
+        {
+            return false;
+        }
+        const uint32_t rowMask = ((1U << matrix.rows) - 1U) << matrix.firstRow;
+        const uint32_t columnMask = ((1U << matrix.columns) - 1U) << matrix.firstColumn;
+        return matrix.rowPort != matrix.columnPort || (rowMask & columnMask) == 0U;
+    }
+
+    bool MatrixScanner::start(uint32_t scanIntervalUs) noexcept
+    {
+        if (activeScanner != nullptr || !isValid() || scanIntervalUs > MAX_SCAN_INTERVAL_US ||
+            scanIntervalUs < matrix.rows * MIN_STEP_US)
+        {
+            return false;
+        }
+        // A running capture owns TIM1 (reads as stopped while its clock is off)
+        if (LL_TIM_IsEnabledCounter(SCAN_TIMER))
+        {
+            return false;
+        }
+        // Channels 2 and 3 are also the USART_3 channels of the DMA bridge; enabled ones are
+        // in use, and so is an idle bridge TX channel, which keeps its TC interrupt armed
+        if (LL_DMA_IsEnabledChannel(SCAN_DMA, ROW_CHANNEL) || LL_DMA_IsEnabledIT_TC(SCAN_DMA, ROW_CHANNEL) ||
+            LL_DMA_IsEnabledChannel(SCAN_DMA, COLUMN_CHANNEL))
+        {
+            return false;
+        }
+
+        // Row r low, all other rows released
+        const uint32_t rowMask = ((1U << matrix.rows) - 1U) << matrix.firstRow;
+        for (uint8_t r = 0; r < matrix.rows; r++)
+        {
+            rowWords[r] = GPIO::bsrrWord(rowMask, rowMask & ~(1U << (matrix.firstRow + r)));
+        }
+
+        // No key pressed to start with; a key held at start is reported after 4 scans
+        counter.reset(0);
+        raw = 0;
+        debounced = 0;
+        pressed = 0;
+        released = 0;
+        scans = 0;
+        ghostScans = 0;
+        missedScans = 0;
+        activeScanner = this;
+        running = true;
+
+        LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM1);
+        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+
+        // Row words -> BSRR, one per compare 1 event, no interrupts
+        LL_DMA_DisableChannel(SCAN_DMA, ROW_CHANNEL);
+        LL_DMA_ConfigTransfer(SCAN_DMA, ROW_CHANNEL,
+                              LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_MODE_CIRCULAR |
+                              LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                              LL_DMA_PDATAALIGN_WORD | LL_DMA_MDATAALIGN_WORD | LL_DMA_PRIORITY_HIGH);
+        LL_DMA_SetPeriphRequest(SCAN_DMA, ROW_CHANNEL, SCAN_REQUEST);
+        LL_DMA_SetPeriphAddress(SCAN_DMA, ROW_CHANNEL, dmaAddress(&matrix.rowPort->BSRR));
+        LL_DMA_SetMemoryAddress(SCAN_DMA, ROW_CHANNEL, dmaAddress(rowWords));
+        LL_DMA_SetDataLength(SCAN_DMA, ROW_CHANNEL, matrix.rows);
+        WRITE_REG(SCAN_DMA->IFCR, DMA_IFCR_CGIF2);
+
+        // Column IDR -> samples, one per compare 2 event; each half is one full scan
+        LL_DMA_DisableChannel(SCAN_DMA, COLUMN_CHANNEL);
+        LL_DMA_ConfigTransfer(SCAN_DMA, COLUMN_CHANNEL,
+                              LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_MODE_CIRCULAR |
+                              LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                              LL_DMA_PDATAALIGN_HALFWORD | LL_DMA_MDATAALIGN_HALFWORD | LL_DMA_PRIORITY_HIGH);
+        LL_DMA_SetPeriphRequest(SCAN_DMA, COLUMN_CHANNEL, SCAN_REQUEST);
+        LL_DMA_SetPeriphAddress(SCAN_DMA, COLUMN_CHANNEL, dmaAddress(&matrix.columnPort->IDR));
+        LL_DMA_SetMemoryAddress(SCAN_DMA, COLUMN_CHANNEL, dmaAddress(samples));
+        LL_DMA_SetDataLength(SCAN_DMA, COLUMN_CHANNEL, matrix.rows * 2U);
+        WRITE_REG(SCAN_DMA->IFCR, DMA_IFCR_CGIF3);
+        LL_DMA_EnableIT_HT(SCAN_DMA, COLUMN_CHANNEL);
+        LL_DMA_EnableIT_TC(SCAN_DMA, COLUMN_CHANNEL);
+        LL_DMA_EnableIT_TE(SCAN_DMA, COLUMN_CHANNEL);
+        if (NVIC_GetEnableIRQ(SCAN_DMA_IRQN) == 0U)
+        {
+            // The vector is shared with the bridge: keep the priority it was given
+            NVIC_SetPriority(SCAN_DMA_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+            NVIC_ClearPendingIRQ(SCAN_DMA_IRQN);
+            NVIC_EnableIRQ(SCAN_DMA_IRQN);
+        }
+        LL_DMA_EnableChannel(SCAN_DMA, ROW_CHANNEL);
+        LL_DMA_EnableChannel(SCAN_DMA, COLUMN_CHANNEL);
+
+        // 1 us ticks; each row step writes the row at tick 1 and reads the columns at its last tick
+        const uint32_t stepUs = scanIntervalUs / matrix.rows;
+        LL_TIM_DisableCounter(SCAN_TIMER);
+        LL_TIM_SetPrescaler(SCAN_TIMER, (SystemCoreClock / 1000000U) - 1U);
+        LL_TIM_SetAutoReload(SCAN_TIMER, stepUs - 1U);
+        LL_TIM_SetRepetitionCounter(SCAN_TIMER, 0);
+        LL_TIM_OC_SetCompareCH1(SCAN_TIMER, 1U);
+        LL_TIM_OC_SetCompareCH2(SCAN_TIMER, stepUs - 1U);
+        LL_TIM_CC_SetDMAReqTrigger(SCAN_TIMER, LL_TIM_CCDMAREQUEST_CC);
+        LL_TIM_SetCounter(SCAN_TIMER, 0);
+        LL_TIM_GenerateEvent_UPDATE(SCAN_TIMER);    // Load the prescaler
+        LL_TIM_ClearFlag_UPDATE(SCAN_TIMER);
+        LL_TIM_EnableDMAReq_CC1(SCAN_TIMER);
+        LL_TIM_EnableDMAReq_CC2(SCAN_TIMER);
+        LL_TIM_EnableCounter(SCAN_TIMER);
+        return true;
+    }
+
+    void MatrixScanner::stop() noexcept
+    {
+        if (activeScanner != this)
+        {
+            return;
+        }
+        LL_TIM_DisableCounter(SCAN_TIMER);
+        LL_TIM_DisableDMAReq_CC1(SCAN_TIMER);
+        LL_TIM_DisableDMAReq_CC2(SCAN_TIMER);
+
+        // Only channels that still move this scanner's words are ours to stop
+        if (LL_DMA_GetPeriphAddress(SCAN_DMA, ROW_CHANNEL) == dmaAddress(&matrix.rowPort->BSRR))
+        {
+            LL_DMA_DisableChannel(SCAN_DMA, ROW_CHANNEL);
+            WRITE_REG(SCAN_DMA->IFCR, DMA_IFCR_CGIF2);
+        }
+        if (LL_DMA_GetPeriphAddress(SCAN_DMA, COLUMN_CHANNEL) == dmaAddress(&matrix.columnPort->IDR))
+        {
+            LL_DMA_DisableChannel(SCAN_DMA, COLUMN_CHANNEL);
+            LL_DMA_DisableIT_HT(SCAN_DMA, COLUMN_CHANNEL);
+            LL_DMA_DisableIT_TC(SCAN_DMA, COLUMN_CHANNEL);
+            LL_DMA_DisableIT_TE(SCAN_DMA, COLUMN_CHANNEL);
+            WRITE_REG(SCAN_DMA->IFCR, DMA_IFCR_CGIF3);
+        }
+
+        // Release all rows
+        WRITE_REG(matrix.rowPort->BSRR, ((1U << matrix.rows) - 1U) << matrix.firstRow);
+        running = false;
+        activeScanner = nullptr;
+    }
+
+    Debounce::Edges MatrixScanner::takeEdges() noexcept
+    {
+        // The DMA interrupt ORs into both words, so take them with it masked;
+        // the vector is shared with the bridge, so only restore what was there
+        const uint32_t enabled = NVIC_GetEnableIRQ(SCAN_DMA_IRQN);
+        NVIC_DisableIRQ(SCAN_DMA_IRQN);
+        const Debounce::Edges edges{pressed, released};
+        pressed = 0;
+        released = 0;
+        if (enabled != 0U)
+        {
+            NVIC_EnableIRQ(SCAN_DMA_IRQN);
+        }
+        return edges;
+    }
+
+    void MatrixScanner::decode(const uint16_t* scan) noexcept
+    {
+        const uint8_t rows = matrix.rows;
+        const uint8_t columns = matrix.columns;
+        const uint32_t columnMask = (1U << columns) - 1U;
+
+        // Columns read low where a key connects them to the selected row
+        uint32_t rowKeys[MAX_ROWS];
+        uint32_t keys = 0;
+        for (uint8_t r = 0; r < rows; r++)
+        {
+            rowKeys[r] = (~static_cast<uint32_t>(scan[r]) >> matrix.firstColumn) & columnMask;
+            keys |= rowKeys[r] << (r * columns);
+        }
+
+        // Two rows sharing two or more columns: all keys of the rectangle are ambiguous
+        uint32_t ghost = 0;
+        for (uint8_t a = 0; a + 1U < rows; a++)
+        {
+            if ((rowKeys[a] & (rowKeys[a] - 1U)) == 0U)
+            {
+                continue;   // Fewer than two keys in this row
+            }
+            for (uint8_t b = a + 1U; b < rows; b++)
+            {
+                const uint32_t common = rowKeys[a] & rowKeys[b];
+                if ((common & (common - 1U)) != 0U)
+                {
+                    ghost |= (common << (a * columns)) | (common << (b * columns));
+                }
+            }
+        }
+        if (ghost != 0U)
+        {
+            keys = (keys & ~ghost) | (raw & ghost);
+            ghostScans = ghostScans + 1;
+        }
+        raw = keys;
+
+        const Debounce::Edges edges = counter.update(keys);
+        debounced = counter.getState();
+        pressed = pressed | edges.pressed;
+        released = released | edges.released;
+        scans = scans + 1;
+    }
+
+    void MatrixScanner::handleDmaInterrupt(uint32_t flags) noexcept
+    {
+        if ((flags & DMA_ISR_TEIF3) != 0U)
+        {
+            stop();
+            return;
+        }
+
+        // Both halves at once: the first one is already being overwritten
+        if ((flags & (DMA_ISR_HTIF3 | DMA_ISR_TCIF3)) == (DMA_ISR_HTIF3 | DMA_ISR_TCIF3))
+        {
+            missedScans = missedScans + 1;
+        }
+        else if ((flags & DMA_ISR_HTIF3) != 0U)
+        {
+            decode(samples);
+        }
+        if ((flags & DMA_ISR_TCIF3) != 0U)
+        {
+            decode(samples + matrix.rows);
+        }
+    }
+
+} // namespace Keypad
+
+extern "C" {
+    /**
+     * @brief DMA1 Channel 3 interrupt: only the scanner's flags, and only while it runs
+     *
+     * The channel is shared with the USART bridge, whose handler runs after
+     * this one and sees no flags of a running scan.
+     */
+    void KEYPAD_HandleDmaInterrupt(void)
+    {
+        Keypad::MatrixScanner* scanner = Keypad::activeScanner;
+        if (scanner == nullptr)
+        {
+            return;
+        }
+        const uint32_t flags = READ_REG(DMA1->ISR) & (DMA_ISR_GIF3 | DMA_ISR_TCIF3 | DMA_ISR_HTIF3 | DMA_ISR_TEIF3);
+        WRITE_REG(DMA1->IFCR, flags);   // IFCR bits share the ISR positions
+        scanner->handleDmaInterrupt(flags);
+    }
+}
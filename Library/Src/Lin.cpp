@@ -0,0 +1,366 @@
+/**
+ * @file    Lin.cpp
+ * @brief   LIN master/slave implementation
+ * @author  MootSeeker
+ *
+ * @see Lin.h for the frame format and the schedule timing
+ */
+
+#include "Lin.h"
+
+#include <cstring>
+
+namespace Lin
+{
+    /**
+     * @brief Schedule timer (TIM6 is otherwise unused; TIM7 belongs to the LPUART RX timeout)
+     */
+    static TIM_TypeDef* const SCHEDULE_TIMER = TIM6;
+    static constexpr IRQn_Type SCHEDULE_TIMER_IRQN = TIM6_DAC_IRQn;
+
+    /// Master owning the schedule timer (one per device)
+    static Master* activeMaster = nullptr;
+
+    // ========================================================================
+    // Node
+    // ========================================================================
+
+    Node::Node(USART::StandardUSART& uart, const FrameTable& frames) noexcept
+        : uart(uart), frames(frames), statistics(), frameIndex(),
+          rxState(RxState::IDLE), rxFrame(NO_FRAME), rxCount(0), rxSum(0), rxData(),
+          frameCallback(nullptr), frameContext(nullptr)
+    {
+        std::memset(frameIndex, NO_FRAME, sizeof(frameIndex));
+        for (uint8_t i = 0; i < frames.size(); i++)
+        {
+            frameIndex[frames[i].id & MAX_ID] = i;
+        }
+    }
+
+    void Node::setFrameCallback(FrameCallback callback, void* context) noexcept
+    {
+        // Never let the RX interrupt see a new callback with the old context
+        frameCallback = nullptr;
+        frameContext = context;
+        frameCallback = callback;
+    }
+
+    USART::UsartStatus Node::attach() noexcept
+    {
+        rxState = RxState::IDLE;
+        const USART::UsartStatus status = uart.enableLin(&Node::onBreak, this);
+        if (status.error == USART::UsartError::OK)
+        {
+            uart.setRxCallback(&Node::onRxByte, this);
+        }
+        return status;
+    }
+
+    void Node::detach() noexcept
+    {
+        uart.setRxCallback(nullptr, nullptr);
+        uart.disableLin();
+        rxState = RxState::IDLE;
+    }
+
+    void Node::abortFrame() noexcept
+    {
+        switch (rxState)
+        {
+            case RxState::SYNC:
+            case RxState::PID:
+                statistics.headerErrors++;
+                break;
+
+            case RxState::DATA:
+                if (rxCount == 0)
+                {
+                    statistics.noResponse++;
+                }
+                else
+                {
+                    statistics.responseErrors++;
+                }
+                break;
+
+            case RxState::IDLE:
+                break;
+        }
+        rxState = RxState::IDLE;
+    }
+
+    /**
+     * @brief Break detected: a new frame starts
+     *
+     * The master already expects the sync byte after sending its own break,
+     * so only an unexpected break ends a frame early.
+     */
+    void Node::onBreak(void* context)
+    {
+        Node* self = static_cast<Node*>(context);
+        if (self->rxState != RxState::SYNC)
+        {
+            self->abortFrame();
+        }
+        self->rxState = RxState::SYNC;
+    }
+
+    void Node::onRxByte(void* context, uint8_t data)
+    {
+        static_cast<Node*>(context)->receiveByte(data);
+    }
+
+    /**
+     * @brief Frame state machine, runs in the RX interrupt
+     *
+     * The checksum is accumulated per byte, so the check at the last byte is
+     * one addition: data sum plus checksum byte is 0xFF for a valid response.
+     */
+    void Node::receiveByte(uint8_t data) noexcept
+    {
+        switch (rxState)
+        {
+            case RxState::IDLE:
+                break;
+
+            case RxState::SYNC:
+                // 0x00 is the break itself, received as a character with framing error
+                if (data == SYNC_BYTE)
+                {
+                    rxState = RxState::PID;
+                }
+                else if (data != 0x00U)
+                {
+                    statistics.headerErrors++;
+                    rxState = RxState::IDLE;
+                }
+                break;
+
+            case RxState::PID:
+            {
+                const uint8_t id = data & MAX_ID;
+                if (protectedId(id) != data)
+                {
+                    statistics.headerErrors++;
+                    rxState = RxState::IDLE;
+                    break;
+                }
+                rxFrame = frameIndex[id];
+                if (rxFrame == NO_FRAME)
+                {
+                    rxState = RxState::IDLE;   // Not our frame
+                    break;
+                }
+
+                const Frame& frame = frames[rxFrame];
+                rxCount = 0;
+                rxSum = (frame.checksum == ChecksumModel::ENHANCED) ? data : 0U;
+                rxState = RxState::DATA;
+                if (frame.direction == Direction::PUBLISH)
+                {
+                    sendResponse(frame, data);
+                }
+                break;
+            }
+
+            case RxState::DATA:
+            {
+                const Frame& frame = frames[rxFrame];
+                if (rxCount < frame.length)
+                {
+                    rxData[rxCount++] = data;
+                    rxSum = addToSum(rxSum, data);
+                    break;
+                }
+
+                rxState = RxState::IDLE;
+                if (addToSum(rxSum, data) != 0xFFU)
+                {
+                    statistics.responseErrors++;
+                    break;
+                }
+                if (frame.direction == Direction::SUBSCRIBE)
+                {
+                    std::memcpy(frame.data, rxData, frame.length);
+                }
+                statistics.frames++;
+
+                FrameCallback callback = frameCallback;
+                if (callback != nullptr)
+                {
+                    callback(frameContext, frame);
+                }
+                break;
+            }
+        }
+    }
+
+    void Node::sendResponse(const Frame& frame, uint8_t pid) noexcept
+    {
+        uint8_t response[MAX_DATA_LENGTH + 1];
+        std::memcpy(response, frame.data, frame.length);
+        response[frame.length] = checksum(frame.checksum, pid, response, frame.length);
+        (void)uart.sendData(response, static_cast<uint16_t>(frame.length + 1U));
+    }
+
+    // ========================================================================
+    // Master
+    // ========================================================================
+
+    Master::Master(USART::StandardUSART& uart, const FrameTable& frames, const ScheduleTable& schedule) noexcept
+        : Node(uart, frames), schedule(schedule), pendingSchedule(schedule), switchPending(false),
+          running(false), currentSlot(0), nextSlot(0), cycles(0)
+    {
+    }
+
+    USART::UsartStatus Master::start() noexcept
+    {
+        if (activeMaster != nullptr)
+        {
+            return USART::UsartStatus{USART::UsartError::BUSY, 0};
+        }
+        const USART::UsartStatus status = attach();
+        if (status.error != USART::UsartError::OK)
+        {
+            return status;
+        }
+        activeMaster = this;
+        currentSlot = 0;
+        cycles = 0;
+        if (switchPending)
+        {
+            schedule = pendingSchedule;
+            switchPending = false;
+        }
+
+        // 1 us ticks; the first slot length is loaded directly, later ones via the preload
+        LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM6);
+        LL_TIM_DisableCounter(SCHEDULE_TIMER);
+        LL_TIM_DisableARRPreload(SCHEDULE_TIMER);
+        LL_TIM_SetPrescaler(SCHEDULE_TIMER, (SystemCoreClock / 1000000U) - 1U);
+        LL_TIM_SetAutoReload(SCHEDULE_TIMER, schedule[0].durationUs - 1U);
+        LL_TIM_SetUpdateSource(SCHEDULE_TIMER, LL_TIM_UPDATESOURCE_COUNTER);
+        LL_TIM_SetCounter(SCHEDULE_TIMER, 0);
+        LL_TIM_GenerateEvent_UPDATE(SCHEDULE_TIMER);
+        LL_TIM_ClearFlag_UPDATE(SCHEDULE_TIMER);
+        LL_TIM_EnableARRPreload(SCHEDULE_TIMER);
+        preloadNextSlot();
+        LL_TIM_EnableIT_UPDATE(SCHEDULE_TIMER);
+
+        NVIC_SetPriority(SCHEDULE_TIMER_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+        NVIC_EnableIRQ(SCHEDULE_TIMER_IRQN);
+
+        running = true;
+        sendHeader(frames[schedule[0].frame]);
+        LL_TIM_EnableCounter(SCHEDULE_TIMER);
+        return USART::UsartStatus{USART::UsartError::OK, 0};
+    }
+
+    void Master::stop() noexcept
+    {
+        if (activeMaster != this)
+        {
+            return;
+        }
+        running = false;
+        LL_TIM_DisableIT_UPDATE(SCHEDULE_TIMER);
+        LL_TIM_DisableCounter(SCHEDULE_TIMER);
+        NVIC_DisableIRQ(SCHEDULE_TIMER_IRQN);
+        detach();
+        activeMaster = nullptr;
+    }
+
+    void Master::setSchedule(const ScheduleTable& table) noexcept
+    {
+        // The timer interrupt reads both fields, so hand over with it masked
+        NVIC_DisableIRQ(SCHEDULE_TIMER_IRQN);
+        pendingSchedule = table;
+        switchPending = true;
+        if (running)
+        {
+            NVIC_EnableIRQ(SCHEDULE_TIMER_IRQN);
+        }
+    }
+
+    /**
+     * @brief Write the length of the slot after the current one to the ARR preload
+     *
+     * It is transferred to the counter at the next update event, so the
+     * interrupt has a whole slot to get here and its latency never adds up.
+     * A pending table takes over where the current cycle wraps.
+     */
+    void Master::preloadNextSlot() noexcept
+    {
+        nextSlot = static_cast<uint8_t>(currentSlot + 1U);
+        if (nextSlot >= schedule.size())
+        {
+            nextSlot = 0;
+            if (switchPending)
+            {
+                schedule = pendingSchedule;
+                switchPending = false;
+            }
+        }
+        LL_TIM_SetAutoReload(SCHEDULE_TIMER, schedule[nextSlot].durationUs - 1U);
+    }
+
+    void Master::sendHeader(const Frame& frame) noexcept
+    {
+        // A response running over its slot would put the break inside it
+        if (!uart.sendBreak())
+        {
+            statistics.overruns++;
+            return;
+        }
+        rxState = RxState::SYNC;
+        const uint8_t header[2] = {SYNC_BYTE, protectedId(frame.id)};
+        (void)uart.sendData(header, sizeof(header));
+    }
+
+    void Master::handleTimerInterrupt() noexcept
+    {
+        LL_TIM_ClearFlag_UPDATE(SCHEDULE_TIMER);
+        if (!running)
+        {
+            return;
+        }
+
+        abortFrame();   // Whatever the previous slot left unfinished
+        currentSlot = nextSlot;
+        if (currentSlot == 0)
+        {
+            cycles = cycles + 1;
+        }
+        sendHeader(frames[schedule[currentSlot].frame]);
+        preloadNextSlot();
+    }
+
+    // ========================================================================
+    // Slave
+    // ========================================================================
+
+    Slave::Slave(USART::StandardUSART& uart, const FrameTable& frames) noexcept : Node(uart, frames)
+    {
+    }
+
+    USART::UsartStatus Slave::start() noexcept
+    {
+        return attach();
+    }
+
+    void Slave::stop() noexcept
+    {
+        detach();
+    }
+
+} // namespace Lin
+
+extern "C" {
+    void LIN_HandleScheduleTimerInterrupt(void) {
+        if (Lin::activeMaster != nullptr) {
+            Lin::activeMaster->handleTimerInterrupt();
+        } else {
+            LL_TIM_ClearFlag_UPDATE(Lin::SCHEDULE_TIMER);
+        }
+    }
+}
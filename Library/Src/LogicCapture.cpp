@@ -0,0 +1,660 @@
+/**
+ * @file    LogicCapture.cpp
+ * @brief   Logic-analyzer capture engine and host-side VCD converter
+ * @author  MootSeeker
+ *
+ * @see LogicCapture.h for the stream format and the sustainable rates
+ */
+
+#include "LogicCapture.h"
+#include "dma_address.h"
+
+#include <cstdio>
+
+namespace LogicCapture
+{
+    /**
+     * @brief Sample timer and DMA (TIM1_UP = DMA1 Channel 6 request 7; TIM15 belongs to the GPIO pattern player)
+     */
+    static TIM_TypeDef* const SAMPLE_TIMER = TIM1;
+    static DMA_TypeDef* const SAMPLE_DMA = DMA1;
+    static constexpr uint32_t SAMPLE_CHANNEL = LL_DMA_CHANNEL_6;
+    static constexpr uint32_t SAMPLE_REQUEST = LL_DMA_REQUEST_7;
+    static constexpr IRQn_Type SAMPLE_DMA_IRQN = DMA1_Channel6_IRQn;
+
+    static constexpr uint8_t END_RECORD_SIZE = 3;
+    static constexpr uint8_t MAGIC[4] = {'L', 'A', 'C', '1'};
+
+    /// Capture owning TIM1 and the DMA channel, if any
+    static Capture* volatile activeCapture = nullptr;
+
+    /**
+     * @brief Split the sample period into TIM1 prescaler and reload, exactly
+     * @return false if rateHz does not divide SystemCoreClock into a 16 x 16 bit period
+     */
+    static bool findTimerPeriod(uint32_t rateHz, uint32_t& prescaler, uint32_t& reload) noexcept
+    {
+        if (SystemCoreClock % rateHz != 0U)
+        {
+            return false;
+        }
+        const uint32_t ticks = SystemCoreClock / rateHz;    // TIM1 clock = HCLK (APB2 divider 1)
+        for (uint32_t divider = (ticks + 65535U) / 65536U; divider <= 65536U; divider++)
+        {
+            if (ticks % divider == 0U)
+            {
+                prescaler = divider - 1U;
+                reload = ticks / divider - 1U;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Capture::Capture(USART::StandardUSART& uart, uint16_t* sampleRing, uint16_t ringCount,
+                     uint8_t* output, uint16_t outputSize) noexcept
+        : uart(uart), ring(sampleRing), halfCount(ringCount / 2U), output(output), outputSize(outputSize),
+          outputHead(0), outputTail(0), config(), state(State::IDLE), halvesFilled(0), dmaError(false),
+          halvesDone(0), primed(false), previous(0), current(0), runLength(0), postRemaining(0),
+          history(), historyHead(0), historyCount(0), sampleCount(0), encodedBytes(0), preCount(0)
+    {
+    }
+
+    Capture::~Capture()
+    {
+        stop();
+    }
+
+    bool Capture::start(const Config& newConfig) noexcept
+    {
+        if (state == State::ARMED || state == State::TRIGGERED || getPendingBytes() != 0)
+        {
+            return false;
+        }
+        if (activeCapture != nullptr || ring == nullptr || halfCount == 0 || output == nullptr ||
+            outputSize < MIN_OUTPUT_SIZE)
+        {
+            return false;
+        }
+        // TIM1 is shared with the keypad scanner (reads as stopped while its clock is off)
+        if (LL_TIM_IsEnabledCounter(SAMPLE_TIMER))
+        {
+            return false;
+        }
+        // Channel 6 is also the USART_2 RX channel of the DMA bridge; an enabled one is in use
+        if (LL_DMA_IsEnabledChannel(SAMPLE_DMA, SAMPLE_CHANNEL))
+        {
+            return false;
+        }
+        if (newConfig.port == nullptr || newConfig.pinMask == 0 || newConfig.postTrigger == 0 ||
+            newConfig.sampleRateHz == 0 || newConfig.sampleRateHz > MAX_SAMPLE_RATE_HZ)
+        {
+            return false;
+        }
+        // The header carries the rate: it must be the one the timer runs at
+        uint32_t prescaler = 0;
+        uint32_t reload = 0;
+        if (!findTimerPeriod(newConfig.sampleRateHz, prescaler, reload))
+        {
+            return false;
+        }
+
+        config = newConfig;
+        outputHead = 0;
+        outputTail = 0;
+        halvesFilled = 0;
+        halvesDone = 0;
+        dmaError = false;
+        primed = false;
+        runLength = 0;
+        postRemaining = config.postTrigger;
+        historyHead = 0;
+        historyCount = 0;
+        sampleCount = 0;
+        encodedBytes = 0;
+        preCount = 0;
+        state = State::ARMED;
+        activeCapture = this;
+
+        LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM1);
+        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+
+        // IDR -> ring, circular, interrupts at both halves
+        LL_DMA_DisableChannel(SAMPLE_DMA, SAMPLE_CHANNEL);
+        LL_DMA_ConfigTransfer(SAMPLE_DMA, SAMPLE_CHANNEL,
+                              LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_MODE_CIRCULAR |
+                              LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                              LL_DMA_PDATAALIGN_HALFWORD | LL_DMA_MDATAALIGN_HALFWORD | LL_DMA_PRIORITY_HIGH);
+        LL_DMA_SetPeriphRequest(SAMPLE_DMA, SAMPLE_CHANNEL, SAMPLE_REQUEST);
+        LL_DMA_SetPeriphAddress(SAMPLE_DMA, SAMPLE_CHANNEL, dmaAddress(&config.port->IDR));
+        LL_DMA_SetMemoryAddress(SAMPLE_DMA, SAMPLE_CHANNEL, dmaAddress(ring));
+        LL_DMA_SetDataLength(SAMPLE_DMA, SAMPLE_CHANNEL, halfCount * 2U);
+        WRITE_REG(SAMPLE_DMA->IFCR, DMA_IFCR_CGIF6);
+        LL_DMA_EnableIT_HT(SAMPLE_DMA, SAMPLE_CHANNEL);
+        LL_DMA_EnableIT_TC(SAMPLE_DMA, SAMPLE_CHANNEL);
+        LL_DMA_EnableIT_TE(SAMPLE_DMA, SAMPLE_CHANNEL);
+        if (NVIC_GetEnableIRQ(SAMPLE_DMA_IRQN) == 0U)
+        {
+            // The vector is shared with the bridge: keep the priority it was given
+            NVIC_SetPriority(SAMPLE_DMA_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+            NVIC_ClearPendingIRQ(SAMPLE_DMA_IRQN);
+            NVIC_EnableIRQ(SAMPLE_DMA_IRQN);
+        }
+        LL_DMA_EnableChannel(SAMPLE_DMA, SAMPLE_CHANNEL);
+
+        // One DMA request per update event
+        LL_TIM_DisableCounter(SAMPLE_TIMER);
+        LL_TIM_SetPrescaler(SAMPLE_TIMER, prescaler);
+        LL_TIM_SetAutoReload(SAMPLE_TIMER, reload);
+        LL_TIM_SetRepetitionCounter(SAMPLE_TIMER, 0);
+        LL_TIM_SetCounter(SAMPLE_TIMER, 0);
+        LL_TIM_GenerateEvent_UPDATE(SAMPLE_TIMER);
+        LL_TIM_ClearFlag_UPDATE(SAMPLE_TIMER);
+        LL_TIM_EnableDMAReq_UPDATE(SAMPLE_TIMER);
+        LL_TIM_EnableCounter(SAMPLE_TIMER);
+        return true;
+    }
+
+    void Capture::stopSampling() noexcept
+    {
+        if (activeCapture != this)
+        {
+            return;
+        }
+        LL_TIM_DisableCounter(SAMPLE_TIMER);
+        LL_TIM_DisableDMAReq_UPDATE(SAMPLE_TIMER);
+
+        // Only a channel that still reads this capture's IDR is ours to stop
+        if (LL_DMA_GetPeriphAddress(SAMPLE_DMA, SAMPLE_CHANNEL) == dmaAddress(&config.port->IDR))
+        {
+            LL_DMA_DisableChannel(SAMPLE_DMA, SAMPLE_CHANNEL);
+            LL_DMA_DisableIT_HT(SAMPLE_DMA, SAMPLE_CHANNEL);
+            LL_DMA_DisableIT_TC(SAMPLE_DMA, SAMPLE_CHANNEL);
+            LL_DMA_DisableIT_TE(SAMPLE_DMA, SAMPLE_CHANNEL);
+            WRITE_REG(SAMPLE_DMA->IFCR, DMA_IFCR_CGIF6);
+        }
+        activeCapture = nullptr;
+    }
+
+    void Capture::stop() noexcept
+    {
+        stopSampling();
+        if (state == State::ARMED || state == State::TRIGGERED)
+        {
+            state = State::IDLE;
+        }
+    }
+
+    State Capture::poll() noexcept
+    {
+        while (state == State::ARMED || state == State::TRIGGERED)
+        {
+            // Two halves ahead: DMA is already overwriting the half to process
+            if (dmaError || halvesFilled - halvesDone > 1U)
+            {
+                finish(STATUS_OVERRUN);
+                break;
+            }
+            if (halvesFilled == halvesDone)
+            {
+                break;
+            }
+
+            processHalf(ring + (halvesDone & 1U) * halfCount, halfCount);
+            if ((state == State::ARMED || state == State::TRIGGERED) && halvesFilled - halvesDone > 1U)
+            {
+                finish(STATUS_OVERRUN);     // Overwritten while it was encoded
+                break;
+            }
+            halvesDone++;
+        }
+
+        drain();
+        return state;
+    }
+
+    uint16_t Capture::armedScan(const uint16_t* samples, uint16_t count) noexcept
+    {
+        const Trigger& trig = config.trigger;
+        if (trig.type == TriggerType::NONE)
+        {
+            return 0;
+        }
+        const uint16_t mask = config.pinMask;
+        const uint16_t riseMask = (trig.type == TriggerType::RISING || trig.type == TriggerType::EDGE) ? trig.mask : 0;
+        const uint16_t fallMask = (trig.type == TriggerType::FALLING || trig.type == TriggerType::EDGE) ? trig.mask : 0;
+        const bool pattern = trig.type == TriggerType::PATTERN;
+
+        uint16_t prev = previous;
+        for (uint16_t i = 0; i < count; i++)
+        {
+            const uint16_t s = samples[i] & mask;
+            const bool fire = pattern ? ((s & trig.mask) == (trig.value & trig.mask))
+                                      : ((static_cast<uint16_t>(~prev & s & riseMask) | (prev & ~s & fallMask)) != 0);
+            if (fire)
+            {
+                previous = prev;
+                return i;
+            }
+
+            // Runs go into the history until the trigger decides which of them are sent
+            if (s != current)
+            {
+                history[historyHead] = Run{current, runLength};
+                historyHead = (historyHead + 1U) % HISTORY_RUNS;
+                if (historyCount < HISTORY_RUNS)
+                {
+                    historyCount++;
+                }
+                current = s;
+                runLength = 0;
+            }
+            runLength++;
+            prev = s;
+        }
+        previous = prev;
+        return count;
+    }
+
+    /**
+     * @brief Send the header and the pre-trigger runs; the trigger sample opens a new run
+     */
+    void Capture::trigger() noexcept
+    {
+        if (runLength != 0)
+        {
+            history[historyHead] = Run{current, runLength};
+            historyHead = (historyHead + 1U) % HISTORY_RUNS;
+            if (historyCount < HISTORY_RUNS)
+            {
+                historyCount++;
+            }
+        }
+
+        // Newest runs back to preTrigger samples (or as far as the history goes)
+        uint32_t covered = 0;
+        uint16_t runs = 0;
+        while (runs < historyCount && covered < config.preTrigger)
+        {
+            covered += history[(historyHead + HISTORY_RUNS - 1U - runs) % HISTORY_RUNS].length;
+            runs++;
+        }
+        preCount = (covered < config.preTrigger) ? covered : config.preTrigger;
+
+        const uint8_t portLetter = static_cast<uint8_t>(
+            'A' + (reinterpret_cast<uintptr_t>(config.port) - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE));
+        const uint8_t header[HEADER_SIZE] = {
+            MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3], portLetter, 0,
+            static_cast<uint8_t>(config.pinMask), static_cast<uint8_t>(config.pinMask >> 8),
+            static_cast<uint8_t>(config.sampleRateHz), static_cast<uint8_t>(config.sampleRateHz >> 8),
+            static_cast<uint8_t>(config.sampleRateHz >> 16), static_cast<uint8_t>(config.sampleRateHz >> 24),
+            static_cast<uint8_t>(preCount), static_cast<uint8_t>(preCount >> 8),
+            static_cast<uint8_t>(preCount >> 16), static_cast<uint8_t>(preCount >> 24),
+        };
+        for (uint8_t byte : header)
+        {
+            put(byte);
+        }
+
+        // The oldest run is cut to the requested depth
+        uint32_t skip = covered - preCount;
+        for (uint16_t k = runs; k > 0; k--)
+        {
+            const Run& run = history[(historyHead + HISTORY_RUNS - k) % HISTORY_RUNS];
+            if (!emit(run.value, run.length - skip))
+            {
+                break;
+            }
+            skip = 0;
+        }
+
+        historyCount = 0;
+        runLength = 0;
+        state = State::TRIGGERED;
+    }
+
+    void Capture::processHalf(const uint16_t* samples, uint16_t count) noexcept
+    {
+        const uint16_t mask = config.pinMask;
+        if (!primed)
+        {
+            previous = samples[0] & mask;
+            current = previous;
+            primed = true;
+        }
+
+        uint16_t start = 0;
+        if (state == State::ARMED)
+        {
+            start = armedScan(samples, count);
+            sampleCount += start;
+            if (start == count)
+            {
+                return;
+            }
+            trigger();
+            current = samples[start] & mask;
+            if (state != State::TRIGGERED)
+            {
+                return;
+            }
+        }
+
+        // Post-trigger: the hot loop, one compare per sample while nothing changes
+        uint32_t n = count - start;
+        if (n > postRemaining)
+        {
+            n = postRemaining;
+        }
+        const uint16_t* p = samples + start;
+        const uint16_t* const end = p + n;
+        uint16_t value = current;
+        uint32_t run = runLength;
+        for (; p != end; ++p)
+        {
+            const uint16_t s = *p & mask;
+            if (s != value)
+            {
+                if (!emit(value, run))
+                {
+                    current = value;
+                    runLength = run;
+                    finish(STATUS_OVERRUN);
+                    return;
+                }
+                value = s;
+                run = 0;
+            }
+            run++;
+        }
+        current = value;
+        runLength = run;
+        postRemaining -= n;
+        sampleCount += n;
+
+        if (postRemaining == 0)
+        {
+            finish(STATUS_COMPLETE);
+        }
+    }
+
+    bool Capture::emit(uint16_t value, uint32_t length) noexcept
+    {
+        // Room for the end record is always kept
+        if (length == 0 || freeSpace() < MAX_RECORD_SIZE + END_RECORD_SIZE)
+        {
+            return length == 0;
+        }
+        put(static_cast<uint8_t>(value));
+        put(static_cast<uint8_t>(value >> 8));
+        do
+        {
+            uint8_t byte = length & 0x7FU;
+            length >>= 7;
+            if (length != 0)
+            {
+                byte |= 0x80U;
+            }
+            put(byte);
+        } while (length != 0);
+        return true;
+    }
+
+    void Capture::finish(uint16_t status) noexcept
+    {
+        stopSampling();
+
+        if (state == State::ARMED)
+        {
+            // Never triggered: an empty capture, so the host still sees why it ended
+            config.preTrigger = 0;
+            runLength = 0;
+            trigger();
+        }
+        else
+        {
+            emit(current, runLength);   // Fails quietly if the output is what overran
+        }
+        runLength = 0;
+
+        put(static_cast<uint8_t>(status));
+        put(static_cast<uint8_t>(status >> 8));
+        put(0);
+        state = (status == STATUS_COMPLETE) ? State::DONE : State::OVERRUN;
+    }
+
+    void Capture::put(uint8_t data) noexcept
+    {
+        output[outputHead] = data;
+        outputHead = (outputHead + 1U == outputSize) ? 0 : outputHead + 1U;
+        encodedBytes++;
+    }
+
+    uint16_t Capture::getPendingBytes() const noexcept
+    {
+        const uint16_t head = outputHead;
+        return (head >= outputTail) ? head - outputTail : outputSize - outputTail + head;
+    }
+
+    uint16_t Capture::freeSpace() const noexcept
+    {
+        return outputSize - 1U - getPendingBytes();
+    }
+
+    void Capture::drain() noexcept
+    {
+        while (outputTail != outputHead)
+        {
+            const uint16_t end = (outputHead > outputTail) ? outputHead : outputSize;
+            const uint16_t sent = uart.sendData(output + outputTail, end - outputTail);
+            if (sent == 0)
+            {
+                break;
+            }
+            outputTail = (outputTail + sent == outputSize) ? 0 : outputTail + sent;
+        }
+    }
+
+    void Capture::handleDmaInterrupt(uint32_t flags) noexcept
+    {
+        if ((flags & DMA_ISR_TEIF6) != 0U)
+        {
+            dmaError = true;
+        }
+        if ((flags & DMA_ISR_HTIF6) != 0U)
+        {
+            halvesFilled = halvesFilled + 1;
+        }
+        if ((flags & DMA_ISR_TCIF6) != 0U)
+        {
+            halvesFilled = halvesFilled + 1;
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // Host side
+    // ---------------------------------------------------------------------
+
+    VcdConverter::VcdConverter(TextSink& sink) noexcept
+        : sink(sink), phase(Phase::HEADER), header(), headerLength(0), portLetter('A'), pinMask(0),
+          rateHz(1), preTrigger(0), value(0), lastValue(0), length(0), lengthShift(0), sample(0),
+          status(STATUS_COMPLETE)
+    {
+    }
+
+    bool VcdConverter::feed(const uint8_t* data, size_t size) noexcept
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            const uint8_t byte = data[i];
+            switch (phase)
+            {
+                case Phase::HEADER:
+                    header[headerLength++] = byte;
+                    if (headerLength < HEADER_SIZE)
+                    {
+                        break;
+                    }
+                    if (header[0] != MAGIC[0] || header[1] != MAGIC[1] || header[2] != MAGIC[2] || header[3] != MAGIC[3])
+                    {
+                        phase = Phase::ERROR;
+                        return false;
+                    }
+                    portLetter = static_cast<char>(header[4]);
+                    pinMask = static_cast<uint16_t>(header[6] | (header[7] << 8));
+                    rateHz = header[8] | (header[9] << 8) | (header[10] << 16) | (static_cast<uint32_t>(header[11]) << 24);
+                    preTrigger = header[12] | (header[13] << 8) | (header[14] << 16) | (static_cast<uint32_t>(header[15]) << 24);
+                    if (rateHz == 0)
+                    {
+                        phase = Phase::ERROR;
+                        return false;
+                    }
+                    writeHeader();
+                    phase = Phase::VALUE_LOW;
+                    break;
+
+                case Phase::VALUE_LOW:
+                    value = byte;
+                    phase = Phase::VALUE_HIGH;
+                    break;
+
+                case Phase::VALUE_HIGH:
+                    value = static_cast<uint16_t>(value | (byte << 8));
+                    length = 0;
+                    lengthShift = 0;
+                    phase = Phase::LENGTH;
+                    break;
+
+                case Phase::LENGTH:
+                    if (lengthShift > 28)
+                    {
+                        phase = Phase::ERROR;
+                        return false;
+                    }
+                    length |= static_cast<uint32_t>(byte & 0x7FU) << lengthShift;
+                    lengthShift += 7;
+                    if ((byte & 0x80U) != 0)
+                    {
+                        break;
+                    }
+                    if (length == 0)
+                    {
+                        status = value;
+                        writeEnd();
+                        phase = Phase::END;
+                        return false;
+                    }
+                    writeRun();
+                    phase = Phase::VALUE_LOW;
+                    break;
+
+                case Phase::END:
+                case Phase::ERROR:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    void VcdConverter::writeText(const char* text) noexcept
+    {
+        size_t size = 0;
+        while (text[size] != '\0')
+        {
+            size++;
+        }
+        sink.write(text, size);
+    }
+
+    void VcdConverter::writeTime(uint64_t sampleIndex) noexcept
+    {
+        char line[24];
+        const int size = snprintf(line, sizeof(line), "#%llu\n",
+                                  static_cast<unsigned long long>(sampleIndex * 1000000000ULL / rateHz));
+        sink.write(line, static_cast<size_t>(size));
+    }
+
+    void VcdConverter::writeHeader() noexcept
+    {
+        char line[96];
+        int size = snprintf(line, sizeof(line), "$comment LogicCapture GPIO%c, %lu Hz, trigger at sample %lu $end\n",
+                            portLetter, static_cast<unsigned long>(rateHz), static_cast<unsigned long>(preTrigger));
+        sink.write(line, static_cast<size_t>(size));
+        writeText("$timescale 1 ns $end\n$scope module capture $end\n");
+        for (uint8_t pin = 0; pin < 16; pin++)
+        {
+            if ((pinMask & (1U << pin)) != 0)
+            {
+                // One printable identifier per pin: '!' + pin
+                size = snprintf(line, sizeof(line), "$var wire 1 %c P%c%u $end\n",
+                                static_cast<char>('!' + pin), portLetter, static_cast<unsigned>(pin));
+                sink.write(line, static_cast<size_t>(size));
+            }
+        }
+        writeText("$upscope $end\n$enddefinitions $end\n");
+    }
+
+    void VcdConverter::writeRun() noexcept
+    {
+        uint16_t changed = static_cast<uint16_t>(value ^ lastValue);
+        if (sample == 0)
+        {
+            writeText("#0\n$dumpvars\n");
+            changed = pinMask;
+        }
+        else if (changed != 0 || sample == preTrigger)
+        {
+            writeTime(sample);
+        }
+        if (sample == preTrigger)
+        {
+            writeText("$comment trigger $end\n");
+        }
+
+        for (uint8_t pin = 0; pin < 16; pin++)
+        {
+            if ((changed & pinMask & (1U << pin)) != 0)
+            {
+                const char bit[3] = {(value & (1U << pin)) ? '1' : '0', static_cast<char>('!' + pin), '\n'};
+                sink.write(bit, sizeof(bit));
+            }
+        }
+        if (sample == 0)
+        {
+            writeText("$end\n");
+        }
+
+        lastValue = value;
+        sample += length;
+    }
+
+    void VcdConverter::writeEnd() noexcept
+    {
+        writeTime(sample);
+        if (status == STATUS_OVERRUN)
+        {
+            writeText("$comment capture overrun $end\n");
+        }
+    }
+
+} // namespace LogicCapture
+
+extern "C" {
+    /**
+     * @brief DMA1 Channel 6 interrupt: only the capture's flags, and only while it samples
+     *
+     * The channel is shared with the USART bridge, whose handler runs after
+     * this one and sees no flags of a running capture.
+     */
+    void LOGIC_CAPTURE_HandleDmaInterrupt(void)
+    {
+        LogicCapture::Capture* capture = LogicCapture::activeCapture;
+        if (capture == nullptr)
+        {
+            return;
+        }
+        const uint32_t flags = READ_REG(DMA1->ISR) & (DMA_ISR_GIF6 | DMA_ISR_TCIF6 | DMA_ISR_HTIF6 | DMA_ISR_TEIF6);
+        WRITE_REG(DMA1->IFCR, flags);   // IFCR bits share the ISR positions
+        capture->handleDmaInterrupt(flags);
+    }
+}
@@ -0,0 +1,393 @@
+/**
+ * @file    ModbusRtu.cpp
+ * @brief   Modbus RTU slave engine implementation
+ * @author  MootSeeker
+ *
+ * @see ModbusRtu.h for the data map description and usage
+ */
+
+#include "ModbusRtu.h"
+
+namespace Modbus
+{
+    // Protocol limits from the Modbus application protocol specification
+    static constexpr uint16_t MAX_READ_BITS = 2000;
+    static constexpr uint16_t MAX_READ_REGISTERS = 125;
+    static constexpr uint16_t MAX_WRITE_BITS = 1968;
+    static constexpr uint16_t MAX_WRITE_REGISTERS = 123;
+    static constexpr uint16_t MIN_FRAME_SIZE = 4;  // address + function + CRC
+
+    /**
+     * @brief Read a big-endian 16-bit field
+     */
+    static inline uint16_t readU16(const uint8_t* data)
+    {
+        return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    /**
+     * @brief Write a big-endian 16-bit field
+     */
+    static inline void writeU16(uint8_t* data, uint16_t value)
+    {
+        data[0] = static_cast<uint8_t>(value >> 8);
+        data[1] = static_cast<uint8_t>(value & 0xFFU);
+    }
+
+    RtuSlave::RtuSlave(USART::StandardUSART& uart, uint8_t address, const DataMap& map) noexcept
+        : uart(uart), address(address), map(map), frame(), response(),
+          frameLength(0), requestLength(0), frameOverrun(false), crc(), statistics()
+    {
+    }
+
+    USART::UsartStatus RtuSlave::start(uint32_t baudRate) noexcept
+    {
+        if (address == BROADCAST_ADDRESS || address > 247)
+        {
+            return USART::UsartStatus{USART::UsartError::INVALID_PARAMETER, address};
+        }
+
+        frameLength = 0;
+        frameOverrun = false;
+        crc.reset();
+
+        uart.setRxCallback(&RtuSlave::onRxByte, this);
+        return uart.enableReceiverTimeout(frameGapBitPeriods(baudRate), &RtuSlave::onFrameEnd, this);
+    }
+
+    void RtuSlave::stop() noexcept
+    {
+        uart.disableReceiverTimeout();
+        uart.setRxCallback(nullptr, nullptr);
+    }
+
+    void RtuSlave::onRxByte(void* context, uint8_t data)
+    {
+        static_cast<RtuSlave*>(context)->receiveByte(data);
+    }
+
+    void RtuSlave::onFrameEnd(void* context)
+    {
+        static_cast<RtuSlave*>(context)->processFrame();
+    }
+
+    /**
+     * @brief Store a received byte and fold it into the running CRC
+     *
+     * Runs in the RX interrupt. Doing the CRC here spreads the cost over the
+     * frame so the end-of-frame handler only has to test the residue.
+     */
+    void RtuSlave::receiveByte(uint8_t data) noexcept
+    {
+        if (frameLength < MAX_FRAME_SIZE)
+        {
+            frame[frameLength++] = data;
+            crc.update(data);
+        }
+        else
+        {
+            frameOverrun = true;
+        }
+    }
+
+    /**
+     * @brief Validate and execute the frame collected since the last gap
+     *
+     * Runs in the receiver-timeout interrupt (t3.5 after the last byte).
+     */
+    void RtuSlave::processFrame() noexcept
+    {
+        const uint16_t length = frameLength;
+        const bool overrun = frameOverrun;
+        const uint16_t residue = crc.get();
+
+        // Re-arm for the next frame before doing any work
+        frameLength = 0;
+        frameOverrun = false;
+        crc.reset();
+
+        if (length == 0)
+        {
+            return;
+        }
+        if (overrun)
+        {
+            statistics.overruns++;
+            return;
+        }
+        if (length < MIN_FRAME_SIZE || residue != 0)
+        {
+            statistics.crcErrors++;
+            return;
+        }
+        statistics.framesReceived++;
+
+        const uint8_t target = frame[0];
+        if (target != address && target != BROADCAST_ADDRESS)
+        {
+            return;
+        }
+        statistics.framesHandled++;
+
+        // Strip the CRC, execute() only sees address + PDU
+        requestLength = length - 2;
+        uint16_t responseLength = 0;
+        ExceptionCode exception = execute(responseLength);
+
+        // Broadcast requests are executed but never answered
+        if (target == BROADCAST_ADDRESS)
+        {
+            return;
+        }
+
+        if (exception != ExceptionCode::NONE)
+        {
+            response[0] = address;
+            response[1] = static_cast<uint8_t>(frame[1] | 0x80U);
+            response[2] = static_cast<uint8_t>(exception);
+            responseLength = 3;
+            statistics.exceptionsSent++;
+        }
+        sendResponse(responseLength);
+    }
+
+    ExceptionCode RtuSlave::execute(uint16_t& responseLength) noexcept
+    {
+        response[0] = address;
+        response[1] = frame[1];
+
+        switch (static_cast<FunctionCode>(frame[1]))
+        {
+            case FunctionCode::READ_COILS:
+                return readBits(map.coils, responseLength);
+            case FunctionCode::READ_DISCRETE_INPUTS:
+                return readBits(map.discreteInputs, responseLength);
+            case FunctionCode::READ_HOLDING_REGISTERS:
+                return readRegisters(map.holdingRegisters, responseLength);
+            case FunctionCode::READ_INPUT_REGISTERS:
+                return readRegisters(map.inputRegisters, responseLength);
+            case FunctionCode::WRITE_SINGLE_COIL:
+                return writeSingleCoil(responseLength);
+            case FunctionCode::WRITE_SINGLE_REGISTER:
+                return writeSingleRegister(responseLength);
+            case FunctionCode::WRITE_MULTIPLE_COILS:
+                return writeMultipleCoils(responseLength);
+            case FunctionCode::WRITE_MULTIPLE_REGISTERS:
+                return writeMultipleRegisters(responseLength);
+        }
+        return ExceptionCode::ILLEGAL_FUNCTION;
+    }
+
+    ExceptionCode RtuSlave::readBits(const BlockTable<CoilBlock>& table, uint16_t& responseLength) noexcept
+    {
+        if (requestLength != 6)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const uint16_t start = readU16(&frame[2]);
+        const uint16_t quantity = readU16(&frame[4]);
+        if (quantity == 0 || quantity > MAX_READ_BITS)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const CoilBlock* block = table.find(start, quantity);
+        if (block == nullptr)
+        {
+            return ExceptionCode::ILLEGAL_DATA_ADDRESS;
+        }
+
+        const uint8_t byteCount = static_cast<uint8_t>((quantity + 7U) / 8U);
+        uint8_t* out = &response[3];
+        for (uint8_t i = 0; i < byteCount; i++)
+        {
+            out[i] = 0;
+        }
+
+        uint16_t source = start - block->start;
+        for (uint16_t i = 0; i < quantity; i++, source++)
+        {
+            if ((block->bits[source >> 3] >> (source & 7U)) & 1U)
+            {
+                out[i >> 3] = static_cast<uint8_t>(out[i >> 3] | (1U << (i & 7U)));
+            }
+        }
+
+        response[2] = byteCount;
+        responseLength = 3U + byteCount;
+        return ExceptionCode::NONE;
+    }
+
+    ExceptionCode RtuSlave::readRegisters(const BlockTable<RegisterBlock>& table, uint16_t& responseLength) noexcept
+    {
+        if (requestLength != 6)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const uint16_t start = readU16(&frame[2]);
+        const uint16_t quantity = readU16(&frame[4]);
+        if (quantity == 0 || quantity > MAX_READ_REGISTERS)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const RegisterBlock* block = table.find(start, quantity);
+        if (block == nullptr)
+        {
+            return ExceptionCode::ILLEGAL_DATA_ADDRESS;
+        }
+
+        const uint16_t* source = &block->data[start - block->start];
+        for (uint16_t i = 0; i < quantity; i++)
+        {
+            writeU16(&response[3 + 2 * i], source[i]);
+        }
+
+        response[2] = static_cast<uint8_t>(quantity * 2U);
+        responseLength = 3U + quantity * 2U;
+        return ExceptionCode::NONE;
+    }
+
+    ExceptionCode RtuSlave::writeSingleCoil(uint16_t& responseLength) noexcept
+    {
+        if (requestLength != 6)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const uint16_t target = readU16(&frame[2]);
+        const uint16_t value = readU16(&frame[4]);
+        if (value != 0xFF00U && value != 0x0000U)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const CoilBlock* block = map.coils.find(target, 1);
+        if (block == nullptr || block->access != Access::READ_WRITE)
+        {
+            return ExceptionCode::ILLEGAL_DATA_ADDRESS;
+        }
+
+        const uint16_t bit = target - block->start;
+        if (value == 0xFF00U)
+        {
+            block->bits[bit >> 3] = static_cast<uint8_t>(block->bits[bit >> 3] | (1U << (bit & 7U)));
+        }
+        else
+        {
+            block->bits[bit >> 3] = static_cast<uint8_t>(block->bits[bit >> 3] & ~(1U << (bit & 7U)));
+        }
+
+        // Normal response echoes the request
+        for (uint16_t i = 2; i < 6; i++)
+        {
+            response[i] = frame[i];
+        }
+        responseLength = 6;
+        return ExceptionCode::NONE;
+    }
+
+    ExceptionCode RtuSlave::writeSingleRegister(uint16_t& responseLength) noexcept
+    {
+        if (requestLength != 6)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const uint16_t target = readU16(&frame[2]);
+        const RegisterBlock* block = map.holdingRegisters.find(target, 1);
+        if (block == nullptr || block->access != Access::READ_WRITE)
+        {
+            return ExceptionCode::ILLEGAL_DATA_ADDRESS;
+        }
+
+        block->data[target - block->start] = readU16(&frame[4]);
+
+        for (uint16_t i = 2; i < 6; i++)
+        {
+            response[i] = frame[i];
+        }
+        responseLength = 6;
+        return ExceptionCode::NONE;
+    }
+
+    ExceptionCode RtuSlave::writeMultipleCoils(uint16_t& responseLength) noexcept
+    {
+        if (requestLength < 7)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const uint16_t start = readU16(&frame[2]);
+        const uint16_t quantity = readU16(&frame[4]);
+        const uint8_t byteCount = frame[6];
+        if (quantity == 0 || quantity > MAX_WRITE_BITS || byteCount != (quantity + 7U) / 8U ||
+            requestLength != 7U + byteCount)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const CoilBlock* block = map.coils.find(start, quantity);
+        if (block == nullptr || block->access != Access::READ_WRITE)
+        {
+            return ExceptionCode::ILLEGAL_DATA_ADDRESS;
+        }
+
+        const uint8_t* in = &frame[7];
+        uint16_t target = start - block->start;
+        for (uint16_t i = 0; i < quantity; i++, target++)
+        {
+            const uint8_t mask = static_cast<uint8_t>(1U << (target & 7U));
+            if ((in[i >> 3] >> (i & 7U)) & 1U)
+            {
+                block->bits[target >> 3] = static_cast<uint8_t>(block->bits[target >> 3] | mask);
+            }
+            else
+            {
+                block->bits[target >> 3] = static_cast<uint8_t>(block->bits[target >> 3] & ~mask);
+            }
+        }
+
+        writeU16(&response[2], start);
+        writeU16(&response[4], quantity);
+        responseLength = 6;
+        return ExceptionCode::NONE;
+    }
+
+    ExceptionCode RtuSlave::writeMultipleRegisters(uint16_t& responseLength) noexcept
+    {
+        if (requestLength < 7)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const uint16_t start = readU16(&frame[2]);
+        const uint16_t quantity = readU16(&frame[4]);
+        const uint8_t byteCount = frame[6];
+        if (quantity == 0 || quantity > MAX_WRITE_REGISTERS || byteCount != quantity * 2U ||
+            requestLength != 7U + byteCount)
+        {
+            return ExceptionCode::ILLEGAL_DATA_VALUE;
+        }
+        const RegisterBlock* block = map.holdingRegisters.find(start, quantity);
+        if (block == nullptr || block->access != Access::READ_WRITE)
+        {
+            return ExceptionCode::ILLEGAL_DATA_ADDRESS;
+        }
+
+        uint16_t* target = &block->data[start - block->start];
+        for (uint16_t i = 0; i < quantity; i++)
+        {
+            target[i] = readU16(&frame[7 + 2 * i]);
+        }
+
+        writeU16(&response[2], start);
+        writeU16(&response[4], quantity);
+        responseLength = 6;
+        return ExceptionCode::NONE;
+    }
+
+    /**
+     * @brief Append the CRC and queue the response on the TX ring
+     */
+    void RtuSlave::sendResponse(uint16_t length) noexcept
+    {
+        const uint16_t value = Crc16::compute(response, length);
+        response[length++] = static_cast<uint8_t>(value & 0xFFU);
+        response[length++] = static_cast<uint8_t>(value >> 8);
+        uart.sendData(response, length);
+    }
+
+} // namespace Modbus
@@ -0,0 +1,257 @@
+/**
+ * @file    Rpc.cpp
+ * @brief   Binary RPC server implementation
+ * @author  MootSeeker
+ *
+ * @see Rpc.h for the frame format and method table description
+ */
+
+#include "Rpc.h"
+
+namespace Rpc
+{
+    // Offsets inside a slot (the SYNC byte is not stored)
+    static constexpr uint8_t SLOT_LENGTH = 0;
+    static constexpr uint8_t SLOT_ID = 1;
+    static constexpr uint8_t SLOT_METHOD = 2;
+    static constexpr uint8_t SLOT_PAYLOAD = 3;
+
+    Server::Server(USART::StandardUSART& uart, const MethodTable& table) noexcept
+        : uart(uart), table(table), slots(), slotHead(0), slotTail(0),
+          rxState(RxState::SYNC), rxDiscard(false), rxPosition(0), rxExpected(0), crc(), statistics()
+    {
+    }
+
+    void Server::start() noexcept
+    {
+        rxState = RxState::SYNC;
+        slotHead = 0;
+        slotTail = 0;
+        uart.setRxCallback(&Server::onRxByte, this);
+    }
+
+    void Server::stop() noexcept
+    {
+        uart.setRxCallback(nullptr, nullptr);
+        slotTail = slotHead;
+    }
+
+    void Server::onRxByte(void* context, uint8_t data)
+    {
+        static_cast<Server*>(context)->receiveByte(data);
+    }
+
+    /**
+     * @brief Frame assembly, runs in the RX interrupt
+     *
+     * Bytes go straight into the next free slot and into the running CRC.
+     * A slot is published to poll() by advancing slotHead once its CRC
+     * residue is zero. Without a free slot the frame is still parsed (to stay
+     * in sync) but not stored, so the slot poll() is executing stays intact.
+     */
+    void Server::receiveByte(uint8_t data) noexcept
+    {
+        uint8_t* slot = slots[slotHead & (SLOT_COUNT - 1U)].bytes;
+
+        switch (rxState)
+        {
+            case RxState::SYNC:
+                if (data == SYNC)
+                {
+                    crc.reset();
+                    rxState = RxState::LENGTH;
+                }
+                break;
+
+            case RxState::LENGTH:
+                if (data > MAX_PAYLOAD)
+                {
+                    // Not a frame start (SYNC itself is a valid length), resynchronize on the next SYNC
+                    rxState = RxState::SYNC;
+                    break;
+                }
+                crc.update(data);
+                rxDiscard = static_cast<uint8_t>(slotHead - slotTail) >= SLOT_COUNT;
+                if (!rxDiscard)
+                {
+                    slot[SLOT_LENGTH] = data;
+                }
+                rxPosition = 1;
+                rxExpected = static_cast<uint16_t>(SLOT_PAYLOAD + data + CRC_SIZE);
+                rxState = RxState::BODY;
+                break;
+
+            case RxState::BODY:
+                crc.update(data);
+                if (!rxDiscard)
+                {
+                    slot[rxPosition] = data;
+                }
+                rxPosition++;
+                if (rxPosition < rxExpected)
+                {
+                    break;
+                }
+
+                rxState = RxState::SYNC;
+                if (crc.get() != 0)
+                {
+                    statistics.crcErrors++;
+                }
+                else if (rxDiscard)
+                {
+                    statistics.slotOverruns++;
+                }
+                else
+                {
+                    slotHead = static_cast<uint8_t>(slotHead + 1U);
+                }
+                break;
+        }
+    }
+
+    uint8_t Server::poll() noexcept
+    {
+        uint8_t executed = 0;
+        while (slotTail != slotHead)
+        {
+            execute(slots[slotTail & (SLOT_COUNT - 1U)].bytes);
+            slotTail = static_cast<uint8_t>(slotTail + 1U);
+            executed++;
+        }
+        return executed;
+    }
+
+    /**
+     * @brief Validate, dispatch and answer one request slot
+     *
+     * The handler serializes its result straight into reserved TX ring space
+     * behind the header; header and CRC are filled in around it and the
+     * frame is committed as a whole. With less than a full frame of free
+     * ring space the payload capacity shrinks accordingly, and a result
+     * that does not fit counts as a TX overrun.
+     */
+    void Server::execute(const uint8_t* request) noexcept
+    {
+        const uint8_t length = request[SLOT_LENGTH];
+        const uint8_t methodId = request[SLOT_METHOD];
+        using Reservation = USART::StandardUSART::TxReservation;
+
+        Reservation reservation = uart.reserveTx(MAX_FRAME_SIZE);
+        const uint16_t frameCapacity = reservation.getCapacity();
+        const uint8_t payloadCapacity = (frameCapacity >= MAX_FRAME_SIZE) ? MAX_PAYLOAD
+            : (frameCapacity > HEADER_SIZE + CRC_SIZE) ? static_cast<uint8_t>(frameCapacity - HEADER_SIZE - CRC_SIZE)
+            : 0;
+        uint16_t start = 0;
+        uint8_t* ring = reservation.getRing(start);
+        const auto at = [&](uint16_t offset) -> uint8_t& { return ring[(start + offset) & Reservation::RING_MASK]; };
+
+        Reader reader(&request[SLOT_PAYLOAD], length);
+        Writer writer(ring, Reservation::RING_MASK, static_cast<uint16_t>(start + HEADER_SIZE), payloadCapacity);
+        Status status = Status::OK;
+
+        if (methodId == DESCRIBE_METHOD)
+        {
+            status = describe(reader, writer);
+        }
+        else
+        {
+            const Method* method = table.find(methodId);
+            if (method == nullptr)
+            {
+                status = Status::UNKNOWN_METHOD;
+            }
+            else
+            {
+                const uint16_t expected = schemaSize(method->requestSchema);
+                const bool lengthOk = isVariableSchema(method->requestSchema) ? (length >= expected)
+                                                                               : (length == expected);
+                status = lengthOk ? method->handler(reader, writer, method->context) : Status::BAD_REQUEST;
+                if (status == Status::OK && !reader.isValid())
+                {
+                    status = Status::BAD_REQUEST;
+                }
+            }
+        }
+
+        statistics.callsHandled++;
+        if (status == Status::OK && !writer.isValid())
+        {
+            if (payloadCapacity < MAX_PAYLOAD)
+            {
+                // Cut short by the TX ring, not by MAX_PAYLOAD
+                uart.abortTx(reservation);
+                statistics.txOverruns++;
+                return;
+            }
+            status = Status::RESPONSE_OVERFLOW;
+        }
+        const uint8_t payloadLength = (status == Status::OK) ? writer.size() : 0;
+        const uint16_t frameLength = static_cast<uint16_t>(HEADER_SIZE + payloadLength + CRC_SIZE);
+        if (frameCapacity < frameLength)
+        {
+            uart.abortTx(reservation);
+            statistics.txOverruns++;
+            return;
+        }
+
+        at(0) = SYNC;
+        at(1) = payloadLength;
+        at(2) = request[SLOT_ID];
+        at(3) = static_cast<uint8_t>(status);
+        Crc::Crc16 frameCrc;
+        for (uint16_t offset = 1; offset < HEADER_SIZE + payloadLength; offset++)
+        {
+            frameCrc.update(at(offset));
+        }
+        const uint16_t crcValue = frameCrc.get();
+        at(HEADER_SIZE + payloadLength) = static_cast<uint8_t>(crcValue & 0xFFU);
+        at(HEADER_SIZE + payloadLength + 1) = static_cast<uint8_t>(crcValue >> 8);
+
+        reservation.setSize(frameLength);
+        uart.commitTx(reservation);
+    }
+
+    /**
+     * @brief Built-in method 0x00: describe the method table
+     *
+     * Request: u8 first index. Response: u8 total count, u8 next index (0 when
+     * done), then per method u8 id and NUL-terminated name, request schema
+     * and response schema, as many as fit into one payload.
+     */
+    Status Server::describe(Reader& reader, Writer& writer) noexcept
+    {
+        uint8_t index = reader.readU8();
+        if (!reader.isValid() || reader.remaining() != 0)
+        {
+            return Status::BAD_REQUEST;
+        }
+
+        // Entries that fit, counted first: the next index precedes them in the payload
+        uint8_t next = index;
+        size_t payloadSize = DESCRIBE_HEADER_SIZE;
+        while (next < table.size() && payloadSize + describeEntrySize(table[next]) <= MAX_PAYLOAD)
+        {
+            payloadSize += describeEntrySize(table[next]);
+            next++;
+        }
+        if (next == index && index < table.size())
+        {
+            // Entry larger than a payload (table not checked with isValid())
+            return Status::RESPONSE_OVERFLOW;
+        }
+
+        writer.writeU8(table.size());
+        writer.writeU8((next < table.size()) ? next : 0);
+        for (; index < next; index++)
+        {
+            const Method& method = table[index];
+            writer.writeU8(method.id);
+            writer.writeString(method.name);
+            writer.writeString(method.requestSchema);
+            writer.writeString(method.responseSchema);
+        }
+        return Status::OK;
+    }
+
+} // namespace Rpc
@@ -0,0 +1,154 @@
+/**
+ * @file    RpcClient.cpp
+ * @brief   Host side of the binary RPC link
+ * @author  MootSeeker
+ *
+ * @see Rpc.h for the frame format
+ */
+
+#include "RpcClient.h"
+
+namespace Rpc
+{
+    // Offsets inside the received frame (the SYNC byte is not stored)
+    static constexpr uint8_t FRAME_LENGTH = 0;
+    static constexpr uint8_t FRAME_ID = 1;
+    static constexpr uint8_t FRAME_STATUS = 2;
+    static constexpr uint8_t FRAME_PAYLOAD = 3;
+
+    Client::Client(ClientPort& port, Completion completion, void* context) noexcept
+        : port(port), completion(completion), context(context), request(),
+          writer(&request[HEADER_SIZE], MAX_PAYLOAD), nextId(0), outstanding(), inFlight(0), frame(),
+          rxState(RxState::SYNC), rxPosition(0), rxExpected(0), crc(), statistics()
+    {
+    }
+
+    Writer& Client::prepare(uint8_t method) noexcept
+    {
+        request[3] = method;
+        writer = Writer(&request[HEADER_SIZE], MAX_PAYLOAD);
+        return writer;
+    }
+
+    bool Client::send(uint8_t& id) noexcept
+    {
+        if (inFlight >= MAX_IN_FLIGHT || !writer.isValid())
+        {
+            return false;
+        }
+
+        id = nextId;
+        nextId = static_cast<uint8_t>(nextId + 1U);
+
+        const uint8_t payloadLength = writer.size();
+        request[0] = SYNC;
+        request[1] = payloadLength;
+        request[2] = id;
+        const uint16_t crcValue = Crc::Crc16::compute(&request[1], static_cast<uint16_t>(HEADER_SIZE - 1 + payloadLength));
+        request[HEADER_SIZE + payloadLength] = static_cast<uint8_t>(crcValue & 0xFFU);
+        request[HEADER_SIZE + payloadLength + 1] = static_cast<uint8_t>(crcValue >> 8);
+
+        outstanding[inFlight++] = id;
+        port.write(request, static_cast<size_t>(HEADER_SIZE + payloadLength + CRC_SIZE));
+        return true;
+    }
+
+    void Client::receive(const uint8_t* data, size_t length) noexcept
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            receiveByte(data[i]);
+        }
+    }
+
+    void Client::reset() noexcept
+    {
+        statistics.lostCalls += inFlight;
+        inFlight = 0;
+        rxState = RxState::SYNC;
+    }
+
+    /**
+     * @brief Frame assembly, same state machine as the server
+     */
+    void Client::receiveByte(uint8_t data) noexcept
+    {
+        switch (rxState)
+        {
+            case RxState::SYNC:
+                if (data == SYNC)
+                {
+                    crc.reset();
+                    rxState = RxState::LENGTH;
+                }
+                break;
+
+            case RxState::LENGTH:
+                if (data > MAX_PAYLOAD)
+                {
+                    rxState = (data == SYNC) ? RxState::LENGTH : RxState::SYNC;
+                    break;
+                }
+                crc.update(data);
+                frame[FRAME_LENGTH] = data;
+                rxPosition = 1;
+                rxExpected = static_cast<uint16_t>(FRAME_PAYLOAD + data + CRC_SIZE);
+                rxState = RxState::BODY;
+                break;
+
+            case RxState::BODY:
+                crc.update(data);
+                frame[rxPosition++] = data;
+                if (rxPosition < rxExpected)
+                {
+                    break;
+                }
+
+                rxState = RxState::SYNC;
+                if (crc.get() != 0)
+                {
+                    statistics.crcErrors++;
+                }
+                else
+                {
+                    complete();
+                }
+                break;
+        }
+    }
+
+    /**
+     * @brief Match a valid response to its call and run the completion
+     */
+    void Client::complete() noexcept
+    {
+        const uint8_t id = frame[FRAME_ID];
+        uint8_t match = 0;
+        while (match < inFlight && outstanding[match] != id)
+        {
+            match++;
+        }
+        if (match == inFlight)
+        {
+            statistics.unexpectedIds++;
+            return;
+        }
+
+        // Responses come in request order: older calls are gone
+        statistics.lostCalls += match;
+        const uint8_t closed = static_cast<uint8_t>(match + 1U);
+        for (uint8_t i = closed; i < inFlight; i++)
+        {
+            outstanding[i - closed] = outstanding[i];
+        }
+        inFlight = static_cast<uint8_t>(inFlight - closed);
+
+        statistics.responses++;
+        Reader reader(&frame[FRAME_PAYLOAD], frame[FRAME_LENGTH]);
+        if (completion != nullptr)
+        {
+            completion(context, id, static_cast<Status>(frame[FRAME_STATUS]), reader);
+        }
+    }
+
+} // namespace Rpc
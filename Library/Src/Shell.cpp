@@ -0,0 +1,459 @@
+/**
+ * @file    Shell.cpp
+ * @brief   Command shell line editor and dispatcher
+ * @author  MootSeeker
+ *
+ * @see Shell.h for key bindings and the perfect-hash command table
+ */
+
+#include "Shell.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace Shell
+{
+    static constexpr uint8_t KEY_CTRL_A = 0x01;
+    static constexpr uint8_t KEY_CTRL_C = 0x03;
+    static constexpr uint8_t KEY_CTRL_E = 0x05;
+    static constexpr uint8_t KEY_BACKSPACE = 0x08;
+    static constexpr uint8_t KEY_LF = 0x0A;
+    static constexpr uint8_t KEY_CR = 0x0D;
+    static constexpr uint8_t KEY_CTRL_U = 0x15;
+    static constexpr uint8_t KEY_ESCAPE = 0x1B;
+    static constexpr uint8_t KEY_DELETE = 0x7F;
+
+    // ========================================================================
+    // Args
+    // ========================================================================
+
+    /**
+     * @brief Number base of a token: 16 with a 0x prefix, otherwise 10
+     *
+     * strtol() with base 0 would read a leading zero as octal ("010" = 8),
+     * which nobody typing into a console expects.
+     * @param digits Token without its sign
+     */
+    static int numberBase(const char* digits) noexcept
+    {
+        return (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) ? 16 : 10;
+    }
+
+    static bool isDigit(char character) noexcept
+    {
+        return character >= '0' && character <= '9';
+    }
+
+    bool Args::toInt(uint8_t index, int32_t& value) const noexcept
+    {
+        if (index >= count)
+        {
+            return false;
+        }
+        const char* text = tokens[index];
+        const char* digits = (text[0] == '-' || text[0] == '+') ? text + 1 : text;
+        if (!isDigit(digits[0]))
+        {
+            return false;
+        }
+        char* end = nullptr;
+        errno = 0;
+        const long parsed = std::strtol(text, &end, numberBase(digits));
+        if (*end != '\0' || errno == ERANGE || parsed < INT32_MIN || parsed > INT32_MAX)
+        {
+            return false;
+        }
+        value = static_cast<int32_t>(parsed);
+        return true;
+    }
+
+    bool Args::toUnsigned(uint8_t index, uint32_t& value) const noexcept
+    {
+        if (index >= count || !isDigit(tokens[index][0]))
+        {
+            return false;
+        }
+        char* end = nullptr;
+        errno = 0;
+        const unsigned long parsed = std::strtoul(tokens[index], &end, numberBase(tokens[index]));
+        if (*end != '\0' || errno == ERANGE || parsed > UINT32_MAX)
+        {
+            return false;
+        }
+        value = static_cast<uint32_t>(parsed);
+        return true;
+    }
+
+    // ========================================================================
+    // Console
+    // ========================================================================
+
+    Console::Console(USART::StandardUSART& uart, const CommandTable& table, const char* prompt) noexcept
+        : uart(uart), table(table), prompt(prompt), line(), length(0), cursor(0),
+          escape(EscapeState::NONE), escapeParameter(0), lastWasCr(false),
+          history(), historyUsed(0), historyPosition(-1)
+    {
+    }
+
+    void Console::start() noexcept
+    {
+        length = 0;
+        cursor = 0;
+        escape = EscapeState::NONE;
+        historyPosition = -1;
+        uart.sendString("\r\n");
+        uart.sendString(prompt);
+    }
+
+    uint8_t Console::poll() noexcept
+    {
+        uint8_t executed = 0;
+        uint8_t chunk[16];
+        uint16_t received;
+        while ((received = uart.receiveData(chunk, sizeof(chunk))) != 0U)
+        {
+            for (uint16_t i = 0; i < received; i++)
+            {
+                executed = static_cast<uint8_t>(executed + handleByte(chunk[i]));
+            }
+        }
+        return executed;
+    }
+
+    /**
+     * @brief Line editor state machine
+     * @return 1 if a command line was submitted
+     */
+    uint8_t Console::handleByte(uint8_t data) noexcept
+    {
+        const bool crLf = lastWasCr && data == KEY_LF;
+        lastWasCr = (data == KEY_CR);
+
+        if (escape != EscapeState::NONE)
+        {
+            handleEscape(data);
+            return 0;
+        }
+
+        switch (data)
+        {
+            case KEY_CR:
+            case KEY_LF:
+                return crLf ? 0 : submitLine();
+
+            case KEY_BACKSPACE:
+            case KEY_DELETE:
+                if (cursor > 0)
+                {
+                    moveCursor(-1);
+                    erase(cursor);
+                }
+                break;
+
+            case KEY_CTRL_A:
+                moveCursor(static_cast<int16_t>(-cursor));
+                break;
+
+            case KEY_CTRL_E:
+                moveCursor(static_cast<int16_t>(length - cursor));
+                break;
+
+            case KEY_CTRL_C:
+                uart.sendString("^C\r\n");
+                length = 0;
+                cursor = 0;
+                historyPosition = -1;
+                uart.sendString(prompt);
+                break;
+
+            case KEY_CTRL_U:
+                loadLine("");
+                historyPosition = -1;
+                break;
+
+            case KEY_ESCAPE:
+                escape = EscapeState::ESCAPE;
+                break;
+
+            default:
+                if (data >= 0x20U && data < 0x7FU)
+                {
+                    insert(static_cast<char>(data));
+                }
+                break;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief VT100 sequences: ESC [ A/B/C/D/H/F and ESC [ 3 ~
+     */
+    void Console::handleEscape(uint8_t data) noexcept
+    {
+        if (escape == EscapeState::ESCAPE)
+        {
+            escape = (data == '[') ? EscapeState::SEQUENCE : EscapeState::NONE;
+            escapeParameter = 0;
+            return;
+        }
+
+        if (data >= '0' && data <= '9')
+        {
+            escapeParameter = static_cast<uint8_t>(escapeParameter * 10U + (data - '0'));
+            return;
+        }
+
+        escape = EscapeState::NONE;
+        switch (data)
+        {
+            case 'A': recallOlder(); break;
+            case 'B': recallNewer(); break;
+            case 'C': moveCursor((cursor < length) ? 1 : 0); break;
+            case 'D': moveCursor((cursor > 0) ? -1 : 0); break;
+            case 'H': moveCursor(static_cast<int16_t>(-cursor)); break;
+            case 'F': moveCursor(static_cast<int16_t>(length - cursor)); break;
+            case '~':
+                if (escapeParameter == 3U && cursor < length)
+                {
+                    erase(cursor);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    void Console::insert(char character) noexcept
+    {
+        if (length >= LINE_SIZE)
+        {
+            return;
+        }
+        std::memmove(&line[cursor + 1], &line[cursor], length - cursor);
+        line[cursor] = character;
+        length++;
+
+        // Echo the character and the shifted tail, then step back over the tail
+        const uint8_t tail = static_cast<uint8_t>(length - cursor);
+        uart.sendData(reinterpret_cast<const uint8_t*>(&line[cursor]), tail);
+        cursor++;
+        if (tail > 1U)
+        {
+            uart.sendFormatted("\x1b[%uD", static_cast<unsigned>(tail - 1U));
+        }
+    }
+
+    /**
+     * @brief Remove the character at position (cursor already placed there)
+     */
+    void Console::erase(uint8_t position) noexcept
+    {
+        std::memmove(&line[position], &line[position + 1], length - position - 1U);
+        length--;
+
+        // Redraw the tail, blank the old last column, step back
+        const uint8_t tail = static_cast<uint8_t>(length - position);
+        uart.sendData(reinterpret_cast<const uint8_t*>(&line[position]), tail);
+        uart.sendByte(' ');
+        uart.sendFormatted("\x1b[%uD", static_cast<unsigned>(tail + 1U));
+    }
+
+    void Console::moveCursor(int16_t delta) noexcept
+    {
+        if (delta > 0)
+        {
+            uart.sendFormatted("\x1b[%dC", delta);
+        }
+        else if (delta < 0)
+        {
+            uart.sendFormatted("\x1b[%dD", -delta);
+        }
+        cursor = static_cast<uint8_t>(cursor + delta);
+    }
+
+    void Console::redraw() noexcept
+    {
+        uart.sendString("\r\x1b[K");
+        uart.sendString(prompt);
+        uart.sendData(reinterpret_cast<const uint8_t*>(line), length);
+        cursor = length;
+    }
+
+    void Console::loadLine(const char* text) noexcept
+    {
+        const size_t size = std::strlen(text);
+        length = static_cast<uint8_t>((size < LINE_SIZE) ? size : LINE_SIZE);
+        std::memcpy(line, text, length);
+        redraw();
+    }
+
+    uint8_t Console::submitLine() noexcept
+    {
+        uart.sendString("\r\n");
+        line[length] = '\0';
+        historyPosition = -1;
+
+        uint8_t executed = 0;
+        if (length > 0)
+        {
+            addHistory();
+            execute();
+            executed = 1;
+        }
+
+        length = 0;
+        cursor = 0;
+        uart.sendString(prompt);
+        return executed;
+    }
+
+    /**
+     * @brief Tokenize the line in place and dispatch
+     */
+    void Console::execute() noexcept
+    {
+        const char* tokens[MAX_ARGS];
+        uint8_t count = 0;
+        char* position = line;
+
+        while (*position != '\0')
+        {
+            while (*position == ' ')
+            {
+                *position++ = '\0';
+            }
+            if (*position == '\0')
+            {
+                break;
+            }
+            if (count == MAX_ARGS)
+            {
+                uart.sendString("error: too many arguments\r\n");
+                return;
+            }
+
+            const bool quoted = (*position == '"');
+            if (quoted)
+            {
+                position++;
+            }
+            tokens[count++] = position;
+            while (*position != '\0' && *position != (quoted ? '"' : ' '))
+            {
+                position++;
+            }
+            if (*position != '\0')
+            {
+                *position++ = '\0';
+            }
+        }
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        const Args args(tokens, count);
+        const Command* command = table.find(tokens[0], std::strlen(tokens[0]));
+        if (command != nullptr)
+        {
+            command->handler(*this, args, command->context);
+        }
+        else if (std::strcmp(tokens[0], "help") == 0)
+        {
+            listCommands();
+        }
+        else
+        {
+            uart.sendFormatted("unknown command: %s (try help)\r\n", tokens[0]);
+        }
+    }
+
+    void Console::listCommands() noexcept
+    {
+        for (uint16_t i = 0; i < table.size(); i++)
+        {
+            // Wait for room instead of truncating long tables
+            const size_t needed = std::strlen(table[i].help) + 2U;
+            while (uart.getAvailableSpace() < needed && uart.isTransmissionActive())
+            {
+            }
+            uart.sendString(table[i].help);
+            uart.sendString("\r\n");
+        }
+    }
+
+    // ========================================================================
+    // History
+    // ========================================================================
+
+    /**
+     * @brief Append the current line, dropping the oldest lines if needed
+     */
+    void Console::addHistory() noexcept
+    {
+        const uint16_t needed = static_cast<uint16_t>(length + 1U);
+
+        // Skip a repeat of the newest line
+        if (historyUsed > 0)
+        {
+            uint16_t newest = static_cast<uint16_t>(historyUsed - 1U);
+            while (newest > 0 && history[newest - 1U] != '\0')
+            {
+                newest--;
+            }
+            if (std::strcmp(&history[newest], line) == 0)
+            {
+                return;
+            }
+        }
+
+        while (historyUsed + needed > HISTORY_SIZE)
+        {
+            const uint16_t oldest = static_cast<uint16_t>(std::strlen(history) + 1U);
+            std::memmove(history, &history[oldest], historyUsed - oldest);
+            historyUsed = static_cast<uint16_t>(historyUsed - oldest);
+        }
+        std::memcpy(&history[historyUsed], line, needed);
+        historyUsed = static_cast<uint16_t>(historyUsed + needed);
+    }
+
+    void Console::recallOlder() noexcept
+    {
+        if (historyUsed == 0 || historyPosition == 0)
+        {
+            return;
+        }
+
+        // Start of the entry before historyPosition (or of the newest entry)
+        int32_t start = ((historyPosition < 0) ? historyUsed : historyPosition) - 1;
+        while (start > 0 && history[start - 1] != '\0')
+        {
+            start--;
+        }
+        historyPosition = start;
+        loadLine(&history[start]);
+    }
+
+    void Console::recallNewer() noexcept
+    {
+        if (historyPosition < 0)
+        {
+            return;
+        }
+
+        const int32_t next = historyPosition + static_cast<int32_t>(std::strlen(&history[historyPosition])) + 1;
+        if (next >= historyUsed)
+        {
+            historyPosition = -1;
+            loadLine("");
+        }
+        else
+        {
+            historyPosition = next;
+            loadLine(&history[next]);
+        }
+    }
+
+} // namespace Shell
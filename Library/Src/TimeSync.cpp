@@ -0,0 +1,387 @@
+/**
+ * @file    TimeSync.cpp
+ * @brief   Host/device time synchronization implementation
+ * @author  MootSeeker
+ *
+ * @see TimeSync.h for the exchange format and usage
+ */
+
+#include "TimeSync.h"
+
+namespace TimeSync
+{
+    static void putU64(uint8_t* out, int64_t value) noexcept
+    {
+        const uint64_t bits = static_cast<uint64_t>(value);
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            out[i] = static_cast<uint8_t>(bits >> (8U * i));
+        }
+    }
+
+    static int64_t getU64(const uint8_t* in) noexcept
+    {
+        uint64_t bits = 0;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            bits |= static_cast<uint64_t>(in[i]) << (8U * i);
+        }
+        return static_cast<int64_t>(bits);
+    }
+
+    static void putCrc(uint8_t* frame, uint16_t length) noexcept
+    {
+        const uint16_t crcValue = Crc::Crc16::compute(frame, length);
+        frame[length] = static_cast<uint8_t>(crcValue & 0xFFU);
+        frame[length + 1] = static_cast<uint8_t>(crcValue >> 8);
+    }
+
+    // ========================================================================
+    // ClockModel
+    // ========================================================================
+
+    ClockModel::ClockModel() noexcept
+    {
+        reset();
+    }
+
+    void ClockModel::reset() noexcept
+    {
+        referenceDevice = 0;
+        referenceHost = 0;
+        minRoundTripUs = -1;
+        lastErrorUs = 0;
+        driftPpb = 0;
+        head = 0;
+        count = 0;
+        rejected = 0;
+    }
+
+    int64_t ClockModel::toHost(int64_t deviceUs) const noexcept
+    {
+        const int64_t elapsed = deviceUs - referenceDevice;
+        return referenceHost + elapsed + (elapsed * driftPpb) / 1000000000LL;
+    }
+
+    /**
+     * @brief Outlier gate, then refit offset and drift
+     *
+     * The minimum round trip relaxes by ~0.4 % per exchange so a permanently
+     * slower path (e.g. another USB hub) is accepted again after a while.
+     */
+    bool ClockModel::addExchange(const Exchange& exchange) noexcept
+    {
+        const int64_t roundTrip = (exchange.t4 - exchange.t1) - (exchange.t3 - exchange.t2);
+        if (roundTrip < 0 || exchange.t3 < exchange.t2)
+        {
+            rejected++;
+            return false;
+        }
+
+        if (minRoundTripUs < 0 || roundTrip < minRoundTripUs)
+        {
+            minRoundTripUs = roundTrip;
+        }
+        else
+        {
+            minRoundTripUs += (minRoundTripUs >> 8) + 1;
+        }
+        if (roundTrip > minRoundTripUs + (minRoundTripUs >> 2) + ROUND_TRIP_MARGIN_US)
+        {
+            rejected++;
+            return false;
+        }
+
+        // Offset at the exchange midpoint, assuming symmetric delays
+        const int64_t deviceMid = (exchange.t1 + exchange.t4) / 2;
+        const int64_t hostMid = (exchange.t2 + exchange.t3) / 2;
+
+        if (count != 0)
+        {
+            lastErrorUs = hostMid - toHost(deviceMid);
+            const int64_t newest = points[(head + WINDOW_SIZE - 1U) % WINDOW_SIZE].deviceUs;
+            if (lastErrorUs > STEP_THRESHOLD_US || lastErrorUs < -STEP_THRESHOLD_US || deviceMid <= newest)
+            {
+                // Host clock stepped or device restarted: start over from this exchange
+                head = 0;
+                count = 0;
+                driftPpb = 0;
+            }
+        }
+
+        points[head].deviceUs = deviceMid;
+        points[head].offsetUs = hostMid - deviceMid;
+        head = static_cast<uint8_t>((head + 1U) % WINDOW_SIZE);
+        if (count < WINDOW_SIZE)
+        {
+            count++;
+        }
+        fit();
+        return true;
+    }
+
+    /**
+     * @brief Least-squares line through the window: offset = a + drift * (device - mean)
+     *
+     * Runs once per accepted exchange in poll() context, so double precision
+     * (software on the M4) costs only a few microseconds per second.
+     */
+    void ClockModel::fit() noexcept
+    {
+        const Point& newest = points[(head + WINDOW_SIZE - 1U) % WINDOW_SIZE];
+        double meanX = 0.0;
+        double meanY = 0.0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            meanX += static_cast<double>(points[i].deviceUs - newest.deviceUs);
+            meanY += static_cast<double>(points[i].offsetUs - newest.offsetUs);
+        }
+        meanX /= count;
+        meanY /= count;
+
+        double sxx = 0.0;
+        double sxy = 0.0;
+        int64_t oldest = newest.deviceUs;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            const double dx = static_cast<double>(points[i].deviceUs - newest.deviceUs) - meanX;
+            const double dy = static_cast<double>(points[i].offsetUs - newest.offsetUs) - meanY;
+            sxx += dx * dx;
+            sxy += dx * dy;
+            if (points[i].deviceUs < oldest)
+            {
+                oldest = points[i].deviceUs;
+            }
+        }
+
+        if (newest.deviceUs - oldest >= MIN_DRIFT_INTERVAL_US)
+        {
+            double drift = (sxy / sxx) * 1e9;
+            if (drift > MAX_DRIFT_PPB)
+            {
+                drift = MAX_DRIFT_PPB;
+            }
+            else if (drift < -MAX_DRIFT_PPB)
+            {
+                drift = -MAX_DRIFT_PPB;
+            }
+            driftPpb = static_cast<int32_t>(drift);
+        }
+
+        referenceDevice = newest.deviceUs + static_cast<int64_t>(meanX);
+        referenceHost = referenceDevice + newest.offsetUs + static_cast<int64_t>(meanY);
+    }
+
+    // ========================================================================
+    // Responder (host side)
+    // ========================================================================
+
+    Responder::Responder() noexcept : frame(), length(0), sequence(0), requestTime(0)
+    {
+    }
+
+    bool Responder::receiveByte(uint8_t data, int64_t hostUs) noexcept
+    {
+        if (length == 0 && data != REQUEST_MARKER)
+        {
+            return false;
+        }
+        frame[length++] = data;
+        if (length < REQUEST_SIZE)
+        {
+            return false;
+        }
+
+        length = 0;
+        if (Crc::Crc16::compute(frame, REQUEST_SIZE) != 0)
+        {
+            return false;
+        }
+        sequence = frame[1];
+        requestTime = hostUs;
+        return true;
+    }
+
+    void Responder::buildReply(uint8_t* out, int64_t t3) const noexcept
+    {
+        out[0] = REPLY_MARKER;
+        out[1] = sequence;
+        putU64(&out[2], requestTime);
+        putU64(&out[10], t3);
+        putCrc(out, REPLY_SIZE - 2);
+    }
+
+    // ========================================================================
+    // Client (device side)
+    // ========================================================================
+
+    Client::Client(USART::StandardUSART& uart, uint32_t baudRate) noexcept
+        : uart(uart), model(),
+          characterCycles((SystemCoreClock / baudRate) * 10U),
+          cyclesPerUs(SystemCoreClock / 1000000U), intervalUs(0),
+          cycleTotal(0), lastCycles(0), lastRequestUs(0),
+          pending(false), t1Captured(false), replyReady(false), t1Cycles(0), t4Cycles(0),
+          sequence(0), reply(), replyLength(0), timeouts(0)
+    {
+    }
+
+    void Client::start(uint32_t intervalMs) noexcept
+    {
+        // Free-running; other users of CYCCNT (benchmarks) are not disturbed
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        cycleTotal = 0;
+        lastCycles = DWT->CYCCNT;
+        intervalUs = intervalMs * 1000U;
+        lastRequestUs = -static_cast<int64_t>(intervalUs);   // First exchange on the next poll()
+        pending = false;
+        replyReady = false;
+        replyLength = 0;
+        model.reset();
+
+        uart.setRxCallback(&Client::onRxByte, this);
+        uart.setTxCompleteCallback(&Client::onTxComplete, this);
+    }
+
+    void Client::stop() noexcept
+    {
+        uart.setRxCallback(nullptr, nullptr);
+        uart.setTxCompleteCallback(nullptr, nullptr);
+        pending = false;
+    }
+
+    void Client::onRxByte(void* context, uint8_t data)
+    {
+        static_cast<Client*>(context)->receiveByte(data);
+    }
+
+    /**
+     * @brief TC interrupt: the last stop bit of the request has left the pin
+     */
+    void Client::onTxComplete(void* context)
+    {
+        Client* self = static_cast<Client*>(context);
+        if (self->pending && !self->t1Captured)
+        {
+            self->t1Cycles = DWT->CYCCNT;
+            self->t1Captured = true;
+        }
+    }
+
+    /**
+     * @brief Reply assembly, runs in the RX interrupt
+     *
+     * The first byte is timestamped and moved back by one character time
+     * to the start of its start bit; validation is left to poll().
+     */
+    void Client::receiveByte(uint8_t data) noexcept
+    {
+        if (!pending || replyReady)
+        {
+            return;
+        }
+        if (replyLength == 0)
+        {
+            if (data != REPLY_MARKER)
+            {
+                return;
+            }
+            t4Cycles = DWT->CYCCNT - characterCycles;
+        }
+        reply[replyLength++] = data;
+        if (replyLength == REPLY_SIZE)
+        {
+            replyReady = true;
+        }
+    }
+
+    uint64_t Client::extendCycles(uint32_t raw) noexcept
+    {
+        const uint32_t now = DWT->CYCCNT;
+        cycleTotal += static_cast<uint32_t>(now - lastCycles);
+        lastCycles = now;
+        // raw lies in the past, less than one counter period ago
+        return cycleTotal - static_cast<uint32_t>(now - raw);
+    }
+
+    int64_t Client::deviceTimeUs() noexcept
+    {
+        return static_cast<int64_t>(extendCycles(DWT->CYCCNT) / cyclesPerUs);
+    }
+
+    int64_t Client::hostTimeUs() noexcept
+    {
+        return model.toHost(deviceTimeUs());
+    }
+
+    bool Client::requestSync() noexcept
+    {
+        // t1 is taken when the TX queue drains, so the request must be last in it
+        if (pending || uart.isTransmissionActive() || uart.getQueueSize() != 0)
+        {
+            return false;
+        }
+
+        uint8_t request[REQUEST_SIZE];
+        sequence = static_cast<uint8_t>(sequence + 1U);
+        request[0] = REQUEST_MARKER;
+        request[1] = sequence;
+        putCrc(request, REQUEST_SIZE - 2);
+
+        replyLength = 0;
+        replyReady = false;
+        t1Captured = false;
+        lastRequestUs = deviceTimeUs();
+        pending = true;
+
+        if (uart.sendData(request, REQUEST_SIZE) != REQUEST_SIZE)
+        {
+            pending = false;
+            return false;
+        }
+        return true;
+    }
+
+    void Client::processReply() noexcept
+    {
+        const bool valid = t1Captured &&
+                           reply[1] == sequence &&
+                           Crc::Crc16::compute(reply, REPLY_SIZE) == 0;
+        if (valid)
+        {
+            Exchange exchange;
+            exchange.t1 = static_cast<int64_t>(extendCycles(t1Cycles) / cyclesPerUs);
+            exchange.t2 = getU64(&reply[2]);
+            exchange.t3 = getU64(&reply[10]);
+            exchange.t4 = static_cast<int64_t>(extendCycles(t4Cycles) / cyclesPerUs);
+            model.addExchange(exchange);
+        }
+
+        pending = false;
+        replyLength = 0;
+        replyReady = false;
+    }
+
+    void Client::poll() noexcept
+    {
+        const int64_t now = deviceTimeUs();
+
+        if (replyReady)
+        {
+            processReply();
+        }
+        else if (pending && (now - lastRequestUs) > static_cast<int64_t>(REPLY_TIMEOUT_US))
+        {
+            pending = false;
+            replyLength = 0;
+            timeouts++;
+        }
+
+        if (intervalUs != 0 && !pending && (now - lastRequestUs) >= static_cast<int64_t>(intervalUs))
+        {
+            (void)requestSync();
+        }
+    }
+
+} // namespace TimeSync
@@ -28,15 +28,27 @@
 extern "C" {
 #endif
 
-// Forward declaration for C++ USART interrupt handler
+// Forward declaration for C++ USART interrupt handlers
 void USART_HandleLpuart1Interrupt(void);
+void USART_HandleRxTimeoutTimerInterrupt(void);
+void USART_HandleUsart1Interrupt(void);
+void USART_HandleUsart2Interrupt(void);
+void USART_HandleUsart3Interrupt(void);
+void USART_HandleDmaInterrupt(DMA_TypeDef* dma, uint32_t channel);
+void LIN_HandleScheduleTimerInterrupt(void);
+void USART_HandleSoftUartTimerInterrupt(void);
+void DEBOUNCE_HandleSampleTimerInterrupt(void);
+void GPIO_HandlePatternDmaInterrupt(void);
+void LOGIC_CAPTURE_HandleDmaInterrupt(void);
+void KEYPAD_HandleDmaInterrupt(void);
 
 #ifdef __cplusplus
 }
 #endif
 
-// Forward declaration for C++ GPIO interrupt handler
+// Forward declaration for C++ GPIO interrupt handlers
 extern void GPIO_EXTI_HandleInterrupt(uint32_t pin);
+extern void GPIO_EXTI_HandleLines(uint32_t lineMask);
 
 #ifdef __cplusplus
 }
@@ -306,7 +318,12 @@ void TIM7_IRQHandler(void)
 
   /* USER CODE END TIM7_IRQn 0 */
   /* USER CODE BEGIN TIM7_IRQn 1 */
-
+  // TIM7 emulates the LPUART1 receiver timeout (end-of-frame detection)
+  if (LL_TIM_IsActiveFlag_UPDATE(TIM7) != 0)
+  {
+    LL_TIM_ClearFlag_UPDATE(TIM7);
+    USART_HandleRxTimeoutTimerInterrupt();
+  }
   /* USER CODE END TIM7_IRQn 1 */
 }
 
@@ -325,4 +342,123 @@ void LPUART1_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief USART1..3 global interrupts (RX, TX, idle line for the DMA bridge).
+  */
+void USART1_IRQHandler(void)
+{
+  USART_HandleUsart1Interrupt();
+}
+
+void USART2_IRQHandler(void)
+{
+  USART_HandleUsart2Interrupt();
+}
+
+void USART3_IRQHandler(void)
+{
+  USART_HandleUsart3Interrupt();
+}
+
+/**
+  * @brief DMA channels used by the USART DMA bridge (see usart_bridge.h).
+  */
+void DMA1_Channel2_IRQHandler(void)
+{
+  USART_HandleDmaInterrupt(DMA1, 2U);
+}
+
+/**
+  * @brief DMA1 channel 3 is shared with the keypad scanner (TIM1 compare 2,
+  *        see Keypad.h); it takes its flags first while it is scanning.
+  */
+void DMA1_Channel3_IRQHandler(void)
+{
+  KEYPAD_HandleDmaInterrupt();
+  USART_HandleDmaInterrupt(DMA1, 3U);
+}
+
+void DMA1_Channel4_IRQHandler(void)
+{
+  USART_HandleDmaInterrupt(DMA1, 4U);
+}
+
+/**
+  * @brief DMA1 channel 5 is shared with the GPIO pattern player (TIM15 update,
+  *        see gpio_wave.h); it takes its flags first while it is playing.
+  */
+void DMA1_Channel5_IRQHandler(void)
+{
+  GPIO_HandlePatternDmaInterrupt();
+  USART_HandleDmaInterrupt(DMA1, 5U);
+}
+
+/**
+  * @brief DMA1 channel 6 is shared with the logic-analyzer capture (TIM1 update,
+  *        see LogicCapture.h); it takes its flags first while it is sampling.
+  */
+void DMA1_Channel6_IRQHandler(void)
+{
+  LOGIC_CAPTURE_HandleDmaInterrupt();
+  USART_HandleDmaInterrupt(DMA1, 6U);
+}
+
+void DMA1_Channel7_IRQHandler(void)
+{
+  USART_HandleDmaInterrupt(DMA1, 7U);
+}
+
+void DMA2_Channel6_IRQHandler(void)
+{
+  USART_HandleDmaInterrupt(DMA2, 6U);
+}
+
+void DMA2_Channel7_IRQHandler(void)
+{
+  USART_HandleDmaInterrupt(DMA2, 7U);
+}
+
+/**
+  * @brief TIM6 update: LIN master schedule slot boundary (see Lin.h).
+  */
+void TIM6_DAC_IRQHandler(void)
+{
+  LIN_HandleScheduleTimerInterrupt();
+}
+
+/**
+  * @brief EXTI line 4 and the shared EXTI vectors: every pending line is
+  *        cleared and dispatched by GPIOEXTI::handleLines (see gpio.h).
+  */
+void EXTI4_IRQHandler(void)
+{
+  GPIO_EXTI_HandleLines(0x00000010U);
+}
+
+void EXTI9_5_IRQHandler(void)
+{
+  GPIO_EXTI_HandleLines(0x000003E0U);
+}
+
+void EXTI15_10_IRQHandler(void)
+{
+  GPIO_EXTI_HandleLines(0x0000FC00U);
+}
+
+/**
+  * @brief TIM2 compare: software UART bit events (see soft_uart.h).
+  */
+void TIM2_IRQHandler(void)
+{
+  USART_HandleSoftUartTimerInterrupt();
+}
+
+/**
+  * @brief TIM16 update: debounce sample of the input panel (see Debounce.h).
+  */
+void TIM1_UP_TIM16_IRQHandler(void)
+{
+  DEBOUNCE_HandleSampleTimerInterrupt();
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,208 @@
+/**
+ * @file    AddressMuteTest.cpp
+ * @brief   Multi-drop bus: address-mark framing, mute configuration, RX load per node (usart.h Pattern 10)
+ * @author  MootSeeker
+ *
+ * The master frames come from sendAddressedFrame() on the emulated USART_1.
+ * The mute mode itself is hardware, so MuteFilter applies the reference
+ * manual rule to the bus words: a mark with the node address wakes the
+ * receiver, any other mark mutes it. Only words that pass are queued on
+ * the node's USART, and every one of them is an RX interrupt there.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "usart.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr uint8_t NODE_COUNT = 16;
+    constexpr uint8_t PAYLOAD_SIZE = 8;
+
+    USART::Config nineBitConfig()
+    {
+        USART::Config config = USART::getDefaultUsartConfig();
+        config.wordLength = USART_CR1_M0;
+        return config;
+    }
+
+    void testMasterFraming()
+    {
+        HostMcu::reset();
+        USART::StandardUSART master(USART::PeripheralType::USART_1);
+        CHECK(master.initialize(nineBitConfig()).isSuccess());
+        UsartModel<USART::StandardUSART> wire(master);
+
+        const uint8_t payload[3] = {0x11, 0xFF, 0x80};
+        CHECK(master.sendAddressedFrame(0x05, payload, sizeof(payload)));
+        CHECK(!master.sendAddressedFrame(0x06, payload, sizeof(payload)));   // Queue not idle
+        wire.run();
+        CHECK(wire.getTransmitted() == std::vector<uint16_t>({0x105, 0x11, 0xFF, 0x80}));
+        CHECK(master.sendAddressedFrame(0xFF, nullptr, 0));   // Mark only
+        wire.run();
+        CHECK_EQ(wire.getTransmitted().back(), 0x1FF);
+        CHECK(!master.sendAddressedFrame(0x01, nullptr, 1));
+
+        // 8-bit words: the mark is bit 7, addresses stop at 0x7F
+        HostMcu::reset();
+        USART::StandardUSART narrow(USART::PeripheralType::USART_1);
+        CHECK(narrow.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        UsartModel<USART::StandardUSART> narrowWire(narrow);
+        CHECK(!narrow.sendAddressedFrame(0x80, payload, 1));
+        CHECK(narrow.sendAddressedFrame(0x05, payload, 1));
+        narrowWire.run();
+        CHECK(narrowWire.getTransmitted() == std::vector<uint16_t>({0x85, 0x11}));
+    }
+
+    void testMuteConfiguration()
+    {
+        HostMcu::reset();
+        USART::StandardUSART node(USART::PeripheralType::USART_2);
+        CHECK(node.initialize(nineBitConfig()).isSuccess());
+
+        CHECK_EQ(node.enableAddressMute({0x10, false}).error, USART::UsartError::INVALID_PARAMETER);
+        CHECK_EQ(node.enableAddressMute({0x80, true}).error, USART::UsartError::INVALID_PARAMETER);
+        CHECK_EQ(node.enableAddressMute({0x45, true}).error, USART::UsartError::OK);
+
+        USART_TypeDef* const usart = node.getInstance();
+        CHECK_EQ((usart->CR2 & USART_CR2_ADD_Msk) >> USART_CR2_ADD_Pos, 0x45);
+        CHECK((usart->CR2 & USART_CR2_ADDM7) != 0U);
+        CHECK((usart->CR1 & (USART_CR1_WAKE | USART_CR1_MME | USART_CR1_UE)) ==
+              (USART_CR1_WAKE | USART_CR1_MME | USART_CR1_UE));
+        CHECK((usart->RQR & USART_RQR_MMRQ) != 0U);   // Starts muted
+
+        node.disableAddressMute();
+        CHECK((usart->CR1 & (USART_CR1_WAKE | USART_CR1_MME)) == 0U);
+        CHECK((usart->CR1 & USART_CR1_UE) != 0U);
+
+        // 7-bit words carry no mark bit
+        HostMcu::reset();
+        USART::StandardUSART sevenBit(USART::PeripheralType::USART_2);
+        USART::Config config = USART::getDefaultUsartConfig();
+        config.wordLength = USART_CR1_M1;
+        CHECK(sevenBit.initialize(config).isSuccess());
+        CHECK_EQ(sevenBit.enableAddressMute({0x05, false}).error, USART::UsartError::INVALID_PARAMETER);
+    }
+
+    /// Reference manual mute rule for one node (9-bit words, 4-bit address)
+    class MuteFilter
+    {
+    public:
+        MuteFilter(uint8_t address, bool enabled) : address(address), enabled(enabled) {}
+
+        /// @return true if the word reaches RDR
+        bool pass(uint16_t word)
+        {
+            if (!enabled)
+            {
+                return true;
+            }
+            if ((word & 0x100U) != 0U)
+            {
+                muted = (word & 0x0FU) != address;
+            }
+            return !muted;
+        }
+
+    private:
+        uint8_t address;
+        bool enabled;
+        bool muted = true;
+    };
+
+    /**
+     * @brief Bus words of a frame sequence, sent by the master driver
+     * @param share0 Every share0-th frame goes to node 0, the rest round-robin to 1..15 (0: all round-robin)
+     */
+    std::vector<uint16_t> busTraffic(size_t frames, size_t share0)
+    {
+        HostMcu::reset();
+        USART::StandardUSART master(USART::PeripheralType::USART_1);
+        CHECK(master.initialize(nineBitConfig()).isSuccess());
+        UsartModel<USART::StandardUSART> wire(master);
+
+        const uint8_t payload[PAYLOAD_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8};
+        uint8_t next = 0;
+        for (size_t i = 0; i < frames; i++)
+        {
+            uint8_t address = 0;
+            if (share0 == 0)
+            {
+                address = static_cast<uint8_t>(i % NODE_COUNT);
+            }
+            else if (i % share0 != 0)
+            {
+                address = static_cast<uint8_t>(1U + next);
+                next = static_cast<uint8_t>((next + 1U) % (NODE_COUNT - 1U));
+            }
+            CHECK(master.sendAddressedFrame(address, payload, sizeof(payload)));
+            wire.run();
+        }
+        return wire.getTransmitted();
+    }
+
+    /// RX interrupts on one node's USART for the given bus traffic
+    size_t rxInterrupts(const std::vector<uint16_t>& bus, uint8_t address, bool mute)
+    {
+        HostMcu::reset();
+        USART::StandardUSART node(USART::PeripheralType::USART_2);
+        CHECK(node.initialize(nineBitConfig()).isSuccess());
+        if (mute)
+        {
+            CHECK(node.enableAddressMute({address, false}).isSuccess());
+        }
+        UsartModel<USART::StandardUSART> wire(node);
+
+        MuteFilter filter(address, mute);
+        size_t received = 0;
+        for (uint16_t word : bus)
+        {
+            if (filter.pass(word))
+            {
+                wire.queueReceive(static_cast<uint8_t>(word));
+                wire.run();
+                uint8_t data = 0;
+                while (node.receiveByte(data))
+                {
+                    received++;
+                }
+            }
+        }
+        return received;
+    }
+
+    void testInterruptLoad()
+    {
+        // Uniform: 16000 frames, 1000 per node
+        const std::vector<uint16_t> uniform = busTraffic(16000, 0);
+        CHECK_EQ(uniform.size(), 16000U * (1U + PAYLOAD_SIZE));
+        const size_t unmuted = rxInterrupts(uniform, 5, false);
+        const size_t muted = rxInterrupts(uniform, 5, true);
+        CHECK_EQ(unmuted, 144000);
+        CHECK_EQ(muted, 9000);
+
+        // Node 0 receives every other frame: 30000 frames, 15000 to node 0, 1000 to each other node
+        const std::vector<uint16_t> skewed = busTraffic(30000, 2);
+        const size_t busy = rxInterrupts(skewed, 0, true);
+        const size_t quiet = rxInterrupts(skewed, 7, true);
+        CHECK_EQ(busy, 135000);
+        CHECK_EQ(quiet, 9000);
+
+        std::printf("RX interrupts per node per 1000 bus frames: without mute %.0f, with mute %.1f, "
+                    "50 %% node %.0f / others %.0f\n",
+                    unmuted / 16.0, muted / 16.0, busy / 30.0, quiet / 30.0);
+    }
+}
+
+int main()
+{
+    testMasterFraming();
+    testMuteConfiguration();
+    testInterruptLoad();
+    return Check::result();
+}
@@ -0,0 +1,252 @@
+/**
+ * @file    BaudSwitchTest.cpp
+ * @brief   setBaudRate() after interrupt-driven TC, and the BaudSwitch switch-over/fallback simulation
+ * @author  MootSeeker
+ *
+ * The simulation connects the device side (Shell console with the `baud`
+ * command and a Negotiator on the emulated LPUART_1) to BaudSwitch::Host in
+ * 1 ms ticks. A byte only arrives when both ends run at the same rate;
+ * otherwise it is lost, as a framing error would drop it. It covers:
+ * - a switch that locks on both ends
+ * - a host adapter that cannot follow: the confirmation is lost, the device
+ *   falls back after CONFIRM_TIMEOUT_MS and the host after LOCK_TIMEOUT_MS,
+ *   and a later negotiation succeeds
+ * - a rate the kernel clock cannot produce (nak with the device maximum)
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "BaudSwitch.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    // ========================================================================
+    // setBaudRate() and TC
+    // ========================================================================
+
+    uint32_t txCompletions = 0;
+
+    void onTxComplete(void*)
+    {
+        txCompletions++;
+    }
+
+    /// The TC interrupt consumed the flag: the switch must not wait for it again
+    void testTcConsumedByInterrupt()
+    {
+        HostMcu::reset();
+        USART::StandardUSART uart(USART::PeripheralType::LPUART_1);
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        UsartModel<USART::StandardUSART> wire(uart);
+        uart.setTxCompleteCallback(onTxComplete, nullptr);
+
+        uart.sendString("ping\r\n");
+        CHECK_EQ(uart.setBaudRate(2000000).error, USART::UsartError::BUSY);
+        wire.run();
+        CHECK_EQ(txCompletions, 1);
+        CHECK((uart.getInstance()->ISR & USART_ISR_TC) == 0U);
+
+        CHECK_EQ(uart.setBaudRate(2000000).error, USART::UsartError::OK);
+        CHECK_EQ(uart.getBaudRate(), 2000000);
+        CHECK_EQ(uart.getInstance()->BRR, 256ULL * 32000000U / 2000000U);
+        CHECK((uart.getInstance()->CR1 & USART_CR1_UE) != 0U);
+        uart.setTxCompleteCallback(nullptr, nullptr);
+    }
+
+    /// TC cleared outside the driver: the wait is bounded
+    void testTcWaitBounded()
+    {
+        HostMcu::reset();
+        USART::StandardUSART uart(USART::PeripheralType::USART_2);
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        UsartModel<USART::StandardUSART> wire(uart);
+        wire.run();
+
+        uart.getInstance()->ISR = uart.getInstance()->ISR & ~USART_ISR_TC;
+        CHECK_EQ(uart.setBaudRate(4000000).error, USART::UsartError::OK);
+        CHECK((uart.getInstance()->CR1 & (USART_CR1_UE | USART_CR1_OVER8)) == (USART_CR1_UE | USART_CR1_OVER8));
+    }
+
+    // ========================================================================
+    // Handshake simulation
+    // ========================================================================
+
+    /// Host serial port; `maxRate` models an adapter that silently ignores faster rates
+    class SimulatedPort : public BaudSwitch::HostPort
+    {
+    public:
+        uint32_t rate = 115200;
+        uint32_t maxRate = 0xFFFFFFFFU;
+        std::string pending;
+
+        void write(const char* text) override { pending += text; }
+
+        void setBaudRate(uint32_t baudRate) override
+        {
+            if (baudRate <= maxRate)
+            {
+                rate = baudRate;
+            }
+        }
+    };
+
+    class Link
+    {
+    public:
+        Link()
+            : uart(USART::PeripheralType::LPUART_1), negotiator(uart),
+              commands{{"baud", "baud [confirm] <rate>", BaudSwitch::Negotiator::shellCommand, &negotiator}},
+              index(Shell::buildIndex(commands)), table(commands, index), console(uart, table),
+              host(port, 115200)
+        {
+        }
+
+        void start()
+        {
+            CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+            wire = new UsartModel<USART::StandardUSART>(uart);
+            console.start();
+            wire->run();
+            wire->takeTransmitted();
+        }
+
+        /// One millisecond on both ends
+        void tick()
+        {
+            now++;
+            if (!port.pending.empty())
+            {
+                if (port.rate == uart.getBaudRate())
+                {
+                    wire->queueReceive(reinterpret_cast<const uint8_t*>(port.pending.data()), port.pending.size());
+                }
+                port.pending.clear();
+            }
+            wire->run();
+            console.poll();
+            negotiator.poll(now);
+            wire->run();
+
+            const std::vector<uint8_t> bytes = wire->takeTransmitted();
+            if (port.rate == uart.getBaudRate())
+            {
+                for (uint8_t byte : bytes)
+                {
+                    if (byte == '\r' || byte == '\n')
+                    {
+                        if (!line.empty())
+                        {
+                            host.receiveLine(line.c_str(), now);
+                        }
+                        line.clear();
+                    }
+                    else
+                    {
+                        line.push_back(static_cast<char>(byte));
+                    }
+                }
+            }
+            host.poll(now);
+        }
+
+        /// Run until the host is done; returns the elapsed milliseconds
+        uint32_t negotiate(uint32_t rate)
+        {
+            const uint32_t start = now;
+            CHECK(host.begin(rate, now));
+            while (host.getState() != BaudSwitch::Host::State::LOCKED &&
+                   host.getState() != BaudSwitch::Host::State::FAILED && now - start < 5000U)
+            {
+                tick();
+            }
+            // Let the device finish its own timeout
+            for (uint32_t i = 0; i < BaudSwitch::CONFIRM_TIMEOUT_MS; i++)
+            {
+                tick();
+            }
+            return now - start;
+        }
+
+        USART::StandardUSART uart;
+        BaudSwitch::Negotiator negotiator;
+        Shell::Command commands[1];
+        Shell::CommandIndex<1> index;
+        Shell::CommandTable table;
+        Shell::Console console;
+        SimulatedPort port;
+        BaudSwitch::Host host;
+        UsartModel<USART::StandardUSART>* wire = nullptr;
+        std::string line;
+        uint32_t now = 1000;
+    };
+
+    void testSwitchOver()
+    {
+        HostMcu::reset();
+        static Link link;
+        link.start();
+
+        link.negotiate(2000000);
+        CHECK(link.host.getState() == BaudSwitch::Host::State::LOCKED);
+        CHECK_EQ(link.host.getBaudRate(), 2000000);
+        CHECK_EQ(link.port.rate, 2000000);
+        CHECK_EQ(link.uart.getBaudRate(), 2000000);
+        CHECK(link.negotiator.getState() == BaudSwitch::Negotiator::State::IDLE);
+        CHECK_EQ(link.negotiator.getFallbackCount(), 0);
+
+        // And back to the boot rate with the same handshake
+        link.negotiate(115200);
+        CHECK(link.host.getState() == BaudSwitch::Host::State::LOCKED);
+        CHECK_EQ(link.uart.getBaudRate(), 115200);
+    }
+
+    void testFallback()
+    {
+        HostMcu::reset();
+        static Link link;
+        link.start();
+        link.port.maxRate = 1000000;
+
+        link.negotiate(2000000);
+        CHECK(link.host.getState() == BaudSwitch::Host::State::FAILED);
+        CHECK_EQ(link.host.getBaudRate(), 115200);
+        CHECK_EQ(link.port.rate, 115200);
+        CHECK_EQ(link.uart.getBaudRate(), 115200);
+        CHECK_EQ(link.negotiator.getFallbackCount(), 1);
+        CHECK(link.negotiator.getState() == BaudSwitch::Negotiator::State::IDLE);
+
+        // Both ends are back in step: a rate the adapter supports locks
+        link.negotiate(1000000);
+        CHECK(link.host.getState() == BaudSwitch::Host::State::LOCKED);
+        CHECK_EQ(link.uart.getBaudRate(), 1000000);
+        CHECK_EQ(link.port.rate, 1000000);
+    }
+
+    void testUnsupportedRate()
+    {
+        HostMcu::reset();
+        static Link link;
+        link.start();
+
+        link.negotiate(20000000);
+        CHECK(link.host.getState() == BaudSwitch::Host::State::FAILED);
+        CHECK_EQ(link.host.getDeviceMaxRate(), link.uart.getMaxBaudRate());
+        CHECK_EQ(link.uart.getBaudRate(), 115200);
+        CHECK_EQ(link.negotiator.getFallbackCount(), 0);
+    }
+}
+
+int main()
+{
+    testTcConsumedByInterrupt();
+    testTcWaitBounded();
+    testSwitchOver();
+    testFallback();
+    testUnsupportedRate();
+    return Check::result();
+}
@@ -0,0 +1,182 @@
+/**
+ * @file    CompressionTest.cpp
+ * @brief   Delta/XOR + LZSS pipeline on synthetic sensor traces: lossless round trip, ratio, encode time
+ * @author  MootSeeker
+ *
+ * The traces are generated from a fixed seed, so the compressed sizes are
+ * exact and are the figures quoted in Compression.h. The encode time per
+ * input byte is measured on the host and only printed.
+ */
+
+#include "Check.h"
+
+#include "Compression.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    /// xorshift32, deterministic noise for the traces
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    class VectorSink
+    {
+    public:
+        explicit VectorSink(std::vector<uint8_t>& bytes) : bytes(bytes) {}
+
+        bool put(uint8_t value)
+        {
+            bytes.push_back(value);
+            return true;
+        }
+
+        [[nodiscard]] uint16_t size() const { return static_cast<uint16_t>(bytes.size()); }
+
+    private:
+        std::vector<uint8_t>& bytes;
+    };
+
+    struct Result
+    {
+        size_t raw;
+        size_t compressed;
+        double encodeNsPerByte;
+    };
+
+    /**
+     * @brief Compress a trace frame by frame (2-byte length prefix per frame as on the link)
+     *        and check that every frame decodes back to its samples
+     */
+    template<typename T, uint8_t CHANNELS>
+    Result run(const std::vector<T>& trace, size_t samplesPerFrame)
+    {
+        using Pipeline = Compression::Pipeline<T, CHANNELS, VectorSink>;
+        static std::vector<uint8_t> frame;
+        static VectorSink sink(frame);
+        static Pipeline pipeline(sink);
+
+        const size_t sampleCount = trace.size() / CHANNELS;
+        std::vector<std::vector<uint8_t>> frames;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t first = 0; first < sampleCount; first += samplesPerFrame)
+        {
+            frame.clear();
+            frame.reserve(1024);
+            for (size_t i = first; i < first + samplesPerFrame && i < sampleCount; i++)
+            {
+                T sample[CHANNELS];
+                for (uint8_t channel = 0; channel < CHANNELS; channel++)
+                {
+                    sample[channel] = trace[i * CHANNELS + channel];
+                }
+                pipeline.pushSample(sample);
+            }
+            CHECK(pipeline.flushFrame() == frame.size());
+            frames.push_back(frame);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Result result{trace.size() * sizeof(T), 0, seconds * 1e9 / static_cast<double>(trace.size() * sizeof(T))};
+        size_t decoded = 0;
+        bool lossless = true;
+        for (const std::vector<uint8_t>& compressed : frames)
+        {
+            result.compressed += 2U + compressed.size();
+
+            std::vector<uint8_t> residuals;
+            VectorSink residualSink(residuals);
+            Compression::LzDecoder lz;
+            CHECK(lz.decodeFrame(compressed.data(), static_cast<uint16_t>(compressed.size()), residualSink));
+
+            Compression::ChannelDecoder<T, CHANNELS> channels;
+            for (size_t offset = 0; offset + sizeof(T) * CHANNELS <= residuals.size(); offset += sizeof(T) * CHANNELS)
+            {
+                T sample[CHANNELS];
+                channels.decode(&residuals[offset], sample);
+                for (uint8_t channel = 0; channel < CHANNELS; channel++)
+                {
+                    lossless = lossless &&
+                               std::memcmp(&sample[channel], &trace[decoded * CHANNELS + channel], sizeof(T)) == 0;
+                }
+                decoded++;
+            }
+        }
+        CHECK(lossless);
+        CHECK_EQ(decoded, sampleCount);
+        return result;
+    }
+
+    void report(const char* name, const Result& result)
+    {
+        std::printf("%-42s raw %6zu  compressed %6zu  ratio %.2f  encode %.1f ns/byte (host)\n", name, result.raw,
+                    result.compressed, static_cast<double>(result.raw) / static_cast<double>(result.compressed),
+                    result.encodeNsPerByte);
+    }
+
+    void testAdcSine()
+    {
+        uint32_t seed = 0x12345678U;
+        std::vector<int16_t> trace;
+        for (int i = 0; i < 1600; i++)
+        {
+            for (int channel = 0; channel < 6; channel++)
+            {
+                const double phase = 2.0 * M_PI * i / 800.0 + channel;
+                const int noise = static_cast<int>(random(seed) % 5U) - 2;
+                trace.push_back(static_cast<int16_t>(2048.0 + 1500.0 * std::sin(phase) + noise));
+            }
+        }
+        const Result result = run<int16_t, 6>(trace, 32);
+        report("6 x int16 ADC, slow sine + 2 LSB noise", result);
+        CHECK_EQ(result.raw, 19200);
+        CHECK_EQ(result.compressed, 13640);
+    }
+
+    void testTemperatureRamp()
+    {
+        std::vector<float> trace;
+        for (int i = 0; i < 1600; i++)
+        {
+            for (int channel = 0; channel < 3; channel++)
+            {
+                trace.push_back(20.0F + static_cast<float>(channel) * 5.0F + static_cast<float>(i) * 0.01F);
+            }
+        }
+        const Result result = run<float, 3>(trace, 64);
+        report("3 x float temperature ramp", result);
+        CHECK_EQ(result.raw, 19200);
+        CHECK_EQ(result.compressed, 10142);
+    }
+
+    void testRandom()
+    {
+        uint32_t seed = 0xCAFEF00DU;
+        std::vector<int32_t> trace;
+        for (int i = 0; i < 3200 * 2; i++)
+        {
+            trace.push_back(static_cast<int32_t>(random(seed)));
+        }
+        const Result result = run<int32_t, 2>(trace, 64);
+        report("2 x int32 random (incompressible)", result);
+        CHECK_EQ(result.raw, 25600);
+        CHECK_EQ(result.compressed, 28875);
+    }
+}
+
+int main()
+{
+    testAdcSine();
+    testTemperatureRamp();
+    testRandom();
+    return Check::result();
+}
@@ -0,0 +1,305 @@
+/**
+ * @file    DebounceTest.cpp
+ * @brief   Debounce: counter rules, PortScanner lanes, bounce traces and update cost quoted in Debounce.h
+ * @author  MootSeeker
+ *
+ * The bounce traces are synthetic (fixed seed), as no recorded ones are
+ * available. Each of the 32 inputs alternates between hold times of
+ * 30..300 ms; every transition starts with a burst of 0.2..5 ms during
+ * which the level flips at intervals of 20 us..1 ms. In the "worn contact"
+ * set, 5 % of those intervals are plateaus of 1..6 ms instead. The
+ * PortScanner samples the traces through IDR at the given interval. A
+ * transition is missed if the debounced state is wrong just before the
+ * next one; every debounced edge beyond the transitions is a false edge.
+ *
+ * The cost benchmark runs update() on random samples for 16, 32 and 64
+ * inputs on the host and prints the time per sample.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+
+#include "Debounce.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    /// xorshift32, deterministic traces
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint32_t uniform(uint32_t& state, uint32_t low, uint32_t high)
+    {
+        return low + random(state) % (high - low + 1U);
+    }
+
+    // ========================================================================
+    // Counter rules
+    // ========================================================================
+
+    constexpr bool changesAfterFourSamples()
+    {
+        Debounce::VerticalCounter<uint8_t> counter(0);
+        for (int i = 0; i < 3; i++)
+        {
+            if (counter.update(0x01).pressed != 0)
+            {
+                return false;
+            }
+        }
+        return counter.update(0x01).pressed == 0x01 && counter.getState() == 0x01;
+    }
+
+    constexpr bool bounceRestartsCount()
+    {
+        Debounce::VerticalCounter<uint8_t> counter(0);
+        counter.update(0x03);
+        counter.update(0x03);
+        counter.update(0x03);
+        const auto fourth = counter.update(0x01);   // Bit 0: 4th sample, bit 1 bounces back
+        const auto fifth = counter.update(0x03);    // Bit 1: 1st sample again
+        return fourth.pressed == 0x01 && fifth.pressed == 0 && counter.getState() == 0x01;
+    }
+
+    constexpr bool releasesLikePresses()
+    {
+        Debounce::VerticalCounter<uint16_t> counter(0x8001);
+        Debounce::BasicEdges<uint16_t> edges{0, 0};
+        for (int i = 0; i < 4; i++)
+        {
+            edges = counter.update(0x0001);
+        }
+        return edges.released == 0x8000 && edges.pressed == 0 && counter.getState() == 0x0001;
+    }
+
+    static_assert(changesAfterFourSamples());
+    static_assert(bounceRestartsCount());
+    static_assert(releasesLikePresses());
+
+    void testScanner()
+    {
+        HostMcu::reset();
+        GPIOC->IDR = 0x0001U;   // PC1 held down (active low), PC0 released
+        GPIOB->IDR = 0x0004U;   // PB2 on (active high)
+        Debounce::PortScanner scanner({GPIOC, 0x0003, 0x0003}, {GPIOB, 0x0007, 0x0000});
+        CHECK(scanner.start(2000));
+        CHECK(!scanner.start(2000));
+        CHECK_EQ(TIM16->ARR, 1999);
+        CHECK_EQ(TIM16->PSC, 31);
+        CHECK_EQ(scanner.getState(), 0x0002U | (0x0004U << 16));   // Held inputs start active, no press
+
+        GPIOC->IDR = 0x0002U;   // PC0 pressed, PC1 released
+        GPIOB->IDR = 0x0001U;   // PB0 on, PB2 off
+        for (int i = 0; i < 4; i++)
+        {
+            TIM16->SR = TIM_SR_UIF;
+            DEBOUNCE_HandleSampleTimerInterrupt();
+        }
+        CHECK_EQ(scanner.getSampleCount(), 4);
+        uint32_t state = 0;
+        const Debounce::Edges edges = scanner.takeEdges(state);
+        CHECK_EQ(state, 0x0001U | (0x0001U << 16));
+        CHECK_EQ(edges.pressed, 0x0001U | (0x0001U << 16));
+        CHECK_EQ(edges.released, 0x0002U | (0x0004U << 16));
+        CHECK_EQ(scanner.takeEdges().pressed, 0);
+        CHECK(HostMcu::isIrqEnabled(TIM1_UP_TIM16_IRQn));
+
+        // The vector is shared with TIM1 UP: taking edges does not enable it for someone else
+        scanner.stop();
+        CHECK(!HostMcu::isIrqEnabled(TIM1_UP_TIM16_IRQn));
+        scanner.takeEdges();
+        CHECK(!HostMcu::isIrqEnabled(TIM1_UP_TIM16_IRQn));
+    }
+
+    // ========================================================================
+    // Bounce traces
+    // ========================================================================
+
+    constexpr uint32_t INPUTS = 32;
+    constexpr uint32_t DURATION_US = 52000000U;   // About 10000 transitions over 32 inputs
+
+    struct Trace
+    {
+        std::vector<uint32_t> edges;         ///< Level flips, starting from inactive
+        std::vector<uint32_t> transitions;   ///< Start of each intended change
+        size_t cursor = 0;
+
+        bool levelAt(uint32_t time)
+        {
+            while (cursor < edges.size() && edges[cursor] <= time)
+            {
+                cursor++;
+            }
+            return (cursor % 2U) != 0U;
+        }
+    };
+
+    Trace makeTrace(uint32_t& seed, bool worn)
+    {
+        Trace trace;
+        uint32_t time = uniform(seed, 0, 300000);
+        while (time < DURATION_US - 400000U)
+        {
+            trace.transitions.push_back(time);
+            const uint32_t burstEnd = time + uniform(seed, 200, 5000);
+            bool atTarget = false;
+            while (time < burstEnd)
+            {
+                trace.edges.push_back(time);
+                atTarget = !atTarget;
+                const bool plateau = worn && uniform(seed, 0, 99) < 5U;
+                time += plateau ? uniform(seed, 1000, 6000) : uniform(seed, 20, 1000);
+            }
+            if (!atTarget)
+            {
+                trace.edges.push_back(time);   // Settle at the new level
+            }
+            time += uniform(seed, 30000, 300000);
+        }
+        return trace;
+    }
+
+    struct Rejection
+    {
+        uint32_t transitions;
+        uint32_t falseEdges;
+        uint32_t missed;
+    };
+
+    Rejection runTraces(uint32_t intervalUs, bool worn)
+    {
+        HostMcu::reset();
+        uint32_t seed = worn ? 0xB5297A4DU : 0x68E31DA4U;
+        std::vector<Trace> traces;
+        for (uint32_t i = 0; i < INPUTS; i++)
+        {
+            traces.push_back(makeTrace(seed, worn));
+        }
+
+        GPIOC->IDR = 0;
+        GPIOB->IDR = 0;
+        Debounce::PortScanner scanner({GPIOC, 0xFFFF, 0x0000}, {GPIOB, 0xFFFF, 0x0000});
+        CHECK(scanner.start(intervalUs));
+
+        std::vector<uint32_t> toggles(INPUTS, 0);
+        std::vector<size_t> next(INPUTS, 0);
+        Rejection result{0, 0, 0};
+        for (uint32_t time = intervalUs; time < DURATION_US; time += intervalUs)
+        {
+            uint32_t levels = 0;
+            for (uint32_t i = 0; i < INPUTS; i++)
+            {
+                // The debounced state just before the next transition must match the intended one
+                Trace& trace = traces[i];
+                while (next[i] < trace.transitions.size() && trace.transitions[next[i]] <= time)
+                {
+                    if (next[i] > 0U)
+                    {
+                        const bool expected = (next[i] % 2U) != 0U;
+                        result.missed += (((scanner.getState() >> i) & 1U) != 0U) != expected;
+                    }
+                    next[i]++;
+                }
+                levels |= static_cast<uint32_t>(trace.levelAt(time)) << i;
+            }
+            GPIOC->IDR = levels & 0xFFFFU;
+            GPIOB->IDR = levels >> 16;
+            DEBOUNCE_HandleSampleTimerInterrupt();
+
+            const Debounce::Edges edges = scanner.takeEdges();
+            for (uint32_t i = 0; i < INPUTS; i++)
+            {
+                toggles[i] += ((edges.pressed | edges.released) >> i) & 1U;
+            }
+        }
+        scanner.stop();
+
+        for (uint32_t i = 0; i < INPUTS; i++)
+        {
+            const uint32_t transitions = static_cast<uint32_t>(traces[i].transitions.size());
+            result.transitions += transitions;
+            result.falseEdges += (toggles[i] > transitions) ? toggles[i] - transitions : 0U;
+        }
+        return result;
+    }
+
+    void testBounceTraces()
+    {
+        for (uint32_t intervalUs : {1000U, 2000U, 5000U})
+        {
+            const Rejection clean = runTraces(intervalUs, false);
+            const Rejection worn = runTraces(intervalUs, true);
+            std::printf("sample %4u us (debounce %2u ms): %u / %u transitions, false edges %u / %u, missed %u / %u "
+                        "(clean / worn)\n",
+                        intervalUs, 4U * intervalUs / 1000U, clean.transitions, worn.transitions, clean.falseEdges,
+                        worn.falseEdges, clean.missed, worn.missed);
+            CHECK(clean.transitions > 9000U && clean.transitions < 11000U);
+            CHECK_EQ(clean.falseEdges, 0);
+            CHECK_EQ(clean.missed, 0);
+            CHECK_EQ(worn.missed, 0);
+            if (intervalUs >= 2000U)
+            {
+                CHECK_EQ(worn.falseEdges, 0);   // 8 ms outlasts every 6 ms plateau
+            }
+        }
+    }
+
+    // ========================================================================
+    // Update cost
+    // ========================================================================
+
+    template <typename Word>
+    double nanosecondsPerSample()
+    {
+        constexpr int ROUNDS = 7;
+        constexpr int SAMPLES = 1 << 20;
+        std::vector<Word> samples(4096);
+        uint32_t seed = 0x9E3779B9U;
+        for (Word& sample : samples)
+        {
+            sample = static_cast<Word>((static_cast<uint64_t>(random(seed)) << 32) | random(seed));
+        }
+
+        double results[ROUNDS];
+        volatile Word sink = 0;
+        for (double& result : results)
+        {
+            Debounce::VerticalCounter<Word> counter(0);
+            Word edges = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < SAMPLES; i++)
+            {
+                const auto change = counter.update(samples[static_cast<size_t>(i) & 4095U]);
+                edges = static_cast<Word>(edges ^ change.pressed ^ change.released);
+            }
+            result = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / SAMPLES;
+            sink = sink + edges;
+        }
+        std::sort(results, results + ROUNDS);
+        return results[ROUNDS / 2];
+    }
+
+    void benchmarkUpdate()
+    {
+        std::printf("update(): 16 inputs %.2f ns, 32 inputs %.2f ns, 64 inputs %.2f ns per sample (host)\n",
+                    nanosecondsPerSample<uint16_t>(), nanosecondsPerSample<uint32_t>(),
+                    nanosecondsPerSample<uint64_t>());
+    }
+}
+
+int main()
+{
+    testScanner();
+    testBounceTraces();
+    benchmarkUpdate();
+    return Check::result();
+}
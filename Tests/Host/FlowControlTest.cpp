@@ -0,0 +1,172 @@
+/**
+ * @file    FlowControlTest.cpp
+ * @brief   RTS/CTS and XON/XOFF flow control: 1 MB at 2 Mbaud into a slow reader, no overrun, no loss
+ * @author  MootSeeker
+ *
+ * The sender pushes a byte whenever the line is free and it is allowed to:
+ * - RTS/CTS: the USART model holds the next byte back while RXNE is still
+ *   set and RTSE is on, as a peer watching RTS does (see UsartModel.h).
+ * - XON/XOFF: the sender reads what the driver transmits. A control
+ *   character takes effect PEER_LATENCY characters after its stop bit, the
+ *   bytes already in the peer's UART go out anyway.
+ * The application reads one byte every READ_INTERVAL character times, a
+ * third of the line rate. Every pause must start at the high watermark and
+ * every resume at the low watermark (usart.h Pattern 7), and the full
+ * stream must arrive intact.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "usart.h"
+
+#include <cstdio>
+
+namespace
+{
+    constexpr uint32_t BAUD_RATE = 2000000;
+    constexpr size_t STREAM_SIZE = 1024 * 1024;
+    constexpr size_t READ_INTERVAL = 3;
+    constexpr size_t PEER_LATENCY = 2;
+    constexpr uint16_t RX_BUFFER_SIZE = 256;   // StandardUSART
+    constexpr uint16_t HIGH_WATERMARK = 192;
+    constexpr uint16_t LOW_WATERMARK = 64;
+
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    /// Payload byte; XON/XOFF cannot appear in a software flow-controlled stream
+    uint8_t nextByte(uint32_t& state)
+    {
+        const uint8_t data = static_cast<uint8_t>(random(state));
+        return (data == 0x11 || data == 0x13) ? static_cast<uint8_t>(data | 0x80) : data;
+    }
+
+    void testStream(USART::FlowControl mode, const char* name)
+    {
+        HostMcu::reset();
+        USART::StandardUSART uart(USART::PeripheralType::USART_2);
+        USART::Config config = USART::getDefaultUsartConfig();
+        config.baudRate = BAUD_RATE;
+        CHECK(uart.initialize(config).isSuccess());
+        UsartModel<USART::StandardUSART> wire(uart);
+        CHECK(uart.enableFlowControl({mode, HIGH_WATERMARK, LOW_WATERMARK}).isSuccess());
+
+        uint32_t sendState = 0x2545F491U;
+        uint32_t readState = sendState;
+        size_t sent = 0;
+        size_t received = 0;
+        size_t mismatches = 0;
+        size_t pauses = 0;
+        size_t resumes = 0;
+        size_t misplacedPauses = 0;
+        size_t misplacedResumes = 0;
+        uint16_t peakFill = 0;
+
+        bool peerStopped = false;
+        size_t peerStopIn = 0;          // Characters until a received XOFF takes effect
+        size_t peerStartIn = 0;
+        bool paused = false;
+
+        while (received < STREAM_SIZE && wire.getStepCount() < 8 * STREAM_SIZE)
+        {
+            if (sent < STREAM_SIZE && !peerStopped && wire.getPendingReceiveCount() == 0)
+            {
+                wire.queueReceive(nextByte(sendState));
+                sent++;
+            }
+            wire.step();
+
+            for (uint8_t control : wire.takeTransmitted())
+            {
+                if (control == 0x13)
+                {
+                    peerStopIn = PEER_LATENCY;
+                    peerStartIn = 0;
+                }
+                else if (control == 0x11)
+                {
+                    peerStartIn = PEER_LATENCY;
+                    peerStopIn = 0;
+                }
+            }
+            if (peerStopIn > 0 && --peerStopIn == 0)
+            {
+                peerStopped = true;
+            }
+            if (peerStartIn > 0 && --peerStartIn == 0)
+            {
+                peerStopped = false;
+            }
+
+            const uint16_t fill = uart.getRxCount();
+            peakFill = (fill > peakFill) ? fill : peakFill;
+            if (!paused && uart.isRxPaused())
+            {
+                paused = true;
+                pauses++;
+                misplacedPauses += (fill != HIGH_WATERMARK) ? 1 : 0;
+            }
+
+            uint8_t data = 0;
+            if (wire.getStepCount() % READ_INTERVAL == 0 && uart.receiveByte(data))
+            {
+                mismatches += (data != nextByte(readState)) ? 1 : 0;
+                received++;
+                if (paused && !uart.isRxPaused())
+                {
+                    paused = false;
+                    resumes++;
+                    misplacedResumes += (uart.getRxCount() != LOW_WATERMARK) ? 1 : 0;
+                }
+            }
+        }
+
+        CHECK_EQ(received, STREAM_SIZE);
+        CHECK_EQ(mismatches, 0);
+        CHECK_EQ(wire.getOverrunCount(), 0);
+        CHECK_EQ(uart.getRxOverflowCount(), 0);
+        CHECK((uart.getInstance()->ISR & USART_ISR_ORE) == 0U);
+        CHECK(pauses > 1000);
+        CHECK(resumes == pauses || resumes + 1 == pauses);
+        CHECK_EQ(misplacedPauses, 0);
+        CHECK_EQ(misplacedResumes, 0);
+        // RTS holds the byte in flight in RDR; XON/XOFF takes what the sender had under way
+        CHECK_EQ(peakFill, HIGH_WATERMARK + ((mode == USART::FlowControl::XON_XOFF) ? 1 : 0));
+        CHECK(peakFill < RX_BUFFER_SIZE);
+
+        const double seconds = static_cast<double>(wire.getStepCount()) * wire.getCharacterBits() / BAUD_RATE;
+        std::printf("  %-8s %zu bytes in %zu character times (%.0f ms at %u baud, %.0f kB/s): "
+                    "%zu pauses at %u, resumes at %u, peak fill %u\n",
+                    name, received, wire.getStepCount(), seconds * 1000.0, static_cast<unsigned>(BAUD_RATE),
+                    static_cast<double>(received) / seconds / 1000.0, pauses, HIGH_WATERMARK, LOW_WATERMARK,
+                    peakFill);
+    }
+
+    /// RTS/CTS and RS-485 both need the RTS pin
+    void testRs485Refused()
+    {
+        HostMcu::reset();
+        USART::StandardUSART uart(USART::PeripheralType::USART_2);
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        CHECK(uart.enableRs485(USART::getDefaultRs485Config()).isSuccess());
+        CHECK_EQ(uart.enableFlowControl({USART::FlowControl::RTS_CTS, HIGH_WATERMARK, LOW_WATERMARK}).error,
+                 USART::UsartError::BUSY);
+        CHECK((uart.getInstance()->CR3 & (USART_CR3_RTSE | USART_CR3_CTSE)) == 0U);
+        CHECK(uart.enableFlowControl({USART::FlowControl::XON_XOFF, HIGH_WATERMARK, LOW_WATERMARK}).isSuccess());
+    }
+}
+
+int main()
+{
+    testStream(USART::FlowControl::RTS_CTS, "RTS/CTS");
+    testStream(USART::FlowControl::XON_XOFF, "XON/XOFF");
+    testRs485Refused();
+    return Check::result();
+}
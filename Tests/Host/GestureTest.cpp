@@ -0,0 +1,196 @@
+/**
+ * @file    GestureTest.cpp
+ * @brief   Gesture: the edge traces listed in Gesture.h and update() with both edges of a button
+ * @author  MootSeeker
+ *
+ * Each trace is a list of timestamped edges of one button. It is fed
+ * through press()/release() as an event source would, in three ways:
+ * advance() run between the edges at polls 1..50 ms apart (fixed seed),
+ * no advance() at all until after the last edge, and both again with every
+ * timestamp moved to just before the 2^32 ms wrap. The reported gestures
+ * and their times must be the same every time.
+ */
+
+#include "Check.h"
+
+#include "Gesture.h"
+
+#include <cstdio>
+#include <initializer_list>
+#include <vector>
+
+namespace
+{
+    constexpr uint8_t BUTTON = 5;
+    constexpr uint32_t BIT = 1U << BUTTON;
+
+    /// xorshift32, deterministic poll times
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    struct Event
+    {
+        uint8_t button;
+        Gesture::Type gesture;
+        uint32_t timeMs;
+    };
+
+    std::vector<Event> reported;
+
+    void collect(void*, uint8_t button, Gesture::Type gesture, uint32_t timeMs)
+    {
+        reported.push_back(Event{button, gesture, timeMs});
+    }
+
+    struct Edge
+    {
+        uint32_t timeMs;
+        bool down;
+    };
+
+    struct Expected
+    {
+        Gesture::Type gesture;
+        uint32_t timeMs;
+    };
+
+    void feed(Gesture::ButtonSet& buttons, const Edge& edge, uint32_t base)
+    {
+        if (edge.down)
+        {
+            buttons.press(BUTTON, base + edge.timeMs);
+        }
+        else
+        {
+            buttons.release(BUTTON, base + edge.timeMs);
+        }
+    }
+
+    bool matches(const std::vector<Expected>& expected, uint32_t base)
+    {
+        bool same = reported.size() == expected.size();
+        for (size_t i = 0; same && i < expected.size(); i++)
+        {
+            same = reported[i].button == BUTTON && reported[i].gesture == expected[i].gesture &&
+                   reported[i].timeMs == base + expected[i].timeMs;
+        }
+        return same;
+    }
+
+    void runTrace(const char* name, std::initializer_list<Edge> trace, std::initializer_list<Expected> expected)
+    {
+        const std::vector<Expected> gestures(expected);
+        const uint32_t end = (trace.end() - 1)->timeMs + 2000U;
+        uint32_t seed = 0x3C6EF372U;
+
+        for (uint32_t base : {1000U, 0xFFFFFF00U})
+        {
+            // advance() polled late, edges delivered with their own timestamps
+            Gesture::ButtonSet polled(Gesture::DEFAULT_TIMING, collect, nullptr);
+            reported.clear();
+            const Edge* next = trace.begin();
+            for (uint32_t poll = 0; poll < end; poll += 1U + random(seed) % 50U)
+            {
+                while (next != trace.end() && next->timeMs <= poll)
+                {
+                    feed(polled, *next++, base);
+                }
+                polled.advance(base + poll);
+            }
+            polled.advance(base + end);
+            if (!CHECK(matches(gestures, base)))
+            {
+                std::printf("  trace \"%s\", base %u, polled\n", name, base);
+            }
+
+            // No advance() between the edges
+            Gesture::ButtonSet edgesOnly(Gesture::DEFAULT_TIMING, collect, nullptr);
+            reported.clear();
+            for (const Edge& edge : trace)
+            {
+                feed(edgesOnly, edge, base);
+            }
+            edgesOnly.advance(base + end);
+            if (!CHECK(matches(gestures, base)))
+            {
+                std::printf("  trace \"%s\", base %u, edges only\n", name, base);
+            }
+        }
+    }
+
+    void testTraces()
+    {
+        using Gesture::Type;
+        runTrace("80 ms press", {{0, true}, {80, false}}, {{Type::CLICK, 330}});
+        runTrace("gap 249 ms", {{0, true}, {80, false}, {329, true}, {400, false}}, {{Type::DOUBLE_CLICK, 400}});
+        runTrace("gap 250 ms", {{0, true}, {80, false}, {330, true}, {400, false}},
+                 {{Type::CLICK, 330}, {Type::CLICK, 650}});
+        runTrace("599 ms press", {{0, true}, {599, false}}, {{Type::CLICK, 849}});
+        runTrace("600 ms press", {{0, true}, {600, false}}, {{Type::LONG_PRESS, 600}});
+        runTrace("1000 ms press", {{0, true}, {1000, false}},
+                 {{Type::LONG_PRESS, 600}, {Type::REPEAT, 750}, {Type::REPEAT, 900}});
+        runTrace("click, long second press", {{0, true}, {80, false}, {200, true}, {1000, false}},
+                 {{Type::CLICK, 800}, {Type::LONG_PRESS, 800}, {Type::REPEAT, 950}});
+    }
+
+    /// Edge sources that never call advance(): press at 1000, release at 2000
+    void testLongPressWithoutAdvance()
+    {
+        Gesture::ButtonSet buttons({250, 600, 0}, collect, nullptr);
+        reported.clear();
+        buttons.press(0, 1000);
+        buttons.release(0, 2000);
+        CHECK_EQ(reported.size(), 1U);
+        CHECK(reported[0].gesture == Gesture::Type::LONG_PRESS && reported[0].timeMs == 1600U);
+
+        uint32_t deadlineMs;
+        CHECK(!buttons.nextDeadline(deadlineMs));
+    }
+
+    void testBothEdgesInOneUpdate()
+    {
+        Gesture::ButtonSet buttons(Gesture::DEFAULT_TIMING, collect, nullptr);
+        reported.clear();
+
+        // Up at the end: press, then release, a click
+        buttons.update({BIT, BIT}, 0, 100);
+        CHECK(reported.empty());
+        uint32_t deadlineMs = 0;
+        CHECK(buttons.nextDeadline(deadlineMs) && deadlineMs == 350U);
+        buttons.advance(1000);
+        CHECK_EQ(reported.size(), 1U);
+        CHECK(reported[0].gesture == Gesture::Type::CLICK && reported[0].timeMs == 350U);
+
+        // Down at the end: release, then press, the second press of a double click
+        reported.clear();
+        buttons.update({BIT, 0}, BIT, 2000);
+        buttons.update({BIT, BIT}, BIT, 2100);
+        buttons.update({0, BIT}, 0, 2200);
+        CHECK_EQ(reported.size(), 1U);
+        CHECK(reported[0].gesture == Gesture::Type::DOUBLE_CLICK && reported[0].timeMs == 2200U);
+
+        // Several buttons in one update, each by its own level
+        reported.clear();
+        buttons.update({0x3U, 0x0U}, 0x3U, 3000);
+        buttons.update({0x3U, 0x3U}, 0x1U, 3100);   // Button 0 ends down, button 1 ends up
+        buttons.advance(3400);
+        CHECK_EQ(reported.size(), 1U);
+        CHECK(reported[0].button == 1 && reported[0].gesture == Gesture::Type::CLICK && reported[0].timeMs == 3350U);
+        buttons.update({0x0U, 0x1U}, 0x0U, 3450);
+        CHECK_EQ(reported.size(), 2U);
+        CHECK(reported[1].button == 0 && reported[1].gesture == Gesture::Type::DOUBLE_CLICK);
+    }
+}
+
+int main()
+{
+    testTraces();
+    testLongPressWithoutAdvance();
+    testBothEdgesInOneUpdate();
+    return Check::result();
+}
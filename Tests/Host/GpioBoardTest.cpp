@@ -0,0 +1,264 @@
+/**
+ * @file    GpioBoardTest.cpp
+ * @brief   BoardMap: images, and the registers apply() leaves compared with configuring pin by pin
+ * @author  MootSeeker
+ *
+ * The board is the 40-pin map of gpio_board.h: 16 outputs, 12 pulled-up
+ * inputs, 8 alternate-function and 4 analog pins on ports A, B and C. The
+ * per-pin path is what application code does without a map: a GPIOOutput
+ * or GPIOInput object per pin, Port::configure() for the others. Both start
+ * from the reset values and must leave the same MODER, OTYPER, OSPEEDR,
+ * PUPDR and AFR contents, with and without pins configured elsewhere.
+ * HostMcu counts the register accesses each path makes.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+
+#include "gpio_board.h"
+
+#include <cstdio>
+
+namespace
+{
+    using namespace GPIO;
+
+    constexpr PinDescriptor PINS[] = {
+        // Outputs: PB0..PB2, PB5..PB15, PC0, PC1
+        outputPin(PortName::B, 0),
+        outputPin(PortName::B, 1, PinState::HIGH),
+        outputPin(PortName::B, 2, PinState::LOW, PinSpeed::MEDIUM),
+        outputPin(PortName::B, 5, PinState::HIGH, PinSpeed::LOW, PinOutputType::OPEN_DRAIN),
+        outputPin(PortName::B, 6),
+        outputPin(PortName::B, 7),
+        outputPin(PortName::B, 8, PinState::HIGH),
+        outputPin(PortName::B, 9),
+        outputPin(PortName::B, 10, PinState::LOW, PinSpeed::HIGH),
+        outputPin(PortName::B, 11),
+        outputPin(PortName::B, 12, PinState::LOW, PinSpeed::LOW, PinOutputType::OPEN_DRAIN),
+        outputPin(PortName::B, 13),
+        outputPin(PortName::B, 14, PinState::HIGH),
+        outputPin(PortName::B, 15),
+        outputPin(PortName::C, 0, PinState::HIGH, PinSpeed::VERY_HIGH),
+        outputPin(PortName::C, 1),
+        // Pulled-up inputs: PC2..PC13
+        inputPin(PortName::C, 2, PinPull::PULL_UP),
+        inputPin(PortName::C, 3, PinPull::PULL_UP),
+        inputPin(PortName::C, 4, PinPull::PULL_UP),
+        inputPin(PortName::C, 5, PinPull::PULL_UP),
+        inputPin(PortName::C, 6, PinPull::PULL_UP),
+        inputPin(PortName::C, 7, PinPull::PULL_UP),
+        inputPin(PortName::C, 8, PinPull::PULL_UP),
+        inputPin(PortName::C, 9, PinPull::PULL_UP),
+        inputPin(PortName::C, 10, PinPull::PULL_UP),
+        inputPin(PortName::C, 11, PinPull::PULL_UP),
+        inputPin(PortName::C, 12, PinPull::PULL_UP),
+        inputPin(PortName::C, 13, PinPull::PULL_UP),
+        // Alternate functions: TIM2 CH1..CH4, USART1 CK/TX/RX/CTS
+        alternatePin(PortName::A, 0, 1),
+        alternatePin(PortName::A, 1, 1),
+        alternatePin(PortName::A, 2, 1, PinPull::NO_PULL, PinSpeed::LOW),
+        alternatePin(PortName::A, 3, 1),
+        alternatePin(PortName::A, 8, 7),
+        alternatePin(PortName::A, 9, 7),
+        alternatePin(PortName::A, 10, 7, PinPull::PULL_UP),
+        alternatePin(PortName::A, 11, 7, PinPull::PULL_UP, PinSpeed::HIGH, PinOutputType::OPEN_DRAIN),
+        // Analog: PA4..PA7
+        analogPin(PortName::A, 4),
+        analogPin(PortName::A, 5),
+        analogPin(PortName::A, 6),
+        analogPin(PortName::A, 7),
+    };
+    constexpr BoardMap BOARD(PINS);
+
+    static_assert(BOARD.image(PortName::A).pins == 0x0FFF);
+    static_assert(BOARD.image(PortName::B).pins == 0xFFE7);
+    static_assert(BOARD.image(PortName::C).pins == 0x3FFF);
+    static_assert(BOARD.image(PortName::D).pins == 0);
+    static_assert(BOARD.image(PortName::A).moder == 0xABAAFFAAU);   // PA12..PA15 keep their reset modes
+    static_assert(BOARD.image(PortName::A).afrl == 0x00001111U && BOARD.image(PortName::A).afrh == 0x00007777U);
+    static_assert(BOARD.image(PortName::B).bsrr == ((1U << 1 | 1U << 5 | 1U << 8 | 1U << 14) |
+                                                    ((0xFFE7U & ~(1U << 1 | 1U << 5 | 1U << 8 | 1U << 14)) << 16)));
+    static_assert(BOARD.image(PortName::B).otyper == (1U << 5 | 1U << 12));
+    static_assert(BOARD.image(PortName::C).pupdr == 0x05555550U);
+
+    /// Configuration registers of one port
+    struct PortRegisters
+    {
+        uint32_t moder;
+        uint32_t otyper;
+        uint32_t ospeedr;
+        uint32_t pupdr;
+        uint32_t afrl;
+        uint32_t afrh;
+
+        bool operator==(const PortRegisters&) const = default;
+    };
+
+    struct Snapshot
+    {
+        PortRegisters ports[3];
+        uint32_t clocks;
+
+        bool operator==(const Snapshot&) const = default;
+    };
+
+    Snapshot snapshot()
+    {
+        Snapshot result{};
+        GPIO_TypeDef* const ports[3] = {GPIOA, GPIOB, GPIOC};
+        for (int i = 0; i < 3; i++)
+        {
+            result.ports[i] = {ports[i]->MODER, ports[i]->OTYPER, ports[i]->OSPEEDR,
+                               ports[i]->PUPDR, ports[i]->AFR[0], ports[i]->AFR[1]};
+        }
+        result.clocks = RCC->AHB2ENR & (RCC_AHB2ENR_GPIOAEN | RCC_AHB2ENR_GPIOBEN | RCC_AHB2ENR_GPIOCEN);
+        return result;
+    }
+
+    void report(const Snapshot& expected, const Snapshot& actual)
+    {
+        const char names[3] = {'A', 'B', 'C'};
+        for (int i = 0; i < 3; i++)
+        {
+            const PortRegisters& e = expected.ports[i];
+            const PortRegisters& a = actual.ports[i];
+            if (!(e == a))
+            {
+                std::printf("  port %c: MODER %08X/%08X OTYPER %08X/%08X OSPEEDR %08X/%08X PUPDR %08X/%08X "
+                            "AFR %08X%08X/%08X%08X\n",
+                            names[i], e.moder, a.moder, e.otyper, a.otyper, e.ospeedr, a.ospeedr, e.pupdr, a.pupdr,
+                            e.afrh, e.afrl, a.afrh, a.afrl);
+            }
+        }
+    }
+
+    GPIO_TypeDef* portOf(PortName port)
+    {
+        return reinterpret_cast<GPIO_TypeDef*>(static_cast<uintptr_t>(port));
+    }
+
+    /// The same pins, one object or Port::configure() call each
+    void configurePinByPin()
+    {
+        for (const PinDescriptor& desc : PINS)
+        {
+            GPIO_TypeDef* port = portOf(desc.port);
+            if (desc.mode == PinMode::OUTPUT)
+            {
+                GPIOOutput output(PinConfig{port, desc.pin, PinMode::OUTPUT, desc.pull, desc.speed, desc.outputType});
+                output.write(desc.initial);
+            }
+            else if (desc.mode == PinMode::INPUT)
+            {
+                GPIOInput input(port, desc.pin, desc.pull);
+            }
+            else
+            {
+                Port(port).configure(1U << desc.pin, desc.mode, desc.pull, desc.speed, desc.outputType,
+                                     desc.alternate);
+            }
+        }
+    }
+
+    /// Pins outside the map, as a driver started before the board map would leave them
+    void configureUnlisted()
+    {
+        Port(GPIOA).configure(1U << 12, PinMode::OUTPUT, PinPull::NO_PULL, PinSpeed::HIGH);
+        Port(GPIOB).configure(1U << 3, PinMode::ALTERNATE, PinPull::NO_PULL, PinSpeed::VERY_HIGH,
+                              PinOutputType::PUSH_PULL, 6);
+        Port(GPIOC).configure(1U << 14, PinMode::INPUT, PinPull::PULL_DOWN);
+    }
+
+    void testResetUnlisted()
+    {
+        HostMcu::reset();
+        configurePinByPin();
+        const Snapshot pinByPin = snapshot();
+
+        HostMcu::reset();
+        BOARD.apply();
+        const Snapshot board = snapshot();
+        if (!CHECK(board == pinByPin))
+        {
+            report(pinByPin, board);
+        }
+        CHECK_EQ(board.clocks, RCC_AHB2ENR_GPIOAEN | RCC_AHB2ENR_GPIOBEN | RCC_AHB2ENR_GPIOCEN);
+        CHECK_EQ(GPIOA->BSRR, BOARD.image(PortName::A).bsrr);
+        CHECK_EQ(GPIOB->BSRR, BOARD.image(PortName::B).bsrr);
+        CHECK_EQ(GPIOC->BSRR, BOARD.image(PortName::C).bsrr);
+
+        // Pins configured elsewhere go back to their reset configuration
+        HostMcu::reset();
+        configureUnlisted();
+        BOARD.apply();
+        const Snapshot over = snapshot();
+        if (!CHECK(over == pinByPin))
+        {
+            report(pinByPin, over);
+        }
+    }
+
+    void testKeepUnlisted()
+    {
+        HostMcu::reset();
+        configureUnlisted();
+        configurePinByPin();
+        const Snapshot pinByPin = snapshot();
+
+        HostMcu::reset();
+        configureUnlisted();
+        BOARD.apply(BoardApply::KEEP_UNLISTED);
+        const Snapshot board = snapshot();
+        if (!CHECK(board == pinByPin))
+        {
+            report(pinByPin, board);
+        }
+        CHECK_EQ((GPIOA->MODER >> 24) & 3U, static_cast<uint32_t>(PinMode::OUTPUT));
+        CHECK_EQ((GPIOB->AFR[0] >> 12) & 0xFU, 6);
+        CHECK_EQ((GPIOC->PUPDR >> 28) & 3U, static_cast<uint32_t>(PinPull::PULL_DOWN));
+    }
+
+    /// CPU accesses to GPIO and RCC registers of each path, on the same 40 pins
+    void testAccessCount()
+    {
+        HostMcu::reset();
+        HostMcu::startAccessCount();
+        configurePinByPin();
+        const HostMcu::AccessCount pinByPin = HostMcu::stopAccessCount();
+
+        HostMcu::reset();
+        HostMcu::startAccessCount();
+        BOARD.apply();
+        const HostMcu::AccessCount reset = HostMcu::stopAccessCount();
+
+        HostMcu::reset();
+        HostMcu::startAccessCount();
+        BOARD.apply(BoardApply::KEEP_UNLISTED);
+        const HostMcu::AccessCount keep = HostMcu::stopAccessCount();
+
+        std::printf("  pin by pin: %u reads, %u writes; RESET_UNLISTED: %u reads, %u writes; "
+                    "KEEP_UNLISTED: %u reads, %u writes\n",
+                    pinByPin.reads, pinByPin.writes, reset.reads, reset.writes, keep.reads, keep.writes);
+
+        // RCC: one read-modify-write and the read-back, then 7 registers on each of the 3 ports
+        constexpr uint32_t PORTS = 3;
+        CHECK_EQ(reset.reads, 2);
+        CHECK_EQ(reset.writes, 1 + 7 * PORTS);
+        CHECK_EQ(keep.reads, 2 + 6 * PORTS);
+        CHECK_EQ(keep.writes, 1 + 7 * PORTS);
+
+        // Clock enable and LL_GPIO_Init (plus the initial level of an output) for every pin
+        CHECK_EQ(pinByPin.reads, 182);
+        CHECK_EQ(pinByPin.writes, 171);
+        CHECK(pinByPin.reads + pinByPin.writes > 14 * (reset.reads + reset.writes));
+    }
+}
+
+int main()
+{
+    testResetUnlisted();
+    testKeepUnlisted();
+    testAccessCount();
+    return Check::result();
+}
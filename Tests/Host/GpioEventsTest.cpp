@@ -0,0 +1,171 @@
+/**
+ * @file    GpioEventsTest.cpp
+ * @brief   EventQueue: recording, dispatch order, and the flood test quoted in gpio_events.h
+ * @author  MootSeeker
+ *
+ * The flood test drives one attached line with random gaps between edges
+ * (uniform, mean 1/rate, fixed seed) and drains the queue every 100 us of
+ * simulated time, as a main loop would. DWT->CYCCNT is set to the edge time
+ * before each recorder call, so dispatched timestamps can be checked
+ * against the generated ones. It prints the maximum depth and the lost
+ * share for each traffic pattern.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+
+#include "gpio_events.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    using namespace GPIO;
+
+    constexpr uint32_t CYCLES_PER_US = 32;
+
+    /// xorshift32, deterministic event gaps
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    std::vector<PinEvent> handled;
+
+    void collect(void*, const PinEvent& event)
+    {
+        handled.push_back(event);
+    }
+
+    void testRecordAndDispatch()
+    {
+        HostMcu::reset();
+        handled.clear();
+        EventQueue queue;
+        GPIOEXTI button(GPIOC, 13, EXTITrigger::RISING_FALLING);
+        GPIOEXTI other(GPIOA, 3, EXTITrigger::FALLING);
+        CHECK(queue.attach(button, collect));
+        CHECK(queue.attach(other, collect));
+        CHECK((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U);
+
+        GPIOC->IDR = 0;
+        DWT->CYCCNT = 100;
+        GPIOEXTI::handleInterrupt(13);
+        GPIOA->IDR = 1U << 3;
+        DWT->CYCCNT = 200;
+        GPIOEXTI::handleInterrupt(3);
+        GPIOC->IDR = 1U << 13;
+        DWT->CYCCNT = 300;
+        GPIOEXTI::handleInterrupt(13);
+        CHECK_EQ(queue.getPendingCount(), 3);
+        CHECK(handled.empty());   // Nothing runs in interrupt context
+
+        CHECK_EQ(queue.dispatch(2), 2);   // Bounded per call
+        CHECK_EQ(queue.dispatch(), 1);
+        CHECK_EQ(handled.size(), 3U);
+        CHECK(handled[0].line == 13 && handled[0].edge == Edge::FALLING && handled[0].timestamp == 100U);
+        CHECK(handled[1].line == 3 && handled[1].edge == Edge::RISING && handled[1].timestamp == 200U);
+        CHECK(handled[2].line == 13 && handled[2].edge == Edge::RISING && handled[2].timestamp == 300U);
+        CHECK_EQ(queue.getMaxDepth(), 3);
+
+        // A detached line's queued events are discarded
+        GPIOEXTI::handleInterrupt(3);
+        queue.detach(other);
+        GPIOEXTI::handleInterrupt(3);   // No longer recorded
+        CHECK_EQ(queue.dispatch(), 1);
+        CHECK_EQ(handled.size(), 3U);
+        CHECK_EQ(queue.getRecordedCount(), 4);
+    }
+
+    struct Flood
+    {
+        uint16_t maxDepth;
+        double lostPercent;
+    };
+
+    /**
+     * @brief Edges at `rateKhz` during `burstUs` of every `periodUs`, for one second
+     */
+    Flood flood(uint32_t rateKhz, uint32_t burstUs, uint32_t periodUs)
+    {
+        HostMcu::reset();
+        handled.clear();
+        EventQueue queue;
+        GPIOEXTI line(GPIOB, 5, EXTITrigger::RISING_FALLING);
+        CHECK(queue.attach(line, collect));
+
+        constexpr uint32_t SECOND = 1000000U * CYCLES_PER_US;
+        constexpr uint32_t DRAIN_INTERVAL = 100U * CYCLES_PER_US;
+        const uint32_t meanGap = 1000U * CYCLES_PER_US / rateKhz;
+        uint32_t seed = 0x6A09E667U ^ rateKhz;
+
+        std::vector<uint32_t> generated;
+        uint32_t nextDrain = DRAIN_INTERVAL;
+        uint32_t time = 0;
+        while (time < SECOND)
+        {
+            time += 1U + random(seed) % (2U * meanGap);
+            if (time % (periodUs * CYCLES_PER_US) >= burstUs * CYCLES_PER_US)
+            {
+                time += periodUs * CYCLES_PER_US - time % (periodUs * CYCLES_PER_US);   // Next burst
+            }
+            while (nextDrain <= time)
+            {
+                queue.dispatch();
+                nextDrain += DRAIN_INTERVAL;
+            }
+            GPIOB->IDR = (generated.size() % 2U == 0U) ? 0U : (1U << 5);
+            DWT->CYCCNT = time;
+            GPIOEXTI::handleInterrupt(5);
+            generated.push_back(time);
+        }
+        queue.dispatch();
+
+        // Every dispatched event is a generated one, in order; the rest are counted as lost
+        CHECK_EQ(queue.getRecordedCount() + queue.getLostCount(), generated.size());
+        CHECK_EQ(handled.size(), queue.getRecordedCount());
+        size_t cursor = 0;
+        bool ordered = true;
+        for (const PinEvent& event : handled)
+        {
+            while (cursor < generated.size() && generated[cursor] != event.timestamp)
+            {
+                cursor++;
+            }
+            ordered = ordered && cursor < generated.size();
+            cursor++;
+        }
+        CHECK(ordered);
+
+        const Flood result{queue.getMaxDepth(), 100.0 * queue.getLostCount() / generated.size()};
+        std::printf("%5u kHz, %4u us of every %5u us: %6zu events, max depth %2u, lost %4.1f %%\n", rateKhz, burstUs,
+                    periodUs, generated.size(), result.maxDepth, result.lostPercent);
+        queue.detach(line);
+        return result;
+    }
+
+    void testFlood()
+    {
+        const Flood continuous = flood(10, 1000, 1000);
+        CHECK(continuous.lostPercent == 0.0 && continuous.maxDepth < EVENT_QUEUE_SIZE / 4U);
+
+        const Flood bursts = flood(100, 1000, 10000);
+        CHECK(bursts.lostPercent == 0.0 && bursts.maxDepth < EVENT_QUEUE_SIZE - 1U);
+
+        // 100 events per drain interval against 63 free slots
+        const Flood overload = flood(1000, 1000, 10000);
+        CHECK_EQ(overload.maxDepth, EVENT_QUEUE_SIZE - 1U);
+        CHECK(overload.lostPercent > 30.0 && overload.lostPercent < 45.0);
+    }
+}
+
+int main()
+{
+    testRecordAndDispatch();
+    testFlood();
+    return Check::result();
+}
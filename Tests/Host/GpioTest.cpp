@@ -0,0 +1,256 @@
+/**
+ * @file    GpioTest.cpp
+ * @brief   GPIO: Port and Bus single-store updates, compile-time Pin, EXTI dispatch
+ * @author  MootSeeker
+ *
+ * Registers are plain memory, so BSRR keeps the last value stored to it.
+ * A group update done pin by pin would leave only the last pin there; the
+ * tests check that the one stored value carries every pin of the group,
+ * set bits in the low half and reset bits in the high half.
+ *
+ * EXTI_PR1 is write-1-to-clear on the target; here it keeps the value the
+ * driver wrote, which is exactly the set of lines it cleared.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+
+#include "gpio.h"
+
+namespace
+{
+    using namespace GPIO;
+
+    // ========================================================================
+    // Port and Bus
+    // ========================================================================
+
+    using Contiguous = Bus<0, 1, 2, 3, 4, 5, 6, 7>;
+    using Scattered = Bus<8, 10, 9, 15>;
+
+    static_assert(Contiguous::MASK == 0x00FFU && Contiguous::WIDTH == 8);
+    static_assert(Contiguous::toPortBits(0xA5) == 0xA5U && Contiguous::fromPortBits(0xFFA5) == 0xA5U);
+    static_assert(Scattered::MASK == 0x8700U);
+    static_assert(Scattered::toPortBits(0b0001) == (1U << 8));
+    static_assert(Scattered::toPortBits(0b0010) == (1U << 10));
+    static_assert(Scattered::toPortBits(0b0100) == (1U << 9));
+    static_assert(Scattered::toPortBits(0b1000) == (1U << 15));
+    static_assert(Scattered::fromPortBits(Scattered::toPortBits(0b1011)) == 0b1011U);
+
+    void testPort()
+    {
+        HostMcu::reset();
+        const Port port(GPIOB);
+
+        port.write((1U << 3) | (1U << 4), 1U << 3);
+        CHECK_EQ(GPIOB->BSRR, (1U << 3) | (1U << (4 + 16)));
+        port.write(0x00F0U, 0xFFFFU);   // Levels outside the mask are ignored
+        CHECK_EQ(GPIOB->BSRR, 0x00F0U);
+        port.set(0x0101U);
+        CHECK_EQ(GPIOB->BSRR, 0x0101U);
+        port.reset(0x0101U);
+        CHECK_EQ(GPIOB->BSRR, 0x01010000U);
+
+        // One ODR read, one store for all toggled pins; other pins are not written
+        GPIOB->ODR = 0x0005U;
+        port.toggle(0x000FU);
+        CHECK_EQ(GPIOB->BSRR, 0x000AU | (0x0005U << 16));
+
+        GPIOB->IDR = 0x12345678U;
+        CHECK_EQ(port.read(), 0x5678U);
+        const PortSnapshot snapshot = port.sample();
+        CHECK(snapshot.port == GPIOB);
+        CHECK(snapshot.get(3) == PinState::HIGH && snapshot.get(0) == PinState::LOW);
+
+        // Inputs of the port read the snapshot, not the register
+        GPIOInput input(GPIOB, 3);
+        GPIOB->IDR = 0;
+        CHECK(input.read() == PinState::LOW);
+        CHECK(input.read(snapshot) == PinState::HIGH);
+    }
+
+    void testBus()
+    {
+        HostMcu::reset();
+        const Contiguous data(GPIOC);
+        data.write(0xA5);
+        CHECK_EQ(GPIOC->BSRR, 0xA5U | (0x5AU << 16));   // 8 pins in one store
+
+        const Scattered nibble(GPIOA);
+        nibble.write(0b0110);
+        CHECK_EQ(GPIOA->BSRR, (1U << 10) | (1U << 9) | (((1U << 8) | (1U << 15)) << 16));
+
+        GPIOA->IDR = (1U << 15) | (1U << 8) | (1U << 3);
+        CHECK_EQ(nibble.read(), 0b1001U);
+        GPIOA->ODR = 1U << 10;
+        CHECK_EQ(nibble.readOutput(), 0b0010U);
+        nibble.toggle();
+        CHECK_EQ(GPIOA->BSRR, (1U << 8) | (1U << 9) | (1U << 15) | ((1U << 10) << 16));
+    }
+
+    /// toggle() drives BSRR from ODR and keeps the cached state in step with the pin
+    void testOutputToggle()
+    {
+        HostMcu::reset();
+        GPIOOutput led(GPIOA, 5);
+        GPIOA->ODR = 0;
+        led.toggle();
+        CHECK_EQ(GPIOA->BSRR, 1U << 5);
+        CHECK(led.getCurrentState() == PinState::HIGH);
+
+        GPIOA->ODR = 1U << 5;
+        led.toggle();
+        CHECK_EQ(GPIOA->BSRR, 1U << (5 + 16));
+        CHECK(led.getCurrentState() == PinState::LOW);
+    }
+
+    // ========================================================================
+    // Compile-time Pin
+    // ========================================================================
+
+    using Led = OutputPin<PortName::B, 11>;
+    using Button = InputPin<PortName::C, 13>;
+
+    struct Panel
+    {
+        [[no_unique_address]] Led led;
+        [[no_unique_address]] Button button;
+        uint32_t count;
+    };
+
+    static_assert(sizeof(Led) == 1 && sizeof(Button) == 1);
+    static_assert(sizeof(Panel) == sizeof(uint32_t), "Pin members must not take storage");
+    static_assert(Led::MASK == (1U << 11) && Led::PIN == 11 && Led::MODE == PinMode::OUTPUT);
+
+    void testPin()
+    {
+        HostMcu::reset();
+        CHECK(Led::port() == GPIOB);
+
+        Led::set();
+        CHECK_EQ(GPIOB->BSRR, 1U << 11);
+        Led::reset();
+        CHECK_EQ(GPIOB->BSRR, 1U << (11 + 16));
+        Led::write(PinState::HIGH);
+        CHECK_EQ(GPIOB->BSRR, 1U << 11);
+
+        GPIOB->ODR = 1U << 11;
+        Led::toggle();
+        CHECK_EQ(GPIOB->BSRR, 1U << (11 + 16));
+        CHECK(Led::readOutput() == PinState::HIGH);   // ODR is not modelled: still the value set above
+
+        GPIOC->IDR = 0;
+        CHECK(Button::isLow() && Button::read() == PinState::LOW);
+        GPIOC->IDR = 1U << 13;
+        CHECK(Button::isHigh());
+        CHECK(Button::read(Port(PortName::C).sample()) == PinState::HIGH);
+
+        // Runtime adapter drives the same pin
+        GPIOOutput runtimeLed(Led{});
+        CHECK(runtimeLed.getPort() == GPIOB && runtimeLed.getPin() == 11);
+        runtimeLed.reset();
+        CHECK_EQ(GPIOB->BSRR, 1U << (11 + 16));
+    }
+
+    // ========================================================================
+    // EXTI dispatch table
+    // ========================================================================
+
+    struct Counter
+    {
+        uint32_t calls = 0;
+    };
+
+    void count(void* context)
+    {
+        static_cast<Counter*>(context)->calls++;
+    }
+
+    void testDispatch()
+    {
+        HostMcu::reset();
+        Counter first;
+        Counter second;
+
+        GPIOEXTI::handleInterrupt(7);    // Unused line: no-op
+        GPIOEXTI::handleInterrupt(16);   // Out of range: ignored
+        {
+            GPIOEXTI button(GPIOC, 7, EXTITrigger::FALLING);
+            button.setCallback(count, &first);
+            GPIOEXTI::handleInterrupt(7);
+            GPIOEXTI::handleInterrupt(7);
+            CHECK_EQ(first.calls, 2);
+
+            // A second object on the line takes it over; the old one can no longer change it
+            GPIOEXTI other(GPIOA, 7, EXTITrigger::RISING);
+            other.setCallback(count, &second);
+            button.setCallback(count, &first);
+            GPIOEXTI::handleInterrupt(7);
+            CHECK_EQ(first.calls, 2);
+            CHECK_EQ(second.calls, 1);
+
+            other.setCallback(nullptr);
+            GPIOEXTI::handleInterrupt(7);
+            CHECK_EQ(second.calls, 1);
+            other.setCallback(count, &second);
+        }
+        // Destroying the owner clears the line
+        GPIOEXTI::handleInterrupt(7);
+        CHECK_EQ(second.calls, 1);
+    }
+
+    /// Lines in the order their callbacks ran
+    uint32_t dispatchOrder[16];
+    uint32_t dispatched = 0;
+
+    void record(void* context)
+    {
+        dispatchOrder[dispatched++] = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(context));
+    }
+
+    void testSharedVector()
+    {
+        HostMcu::reset();
+        GPIOEXTI line5(GPIOA, 5);
+        GPIOEXTI line7(GPIOB, 7);
+        GPIOEXTI line8(GPIOC, 8);
+        GPIOEXTI line9(GPIOA, 9);
+        GPIOEXTI line12(GPIOA, 12);
+        for (GPIOEXTI* pin : {&line5, &line7, &line8, &line9, &line12})
+        {
+            pin->setCallback(record, reinterpret_cast<void*>(static_cast<uintptr_t>(pin->getPin())));
+        }
+        EXTI->IMR1 = (1U << 5) | (1U << 7) | (1U << 9) | (1U << 12);   // Line 8 masked by its owner
+
+        // Simultaneous edges: lowest line first, all cleared with one write, the masked line left pending
+        EXTI->PR1 = (1U << 5) | (1U << 7) | (1U << 8) | (1U << 9) | (1U << 12);
+        dispatched = 0;
+        GPIO_EXTI_HandleLines(EXTI_LINES_9_5);
+        CHECK_EQ(dispatched, 3);
+        CHECK(dispatchOrder[0] == 5 && dispatchOrder[1] == 7 && dispatchOrder[2] == 9);
+        CHECK_EQ(EXTI->PR1, (1U << 5) | (1U << 7) | (1U << 9));
+
+        // Nothing pending within the vector: no write at all
+        EXTI->PR1 = (1U << 8) | (1U << 12);
+        dispatched = 0;
+        GPIOEXTI::handleLines(EXTI_LINES_9_5);
+        CHECK_EQ(dispatched, 0);
+        CHECK_EQ(EXTI->PR1, (1U << 8) | (1U << 12));
+
+        GPIOEXTI::handleLines(EXTI_LINES_15_10);
+        CHECK_EQ(dispatched, 1);
+        CHECK_EQ(dispatchOrder[0], 12);
+        CHECK_EQ(EXTI->PR1, 1U << 12);
+    }
+}
+
+int main()
+{
+    testPort();
+    testBus();
+    testOutputToggle();
+    testPin();
+    testDispatch();
+    testSharedVector();
+    return Check::result();
+}
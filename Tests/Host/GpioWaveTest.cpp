@@ -0,0 +1,204 @@
+/**
+ * @file    GpioWaveTest.cpp
+ * @brief   PatternPlayer on the DMA channel model: timer setup, word order, STREAM refills, shared channel
+ * @author  MootSeeker
+ *
+ * Each DmaModel::request() on DMA1 Channel 5 is one TIM15 update event, so
+ * the value in GPIOB->BSRR after request k is the word played at k periods.
+ * In STREAM mode the refill callback numbers the words it writes; the
+ * channel interrupt is entered a given number of words after its flag
+ * was raised. A refill within half the ring is never counted as late; one
+ * that comes later is, and every stale word played comes with a late count.
+ */
+
+#include "Check.h"
+#include "DmaModel.h"
+#include "HostMcu.h"
+
+#include "gpio_wave.h"
+#include "usart_bridge.h"
+
+#include <cstdio>
+
+namespace
+{
+    using namespace GPIO;
+
+    /// DMA address of a register or buffer, as the driver programs it
+    uint32_t address(const volatile void* pointer)
+    {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(pointer));
+    }
+
+    uint32_t table[4] = {bsrrWord(0x00FF, 0x00A5), bsrrWord(0x00FF, 0x005A), bsrrWord(0x0100, 0x0100),
+                         bsrrWord(0x0100, 0x0000)};
+    uint32_t ring[16];
+    uint8_t laneStorage[64];
+
+    void testTimerSetup()
+    {
+        HostMcu::reset();
+        DmaModel channel(DMA1, LL_DMA_CHANNEL_5);
+        PatternPlayer player(GPIOB);
+        CHECK(player.play(table, 4, PlayMode::LOOP, 1000000));
+        CHECK_EQ(TIM15->PSC, 0);
+        CHECK_EQ(TIM15->ARR, 31);
+        CHECK((TIM15->DIER & TIM_DIER_UDE) != 0U && (TIM15->CR1 & TIM_CR1_CEN) != 0U);
+        CHECK_EQ(DMA1_Channel5->CPAR, address(&GPIOB->BSRR));
+        CHECK(!HostMcu::isIrqEnabled(DMA1_Channel5_IRQn));   // LOOP runs without interrupts
+
+        // Slow rates use the prescaler
+        CHECK(player.play(table, 4, PlayMode::LOOP, 100));
+        CHECK_EQ(TIM15->PSC, 4);
+        CHECK_EQ(TIM15->ARR, 63999);
+
+        CHECK(player.play(table, 4, PlayMode::LOOP, 4000000));
+        CHECK(!player.play(table, 4, PlayMode::LOOP, 5000000));   // Fewer than 8 timer clocks per word
+        player.stop();
+        CHECK(!channel.isEnabled() && (TIM15->CR1 & TIM_CR1_CEN) == 0U);
+    }
+
+    void testLoopAndOneShot()
+    {
+        HostMcu::reset();
+        DmaModel channel(DMA1, LL_DMA_CHANNEL_5);
+        PatternPlayer player(GPIOB);
+        CHECK(player.play(table, 4, PlayMode::LOOP, 1000000));
+        bool inOrder = true;
+        for (uint32_t k = 0; k < 10; k++)
+        {
+            CHECK(channel.request());
+            inOrder = inOrder && GPIOB->BSRR == table[k % 4U];
+        }
+        CHECK(inOrder);
+
+        uint32_t doneCalls = 0;
+        auto done = [](void* context) { (*static_cast<uint32_t*>(context))++; };
+        CHECK(player.play(table, 3, PlayMode::ONE_SHOT, 1000000, done, &doneCalls));
+        CHECK(HostMcu::isIrqEnabled(DMA1_Channel5_IRQn));
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            channel.request();
+            channel.dispatch(GPIO_HandlePatternDmaInterrupt);
+        }
+        CHECK_EQ(GPIOB->BSRR, table[2]);
+        CHECK_EQ(doneCalls, 1);
+        CHECK(!player.isPlaying() && !channel.isEnabled());
+        CHECK(!channel.request());   // Timer stopped, no more words
+
+        // The channel is free again for another player
+        PatternPlayer other(GPIOA);
+        CHECK(other.play(table, 4, PlayMode::LOOP, 1000000));
+        CHECK(!player.play(table, 4, PlayMode::LOOP, 1000000));
+    }
+
+    uint32_t nextWord = 0;
+
+    void numberWords(void*, uint32_t* words, uint16_t count)
+    {
+        for (uint16_t i = 0; i < count; i++)
+        {
+            words[i] = nextWord++;
+        }
+    }
+
+    struct StreamRun
+    {
+        uint32_t staleWords;
+        uint32_t refills;
+        uint32_t lateRefills;
+    };
+
+    /**
+     * @brief 400 words from a 16-word ring, the interrupt entered 'latency' words after its flag
+     */
+    StreamRun runStream(uint32_t latency)
+    {
+        HostMcu::reset();
+        DmaModel channel(DMA1, LL_DMA_CHANNEL_5);
+        nextWord = 0;
+        PatternPlayer player(GPIOB);
+        CHECK(player.stream(ring, 16, 1000000, numberWords));
+        CHECK(HostMcu::isIrqEnabled(DMA1_Channel5_IRQn));
+
+        StreamRun run{0, 0, 0};
+        uint32_t flaggedAt = 0;
+        bool flagged = false;
+        for (uint32_t k = 0; k < 400; k++)
+        {
+            CHECK(channel.request());
+            run.staleWords += (GPIOB->BSRR != k) ? 1U : 0U;
+            if (!flagged && channel.isInterruptPending())
+            {
+                flagged = true;
+                flaggedAt = k;
+            }
+            if (flagged && k - flaggedAt >= latency)
+            {
+                channel.dispatch(GPIO_HandlePatternDmaInterrupt);
+                flagged = false;
+            }
+        }
+        run.refills = player.getRefillCount();
+        run.lateRefills = player.getLateRefillCount();
+        return run;
+    }
+
+    void testStream()
+    {
+        for (uint32_t latency : {0U, 4U, 7U, 8U, 12U})
+        {
+            const StreamRun run = runStream(latency);
+            std::printf("STREAM, 16-word ring, interrupt %2u words late: %3u refills, %2u late, %3u stale words\n",
+                        latency, run.refills, run.lateRefills, run.staleWords);
+            // Half the ring is the time a refill has; a stale word is never unreported
+            CHECK(run.staleWords == 0U || run.lateRefills > 0U);
+            if (latency < 8U)
+            {
+                CHECK_EQ(run.lateRefills, 0);
+                CHECK(run.refills >= 48U);
+            }
+            else
+            {
+                CHECK(run.lateRefills > 0U);
+            }
+        }
+        CHECK(runStream(12).staleWords > 0U);
+    }
+
+    /// Channel 5 is the USART_1 RX channel of the bridge: whoever enables it first keeps it
+    void testSharedChannel()
+    {
+        HostMcu::reset();
+        DmaModel channel(DMA1, LL_DMA_CHANNEL_5);
+        USART::BridgeLane lane(laneStorage, sizeof(laneStorage));
+        CHECK(lane.start(USART::PeripheralType::USART_1, USART1, USART::PeripheralType::USART_2, USART2).isSuccess());
+        CHECK(channel.isEnabled());
+
+        PatternPlayer player(GPIOB);
+        CHECK(!player.play(table, 4, PlayMode::LOOP, 1000000));
+        CHECK(!player.stream(ring, 16, 1000000, numberWords));
+        player.stop();
+        CHECK(channel.isEnabled());
+        CHECK_EQ(DMA1_Channel5->CPAR, address(&USART1->RDR));
+        CHECK(!player.isPlaying());
+
+        lane.stop();
+        CHECK(player.play(table, 4, PlayMode::LOOP, 1000000));
+        const USART::UsartStatus busy =
+            lane.start(USART::PeripheralType::USART_1, USART1, USART::PeripheralType::USART_2, USART2);
+        CHECK(busy.error == USART::UsartError::BUSY);
+        CHECK_EQ(busy.details, LL_DMA_CHANNEL_5);
+        CHECK_EQ(DMA1_Channel5->CPAR, address(&GPIOB->BSRR));
+        player.stop();
+    }
+}
+
+int main()
+{
+    testTimerSetup();
+    testLoopAndOneShot();
+    testStream();
+    testSharedChannel();
+    return Check::result();
+}
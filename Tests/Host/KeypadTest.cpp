@@ -0,0 +1,403 @@
+/**
+ * @file    KeypadTest.cpp
+ * @brief   MatrixScanner on the DMA channel model: scan traces, ghosting, shared channels, interrupt cost
+ * @author  MootSeeker
+ *
+ * The matrix is 4 x 6 (rows PB12..PB15, columns PC0..PC5). Each row step
+ * is one DmaModel::request() on DMA1 Channel 2 (compare 1 writes the row
+ * word to GPIOB->BSRR), then the wiring model sets GPIOC->IDR and one
+ * request on Channel 3 stores it (compare 2). In the wiring model released
+ * rows float, so current through three pressed keys of a rectangle pulls
+ * the fourth column low as well. The channel 3 interrupt is dispatched as
+ * soon as its flag is raised; the main loop takes edges every 10 ms.
+ *
+ * The trace (fixed seed) has 20 single presses, each with 0.2..3 ms of
+ * contact bounce on press and on release, and 5 chords that press three
+ * corners of a rectangle one after another and release them in the same
+ * order. Every press and release must be reported once and the fourth
+ * corner never.
+ *
+ * The benchmark times KEYPAD_HandleDmaInterrupt() on the host for a scan
+ * with no key pressed and one with every key pressed (all 6 row pairs in
+ * ghost rectangles) and prints the median time per interrupt.
+ */
+
+#include "Check.h"
+#include "DmaModel.h"
+#include "HostMcu.h"
+
+#include "Keypad.h"
+#include "usart_bridge.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr uint8_t ROWS = 4;
+    constexpr uint8_t COLUMNS = 6;
+    constexpr uint8_t FIRST_ROW = 12;
+    constexpr uint32_t ROW_MASK = 0xFU << FIRST_ROW;
+    constexpr uint32_t KEYS = ROWS * COLUMNS;
+    constexpr uint32_t TAKE_INTERVAL_US = 10000;
+
+    Keypad::MatrixScanner scanner({GPIOB, FIRST_ROW, ROWS, GPIOC, 0, COLUMNS});
+    uint8_t laneStorage[64];
+
+    /// DMA address of a register or buffer, as the driver programs it
+    uint32_t address(const volatile void* pointer)
+    {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(pointer));
+    }
+
+    /// xorshift32, deterministic traces
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint32_t uniform(uint32_t& state, uint32_t low, uint32_t high)
+    {
+        return low + random(state) % (high - low + 1U);
+    }
+
+    uint32_t keyOf(uint32_t row, uint32_t column)
+    {
+        return row * COLUMNS + column;
+    }
+
+    // ========================================================================
+    // Contacts and wiring
+    // ========================================================================
+
+    /// Contact level changes of one key, starting open
+    struct Contact
+    {
+        std::vector<uint32_t> edges;
+        size_t cursor = 0;
+
+        bool closedAt(uint32_t time)
+        {
+            while (cursor < edges.size() && edges[cursor] <= time)
+            {
+                cursor++;
+            }
+            return (cursor % 2U) != 0U;
+        }
+    };
+
+    /// Key that completes a chord's rectangle without being pressed, and the chord's time span
+    struct Phantom
+    {
+        uint32_t key;
+        uint32_t from;
+        uint32_t to;
+    };
+
+    struct Trace
+    {
+        Contact contacts[KEYS];
+        uint32_t presses[KEYS] = {};
+        std::vector<Phantom> phantoms;
+        uint32_t end = 0;
+    };
+
+    /// A contact change at 'time' with 0.2..3 ms of bounce, settled at the new level
+    void bounce(Contact& contact, uint32_t time, uint32_t& seed)
+    {
+        const uint32_t burstEnd = time + uniform(seed, 200, 3000);
+        bool atTarget = false;
+        while (time < burstEnd)
+        {
+            contact.edges.push_back(time);
+            atTarget = !atTarget;
+            time += uniform(seed, 20, 1000);
+        }
+        if (!atTarget)
+        {
+            contact.edges.push_back(time);
+        }
+    }
+
+    Trace makeTrace()
+    {
+        Trace trace;
+        uint32_t seed = 0x1F83D9ABU;
+        uint32_t time = 20000;
+        for (int i = 0; i < 20; i++)
+        {
+            const uint32_t key = uniform(seed, 0, KEYS - 1U);
+            const uint32_t hold = uniform(seed, 60000, 200000);
+            bounce(trace.contacts[key], time, seed);
+            bounce(trace.contacts[key], time + hold, seed);
+            trace.presses[key]++;
+            time += hold + uniform(seed, 60000, 200000);
+        }
+        for (int i = 0; i < 5; i++)
+        {
+            const uint32_t r0 = uniform(seed, 0, ROWS - 1U);
+            const uint32_t r1 = (r0 + uniform(seed, 1, ROWS - 1U)) % ROWS;
+            const uint32_t c0 = uniform(seed, 0, COLUMNS - 1U);
+            const uint32_t c1 = (c0 + uniform(seed, 1, COLUMNS - 1U)) % COLUMNS;
+            const uint32_t corners[3] = {keyOf(r0, c0), keyOf(r0, c1), keyOf(r1, c0)};
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                bounce(trace.contacts[corners[k]], time + k * 60000U, seed);
+                bounce(trace.contacts[corners[k]], time + 300000U + k * 60000U, seed);
+                trace.presses[corners[k]]++;
+            }
+            trace.phantoms.push_back(Phantom{keyOf(r1, c1), time, time + 700000U});
+            time += 700000;
+        }
+        trace.end = time;
+        return trace;
+    }
+
+    /// Column levels with 'row' driven low: closed keys connect columns and floating rows
+    uint16_t columnLevels(uint32_t closed, uint32_t row)
+    {
+        const uint32_t columnMask = (1U << COLUMNS) - 1U;
+        uint32_t rows = 1U << row;
+        uint32_t columns = 0;
+        uint32_t before = 0;
+        do
+        {
+            before = rows | (columns << ROWS);
+            for (uint32_t r = 0; r < ROWS; r++)
+            {
+                const uint32_t rowKeys = (closed >> (r * COLUMNS)) & columnMask;
+                if ((rows & (1U << r)) != 0U)
+                {
+                    columns |= rowKeys;
+                }
+                if ((rowKeys & columns) != 0U)
+                {
+                    rows |= 1U << r;
+                }
+            }
+        } while ((rows | (columns << ROWS)) != before);
+        return static_cast<uint16_t>(~columns);
+    }
+
+    /// Row selected by a BSRR word (its reset half)
+    uint32_t selectedRow(uint32_t bsrr)
+    {
+        const uint32_t low = (bsrr >> 16) & ROW_MASK;
+        for (uint32_t r = 0; r < ROWS; r++)
+        {
+            if (low == (1U << (FIRST_ROW + r)))
+            {
+                return r;
+            }
+        }
+        return ROWS;
+    }
+
+    // ========================================================================
+    // Scan traces
+    // ========================================================================
+
+    struct ScanRun
+    {
+        uint32_t interrupts;
+        uint32_t wrongPresses;
+        uint32_t wrongReleases;
+        uint32_t phantomPresses;
+        uint32_t ghostScans;
+        uint32_t missedScans;
+        uint32_t steps;
+    };
+
+    ScanRun runTrace(uint32_t scanIntervalUs)
+    {
+        HostMcu::reset();
+        DmaModel rowChannel(DMA1, LL_DMA_CHANNEL_2);
+        DmaModel columnChannel(DMA1, LL_DMA_CHANNEL_3);
+        Trace trace = makeTrace();
+
+        CHECK(scanner.start(scanIntervalUs));
+        const uint32_t stepUs = scanIntervalUs / ROWS;
+        CHECK_EQ(TIM1->PSC, 31);
+        CHECK_EQ(TIM1->ARR, stepUs - 1U);
+        CHECK_EQ(TIM1->CCR1, 1);
+        CHECK_EQ(TIM1->CCR2, stepUs - 1U);
+        CHECK_EQ(DMA1_Channel2->CPAR, address(&GPIOB->BSRR));
+        CHECK_EQ(DMA1_Channel3->CPAR, address(&GPIOC->IDR));
+        CHECK(HostMcu::isIrqEnabled(DMA1_Channel3_IRQn));
+
+        ScanRun run{0, 0, 0, 0, 0, 0, 0};
+        uint32_t presses[KEYS] = {};
+        uint32_t releases[KEYS] = {};
+        uint32_t nextTake = TAKE_INTERVAL_US;
+        for (uint32_t time = 0; time < trace.end; time += stepUs)
+        {
+            run.steps++;
+            CHECK(rowChannel.request());
+            const uint32_t row = selectedRow(GPIOB->BSRR);
+            uint32_t closed = 0;
+            for (uint32_t key = 0; key < KEYS; key++)
+            {
+                closed |= static_cast<uint32_t>(trace.contacts[key].closedAt(time + stepUs - 1U)) << key;
+            }
+            GPIOC->IDR = (row < ROWS) ? columnLevels(closed, row) : 0xFFFFU;
+            CHECK(columnChannel.request());
+            run.interrupts += columnChannel.dispatch(KEYPAD_HandleDmaInterrupt);
+
+            if (time >= nextTake)
+            {
+                nextTake += TAKE_INTERVAL_US;
+                const Debounce::Edges edges = scanner.takeEdges();
+                for (const Phantom& phantom : trace.phantoms)
+                {
+                    const bool during = time >= phantom.from && time < phantom.to;
+                    run.phantomPresses += (during && ((edges.pressed >> phantom.key) & 1U) != 0U) ? 1U : 0U;
+                }
+                for (uint32_t key = 0; key < KEYS; key++)
+                {
+                    presses[key] += (edges.pressed >> key) & 1U;
+                    releases[key] += (edges.released >> key) & 1U;
+                }
+            }
+        }
+        const Debounce::Edges last = scanner.takeEdges();
+        for (uint32_t key = 0; key < KEYS; key++)
+        {
+            presses[key] += (last.pressed >> key) & 1U;
+            releases[key] += (last.released >> key) & 1U;
+            run.wrongPresses += (presses[key] != trace.presses[key]) ? 1U : 0U;
+            run.wrongReleases += (releases[key] != trace.presses[key]) ? 1U : 0U;
+        }
+        CHECK(HostMcu::isIrqEnabled(DMA1_Channel3_IRQn));   // takeEdges() left it as it was
+        CHECK_EQ(scanner.getState(), 0);
+        CHECK_EQ(scanner.getScanCount(), run.interrupts);
+        run.ghostScans = scanner.getGhostScanCount();
+        run.missedScans = scanner.getMissedScanCount();
+
+        scanner.stop();
+        CHECK(!rowChannel.isEnabled() && !columnChannel.isEnabled());
+        CHECK_EQ(GPIOB->BSRR, ROW_MASK);   // All rows released
+        return run;
+    }
+
+    void testTraces()
+    {
+        for (uint32_t intervalUs : {1000U, 2000U, 5000U})
+        {
+            const ScanRun run = runTrace(intervalUs);
+            std::printf("scan %4u us (debounce %2u ms): %5u interrupts for %5u scans, wrong press/release counts "
+                        "%u/%u, phantom presses %u, ghost scans %u, missed scans %u\n",
+                        intervalUs, 4U * intervalUs / 1000U, run.interrupts, run.steps / ROWS, run.wrongPresses,
+                        run.wrongReleases, run.phantomPresses, run.ghostScans, run.missedScans);
+            CHECK_EQ(run.interrupts, run.steps / ROWS);   // One per full scan
+            CHECK_EQ(run.wrongPresses, 0);
+            CHECK_EQ(run.wrongReleases, 0);
+            CHECK_EQ(run.phantomPresses, 0);
+            CHECK(run.ghostScans > 0U);
+            CHECK_EQ(run.missedScans, 0);
+        }
+    }
+
+    // ========================================================================
+    // Shared channels and vector
+    // ========================================================================
+
+    /// Channels 2 and 3 are the USART_3 channels of the bridge: whoever enables them first keeps them
+    void testSharedChannels()
+    {
+        HostMcu::reset();
+        USART::BridgeLane lane(laneStorage, sizeof(laneStorage));
+        CHECK(lane.start(USART::PeripheralType::USART_3, USART3, USART::PeripheralType::USART_1, USART1).isSuccess());
+        const bool bridgeIrq = HostMcu::isIrqEnabled(DMA1_Channel3_IRQn);
+        CHECK(!scanner.start(2000));
+        CHECK(!scanner.isRunning());
+        scanner.stop();
+        CHECK((DMA1_Channel3->CCR & DMA_CCR_EN) != 0U);
+        CHECK_EQ(DMA1_Channel3->CPAR, address(&USART3->RDR));
+        scanner.takeEdges();
+        CHECK_EQ(HostMcu::isIrqEnabled(DMA1_Channel3_IRQn), bridgeIrq);
+        lane.stop();
+
+        // The TX side of a USART_3 lane is channel 2
+        CHECK(lane.start(USART::PeripheralType::USART_1, USART1, USART::PeripheralType::USART_3, USART3).isSuccess());
+        CHECK(!scanner.start(2000));
+        lane.stop();
+
+        CHECK(scanner.start(2000));
+        const USART::UsartStatus busy =
+            lane.start(USART::PeripheralType::USART_3, USART3, USART::PeripheralType::USART_1, USART1);
+        CHECK(busy.error == USART::UsartError::BUSY);
+        CHECK_EQ(DMA1_Channel3->CPAR, address(&GPIOC->IDR));
+        scanner.stop();
+
+        // Not running: taking edges does not enable the vector for someone else
+        CHECK(!HostMcu::isIrqEnabled(DMA1_Channel3_IRQn) || bridgeIrq);
+        NVIC_DisableIRQ(DMA1_Channel3_IRQn);
+        scanner.takeEdges();
+        CHECK(!HostMcu::isIrqEnabled(DMA1_Channel3_IRQn));
+
+        // An enabled vector keeps the priority it was given
+        NVIC_SetPriority(DMA1_Channel3_IRQn, 5);
+        NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+        CHECK(scanner.start(2000));
+        CHECK_EQ(HostMcu::getIrqPriority(DMA1_Channel3_IRQn), 5);
+        scanner.stop();
+    }
+
+    // ========================================================================
+    // Interrupt cost
+    // ========================================================================
+
+    /// Median host time of one KEYPAD_HandleDmaInterrupt() with every row reading 'columns'
+    double nanosecondsPerInterrupt(uint16_t columns)
+    {
+        HostMcu::reset();
+        DmaModel columnChannel(DMA1, LL_DMA_CHANNEL_3);
+        CHECK(scanner.start(2000));
+        GPIOC->IDR = columns;
+        for (uint32_t step = 0; step < 2U * ROWS; step++)
+        {
+            columnChannel.request();   // Both halves hold the same scan
+        }
+
+        constexpr int ROUNDS = 7;
+        constexpr int CALLS = 1 << 18;
+        double results[ROUNDS];
+        for (double& result : results)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < CALLS; i++)
+            {
+                DMA1->ISR = DMA_ISR_GIF3 | (((i & 1) != 0) ? DMA_ISR_TCIF3 : DMA_ISR_HTIF3);
+                KEYPAD_HandleDmaInterrupt();
+            }
+            result = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CALLS;
+        }
+        CHECK_EQ(scanner.getMissedScanCount(), 0);
+        scanner.stop();
+        std::sort(results, results + ROUNDS);
+        return results[ROUNDS / 2];
+    }
+
+    void benchmarkInterrupt()
+    {
+        const double idle = nanosecondsPerInterrupt(0xFFFFU);
+        const double ghosts = nanosecondsPerInterrupt(0xFFC0U);
+        CHECK(scanner.getGhostScanCount() > 0U);
+        std::printf("KEYPAD_HandleDmaInterrupt(), 4 x 6 keys: %.1f ns no key, %.1f ns all keys (6 ghost row pairs) "
+                    "(host)\n",
+                    idle, ghosts);
+    }
+}
+
+int main()
+{
+    testTraces();
+    testSharedChannels();
+    benchmarkInterrupt();
+    return Check::result();
+}
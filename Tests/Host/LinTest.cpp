@@ -0,0 +1,297 @@
+/**
+ * @file    LinTest.cpp
+ * @brief   LIN: PID/checksum, master and slave on one bus, schedule timer preload, break jitter
+ * @author  MootSeeker
+ *
+ * The master runs on the emulated USART_1 and the slave on USART_2. The
+ * bus is a LIN transceiver: every character either node sends is received
+ * by both, the sender included. A break request (RQR.SBKRQ) reaches both
+ * receivers as break detection (LBDF) followed by the 0x00 character.
+ * TIM6 is not emulated, so the test calls the update interrupt itself and
+ * checks what the handler writes to the timer.
+ *
+ * For the jitter measurement the test plays TIM6 in microseconds: an update
+ * event every ARR + 1 ticks, the ARR preload moving to the shadow register
+ * at each event, and the interrupt entered a random latency later (a
+ * same-priority interrupt still running). A handler that wrote CNT would
+ * move every later event. The break starts when the handler requests it.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "Lin.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    void testProtectedId()
+    {
+        // LIN 2.x specification, table of protected identifiers
+        CHECK_EQ(Lin::protectedId(0x00), 0x80);
+        CHECK_EQ(Lin::protectedId(0x10), 0x50);
+        CHECK_EQ(Lin::protectedId(0x11), 0x11);
+        CHECK_EQ(Lin::protectedId(0x3C), 0x3C);
+        CHECK_EQ(Lin::protectedId(0x3D), 0x7D);
+        CHECK_EQ(Lin::protectedId(0x3F), 0xBF);
+
+        // Enhanced over PID 0x4A and data 0x55 0x93 0xE5 (LIN 2.x specification example)
+        const uint8_t data[] = {0x55, 0x93, 0xE5};
+        CHECK_EQ(Lin::checksum(Lin::ChecksumModel::ENHANCED, 0x4A, data, sizeof(data)), 0xE6);
+        CHECK_EQ(Lin::checksum(Lin::ChecksumModel::CLASSIC, 0x4A, data, sizeof(data)), 0x31);
+    }
+
+    uint8_t motorCommand[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t motorStatus[8] = {};
+    uint8_t slaveCommand[4] = {};
+    uint8_t slaveStatus[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    constexpr Lin::Frame MASTER_FRAMES[] = {
+        {0x10, 4, Lin::Direction::PUBLISH, Lin::ChecksumModel::ENHANCED, motorCommand},
+        {0x11, 8, Lin::Direction::SUBSCRIBE, Lin::ChecksumModel::ENHANCED, motorStatus},
+    };
+    constexpr Lin::Frame SLAVE_FRAMES[] = {
+        {0x10, 4, Lin::Direction::SUBSCRIBE, Lin::ChecksumModel::ENHANCED, slaveCommand},
+        {0x11, 8, Lin::Direction::PUBLISH, Lin::ChecksumModel::ENHANCED, slaveStatus},
+    };
+    constexpr Lin::Slot SCHEDULE[] = {
+        {0, 10000},
+        {1, 15000},
+        {1, 12000},
+    };
+    static_assert(Lin::FrameTable(MASTER_FRAMES).isValid());
+    static_assert(Lin::ScheduleTable(SCHEDULE).isValid(Lin::FrameTable(MASTER_FRAMES), 19200));
+
+    // 8 data bytes need 1.4 * (34 + 90) bit times = 9042 us at 19200 baud
+    constexpr Lin::Slot SHORT_SCHEDULE[] = {{1, 9000}};
+    static_assert(!Lin::ScheduleTable(SHORT_SCHEDULE).isValid(Lin::FrameTable(MASTER_FRAMES), 19200));
+
+    USART::StandardUSART masterUart(USART::PeripheralType::USART_1);
+    USART::StandardUSART slaveUart(USART::PeripheralType::USART_2);
+
+    class Bus
+    {
+    public:
+        Bus() : master(masterUart), slave(slaveUart) {}
+
+        /// Deliver a requested break, then run until both nodes are idle
+        void run()
+        {
+            if ((masterUart.getInstance()->RQR & USART_RQR_SBKRQ) != 0U)
+            {
+                masterUart.getInstance()->RQR = 0;
+                for (UsartModel<USART::StandardUSART>* node : {&master, &slave})
+                {
+                    node->raise(USART_ISR_LBDF);
+                    node->queueReceive(0x00);
+                }
+            }
+
+            for (int guard = 0; guard < 1000; guard++)
+            {
+                const bool busy = master.step() | slave.step();
+                bool moved = false;
+                for (UsartModel<USART::StandardUSART>* sender : {&master, &slave})
+                {
+                    for (uint8_t byte : sender->takeTransmitted())
+                    {
+                        master.queueReceive(byte);
+                        slave.queueReceive(byte);
+                        moved = true;
+                    }
+                }
+                if (!busy && !moved)
+                {
+                    return;
+                }
+            }
+            CHECK(false);
+        }
+
+        UsartModel<USART::StandardUSART> master;
+        UsartModel<USART::StandardUSART> slave;
+    };
+
+    void testMasterSlave()
+    {
+        HostMcu::reset();
+        USART::Config config = USART::getDefaultUsartConfig();
+        config.baudRate = 19200;
+        CHECK(masterUart.initialize(config).isSuccess());
+        CHECK(slaveUart.initialize(config).isSuccess());
+        Bus bus;
+
+        static Lin::Master master(masterUart, MASTER_FRAMES, SCHEDULE);
+        static Lin::Slave slave(slaveUart, SLAVE_FRAMES);
+        CHECK(slave.start().isSuccess());
+        CHECK(master.start().isSuccess());
+        static Lin::Master second(slaveUart, SLAVE_FRAMES, SCHEDULE);
+        CHECK_EQ(second.start().error, USART::UsartError::BUSY);   // TIM6 has one owner
+
+        // Slot 0: master publishes 0x10
+        bus.run();
+        CHECK(std::equal(motorCommand, motorCommand + 4, slaveCommand));
+        CHECK_EQ(slave.getStatistics().frames, 1);
+        CHECK_EQ(master.getStatistics().frames, 1);   // Own response read back
+
+        // Slots 1 and 2: slave publishes 0x11
+        for (int slot = 1; slot <= 2; slot++)
+        {
+            LIN_HandleScheduleTimerInterrupt();
+            bus.run();
+        }
+        CHECK(std::equal(slaveStatus, slaveStatus + 8, motorStatus));
+        CHECK_EQ(master.getStatistics().frames, 3);
+        CHECK_EQ(slave.getStatistics().frames, 3);
+        CHECK_EQ(master.getStatistics().headerErrors + master.getStatistics().responseErrors, 0);
+        CHECK_EQ(slave.getStatistics().headerErrors + slave.getStatistics().responseErrors, 0);
+
+        // A slot that ends without a response counts as noResponse
+        slave.stop();
+        LIN_HandleScheduleTimerInterrupt();   // Slot 0 again: the master answers itself
+        bus.run();
+        LIN_HandleScheduleTimerInterrupt();   // Slot 1: nobody publishes 0x11
+        bus.run();
+        LIN_HandleScheduleTimerInterrupt();
+        bus.run();
+        CHECK_EQ(master.getStatistics().noResponse, 1);
+        CHECK_EQ(master.getCycleCount(), 1);
+        master.stop();
+    }
+
+    /// The handler writes the slot after next to the ARR preload and never touches the counter
+    void testSchedulePreload()
+    {
+        HostMcu::reset();
+        CHECK(masterUart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        UsartModel<USART::StandardUSART> wire(masterUart);
+
+        static Lin::Master master(masterUart, MASTER_FRAMES, SCHEDULE);
+        CHECK(master.start().isSuccess());
+        CHECK_EQ(TIM6->PSC, 31);
+        CHECK((TIM6->CR1 & TIM_CR1_ARPE) != 0U);
+        CHECK_EQ(TIM6->ARR, SCHEDULE[1].durationUs - 1U);   // Slot 0 was loaded directly, slot 1 is preloaded
+
+        for (uint8_t boundary = 1; boundary <= 6; boundary++)
+        {
+            wire.run();
+            TIM6->CNT = 1234;   // Interrupt latency since the update event
+            TIM6->SR = TIM_SR_UIF;
+            LIN_HandleScheduleTimerInterrupt();
+            CHECK_EQ(master.getCurrentSlot(), boundary % 3U);
+            CHECK_EQ(TIM6->ARR, SCHEDULE[(boundary + 1U) % 3U].durationUs - 1U);
+            CHECK_EQ(TIM6->CNT, 1234);
+            CHECK((TIM6->SR & TIM_SR_UIF) == 0U);
+        }
+        CHECK_EQ(master.getCycleCount(), 2);
+        wire.run();   // The last header, so the USART is idle for the next test
+        master.stop();
+    }
+
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint32_t uniform(uint32_t& state, uint32_t low, uint32_t high)
+    {
+        return low + random(state) % (high - low + 1U);
+    }
+
+    /// Break start against the nominal slot boundary over a schedule run, with interrupt latency injected
+    void testScheduleJitter()
+    {
+        constexpr uint32_t CYCLES = 1000;
+        constexpr uint32_t MAX_LATENCY_US = 40;   // Longest same-priority interrupt at a boundary
+        constexpr uint32_t BIT_US = 1000000U / 19200U;
+
+        HostMcu::reset();
+        USART::Config config = USART::getDefaultUsartConfig();
+        config.baudRate = 19200;
+        CHECK(masterUart.initialize(config).isSuccess());
+        CHECK(slaveUart.initialize(config).isSuccess());
+        Bus bus;
+
+        static Lin::Master master(masterUart, MASTER_FRAMES, SCHEDULE);
+        static Lin::Slave slave(slaveUart, SLAVE_FRAMES);
+        CHECK(slave.start().isSuccess());
+        CHECK(master.start().isSuccess());
+        bus.run();   // Slot 0 header sent by start(), at t = 0
+
+        // start() loaded slot 0 into the shadow register with the UG event
+        uint64_t counterStart = 0;
+        uint32_t shadowArr = SCHEDULE[0].durationUs - 1U;
+        uint64_t nominal = 0;
+        uint32_t seed = 0x1F123BB5U;
+        int64_t maxDeviation = 0;
+        int64_t minDeviation = INT64_MAX;
+        size_t driftingBoundaries = 0;
+        size_t lateFrames = 0;
+        size_t breaks = 0;
+
+        const size_t slots = CYCLES * (sizeof(SCHEDULE) / sizeof(SCHEDULE[0]));
+        for (size_t boundary = 1; boundary <= slots; boundary++)
+        {
+            nominal += SCHEDULE[(boundary - 1U) % 3U].durationUs;
+
+            // Update event: the preload becomes the next period
+            const uint64_t update = counterStart + shadowArr + 1U;
+            shadowArr = TIM6->ARR;
+            counterStart = update;
+
+            const uint32_t latency = uniform(seed, 0, MAX_LATENCY_US);
+            const uint64_t now = update + latency;
+            TIM6->CNT = latency;
+            TIM6->SR = TIM_SR_UIF;
+            LIN_HandleScheduleTimerInterrupt();
+            counterStart = now - TIM6->CNT;   // Only moves if the handler restarted the counter
+
+            if ((masterUart.getInstance()->RQR & USART_RQR_SBKRQ) == 0U)
+            {
+                continue;
+            }
+            breaks++;
+            const int64_t deviation = static_cast<int64_t>(now) - static_cast<int64_t>(nominal);
+            maxDeviation = std::max(maxDeviation, deviation);
+            minDeviation = std::min(minDeviation, deviation);
+            driftingBoundaries += (deviation != static_cast<int64_t>(latency)) ? 1 : 0;
+
+            // The frame must be off the bus before the next break
+            const size_t before = bus.master.getStepCount();
+            bus.run();
+            const double frameUs = static_cast<double>(bus.master.getStepCount() - before) *
+                                   bus.master.getCharacterBits() * 1e6 / 19200.0;
+            lateFrames += (now + frameUs >= nominal + SCHEDULE[boundary % 3U].durationUs) ? 1 : 0;
+        }
+
+        CHECK_EQ(breaks, slots);
+        CHECK_EQ(driftingBoundaries, 0);
+        CHECK(minDeviation >= 0);
+        CHECK(maxDeviation <= static_cast<int64_t>(MAX_LATENCY_US) && maxDeviation < BIT_US);
+        CHECK_EQ(lateFrames, 0);
+        CHECK_EQ(master.getStatistics().frames, slots + 1U);
+        CHECK_EQ(master.getStatistics().headerErrors + master.getStatistics().responseErrors, 0);
+        std::printf("  %zu slots, 0..%u us interrupt latency: break start %lld..%lld us from nominal, "
+                    "%zu boundaries drifted (bit time %u us)\n",
+                    slots, static_cast<unsigned>(MAX_LATENCY_US), static_cast<long long>(minDeviation),
+                    static_cast<long long>(maxDeviation), driftingBoundaries, static_cast<unsigned>(BIT_US));
+        master.stop();
+        slave.stop();
+    }
+}
+
+int main()
+{
+    testProtectedId();
+    testMasterSlave();
+    testSchedulePreload();
+    testScheduleJitter();
+    return Check::result();
+}
@@ -0,0 +1,514 @@
+/**
+ * @file    LogicCaptureTest.cpp
+ * @brief   LogicCapture: timer setup, shared DMA channel, stream and VCD round trips, compression and UART limit
+ * @author  MootSeeker
+ *
+ * Each DmaModel::request() on DMA1 Channel 6 is one TIM1 update event: the
+ * test puts the next sample of a random signal on GPIOB->IDR (8 pins, each
+ * sample changes with probability 1/changeEvery) and lets the channel copy
+ * it into the ring. poll() runs every sample as a main loop would, and the
+ * UsartModel sends either everything at once or a given number of bytes
+ * per sample, the UART byte rate over the sample rate.
+ *
+ * The received stream is decoded independently of VcdConverter and
+ * compared sample for sample with the signal around the trigger. The VCD
+ * output is parsed back and compared with the decoded samples.
+ *
+ * The compression part prints the ratio for several change densities and
+ * the sample rate a 2 Mbaud UART (200 kB/s) sustains with it, then checks
+ * that bound by pacing the UART at 0.8 and 1.25 times the rate.
+ */
+
+#include "Check.h"
+#include "DmaModel.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "LogicCapture.h"
+#include "usart_bridge.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using LogicCapture::State;
+    using LogicCapture::TriggerType;
+
+    constexpr uint16_t RING_COUNT = 1024;
+    constexpr uint16_t PIN_MASK = 0x00FF;
+    constexpr uint32_t UART_BYTE_RATE = 200000;   // 2 Mbaud, 8N1
+
+    USART::StandardUSART uart(USART::PeripheralType::USART_1);
+    uint16_t ring[RING_COUNT];
+    uint8_t encoded[2048];
+    uint8_t laneStorage[64];
+
+    /// xorshift32, deterministic signals
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint32_t address(const volatile void* pointer)
+    {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(pointer));
+    }
+
+    LogicCapture::Config makeConfig(uint32_t rateHz, uint32_t preTrigger, uint32_t postTrigger,
+                                    LogicCapture::Trigger trigger)
+    {
+        return LogicCapture::Config{GPIOB, PIN_MASK, rateHz, preTrigger, postTrigger, trigger};
+    }
+
+    // ========================================================================
+    // Timer setup and shared channel
+    // ========================================================================
+
+    void testSampleRates()
+    {
+        HostMcu::reset();
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        LogicCapture::Capture capture(uart, ring, RING_COUNT, encoded, sizeof(encoded));
+        const LogicCapture::Trigger none{TriggerType::NONE, 0, 0};
+
+        CHECK(capture.start(makeConfig(1000000, 0, 10, none)));
+        CHECK_EQ(TIM1->PSC, 0);
+        CHECK_EQ(TIM1->ARR, 31);
+        CHECK_EQ(DMA1_Channel6->CPAR, address(&GPIOB->IDR));
+        capture.stop();
+
+        // Slow rates: the prescaler divides the period exactly
+        CHECK(capture.start(makeConfig(100, 0, 10, none)));
+        CHECK_EQ((TIM1->PSC + 1U) * (TIM1->ARR + 1U), 320000);
+        CHECK(TIM1->ARR <= 0xFFFFU);
+        capture.stop();
+        CHECK(capture.start(makeConfig(1, 0, 10, none)));
+        CHECK_EQ((TIM1->PSC + 1U) * (TIM1->ARR + 1U), 32000000);
+        capture.stop();
+
+        // The header carries the rate, so one the timer cannot run at exactly is refused
+        CHECK(!capture.start(makeConfig(300000, 0, 10, none)));   // 106.67 clocks
+        CHECK(!capture.start(makeConfig(7, 0, 10, none)));
+        CHECK(!capture.start(makeConfig(4000000, 0, 10, none)));   // Above MAX_SAMPLE_RATE_HZ
+        CHECK(!capture.start(makeConfig(0, 0, 10, none)));
+        CHECK(capture.start(makeConfig(2000000, 0, 10, none)));
+        capture.stop();
+    }
+
+    /// Channel 6 is the USART_2 RX channel of the bridge: whoever enables it first keeps it
+    void testSharedChannel()
+    {
+        HostMcu::reset();
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        LogicCapture::Capture capture(uart, ring, RING_COUNT, encoded, sizeof(encoded));
+        const LogicCapture::Config config = makeConfig(1000000, 0, 10, {TriggerType::NONE, 0, 0});
+
+        USART::BridgeLane lane(laneStorage, sizeof(laneStorage));
+        CHECK(lane.start(USART::PeripheralType::USART_2, USART2, USART::PeripheralType::USART_3, USART3).isSuccess());
+        CHECK(!capture.start(config));
+        capture.stop();
+        CHECK((DMA1_Channel6->CCR & DMA_CCR_EN) != 0U);
+        CHECK_EQ(DMA1_Channel6->CPAR, address(&USART2->RDR));
+        lane.stop();
+
+        CHECK(capture.start(config));
+        const USART::UsartStatus busy =
+            lane.start(USART::PeripheralType::USART_2, USART2, USART::PeripheralType::USART_3, USART3);
+        CHECK(busy.error == USART::UsartError::BUSY);
+        CHECK_EQ(busy.details, LL_DMA_CHANNEL_6);
+        CHECK_EQ(DMA1_Channel6->CPAR, address(&GPIOB->IDR));
+        capture.stop();
+    }
+
+    // ========================================================================
+    // Capture runs
+    // ========================================================================
+
+    struct Run
+    {
+        std::vector<uint16_t> signal;   ///< Every sample the DMA took
+        std::vector<uint8_t> stream;    ///< Bytes on the wire
+        State state;
+        uint32_t preTriggerCount;
+    };
+
+    /**
+     * @param bytesPerSample UART bytes per sample period, 0 = unlimited
+     */
+    Run runCapture(const LogicCapture::Config& config, uint32_t changeEvery, uint32_t seed, double bytesPerSample)
+    {
+        HostMcu::reset();
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        UsartModel<USART::StandardUSART> wire(uart);
+        DmaModel channel(DMA1, LL_DMA_CHANNEL_6);
+        LogicCapture::Capture capture(uart, ring, RING_COUNT, encoded, sizeof(encoded));
+        CHECK(capture.start(config));
+
+        Run run{{}, {}, State::IDLE, 0};
+        uint16_t value = static_cast<uint16_t>(random(seed) & PIN_MASK);
+        double credit = 0.0;
+        while ((capture.getState() == State::ARMED || capture.getState() == State::TRIGGERED) &&
+               run.signal.size() < 4000000U)
+        {
+            run.signal.push_back(value);
+            GPIOB->IDR = 0xA500U | value;   // Pins outside the mask must not show up
+            CHECK(channel.request());
+            channel.dispatch(LOGIC_CAPTURE_HandleDmaInterrupt);
+            capture.poll();
+
+            if (bytesPerSample == 0.0)
+            {
+                while (capture.getPendingBytes() != 0)
+                {
+                    wire.run();
+                    capture.poll();
+                }
+            }
+            else
+            {
+                for (credit += bytesPerSample; credit >= 1.0; credit -= 1.0)
+                {
+                    wire.step();
+                }
+            }
+
+            if (random(seed) % changeEvery == 0U)
+            {
+                value = static_cast<uint16_t>(value ^ (1U + random(seed) % PIN_MASK));
+            }
+        }
+
+        for (int i = 0; i < 1000 && (capture.getPendingBytes() != 0 || wire.step()); i++)
+        {
+            capture.poll();
+            wire.run();
+        }
+        run.stream = wire.takeTransmitted();
+        run.state = capture.getState();
+        run.preTriggerCount = capture.getPreTriggerCount();
+        CHECK_EQ(run.stream.size(), capture.getEncodedBytes());
+        return run;
+    }
+
+    struct Decoded
+    {
+        bool valid;
+        uint16_t pinMask;
+        uint32_t rateHz;
+        uint32_t preTrigger;
+        uint16_t status;
+        std::vector<uint16_t> samples;
+    };
+
+    uint32_t readLittleEndian(const std::vector<uint8_t>& bytes, size_t offset, size_t size)
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            value |= static_cast<uint32_t>(bytes[offset + i]) << (8U * i);
+        }
+        return value;
+    }
+
+    /// Stream format of LogicCapture.h, decoded without VcdConverter
+    Decoded decode(const std::vector<uint8_t>& bytes)
+    {
+        Decoded decoded{false, 0, 0, 0, 0, {}};
+        if (bytes.size() < LogicCapture::HEADER_SIZE || bytes[0] != 'L' || bytes[1] != 'A' || bytes[2] != 'C' ||
+            bytes[3] != '1' || bytes[4] != 'B')
+        {
+            return decoded;
+        }
+        decoded.pinMask = static_cast<uint16_t>(readLittleEndian(bytes, 6, 2));
+        decoded.rateHz = readLittleEndian(bytes, 8, 4);
+        decoded.preTrigger = readLittleEndian(bytes, 12, 4);
+
+        size_t position = LogicCapture::HEADER_SIZE;
+        while (position + 3U <= bytes.size())
+        {
+            const uint16_t value = static_cast<uint16_t>(readLittleEndian(bytes, position, 2));
+            position += 2;
+            uint32_t length = 0;
+            for (uint32_t shift = 0; position < bytes.size(); shift += 7)
+            {
+                const uint8_t byte = bytes[position++];
+                length |= static_cast<uint32_t>(byte & 0x7FU) << shift;
+                if ((byte & 0x80U) == 0U)
+                {
+                    break;
+                }
+            }
+            if (length == 0)
+            {
+                decoded.status = value;
+                decoded.valid = position == bytes.size();
+                return decoded;
+            }
+            decoded.samples.insert(decoded.samples.end(), length, value);
+        }
+        return decoded;
+    }
+
+    /// Index of the trigger sample in the signal as the capture defines it
+    size_t findTrigger(const std::vector<uint16_t>& signal, const LogicCapture::Trigger& trigger)
+    {
+        for (size_t i = 0; i < signal.size(); i++)
+        {
+            const uint16_t now = signal[i];
+            const uint16_t before = (i == 0) ? now : signal[i - 1];
+            const uint16_t rising = static_cast<uint16_t>(~before & now & trigger.mask);
+            const uint16_t falling = static_cast<uint16_t>(before & ~now & trigger.mask);
+            switch (trigger.type)
+            {
+                case TriggerType::NONE:
+                    return i;
+                case TriggerType::RISING:
+                    if (rising != 0U)
+                    {
+                        return i;
+                    }
+                    break;
+                case TriggerType::FALLING:
+                    if (falling != 0U)
+                    {
+                        return i;
+                    }
+                    break;
+                case TriggerType::EDGE:
+                    if ((rising | falling) != 0U)
+                    {
+                        return i;
+                    }
+                    break;
+                case TriggerType::PATTERN:
+                    if ((now & trigger.mask) == (trigger.value & trigger.mask))
+                    {
+                        return i;
+                    }
+                    break;
+            }
+        }
+        return signal.size();
+    }
+
+    /// Pre-trigger samples the HISTORY_RUNS newest runs before the trigger cover
+    uint32_t historyDepth(const std::vector<uint16_t>& signal, size_t triggerIndex)
+    {
+        uint32_t covered = 0;
+        uint32_t runs = 0;
+        for (size_t i = triggerIndex; i > 0 && runs < LogicCapture::HISTORY_RUNS; i--)
+        {
+            covered++;
+            if (i == 1U || signal[i - 2] != signal[i - 1])
+            {
+                runs++;
+            }
+        }
+        return covered;
+    }
+
+    // ========================================================================
+    // VCD
+    // ========================================================================
+
+    class StringSink : public LogicCapture::TextSink
+    {
+    public:
+        std::string text;
+
+        void write(const char* data, size_t length) override { text.append(data, length); }
+    };
+
+    /**
+     * @brief Parse the VCD back into one value per sample (1 MS/s: 1000 ns per sample)
+     * @param triggerSample Set to the sample of the trigger comment
+     */
+    std::vector<uint16_t> parseVcd(const std::string& vcd, uint32_t& triggerSample)
+    {
+        std::vector<uint16_t> samples;
+        uint16_t value = 0;
+        uint64_t time = 0;
+        size_t position = vcd.find("$enddefinitions $end\n");
+        if (position == std::string::npos)
+        {
+            return samples;
+        }
+        position += 21;
+        while (position < vcd.size())
+        {
+            const size_t end = vcd.find('\n', position);
+            const std::string line = vcd.substr(position, end - position);
+            position = end + 1U;
+            if (line[0] == '#')
+            {
+                const uint64_t next = std::stoull(line.substr(1)) / 1000U;
+                samples.insert(samples.end(), next - time, value);
+                time = next;
+            }
+            else if ((line[0] == '0' || line[0] == '1') && line.size() == 2U)
+            {
+                const uint16_t bit = static_cast<uint16_t>(1U << (line[1] - '!'));
+                value = static_cast<uint16_t>((line[0] == '1') ? (value | bit) : (value & ~bit));
+            }
+            else if (line == "$comment trigger $end")
+            {
+                triggerSample = static_cast<uint32_t>(time);
+            }
+        }
+        return samples;
+    }
+
+    void checkVcd(const std::vector<uint8_t>& stream, const Decoded& decoded, uint32_t seed)
+    {
+        StringSink sink;
+        LogicCapture::VcdConverter converter(sink);
+        size_t position = 0;
+        while (position < stream.size())
+        {
+            // Bytes arrive in arbitrary chunks
+            const size_t chunk = std::min<size_t>(1U + random(seed) % 40U, stream.size() - position);
+            converter.feed(stream.data() + position, chunk);
+            position += chunk;
+        }
+        CHECK(converter.isComplete());
+        CHECK_EQ(converter.getSampleCount(), decoded.samples.size());
+        CHECK(sink.text.find("$var wire 1 $ PB3 $end") != std::string::npos);
+        CHECK(sink.text.find("PB8") == std::string::npos);
+
+        uint32_t triggerSample = 0xFFFFFFFFU;
+        const std::vector<uint16_t> samples = parseVcd(sink.text, triggerSample);
+        CHECK(samples == decoded.samples);
+        CHECK_EQ(triggerSample, decoded.preTrigger);
+    }
+
+    // ========================================================================
+    // Round trips
+    // ========================================================================
+
+    /// Checks the received stream against the signal; returns the decoded capture
+    Decoded checkRoundTrip(const char* name, const LogicCapture::Config& config, const Run& run)
+    {
+        const Decoded decoded = decode(run.stream);
+        CHECK(decoded.valid);
+        CHECK_EQ(decoded.pinMask, PIN_MASK);
+        CHECK_EQ(decoded.rateHz, config.sampleRateHz);
+        CHECK_EQ(decoded.preTrigger, run.preTriggerCount);
+
+        const size_t triggerIndex = findTrigger(run.signal, config.trigger);
+        const uint32_t expectedPre = std::min(config.preTrigger, historyDepth(run.signal, triggerIndex));
+        CHECK_EQ(run.preTriggerCount, expectedPre);
+
+        // Sample for sample from the first pre-trigger sample on; all of them unless it overran
+        const size_t first = triggerIndex - run.preTriggerCount;
+        bool same = first + decoded.samples.size() <= run.signal.size();
+        for (size_t i = 0; same && i < decoded.samples.size(); i++)
+        {
+            same = decoded.samples[i] == run.signal[first + i];
+        }
+        if (!CHECK(same))
+        {
+            std::printf("  capture \"%s\" does not match the signal\n", name);
+        }
+        if (run.state == State::DONE)
+        {
+            CHECK_EQ(decoded.status, LogicCapture::STATUS_COMPLETE);
+            CHECK_EQ(decoded.samples.size(), run.preTriggerCount + config.postTrigger);
+        }
+        else
+        {
+            CHECK_EQ(decoded.status, LogicCapture::STATUS_OVERRUN);
+        }
+        return decoded;
+    }
+
+    void testTriggers()
+    {
+        const struct
+        {
+            const char* name;
+            LogicCapture::Trigger trigger;
+            uint32_t preTrigger;
+        } cases[] = {
+            {"none", {TriggerType::NONE, 0, 0}, 500},
+            {"rising PB3", {TriggerType::RISING, 0x0008, 0}, 300},
+            {"falling PB3", {TriggerType::FALLING, 0x0008, 0}, 300},
+            {"edge PB4/PB5", {TriggerType::EDGE, 0x0030, 0}, 50},
+            {"pattern 0101 on PB0..3", {TriggerType::PATTERN, 0x000F, 0x0005}, 400},
+        };
+
+        uint32_t seed = 0x510E527FU;
+        for (const auto& item : cases)
+        {
+            // Rare changes so the trigger comes late and the history is deep enough
+            const LogicCapture::Config config = makeConfig(1000000, item.preTrigger, 3000, item.trigger);
+            const Run run = runCapture(config, 40, random(seed), 0.0);
+            CHECK(run.state == State::DONE);
+            const Decoded decoded = checkRoundTrip(item.name, config, run);
+            checkVcd(run.stream, decoded, seed);
+        }
+
+        // Every sample changes: HISTORY_RUNS changes cut the pre-trigger depth short
+        const LogicCapture::Config busy = makeConfig(1000000, 1000, 2000, {TriggerType::PATTERN, 0x00FF, 0x00A5});
+        const Run run = runCapture(busy, 1, 0x9B05688CU, 0.0);
+        CHECK_EQ(run.preTriggerCount, LogicCapture::HISTORY_RUNS);
+        checkVcd(run.stream, checkRoundTrip("every sample changes", busy, run), seed);
+    }
+
+    // ========================================================================
+    // Compression and UART limit
+    // ========================================================================
+
+    void testCompression()
+    {
+        constexpr uint32_t SAMPLES = 200000;
+        std::printf("changes per sample | compression | UART-bound rate at %u B/s\n", UART_BYTE_RATE);
+        double ratioOneInTen = 0.0;
+        for (uint32_t changeEvery : {1U, 3U, 10U, 15U, 45U, 150U})
+        {
+            const LogicCapture::Config config = makeConfig(1000000, 0, SAMPLES, {TriggerType::NONE, 0, 0});
+            const Run run = runCapture(config, changeEvery, 0x1F83D9ABU ^ changeEvery, 0.0);
+            checkRoundTrip("compression", config, run);
+
+            // Raw capture is 2 bytes per sample
+            const double ratio = 2.0 * SAMPLES / run.stream.size();
+            const double uartBound = UART_BYTE_RATE * ratio / 2.0;
+            std::printf("1/%-16u | %11.2f | %6.0f kS/s%s\n", changeEvery, ratio, uartBound / 1000.0,
+                        uartBound > LogicCapture::MAX_SAMPLE_RATE_HZ ? " (above MAX_SAMPLE_RATE_HZ)" : "");
+            if (changeEvery == 1U)
+            {
+                CHECK(ratio > 0.65 && ratio < 0.68);   // 3-byte record per sample
+            }
+            if (changeEvery == 10U)
+            {
+                ratioOneInTen = ratio;
+            }
+        }
+
+        // The bound holds: a capture paced at 0.8 x completes, at 1.25 x it overruns
+        const double bound = UART_BYTE_RATE * ratioOneInTen / 2.0;
+        const LogicCapture::Config config = makeConfig(1000000, 0, SAMPLES, {TriggerType::NONE, 0, 0});
+        const Run slow = runCapture(config, 10, 0x5BE0CD19U, UART_BYTE_RATE / (0.8 * bound));
+        const Run fast = runCapture(config, 10, 0x5BE0CD19U, UART_BYTE_RATE / (1.25 * bound));
+        std::printf("1/10 changes, UART paced: 0.8 x bound %s, 1.25 x bound %s after %zu samples\n",
+                    slow.state == State::DONE ? "complete" : "overrun",
+                    fast.state == State::DONE ? "complete" : "overrun", fast.signal.size());
+        CHECK(slow.state == State::DONE);
+        CHECK(fast.state == State::OVERRUN);
+        checkRoundTrip("overrun", config, fast);
+    }
+}
+
+int main()
+{
+    testSampleRates();
+    testSharedChannel();
+    testTriggers();
+    testCompression();
+    return Check::result();
+}
@@ -0,0 +1,148 @@
+/**
+ * @file    LoopbackBenchmarkTest.cpp
+ * @brief   The loopback benchmark sweep (Examples/03) on the USART model: no drops, line-rate throughput and latency
+ * @author  MootSeeker
+ *
+ * ModelLoopbackBackend gives runCase() the emulated USART_1 in half-duplex
+ * loopback, as INTERNAL_LOOPBACK does on the board. Its cycle counter runs
+ * at SystemCoreClock and only moves with the line: each receive() poll
+ * costs POLL_CYCLES, and the USART model steps once per character time.
+ * Throughput and latency are therefore what the driver makes of the line
+ * rate, with no CPU time charged; cycles_per_byte stays 0 and is measured
+ * on target only. Every case prints the BENCH record App.cpp would send.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "LoopbackBenchmark.h"
+
+#include <cstdio>
+#include <optional>
+
+namespace
+{
+    constexpr uint32_t BAUD_RATES[] = {115200U, 460800U, 921600U, 2000000U};
+    constexpr uint16_t MESSAGE_SIZES[] = {1U, 16U, 64U, 200U};
+    constexpr uint32_t MESSAGES_PER_CASE = 200U;
+
+    /// Cost of one wait-loop pass, below IDLE_LOOP_MAX_CYCLES so it never counts as driver time
+    constexpr uint32_t POLL_CYCLES = 16U;
+    static_assert(POLL_CYCLES < IDLE_LOOP_MAX_CYCLES);
+
+    class ModelLoopbackBackend
+    {
+    public:
+        USART::UsartStatus configure(uint32_t baudRate)
+        {
+            USART::Config config = USART::getDefaultUsartConfig();
+            config.baudRate = baudRate;
+            const USART::UsartStatus status = uart.initialize(config);
+            if (status.isSuccess())
+            {
+                wire.emplace(uart);
+                wire->setLoopback(true);
+                characterCycles = static_cast<double>(cyclesPerMicrosecond()) * 1e6 * wire->getCharacterBits() /
+                                  baudRate;
+                lineBusy = false;
+            }
+            return status;
+        }
+
+        uint16_t send(const uint8_t* data, uint16_t length)
+        {
+            const uint16_t queued = uart.sendData(data, length);
+            wire->serviceInterrupts();
+            if (!lineBusy)
+            {
+                // The first start bit leaves now, not on the old character grid
+                nextCharacter = static_cast<double>(clock) + characterCycles;
+                lineBusy = true;
+            }
+            return queued;
+        }
+
+        uint16_t receive(uint8_t* data, uint16_t maxLength)
+        {
+            clock += POLL_CYCLES;
+            while (lineBusy && static_cast<double>(clock) >= nextCharacter)
+            {
+                lineBusy = wire->step();
+                nextCharacter += characterCycles;
+            }
+            return uart.receiveData(data, maxLength);
+        }
+
+        uint32_t rxOverflowCount() const { return uart.getRxOverflowCount(); }
+        uint32_t rxErrorCount() const { return uart.getRxErrorCount(); }
+        uint32_t cycles() const { return static_cast<uint32_t>(clock); }
+        static uint32_t cyclesPerMicrosecond() { return SystemCoreClock / 1000000U; }
+
+    private:
+        USART::StandardUSART uart{USART::PeripheralType::USART_1};
+        std::optional<UsartModel<USART::StandardUSART>> wire;
+        uint64_t clock = 0;
+        double characterCycles = 0.0;
+        double nextCharacter = 0.0;
+        bool lineBusy = false;
+    };
+
+    void reportCase(const CaseResult& r)
+    {
+        const uint32_t cyclesPerUs = ModelLoopbackBackend::cyclesPerMicrosecond();
+        const uint32_t elapsedUs = (r.elapsedCycles / cyclesPerUs) + 1U;
+        const uint32_t bytesPerSecond =
+            static_cast<uint32_t>((static_cast<uint64_t>(r.bytesVerified) * 1000000ULL) / elapsedUs);
+        const uint32_t cyclesPerByteX100 =
+            (r.bytesSent > 0) ? static_cast<uint32_t>((static_cast<uint64_t>(r.driverCycles) * 100ULL) / r.bytesSent)
+                              : 0U;
+        std::printf("BENCH,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u", r.baudRate, r.messageSize, r.bytesSent,
+                    r.bytesVerified, r.bytesDropped, r.rxOverflows, r.rxErrors, bytesPerSecond, cyclesPerByteX100,
+                    r.latencyMinUs, r.latencyMaxUs);
+        for (uint32_t count : r.histogram)
+        {
+            std::printf(",%u", count);
+        }
+        std::printf("\n");
+    }
+
+    void testSweep()
+    {
+        HostMcu::reset();
+        ModelLoopbackBackend backend;
+        std::printf("# baud,size,sent,verified,dropped,rx_overflow,rx_error,bytes_per_s,"
+                    "cycles_per_byte_x100,lat_min_us,lat_max_us,hist_lt64us..hist_ge4096us (host, USART model)\n");
+
+        for (uint32_t baudRate : BAUD_RATES)
+        {
+            for (uint16_t size : MESSAGE_SIZES)
+            {
+                const CaseResult r = runCase(backend, baudRate, size, MESSAGES_PER_CASE);
+                reportCase(r);
+
+                CHECK_EQ(r.bytesSent, size * MESSAGES_PER_CASE);
+                CHECK_EQ(r.bytesVerified, r.bytesSent);
+                CHECK_EQ(r.bytesDropped, 0);
+                CHECK_EQ(r.rxOverflows, 0);
+                CHECK_EQ(r.rxErrors, 0);
+                CHECK_EQ(r.driverCycles, 0);
+
+                // The echo of the last byte ends size character times after send()
+                const double lineUs = size * 10.0 * 1e6 / baudRate;
+                CHECK(r.latencyMinUs + 1.0 >= lineUs && r.latencyMaxUs <= lineUs + 1.0);
+
+                // Back-to-back messages keep the line busy but for one poll per message
+                const double elapsedUs = static_cast<double>(r.elapsedCycles) / backend.cyclesPerMicrosecond();
+                const double lineRate = r.bytesVerified / elapsedUs * 1e6;
+                CHECK(lineRate >= 0.9 * baudRate / 10.0);
+            }
+        }
+    }
+}
+
+int main()
+{
+    testSweep();
+    return Check::result();
+}
@@ -0,0 +1,204 @@
+/**
+ * @file    ModbusRtuTest.cpp
+ * @brief   Modbus RTU slave driven through the USART model: framing, CRC, data map, exceptions, latency
+ * @author  MootSeeker
+ *
+ * The test is the master: it queues a request on the emulated USART_2 and
+ * reads the response off the wire. The USART model raises RTOF t3.5 after
+ * the last stop bit from the RTOR value the slave programmed, so the
+ * response time is measured from the last stop bit of the request to the
+ * start bit of the response. Request execution takes no model time; its
+ * host CPU time is measured separately (median of 7 rounds).
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "ModbusRtu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    uint16_t holding[8];
+    uint16_t input[4];
+    uint8_t coils[2];
+
+    constexpr Modbus::RegisterBlock HOLDING[] = {
+        {0x0000, 8, holding, Modbus::Access::READ_WRITE},
+    };
+    constexpr Modbus::RegisterBlock INPUT[] = {
+        {0x0100, 4, input, Modbus::Access::READ_ONLY},
+    };
+    constexpr Modbus::CoilBlock COILS[] = {
+        {0x0000, 16, coils, Modbus::Access::READ_WRITE},
+    };
+    constexpr Modbus::DataMap MAP{COILS, {}, HOLDING, INPUT};
+    static_assert(MAP.isValid(), "Overlapping or unsorted Modbus blocks");
+
+    constexpr uint8_t SLAVE = 0x11;
+
+    USART::StandardUSART uart(USART::PeripheralType::USART_2);
+    Modbus::RtuSlave slave(uart, SLAVE, MAP);
+
+    std::vector<uint8_t> withCrc(std::vector<uint8_t> request)
+    {
+        const uint16_t crc = Modbus::Crc16::compute(request.data(), static_cast<uint16_t>(request.size()));
+        request.push_back(static_cast<uint8_t>(crc));
+        request.push_back(static_cast<uint8_t>(crc >> 8));
+        return request;
+    }
+
+    /// Send a request (CRC appended), let the receiver timeout end it, return the response
+    std::vector<uint8_t> transact(UsartModel<USART::StandardUSART>& wire, const std::vector<uint8_t>& request)
+    {
+        const std::vector<uint8_t> frame = withCrc(request);
+        wire.queueReceive(frame.data(), frame.size());
+        wire.run();
+        return wire.takeTransmitted();
+    }
+
+    bool hasValidCrc(const std::vector<uint8_t>& frame)
+    {
+        return frame.size() >= 4 && Modbus::Crc16::compute(frame.data(), static_cast<uint16_t>(frame.size())) == 0;
+    }
+
+    void testFrameGap()
+    {
+        CHECK_EQ(Modbus::RtuSlave::frameGapBitPeriods(9600), 39);
+        CHECK_EQ(Modbus::RtuSlave::frameGapBitPeriods(19200), 39);
+        CHECK_EQ(Modbus::RtuSlave::frameGapBitPeriods(115200), 202);
+        CHECK_EQ(USART2->RTOR & USART_RTOR_RTO, 202);
+        CHECK((USART2->CR2 & USART_CR2_RTOEN) != 0);
+    }
+
+    void testReadHoldingRegisters(UsartModel<USART::StandardUSART>& wire)
+    {
+        holding[2] = 0x1234;
+        holding[3] = 0xABCD;
+        const std::vector<uint8_t> response = transact(wire, {SLAVE, 0x03, 0x00, 0x02, 0x00, 0x02});
+        CHECK(hasValidCrc(response));
+        const std::vector<uint8_t> expected = {SLAVE, 0x03, 0x04, 0x12, 0x34, 0xAB, 0xCD};
+        CHECK(response.size() == expected.size() + 2 &&
+              std::equal(expected.begin(), expected.end(), response.begin()));
+    }
+
+    void testWriteRegisterAndCoil(UsartModel<USART::StandardUSART>& wire)
+    {
+        std::vector<uint8_t> response = transact(wire, {SLAVE, 0x06, 0x00, 0x05, 0xBE, 0xEF});
+        CHECK_EQ(holding[5], 0xBEEF);
+        CHECK(hasValidCrc(response) && response.size() == 8 && response[1] == 0x06);
+
+        response = transact(wire, {SLAVE, 0x05, 0x00, 0x09, 0xFF, 0x00});
+        CHECK_EQ(coils[1] & 0x02, 0x02);
+        CHECK(hasValidCrc(response) && response.size() == 8);
+
+        response = transact(wire, {SLAVE, 0x01, 0x00, 0x08, 0x00, 0x08});
+        CHECK(hasValidCrc(response) && response.size() == 6 && response[2] == 1 && response[3] == 0x02);
+    }
+
+    void testExceptionsAndErrors(UsartModel<USART::StandardUSART>& wire)
+    {
+        // Input registers are read-only, address 0x0200 does not exist
+        std::vector<uint8_t> response = transact(wire, {SLAVE, 0x04, 0x02, 0x00, 0x00, 0x01});
+        CHECK(hasValidCrc(response) && response.size() == 5 && response[1] == 0x84 && response[2] == 0x02);
+
+        response = transact(wire, {SLAVE, 0x2B, 0x00, 0x00});
+        CHECK(hasValidCrc(response) && response.size() == 5 && response[1] == 0xAB && response[2] == 0x01);
+
+        const Modbus::SlaveStatistics before = slave.getStatistics();
+
+        // Another slave's request is not answered
+        response = transact(wire, {0x12, 0x03, 0x00, 0x00, 0x00, 0x01});
+        CHECK(response.empty());
+
+        // Corrupted CRC: dropped and counted
+        const uint8_t corrupt[] = {SLAVE, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00};
+        wire.queueReceive(corrupt, sizeof(corrupt));
+        wire.run();
+        CHECK(wire.takeTransmitted().empty());
+        CHECK_EQ(slave.getStatistics().crcErrors, before.crcErrors + 1);
+
+        // Broadcast writes are executed silently
+        response = transact(wire, {Modbus::RtuSlave::BROADCAST_ADDRESS, 0x06, 0x00, 0x00, 0x00, 0x2A});
+        CHECK(response.empty());
+        CHECK_EQ(holding[0], 0x2A);
+    }
+
+    /// Host CPU time from RTOF to the first response byte in TDR, in nanoseconds
+    double executionNanoseconds(UsartModel<USART::StandardUSART>& wire, const std::vector<uint8_t>& frame)
+    {
+        constexpr int ROUNDS = 7;
+        constexpr int CALLS = 500;
+        double results[ROUNDS];
+        for (double& result : results)
+        {
+            double total = 0.0;
+            for (int i = 0; i < CALLS; i++)
+            {
+                wire.queueReceive(frame.data(), frame.size());
+                for (size_t n = 0; n < frame.size(); n++)
+                {
+                    wire.step();
+                }
+                const auto start = std::chrono::steady_clock::now();
+                wire.raise(USART_ISR_RTOF);
+                total += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                wire.run();
+                wire.takeTransmitted();
+            }
+            result = total / CALLS;
+        }
+        std::sort(results, results + ROUNDS);
+        return results[ROUNDS / 2];
+    }
+
+    /// Last stop bit of the request to the start bit of the response, in character times
+    void testResponseLatency(UsartModel<USART::StandardUSART>& wire, uint32_t baudRate)
+    {
+        CHECK(uart.setBaudRate(baudRate).isSuccess());
+        CHECK(slave.start(baudRate).isSuccess());
+        wire.takeTransmitted();
+
+        // Largest read the map allows: 8 registers, 21-byte response
+        const std::vector<uint8_t> request = withCrc({SLAVE, 0x03, 0x00, 0x00, 0x00, 0x08});
+        wire.queueReceive(request.data(), request.size());
+        wire.run();
+        CHECK_EQ(wire.getTransmitted().size(), 21);
+
+        const double characterBits = wire.getCharacterBits();
+        const double gapBits = Modbus::RtuSlave::frameGapBitPeriods(baudRate);
+        const double latencyBits = wire.getTransmitTimes().front() - wire.getLastReceiveTime();
+        const double executionUs = executionNanoseconds(wire, request) / 1000.0;
+        const double executionCharacters = executionUs * baudRate / characterBits / 1e6;
+
+        // t3.5 (rounded up to whole bits) is all the model sees; execution is under a character on the host
+        CHECK(latencyBits >= gapBits && latencyBits <= gapBits + 1e-9);
+        CHECK(latencyBits / characterBits <= (baudRate <= 19200U ? 3.9 : 20.2) + 1e-9);
+        CHECK(executionCharacters < 1.0);
+        std::printf("  %6u baud: response %.1f character times after the request (t3.5 = %.0f bits), "
+                    "execution %.2f us = %.3f character times (host)\n",
+                    static_cast<unsigned>(baudRate), latencyBits / characterBits, gapBits, executionUs,
+                    executionCharacters);
+    }
+}
+
+int main()
+{
+    HostMcu::reset();
+    CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+    CHECK(slave.start(115200).isSuccess());
+
+    UsartModel<USART::StandardUSART> wire(uart);
+    testFrameGap();
+    testReadHoldingRegisters(wire);
+    testWriteRegisterAndCoil(wire);
+    testExceptionsAndErrors(wire);
+    testResponseLatency(wire, 19200);
+    testResponseLatency(wire, 115200);
+    return Check::result();
+}
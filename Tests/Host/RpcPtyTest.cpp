@@ -0,0 +1,361 @@
+/**
+ * @file    RpcPtyTest.cpp
+ * @brief   RPC client against the server over a pseudo-terminal: calls, describe, pipelining, latency benchmark
+ * @author  MootSeeker
+ *
+ * A child process plays the device: it runs Rpc::Server on the emulated
+ * USART_2 and bridges the USART model to the master side of a pty. The
+ * parent is the host tool: Rpc::Client on a SerialPort opened on the pty
+ * slave, exactly as it would open a USB-serial adapter.
+ *
+ * After the functional checks the program measures, over the pty:
+ * - round-trip latency of sequential calls (16-byte echo), median and p99
+ * - calls per second with MAX_IN_FLIGHT calls kept outstanding
+ *
+ * `RpcPtyTest <calls>` sets the number of calls per measurement (default 2000).
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "SerialPort.h"
+#include "UsartModel.h"
+
+#include "Rpc.h"
+#include "RpcClient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <sys/wait.h>
+
+namespace
+{
+    // ========================================================================
+    // Device side
+    // ========================================================================
+
+    Rpc::Status echo(Rpc::Reader& request, Rpc::Writer& response, void*)
+    {
+        uint8_t size = 0;
+        const uint8_t* bytes = request.readBytes(size);
+        response.writeBytes(bytes, size);
+        return Rpc::Status::OK;
+    }
+
+    Rpc::Status add(Rpc::Reader& request, Rpc::Writer& response, void*)
+    {
+        const int32_t a = request.readI32();
+        const int32_t b = request.readI32();
+        response.writeI32(a + b);
+        return Rpc::Status::OK;
+    }
+
+    Rpc::Status fail(Rpc::Reader&, Rpc::Writer&, void*)
+    {
+        return Rpc::Status::HANDLER_ERROR;
+    }
+
+    constexpr Rpc::Method METHODS[] = {
+        {0x01, "echo", "s", "s", echo, nullptr},
+        {0x02, "add", "ii", "i", add, nullptr},
+        {0x03, "fail", "", "", fail, nullptr},
+    };
+    constexpr Rpc::MethodTable TABLE{METHODS};
+    static_assert(TABLE.isValid(), "Unsorted/duplicate method IDs or bad schema");
+
+    // An entry that cannot fit into one describe response is rejected
+    constexpr char LONG_NAME[] =
+        "a.method.name.that.is.far.too.long.to.be.described.in.a.single.response.payload.of.two.hundred.and."
+        "forty.eight.bytes.because.describe.adds.the.schemas.and.terminators.on.top.of.it.so.the.table.check."
+        "has.to.reject.it.at.compile.time.instead.of.looping.at.run.time";
+    constexpr Rpc::Method OVERSIZED[] = {
+        {0x01, LONG_NAME, "", "", fail, nullptr},
+    };
+    static_assert(!Rpc::MethodTable{OVERSIZED}.isValid(), "Oversized describe entry must be rejected");
+
+    USART::StandardUSART uart(USART::PeripheralType::USART_2);
+    Rpc::Server server(uart, TABLE);
+
+    /// Device loop in the child: pty master <-> USART model, until the host closes the slave
+    [[noreturn]] void runDevice(int master)
+    {
+        HostMcu::reset();
+        if (!uart.initialize(USART::getDefaultUsartConfig()).isSuccess())
+        {
+            std::_Exit(2);
+        }
+        UsartModel<USART::StandardUSART> wire(uart);
+        server.start();
+
+        uint8_t buffer[256];
+        for (;;)
+        {
+            pollfd request{master, POLLIN, 0};
+            if (::poll(&request, 1, 1) > 0)
+            {
+                const ssize_t count = ::read(master, buffer, sizeof(buffer));
+                if (count <= 0)
+                {
+                    std::_Exit(0);
+                }
+                wire.queueReceive(buffer, static_cast<size_t>(count));
+            }
+            wire.run();
+            server.poll();
+            wire.run();
+
+            const std::vector<uint8_t> response = wire.takeTransmitted();
+            if (!response.empty() && ::write(master, response.data(), response.size()) < 0)
+            {
+                std::_Exit(0);
+            }
+        }
+    }
+
+    // ========================================================================
+    // Host side
+    // ========================================================================
+
+    class PtyClientPort : public Rpc::ClientPort
+    {
+    public:
+        explicit PtyClientPort(SerialPort& port) : port(port) {}
+
+        void write(const uint8_t* data, size_t length) override { port.write(data, length); }
+
+    private:
+        SerialPort& port;
+    };
+
+    struct Response
+    {
+        bool received;
+        uint8_t id;
+        Rpc::Status status;
+        std::vector<uint8_t> payload;
+    };
+
+    std::vector<Response> responses;
+
+    void onResponse(void*, uint8_t id, Rpc::Status status, Rpc::Reader& reader)
+    {
+        Response response{true, id, status, {}};
+        while (reader.remaining() > 0)
+        {
+            response.payload.push_back(reader.readU8());
+        }
+        responses.push_back(response);
+    }
+
+    SerialPort port;
+    PtyClientPort clientPort(port);
+    Rpc::Client client(clientPort, onResponse, nullptr);
+
+    /// Read until no call is outstanding (false on a 1 s timeout)
+    bool wait()
+    {
+        uint8_t buffer[256];
+        while (client.getInFlight() > 0)
+        {
+            const size_t count = port.read(buffer, sizeof(buffer), 1000);
+            if (count == 0)
+            {
+                client.reset();
+                return false;
+            }
+            client.receive(buffer, count);
+        }
+        return true;
+    }
+
+    /// Single call, returns its response (received is false on a timeout)
+    Response call(uint8_t method, const std::vector<uint8_t>& arguments)
+    {
+        Rpc::Writer& writer = client.prepare(method);
+        for (uint8_t byte : arguments)
+        {
+            writer.writeU8(byte);
+        }
+        uint8_t id = 0;
+        responses.clear();
+        if (!client.send(id) || !wait() || responses.size() != 1 || responses[0].id != id)
+        {
+            return Response{false, 0, Rpc::Status::OK, {}};
+        }
+        return responses[0];
+    }
+
+    std::vector<uint8_t> le32(int32_t value)
+    {
+        const uint32_t bits = static_cast<uint32_t>(value);
+        return {static_cast<uint8_t>(bits), static_cast<uint8_t>(bits >> 8), static_cast<uint8_t>(bits >> 16),
+                static_cast<uint8_t>(bits >> 24)};
+    }
+
+    void testCalls()
+    {
+        std::vector<uint8_t> arguments = le32(40);
+        const std::vector<uint8_t> two = le32(2);
+        arguments.insert(arguments.end(), two.begin(), two.end());
+        Response response = call(0x02, arguments);
+        CHECK(response.received && response.status == Rpc::Status::OK && response.payload == le32(42));
+
+        response = call(0x01, {3, 'a', 'b', 'c'});
+        CHECK(response.status == Rpc::Status::OK && response.payload == std::vector<uint8_t>({3, 'a', 'b', 'c'}));
+
+        response = call(0x7F, {});
+        CHECK(response.received && response.status == Rpc::Status::UNKNOWN_METHOD);
+        response = call(0x02, {1, 2, 3});
+        CHECK(response.received && response.status == Rpc::Status::BAD_REQUEST);
+        response = call(0x03, {});
+        CHECK(response.received && response.status == Rpc::Status::HANDLER_ERROR);
+    }
+
+    void testDescribe()
+    {
+        const Response response = call(Rpc::DESCRIBE_METHOD, {0});
+        CHECK(response.received && response.status == Rpc::Status::OK);
+        CHECK(response.payload.size() > 2 && response.payload[0] == 3 && response.payload[1] == 0);
+
+        // id, then three NUL-terminated strings per method
+        std::vector<std::string> names;
+        size_t position = 2;
+        while (position < response.payload.size())
+        {
+            position++;   // id
+            std::string fields[3];
+            for (std::string& field : fields)
+            {
+                while (position < response.payload.size() && response.payload[position] != 0)
+                {
+                    field.push_back(static_cast<char>(response.payload[position++]));
+                }
+                position++;
+            }
+            names.push_back(fields[0]);
+        }
+        CHECK(names == std::vector<std::string>({"echo", "add", "fail"}));
+    }
+
+    void testPipelining()
+    {
+        responses.clear();
+        uint8_t ids[Rpc::MAX_IN_FLIGHT] = {};
+        for (uint8_t i = 0; i < Rpc::MAX_IN_FLIGHT; i++)
+        {
+            Rpc::Writer& writer = client.prepare(0x02);
+            writer.writeI32(i);
+            writer.writeI32(100);
+            CHECK(client.send(ids[i]));
+        }
+        uint8_t extra = 0;
+        client.prepare(0x03);
+        CHECK(!client.send(extra));
+
+        CHECK(wait());
+        CHECK_EQ(responses.size(), Rpc::MAX_IN_FLIGHT);
+        for (size_t i = 0; i < responses.size(); i++)
+        {
+            CHECK(responses[i].id == ids[i] && responses[i].payload == le32(static_cast<int32_t>(i) + 100));
+        }
+        CHECK_EQ(client.getStatistics().lostCalls, 0);
+        CHECK_EQ(client.getStatistics().crcErrors, 0);
+    }
+
+    void benchmark(size_t calls)
+    {
+        std::vector<uint8_t> arguments(17, 0x5A);
+        arguments[0] = 16;
+
+        std::vector<double> latencies;
+        latencies.reserve(calls);
+        for (size_t i = 0; i < calls; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const Response response = call(0x01, arguments);
+            const auto end = std::chrono::steady_clock::now();
+            if (!response.received || response.status != Rpc::Status::OK)
+            {
+                CHECK(false);
+                return;
+            }
+            latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        // Keep MAX_IN_FLIGHT calls outstanding
+        uint8_t buffer[512];
+        size_t sent = 0;
+        size_t received = 0;
+        responses.clear();
+        const auto start = std::chrono::steady_clock::now();
+        while (received < calls)
+        {
+            while (sent < calls && client.getInFlight() < Rpc::MAX_IN_FLIGHT)
+            {
+                Rpc::Writer& writer = client.prepare(0x01);
+                writer.writeBytes(&arguments[1], 16);
+                uint8_t id = 0;
+                client.send(id);
+                sent++;
+            }
+            const size_t count = port.read(buffer, sizeof(buffer), 1000);
+            if (count == 0)
+            {
+                CHECK(false);
+                client.reset();
+                return;
+            }
+            client.receive(buffer, count);
+            received += responses.size();
+            responses.clear();
+        }
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("pty round trip (16-byte echo, %zu calls): median %.1f us, p99 %.1f us\n", calls,
+                    latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100]);
+        std::printf("pipelined (%u in flight): %.0f calls/s\n", static_cast<unsigned>(Rpc::MAX_IN_FLIGHT),
+                    static_cast<double>(calls) / seconds);
+        CHECK_EQ(client.getStatistics().lostCalls, 0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t calls = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2000U;
+
+    int master = -1;
+    std::string slavePath;
+    if (!CHECK(openPty(master, slavePath)) || !CHECK(port.open(slavePath.c_str())))
+    {
+        return Check::result();
+    }
+
+    std::fflush(stdout);
+    const pid_t device = fork();
+    if (device == 0)
+    {
+        port.close();
+        runDevice(master);
+    }
+    ::close(master);
+    CHECK(device > 0);
+
+    testCalls();
+    testDescribe();
+    testPipelining();
+    if (calls > 0)
+    {
+        benchmark(calls);
+    }
+
+    port.close();
+    kill(device, SIGTERM);
+    waitpid(device, nullptr, 0);
+    return Check::result();
+}
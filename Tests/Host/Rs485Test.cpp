@@ -0,0 +1,153 @@
+/**
+ * @file    Rs485Test.cpp
+ * @brief   RS-485 driver enable: DEAT/DEDT against the requested bit times, release at TC, echo suppression
+ * @author  MootSeeker
+ *
+ * The USART model asserts DE from the DEAT/DEDT fields the driver programmed
+ * (see UsartModel.h), so the pulse edges it records are the ones the
+ * transceiver would see. The bus is a half-duplex transceiver in loopback:
+ * every word we drive comes back on RX unless the receiver is off.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "usart.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    using Wire = UsartModel<USART::StandardUSART>;
+
+    bool near(double a, double b)
+    {
+        return std::fabs(a - b) < 1e-9;
+    }
+
+    void testTurnaround(uint32_t baudRate, bool over8)
+    {
+        HostMcu::reset();
+        USART::StandardUSART uart(USART::PeripheralType::USART_2);
+        USART::Config config = USART::getDefaultUsartConfig();
+        config.baudRate = baudRate;
+        CHECK(uart.initialize(config).isSuccess());
+        Wire wire(uart);
+        CHECK_EQ((uart.getInstance()->CR1 & USART_CR1_OVER8) != 0U, over8);
+
+        const USART::Rs485Config rs485{12, 20, false, false};
+        CHECK_EQ(uart.enableRs485(rs485).error, USART::UsartError::OK);
+        const uint32_t cr1 = uart.getInstance()->CR1;
+        CHECK_EQ((cr1 & USART_CR1_DEAT) >> USART_CR1_DEAT_Pos, 12);
+        CHECK_EQ((cr1 & USART_CR1_DEDT) >> USART_CR1_DEDT_Pos, 20);
+        CHECK((cr1 & USART_CR1_UE) != 0U);
+        CHECK((uart.getInstance()->CR3 & (USART_CR3_DEM | USART_CR3_DEP)) == USART_CR3_DEM);
+
+        const uint8_t frame[4] = {0x01, 0x03, 0x00, 0x10};
+        CHECK_EQ(uart.sendData(frame, sizeof(frame)), sizeof(frame));
+        wire.serviceInterrupts();   // TXEIE is taken at once: the first start bit leaves at t = 0
+        wire.run();
+
+        // Four 10-bit characters from t = 0: DE leads the first start bit by
+        // DEAT and trails the last stop bit by the requested turnaround
+        const double samplesPerBit = over8 ? 8.0 : 16.0;
+        const double lastStopBit = 4.0 * wire.getCharacterBits();
+        CHECK_EQ(wire.getDriverEnablePulses().size(), 1);
+        const Wire::DriverEnablePulse pulse = wire.getDriverEnablePulses().front();
+        CHECK(near(pulse.assertedAt, -12.0 / samplesPerBit));
+        CHECK(near(pulse.releasedAt - lastStopBit, USART::getRs485TurnaroundBits(rs485, over8)));
+        std::printf("  %7u baud (OVER%d): DE lead %.3f bit, turnaround %.3f bit\n", static_cast<unsigned>(baudRate),
+                    over8 ? 8 : 16, -pulse.assertedAt, pulse.releasedAt - lastStopBit);
+    }
+
+    /// The driver holds the transmission open until TC, when the hardware releases DE
+    void testReleaseAtTc()
+    {
+        HostMcu::reset();
+        USART::StandardUSART uart(USART::PeripheralType::USART_2);
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        Wire wire(uart);
+        CHECK(uart.enableRs485(USART::getDefaultRs485Config()).isSuccess());
+
+        const uint8_t frame[3] = {0x11, 0x22, 0x33};
+        CHECK_EQ(uart.sendData(frame, sizeof(frame)), sizeof(frame));
+        wire.serviceInterrupts();
+        size_t activeSteps = 0;
+        while (uart.isTransmissionActive() && activeSteps < 16)
+        {
+            CHECK(wire.getDriverEnablePulses().back().releasedAt == 0.0);
+            wire.step();
+            activeSteps++;
+        }
+
+        // The last TXE comes one character before TC: finishing there would cut the last byte
+        CHECK_EQ(activeSteps, sizeof(frame));
+        CHECK(wire.getTransmitted().size() == sizeof(frame));
+        CHECK((uart.getInstance()->CR1 & USART_CR1_TCIE) == 0U);
+        CHECK(near(wire.getDriverEnablePulses().back().releasedAt,
+                   3.0 * wire.getCharacterBits() + USART::getRs485TurnaroundBits(USART::getDefaultRs485Config())));
+
+        // The next frame is a new DE pulse
+        CHECK_EQ(uart.sendData(frame, 1), 1);
+        wire.run();
+        CHECK_EQ(wire.getDriverEnablePulses().size(), 2);
+    }
+
+    void testEcho(bool suppressEcho)
+    {
+        HostMcu::reset();
+        USART::StandardUSART uart(USART::PeripheralType::USART_2);
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        Wire wire(uart);
+        wire.setLoopback(true);
+        USART::Rs485Config rs485 = USART::getDefaultRs485Config();
+        rs485.suppressEcho = suppressEcho;
+        CHECK(uart.enableRs485(rs485).isSuccess());
+
+        const uint8_t request[5] = {0x01, 0x03, 0x00, 0x00, 0x02};
+        CHECK_EQ(uart.sendData(request, sizeof(request)), sizeof(request));
+        wire.run();
+        CHECK_EQ(uart.getRxCount(), suppressEcho ? 0 : sizeof(request));
+        CHECK((uart.getInstance()->CR1 & USART_CR1_RE) != 0U);
+
+        // The receiver is back after TC: the peer's reply gets through
+        uint8_t discard[sizeof(request)];
+        uart.receiveData(discard, sizeof(discard));
+        const uint8_t reply[3] = {0x01, 0x83, 0x02};
+        wire.queueReceive(reply, sizeof(reply));
+        wire.run();
+        uint8_t received[sizeof(reply)] = {};
+        CHECK_EQ(uart.receiveData(received, sizeof(received)), sizeof(reply));
+        CHECK(received[1] == 0x83 && received[2] == 0x02);
+        CHECK_EQ(wire.getOverrunCount(), 0);
+    }
+
+    /// DE is the RTS pin: RS-485 cannot take it from RTS/CTS flow control
+    void testRtsFlowControlRefused()
+    {
+        HostMcu::reset();
+        USART::StandardUSART uart(USART::PeripheralType::USART_2);
+        CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+        CHECK(uart.enableFlowControl({USART::FlowControl::RTS_CTS, 192, 64}).isSuccess());
+
+        CHECK_EQ(uart.enableRs485(USART::getDefaultRs485Config()).error, USART::UsartError::BUSY);
+        CHECK((uart.getInstance()->CR3 & USART_CR3_DEM) == 0U);
+        CHECK((uart.getInstance()->CR1 & USART_CR1_UE) != 0U);
+
+        CHECK(uart.enableFlowControl({USART::FlowControl::NONE, 0, 0}).isSuccess());
+        CHECK_EQ(uart.enableRs485(USART::getDefaultRs485Config()).error, USART::UsartError::OK);
+    }
+}
+
+int main()
+{
+    testTurnaround(115200, false);
+    testTurnaround(4000000, true);
+    testReleaseAtTc();
+    testEcho(false);
+    testEcho(true);
+    testRtsFlowControlRefused();
+    return Check::result();
+}
@@ -0,0 +1,221 @@
+/**
+ * @file    ShellTest.cpp
+ * @brief   Shell: index construction, argument parsing, lookup benchmark quoted in Shell.h
+ * @author  MootSeeker
+ *
+ * The benchmark builds tables of 10, 100 and 500 generated names ("cmd000",
+ * "cmd001", ...) at compile time and measures, on the host, the time per
+ * lookup of a random name from the table with CommandTable::find() against
+ * a linear strcmp() scan. It prints the index size and both times.
+ */
+
+#include "Check.h"
+
+#include "Shell.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    void handler(Shell::Console&, const Shell::Args&, void*) {}
+
+    // ========================================================================
+    // Index construction
+    // ========================================================================
+
+    constexpr Shell::Command COMMANDS[] = {
+        {"led", "led 0|1", handler, nullptr},
+        {"baud", "baud", handler, nullptr},
+        {"reset", "reset", handler, nullptr},
+        {"status", "status", handler, nullptr},
+        {"help2", "help2", handler, nullptr},
+    };
+    constexpr auto INDEX = Shell::buildIndex(COMMANDS);
+    constexpr Shell::CommandTable TABLE{COMMANDS, INDEX};
+    static_assert(TABLE.isValid(), "Valid table rejected");
+
+    constexpr Shell::Command DUPLICATES[] = {
+        {"led", "led 0|1", handler, nullptr},
+        {"baud", "baud", handler, nullptr},
+        {"led", "led again", handler, nullptr},
+    };
+    constexpr auto DUPLICATE_INDEX = Shell::buildIndex(DUPLICATES);
+    static_assert(!DUPLICATE_INDEX.valid, "Duplicate names must be rejected before the seed search");
+    static_assert(!Shell::CommandTable(DUPLICATES, DUPLICATE_INDEX).isValid(), "Duplicate names accepted");
+
+    void testFind()
+    {
+        for (const Shell::Command& command : COMMANDS)
+        {
+            CHECK(TABLE.find(command.name, std::strlen(command.name)) == &command);
+        }
+        CHECK(TABLE.find("le", 2) == nullptr);
+        CHECK(TABLE.find("leds", 4) == nullptr);
+        CHECK(TABLE.find("ledx", 3) == &COMMANDS[0]);   // Only `length` characters are compared
+        CHECK(TABLE.find("unknown", 7) == nullptr);
+    }
+
+    // ========================================================================
+    // Argument parsing
+    // ========================================================================
+
+    void testArguments()
+    {
+        const char* tokens[] = {"cmd",        "42",          "010",        "0x1F",  "-17",       "+5",
+                                "2147483647", "2147483648", "-2147483648", "4294967295", "4294967296", "12ab",
+                                "0x",         " 7",          "",           "99999999999999999999"};
+        const Shell::Args args(tokens, static_cast<uint8_t>(sizeof(tokens) / sizeof(tokens[0])));
+
+        int32_t signedValue = 0;
+        uint32_t value = 0;
+        CHECK(args.toUnsigned(1, value) && value == 42U);
+        CHECK(args.toUnsigned(2, value) && value == 10U);   // Decimal, not octal
+        CHECK(args.toInt(2, signedValue) && signedValue == 10);
+        CHECK(args.toUnsigned(3, value) && value == 0x1FU);
+        CHECK(args.toInt(4, signedValue) && signedValue == -17);
+        CHECK(!args.toUnsigned(4, value));
+        CHECK(args.toInt(5, signedValue) && signedValue == 5);
+        CHECK(!args.toUnsigned(5, value));
+        CHECK(args.toInt(6, signedValue) && signedValue == INT32_MAX);
+        CHECK(!args.toInt(7, signedValue));
+        CHECK(args.toInt(8, signedValue) && signedValue == INT32_MIN);
+        CHECK(args.toUnsigned(9, value) && value == UINT32_MAX);
+        CHECK(!args.toUnsigned(10, value));
+        CHECK(!args.toUnsigned(11, value));
+        CHECK(!args.toUnsigned(12, value));
+        CHECK(!args.toInt(13, signedValue));
+        CHECK(!args.toUnsigned(14, value));
+        CHECK(!args.toUnsigned(15, value));
+        CHECK(!args.toInt(15, signedValue));
+        CHECK(!args.toUnsigned(16, value));   // Beyond the index range
+    }
+
+    // ========================================================================
+    // Lookup benchmark
+    // ========================================================================
+
+    template<size_t N>
+    struct GeneratedNames
+    {
+        char text[N][8];
+
+        constexpr GeneratedNames() : text()
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                text[i][0] = 'c';
+                text[i][1] = 'm';
+                text[i][2] = 'd';
+                text[i][3] = static_cast<char>('0' + i / 100U);
+                text[i][4] = static_cast<char>('0' + (i / 10U) % 10U);
+                text[i][5] = static_cast<char>('0' + i % 10U);
+                text[i][6] = '\0';
+            }
+        }
+    };
+
+    template<size_t N>
+    struct GeneratedTable
+    {
+        static constexpr GeneratedNames<N> NAMES{};
+
+        static constexpr auto makeCommands()
+        {
+            struct Commands
+            {
+                Shell::Command entries[N];
+            } commands{};
+            for (size_t i = 0; i < N; i++)
+            {
+                commands.entries[i] = Shell::Command{NAMES.text[i], "", handler, nullptr};
+            }
+            return commands;
+        }
+
+        static constexpr auto COMMANDS = makeCommands();
+        static constexpr auto INDEX = Shell::buildIndex(COMMANDS.entries);
+        static constexpr Shell::CommandTable TABLE{COMMANDS.entries, INDEX};
+        static_assert(TABLE.isValid(), "Generated table rejected");
+    };
+
+    const Shell::Command* linearFind(const Shell::Command* commands, size_t count, const char* name)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (std::strcmp(commands[i].name, name) == 0)
+            {
+                return &commands[i];
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename Body>
+    double nanosecondsPerCall(Body body)
+    {
+        constexpr int ROUNDS = 7;
+        constexpr int CALLS = 200000;
+        double best[ROUNDS];
+        for (double& result : best)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < CALLS; i++)
+            {
+                body(i);
+            }
+            result = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CALLS;
+        }
+        std::sort(best, best + ROUNDS);
+        return best[ROUNDS / 2];
+    }
+
+    template<size_t N>
+    void benchmark()
+    {
+        using Table = GeneratedTable<N>;
+
+        // Random order of names, fixed seed
+        std::vector<const char*> queries;
+        uint32_t seed = 0x1234567U;
+        for (int i = 0; i < 4096; i++)
+        {
+            seed = seed * 1664525U + 1013904223U;
+            queries.push_back(Table::NAMES.text[(seed >> 8) % N]);
+        }
+
+        bool found = true;
+        volatile uintptr_t sink = 0;
+        const double hashed = nanosecondsPerCall([&](int i) {
+            const char* name = queries[static_cast<size_t>(i) & 4095U];
+            const Shell::Command* command = Table::TABLE.find(name, std::strlen(name));
+            found = found && command != nullptr && command->name == name;
+            sink = sink + reinterpret_cast<uintptr_t>(command);
+        });
+        const double linear = nanosecondsPerCall([&](int i) {
+            const char* name = queries[static_cast<size_t>(i) & 4095U];
+            sink = sink + reinterpret_cast<uintptr_t>(linearFind(Table::COMMANDS.entries, N, name));
+        });
+
+        CHECK(found);
+        std::printf("%3zu commands: index %5zu B, perfect hash %5.1f ns, linear strcmp %6.1f ns (host)\n", N,
+                    sizeof(Table::INDEX), hashed, linear);
+        if (N >= 100)
+        {
+            CHECK(hashed < linear);
+        }
+    }
+}
+
+int main()
+{
+    testFind();
+    testArguments();
+    benchmark<10>();
+    benchmark<100>();
+    benchmark<500>();
+    return Check::result();
+}
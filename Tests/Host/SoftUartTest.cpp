@@ -0,0 +1,439 @@
+/**
+ * @file    SoftUartTest.cpp
+ * @brief   SoftUart: EXTI vector ownership, TX edge timing, RX at +/-2 %, interrupt counts
+ * @author  MootSeeker
+ *
+ * The timing model runs the driver against TIM2->CNT as simulated time in
+ * core cycles. Interrupts execute instantly, LATENCY cycles after their
+ * cause:
+ * - a compare match, when CCxIE is set and CCRx is reached
+ * - a pending TIM2 (set by the driver itself)
+ * - a falling edge of the peer's waveform on an unmasked RX line (EXTI)
+ * The RX pins read the peer's waveform through IDR; every BSRR write to a TX
+ * port is recorded as an edge. The peer sends random bytes back to back at
+ * the channel baud rate off by +/-2 %, and the device keeps its TX queue
+ * full, so every channel runs full duplex for the whole second. The cost of
+ * the interrupt bodies is not modelled; the test prints the interrupt
+ * counts quoted in soft_uart.h.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+
+#include "soft_uart.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t LATENCY = 40;   ///< Cycles from a cause to the interrupt body, as EXTI_LATENCY_CYCLES
+    constexpr uint32_t NONE = 0xFFFFFFFFU;
+
+    /// xorshift32, deterministic traffic
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // ========================================================================
+    // EXTI vector ownership
+    // ========================================================================
+
+    void testExtiVector()
+    {
+        HostMcu::reset();
+        const uint32_t grouping = NVIC_GetPriorityGrouping();
+
+        // EXTI1 belongs to the port: enabled and raised above TIM2
+        {
+            GPIO::GPIOEXTI rx(GPIOA, 1, GPIO::EXTITrigger::FALLING, GPIO::PinPull::PULL_UP);
+            USART::SoftUart port(nullptr, &rx);
+            CHECK(port.initialize(9600).isSuccess());
+            CHECK(HostMcu::isIrqEnabled(EXTI1_IRQn));
+            CHECK_EQ(HostMcu::getIrqPriority(EXTI1_IRQn), NVIC_EncodePriority(grouping, 0, 0));
+            CHECK(HostMcu::isIrqEnabled(TIM2_IRQn));
+        }
+
+        // EXTI9_5 also serves other pins: the port only checks it
+        HostMcu::reset();
+        GPIO::GPIOEXTI rx(GPIOA, 6, GPIO::EXTITrigger::FALLING, GPIO::PinPull::PULL_UP);
+        USART::SoftUart port(nullptr, &rx);
+        const USART::UsartStatus disabled = port.initialize(9600);
+        CHECK_EQ(disabled.error, USART::UsartError::INVALID_PARAMETER);
+        CHECK_EQ(disabled.details, 6);
+        CHECK(!port.isInitialized());
+        CHECK(!HostMcu::isIrqEnabled(EXTI9_5_IRQn));
+
+        const uint32_t shared = NVIC_EncodePriority(grouping, 5, 0);
+        NVIC_SetPriority(EXTI9_5_IRQn, shared);
+        NVIC_EnableIRQ(EXTI9_5_IRQn);
+        CHECK_EQ(port.initialize(9600).error, USART::UsartError::INVALID_PARAMETER);   // Below TIM2
+        CHECK_EQ(HostMcu::getIrqPriority(EXTI9_5_IRQn), shared);
+
+        NVIC_SetPriority(EXTI9_5_IRQn, NVIC_EncodePriority(grouping, 0, 0));
+        CHECK(port.initialize(9600).isSuccess());
+        CHECK_EQ(HostMcu::getIrqPriority(EXTI9_5_IRQn), NVIC_EncodePriority(grouping, 0, 0));
+        CHECK((EXTI->IMR1 & (1U << 6)) != 0U);
+        port.deinitialize();
+        CHECK((EXTI->IMR1 & (1U << 6)) == 0U);
+        CHECK(HostMcu::isIrqEnabled(EXTI9_5_IRQn));   // Other pins keep their vector
+    }
+
+    // ========================================================================
+    // Timing model
+    // ========================================================================
+
+    struct Edge
+    {
+        uint32_t time;
+        bool level;
+    };
+
+    /// Level changes of a line that idles high
+    class Waveform
+    {
+    public:
+        void add(uint32_t time, bool level)
+        {
+            if (level != current)
+            {
+                edges.push_back({time, level});
+                current = level;
+            }
+        }
+
+        std::vector<Edge> edges;
+        bool current = true;
+        size_t cursor = 0;   ///< First edge after the current simulated time
+    };
+
+    /// The peer's back-to-back frames, precomputed
+    Waveform peerWaveform(const std::vector<uint8_t>& bytes, uint32_t start, double bitCycles)
+    {
+        Waveform wave;
+        for (size_t i = 0; i < bytes.size(); i++)
+        {
+            const uint16_t frame = static_cast<uint16_t>((bytes[i] << 1) | 0x200U);
+            for (uint8_t bit = 0; bit < 10; bit++)
+            {
+                const double at = start + (static_cast<double>(i) * 10.0 + bit) * bitCycles;
+                wave.add(static_cast<uint32_t>(std::lround(at)), ((frame >> bit) & 1U) != 0U);
+            }
+        }
+        return wave;
+    }
+
+    /// Decode the frames of a recorded TX waveform that end before `end`; `starts` receives their start bit edges
+    std::vector<uint8_t> decode(const Waveform& wave, double bitCycles, uint32_t end, std::vector<uint32_t>& starts)
+    {
+        std::vector<uint8_t> bytes;
+        size_t i = 0;
+        while (i < wave.edges.size())
+        {
+            if (wave.edges[i].level)
+            {
+                i++;
+                continue;
+            }
+            const double start = wave.edges[i].time;
+            if (start + 10.0 * bitCycles > end)
+            {
+                break;
+            }
+            uint8_t data = 0;
+            size_t cursor = i;
+            bool stop = false;
+            for (uint8_t bit = 1; bit <= 9; bit++)
+            {
+                const double sample = start + (bit + 0.5) * bitCycles;
+                while (cursor + 1U < wave.edges.size() && wave.edges[cursor + 1U].time <= sample)
+                {
+                    cursor++;
+                }
+                const bool level = wave.edges[cursor].level;
+                if (bit <= 8U)
+                {
+                    data = static_cast<uint8_t>((data >> 1) | (level ? 0x80U : 0U));
+                }
+                else
+                {
+                    stop = level;
+                }
+            }
+            if (!stop)
+            {
+                break;
+            }
+            bytes.push_back(data);
+            starts.push_back(wave.edges[i].time);
+            i = cursor + 1U;
+        }
+        return bytes;
+    }
+
+    struct Channel
+    {
+        GPIO::GPIOOutput* tx;
+        GPIO::GPIOEXTI* rx;
+        USART::SoftUart* port;
+        Waveform peer;
+        std::vector<uint8_t> peerBytes;
+        std::vector<uint8_t> received;
+        Waveform sent;
+        std::vector<uint8_t> sentBytes;
+        size_t nextEdge = 0;
+        uint32_t extiDue = NONE;   ///< EXTI interrupt entry for a latched edge
+        uint32_t matched = NONE;   ///< Last compare value that has matched
+    };
+
+    struct Load
+    {
+        uint32_t timerInterrupts;
+        uint32_t extiInterrupts;
+        double maxTxErrorCycles;   ///< Edge against the bit grid of its own frame
+        double txRateErrorPpm;     ///< Mean frame period against the nominal one
+    };
+
+    /**
+     * @brief Run `channels` full-duplex ports for one second
+     * @param skew Peer rate error: channels 0 and 2 run fast by this much, channel 1 slow
+     */
+    Load simulate(uint32_t baud, uint8_t channels, double skew)
+    {
+        HostMcu::reset();
+        GPIO_TypeDef* const PORTS[3] = {GPIOA, GPIOB, GPIOC};
+        const uint32_t RX_PINS[3] = {1, 2, 3};
+        static constexpr uint32_t SECOND = 32000000U;
+        const double bitCycles = static_cast<double>(SystemCoreClock) / baud;
+
+        uint32_t seed = 0x13579BDFU ^ baud ^ channels;
+        std::vector<Channel> ports(channels);
+        for (uint8_t c = 0; c < channels; c++)
+        {
+            Channel& channel = ports[c];
+            channel.tx = new GPIO::GPIOOutput(PORTS[c], 8);
+            channel.rx = new GPIO::GPIOEXTI(PORTS[c], RX_PINS[c], GPIO::EXTITrigger::FALLING, GPIO::PinPull::PULL_UP);
+            channel.port = new USART::SoftUart(channel.tx, channel.rx);
+            PORTS[c]->IDR = 1U << RX_PINS[c];
+            CHECK(channel.port->initialize(baud).isSuccess());
+            PORTS[c]->BSRR = 0;
+
+            const double peerBit = bitCycles / (c % 2U == 0U ? 1.0 + skew : 1.0 - skew);
+            const size_t frames = static_cast<size_t>(SECOND / (10.0 * peerBit)) - 2U;
+            for (size_t i = 0; i < frames; i++)
+            {
+                channel.peerBytes.push_back(static_cast<uint8_t>(random(seed)));
+            }
+            channel.peer = peerWaveform(channel.peerBytes, 1000U + 777U * c, peerBit);
+        }
+
+        uint32_t now = 0;
+        Load load{0, 0, 0.0, 0.0};
+        auto enter = [&](uint32_t time) {
+            now = time;
+            TIM2->CNT = now;
+            for (uint8_t c = 0; c < channels; c++)
+            {
+                Channel& channel = ports[c];
+                while (channel.peer.cursor < channel.peer.edges.size() &&
+                       channel.peer.edges[channel.peer.cursor].time <= now)
+                {
+                    channel.peer.cursor++;
+                }
+                const bool level = channel.peer.cursor == 0 || channel.peer.edges[channel.peer.cursor - 1U].level;
+                PORTS[c]->IDR = level ? (1U << RX_PINS[c]) : 0U;
+            }
+        };
+        auto leave = [&]() {
+            for (uint8_t c = 0; c < channels; c++)
+            {
+                Channel& channel = ports[c];
+                const uint32_t bsrr = PORTS[c]->BSRR;
+                if ((bsrr & (1U << 8)) != 0U)
+                {
+                    channel.sent.add(now, true);
+                }
+                else if ((bsrr & (1U << 24)) != 0U)
+                {
+                    channel.sent.add(now, false);
+                }
+                PORTS[c]->BSRR = 0;
+
+                // Drain RX, keep the TX queue full
+                uint8_t buffer[32];
+                const uint16_t count = channel.port->receiveData(buffer, sizeof(buffer));
+                channel.received.insert(channel.received.end(), buffer, buffer + count);
+
+                while (channel.port->getAvailableSpace() > 0U)
+                {
+                    const uint8_t data = static_cast<uint8_t>(random(seed));
+                    CHECK(channel.port->sendByte(data));
+                    channel.sentBytes.push_back(data);
+                }
+            }
+        };
+
+        enum class Cause
+        {
+            EDGE,
+            COMPARE,
+            EDGE_INTERRUPT,
+            TIMER_INTERRUPT,
+        };
+
+        enter(0);
+        leave();
+        uint32_t timerDue = NONE;
+        while (now < SECOND)
+        {
+            if (timerDue == NONE && HostMcu::isIrqPending(TIM2_IRQn))
+            {
+                timerDue = now + LATENCY;
+            }
+
+            // Earliest cause; on equal times the lower Cause (hardware before software) wins
+            uint32_t next = SECOND;
+            Cause cause = Cause::TIMER_INTERRUPT;
+            uint8_t index = 0;
+            auto consider = [&](uint32_t time, Cause candidate, uint8_t c) {
+                if (time < next || (time == next && candidate < cause))
+                {
+                    next = time;
+                    cause = candidate;
+                    index = c;
+                }
+            };
+            consider(timerDue, Cause::TIMER_INTERRUPT, 0);
+            for (uint8_t c = 0; c < channels; c++)
+            {
+                Channel& channel = ports[c];
+                if ((TIM2->DIER & (TIM_DIER_CC1IE << c)) != 0U)
+                {
+                    const uint32_t compare = (&TIM2->CCR1)[c];
+                    if (static_cast<int32_t>(compare - now) >= 0 && compare != channel.matched)
+                    {
+                        consider(compare, Cause::COMPARE, c);
+                    }
+                }
+                const std::vector<Edge>& edges = channel.peer.edges;
+                while (channel.nextEdge < edges.size() && edges[channel.nextEdge].level)
+                {
+                    channel.nextEdge++;
+                }
+                if (channel.nextEdge < edges.size())
+                {
+                    consider(edges[channel.nextEdge].time, Cause::EDGE, c);
+                }
+                consider(channel.extiDue, Cause::EDGE_INTERRUPT, c);
+            }
+            if (next >= SECOND)
+            {
+                break;
+            }
+
+            Channel& channel = ports[index];
+            switch (cause)
+            {
+            case Cause::EDGE:
+                // Latched only while the line is unmasked; the driver clears it before unmasking
+                now = next;
+                channel.nextEdge++;
+                if ((EXTI->IMR1 & (1U << RX_PINS[index])) != 0U && channel.extiDue == NONE)
+                {
+                    channel.extiDue = next + LATENCY;
+                }
+                break;
+            case Cause::COMPARE:
+                now = next;
+                channel.matched = next;
+                NVIC_SetPendingIRQ(TIM2_IRQn);
+                break;
+            case Cause::EDGE_INTERRUPT:
+                channel.extiDue = NONE;
+                enter(next);
+                load.extiInterrupts++;
+                GPIO::GPIOEXTI::handleInterrupt(RX_PINS[index]);
+                leave();
+                break;
+            case Cause::TIMER_INTERRUPT:
+                timerDue = NONE;
+                enter(next);
+                load.timerInterrupts++;
+                NVIC_ClearPendingIRQ(TIM2_IRQn);
+                USART_HandleSoftUartTimerInterrupt();
+                leave();
+                break;
+            }
+        }
+
+        for (uint8_t c = 0; c < channels; c++)
+        {
+            Channel& channel = ports[c];
+            CHECK_EQ(channel.port->getRxErrorCount(), 0);
+            CHECK_EQ(channel.port->getRxOverflowCount(), 0);
+            CHECK(channel.received == channel.peerBytes);
+
+            // Everything but the queued bytes went out; frames follow each other without gaps
+            std::vector<uint32_t> starts;
+            const std::vector<uint8_t> decoded = decode(channel.sent, bitCycles, now, starts);
+            CHECK(decoded.size() + USART::SOFT_UART_BUFFER_SIZE + 1U >= channel.sentBytes.size());
+            CHECK(std::equal(decoded.begin(), decoded.end(), channel.sentBytes.begin()));
+            size_t frame = 0;
+            for (const Edge& edge : channel.sent.edges)
+            {
+                while (frame + 1U < starts.size() && starts[frame + 1U] <= edge.time)
+                {
+                    frame++;
+                }
+                const double offset = (edge.time - static_cast<double>(starts[frame])) / bitCycles;
+                const double error = std::fabs(offset - std::round(offset)) * bitCycles;
+                load.maxTxErrorCycles = std::fmax(load.maxTxErrorCycles, error);
+            }
+            const double period = static_cast<double>(starts.back() - starts.front()) / (starts.size() - 1U);
+            const double rateError = std::fabs(period / (10.0 * bitCycles) - 1.0) * 1e6;
+            load.txRateErrorPpm = std::fmax(load.txRateErrorPpm, rateError);
+
+            channel.port->deinitialize();
+            delete channel.port;
+            delete channel.rx;
+            delete channel.tx;
+        }
+
+        std::printf("%5u baud, %u channel(s), peer +/-%.0f %%: %6u timer + %6u EXTI interrupts/s, "
+                    "TX edge error max %.0f cycles, frame period %.0f ppm\n",
+                    baud, channels, skew * 100.0, load.timerInterrupts, load.extiInterrupts, load.maxTxErrorCycles,
+                    load.txRateErrorPpm);
+        return load;
+    }
+
+    void testTiming()
+    {
+        for (uint32_t baud : {9600U, 57600U})
+        {
+            for (uint8_t channels = 1; channels <= 3; channels++)
+            {
+                const Load load = simulate(baud, channels, 0.02);
+                // Late by the latency, early by at most the batch window (+1 for the whole-cycle timer)
+                CHECK(load.maxTxErrorCycles <= 64.0 + LATENCY + 1.0);
+                // Latency does not add up from frame to frame (one LATENCY per frame would be 7000 ppm at 57600)
+                CHECK(load.txRateErrorPpm < 100.0);
+                // One EXTI per received byte, at most one timer interrupt per level change and RX sample
+                CHECK(load.extiInterrupts <= channels * (baud * 102U / 1000U + 1U));
+                CHECK(load.timerInterrupts <= channels * baud * 2U);
+            }
+        }
+    }
+}
+
+int main()
+{
+    testExtiVector();
+    testTiming();
+    return Check::result();
+}
@@ -0,0 +1,152 @@
+/**
+ * @file    core_cm4.h
+ * @brief   Host stand-in for the CMSIS Cortex-M4 core header
+ * @author  MootSeeker
+ *
+ * stm32l433xx.h includes "core_cm4.h" by name. On the host build this file
+ * is found instead of the CMSIS one: it provides the qualifiers the device
+ * header needs, the intrinsics the LL drivers use (no ARM assembly), and an
+ * NVIC, PRIMASK, DWT and CoreDebug whose state is plain memory the tests can
+ * inspect through HostMcu.h.
+ */
+
+#ifndef TESTS_HOST_STUBS_CORE_CM4_H_
+#define TESTS_HOST_STUBS_CORE_CM4_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __cplusplus
+  #define   __I     volatile
+#else
+  #define   __I     volatile const
+#endif
+#define     __O     volatile
+#define     __IO    volatile
+#define     __IM    volatile const
+#define     __OM    volatile
+#define     __IOM   volatile
+
+#ifndef __STATIC_INLINE
+  #define __STATIC_INLINE           static inline
+#endif
+#ifndef __STATIC_FORCEINLINE
+  #define __STATIC_FORCEINLINE      static inline
+#endif
+#ifndef __ALIGNED
+  #define __ALIGNED(x)              __attribute__((aligned(x)))
+#endif
+#ifndef __PACKED
+  #define __PACKED                  __attribute__((packed))
+#endif
+#ifndef __WEAK
+  #define __WEAK                    __attribute__((weak))
+#endif
+
+/* NVIC: enable, pending and priority per IRQ number, kept by HostMcu.cpp */
+void NVIC_SetPriorityGrouping(uint32_t PriorityGroup);
+uint32_t NVIC_GetPriorityGrouping(void);
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type IRQn);
+
+__STATIC_INLINE uint32_t NVIC_EncodePriority(uint32_t PriorityGroup, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    const uint32_t group = PriorityGroup & 0x07U;
+    const uint32_t preemptBits = ((7U - group) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7U - group);
+    const uint32_t subBits = ((group + __NVIC_PRIO_BITS) < 7U) ? 0U : (group - 7U + __NVIC_PRIO_BITS);
+    return ((PreemptPriority & ((1UL << preemptBits) - 1UL)) << subBits) |
+           (SubPriority & ((1UL << subBits) - 1UL));
+}
+
+__STATIC_INLINE void NVIC_DecodePriority(uint32_t Priority, uint32_t PriorityGroup, uint32_t* const pPreemptPriority,
+                                         uint32_t* const pSubPriority)
+{
+    const uint32_t group = PriorityGroup & 0x07U;
+    const uint32_t preemptBits = ((7U - group) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7U - group);
+    const uint32_t subBits = ((group + __NVIC_PRIO_BITS) < 7U) ? 0U : (group - 7U + __NVIC_PRIO_BITS);
+    *pPreemptPriority = (Priority >> subBits) & ((1UL << preemptBits) - 1UL);
+    *pSubPriority = Priority & ((1UL << subBits) - 1UL);
+}
+
+/* PRIMASK */
+extern volatile uint32_t HostPrimask;
+
+__STATIC_INLINE void __disable_irq(void) { HostPrimask = 1U; }
+__STATIC_INLINE void __enable_irq(void) { HostPrimask = 0U; }
+__STATIC_INLINE uint32_t __get_PRIMASK(void) { return HostPrimask; }
+__STATIC_INLINE void __set_PRIMASK(uint32_t priMask) { HostPrimask = priMask & 1U; }
+
+/* Barriers and hints have no effect on the host */
+__STATIC_INLINE void __NOP(void) {}
+__STATIC_INLINE void __WFI(void) {}
+__STATIC_INLINE void __WFE(void) {}
+__STATIC_INLINE void __SEV(void) {}
+__STATIC_INLINE void __DSB(void) { __sync_synchronize(); }
+__STATIC_INLINE void __DMB(void) { __sync_synchronize(); }
+__STATIC_INLINE void __ISB(void) { __sync_synchronize(); }
+
+__STATIC_INLINE uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+    for (uint32_t bit = 0; bit < 32U; bit++)
+    {
+        result = (result << 1) | ((value >> bit) & 1U);
+    }
+    return result;
+}
+
+__STATIC_INLINE uint8_t __CLZ(uint32_t value)
+{
+    return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+__STATIC_INLINE uint32_t __REV(uint32_t value) { return __builtin_bswap32(value); }
+
+/* Exclusive access: single-threaded host, the store always succeeds */
+__STATIC_INLINE uint32_t __LDREXW(volatile uint32_t* addr) { return *addr; }
+__STATIC_INLINE uint32_t __STREXW(uint32_t value, volatile uint32_t* addr) { *addr = value; return 0U; }
+__STATIC_INLINE uint16_t __LDREXH(volatile uint16_t* addr) { return *addr; }
+__STATIC_INLINE uint32_t __STREXH(uint16_t value, volatile uint16_t* addr) { *addr = value; return 0U; }
+__STATIC_INLINE uint8_t __LDREXB(volatile uint8_t* addr) { return *addr; }
+__STATIC_INLINE uint32_t __STREXB(uint8_t value, volatile uint8_t* addr) { *addr = value; return 0U; }
+
+/* DWT and CoreDebug: only the registers the drivers use */
+typedef struct
+{
+    __IOM uint32_t CTRL;
+    __IOM uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    __IOM uint32_t DHCSR;
+    __OM  uint32_t DCRSR;
+    __IOM uint32_t DCRDR;
+    __IOM uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Pos          0U
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << DWT_CTRL_CYCCNTENA_Pos)
+#define CoreDebug_DEMCR_TRCENA_Pos      24U
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << CoreDebug_DEMCR_TRCENA_Pos)
+
+extern DWT_Type HostDwt;
+extern CoreDebug_Type HostCoreDebug;
+
+#define DWT         (&HostDwt)
+#define CoreDebug   (&HostCoreDebug)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_HOST_STUBS_CORE_CM4_H_ */
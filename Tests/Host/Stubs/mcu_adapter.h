@@ -0,0 +1,26 @@
+#ifndef MCU_ADAPTER_H_
+#define MCU_ADAPTER_H_
+
+/*
+ * Host build replacement for Adapters/Inc/mcu_adapter.h.
+ * Same LL headers as the STM32L433 target, except the Cortex (SysTick/SCB)
+ * and utils headers: the drivers do not use them and the host core_cm4.h
+ * does not model those core peripherals.
+ */
+
+#if defined(STM32L433xx)
+    #include "stm32l4xx_ll_bus.h"
+    #include "stm32l4xx_ll_crs.h"
+    #include "stm32l4xx_ll_dma.h"
+    #include "stm32l4xx_ll_exti.h"
+    #include "stm32l4xx_ll_gpio.h"
+    #include "stm32l4xx_ll_lpuart.h"
+    #include "stm32l4xx_ll_pwr.h"
+    #include "stm32l4xx_ll_rcc.h"
+    #include "stm32l4xx_ll_system.h"
+    #include "stm32l4xx_ll_tim.h"
+#else
+    #error "The host build emulates the STM32L433 only (-DSTM32L433xx)"
+#endif
+
+#endif /* MCU_ADAPTER_H_ */
@@ -0,0 +1,60 @@
+/**
+ * @file    Check.h
+ * @brief   Minimal assertion helpers for the host test programs
+ * @author  MootSeeker
+ *
+ * Each test is a plain program: CHECK()/CHECK_EQ() report a failure with its
+ * location and carry on, main() ends with `return Check::result();` so
+ * ctest sees a non-zero exit code if anything failed.
+ */
+
+#ifndef TESTS_HOST_SUPPORT_CHECK_H_
+#define TESTS_HOST_SUPPORT_CHECK_H_
+
+#include <cstdio>
+
+namespace Check
+{
+    inline int failures = 0;
+    inline int checks = 0;
+
+    inline bool check(bool condition, const char* expression, const char* file, int line)
+    {
+        checks++;
+        if (!condition)
+        {
+            failures++;
+            std::printf("%s:%d: CHECK failed: %s\n", file, line, expression);
+        }
+        return condition;
+    }
+
+    inline bool checkEqual(long long actual, long long expected, const char* expression, const char* file, int line)
+    {
+        checks++;
+        if (actual != expected)
+        {
+            failures++;
+            std::printf("%s:%d: CHECK_EQ failed: %s (got %lld, expected %lld)\n", file, line, expression, actual,
+                        expected);
+        }
+        return actual == expected;
+    }
+
+    /**
+     * @brief Print the summary; exit code for main()
+     */
+    inline int result()
+    {
+        std::printf("%d checks, %d failed\n", checks, failures);
+        return (failures == 0) ? 0 : 1;
+    }
+
+} // namespace Check
+
+#define CHECK(condition) Check::check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected) \
+    Check::checkEqual(static_cast<long long>(actual), static_cast<long long>(expected), #actual " == " #expected, \
+                      __FILE__, __LINE__)
+
+#endif /* TESTS_HOST_SUPPORT_CHECK_H_ */
@@ -0,0 +1,217 @@
+/**
+ * @file    DmaModel.h
+ * @brief   Model of one STM32L4 DMA channel on top of the host register memory
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * A driver programs CCR, CNDTR, CPAR and CMAR as on the target. Each call to
+ * request() plays one hardware request (a USART RXNE/TXE, a timer update or
+ * compare event) like the DMA controller does:
+ * - one item moves between CPAR and CMAR in the CCR direction and data sizes,
+ *   with address increments;
+ * - CNDTR counts down, HTIF/TCIF/GIF are raised at half and full count, and
+ *   a circular channel reloads the count latched when EN was set.
+ *
+ * Addresses are the 32-bit values the driver wrote, so they must point to
+ * mapped peripherals or static storage (see HostMcu.h).
+ *
+ * dispatch() runs a handler while one of the channel's enabled flags
+ * (TCIE/HTIE/TEIE) is set and then applies the IFCR writes, so it behaves
+ * like the NVIC entering the channel vector. IFCR writes made outside a
+ * handler take effect before the next request; CGIFx clears all four flags
+ * of the channel, as on the target.
+ */
+
+#ifndef TESTS_HOST_SUPPORT_DMAMODEL_H_
+#define TESTS_HOST_SUPPORT_DMAMODEL_H_
+
+#include "mcu_adapter.h"
+
+#include <cstdint>
+
+class DmaModel
+{
+public:
+    /**
+     * @param dma DMA1 or DMA2
+     * @param channel LL_DMA_CHANNEL_x (0-based)
+     */
+    DmaModel(DMA_TypeDef* dma, uint32_t channel)
+        : dma(dma), index(channel),
+          regs(reinterpret_cast<DMA_Channel_TypeDef*>(reinterpret_cast<uintptr_t>(dma) + 0x08U + 0x14U * channel))
+    {
+    }
+
+    [[nodiscard]] bool isEnabled() const { return (regs->CCR & DMA_CCR_EN) != 0; }
+    [[nodiscard]] uint32_t getRemaining() const { return regs->CNDTR; }
+    [[nodiscard]] uint32_t getTransfers() const { return transfers; }
+
+    /**
+     * @brief One DMA request: move one item if the channel is enabled and has data left
+     * @return true if an item was moved
+     */
+    bool request()
+    {
+        applyClears();   // IFCR writes of the driver take effect before the next request
+        if (!isEnabled() || regs->CNDTR == 0)
+        {
+            return false;
+        }
+
+        const uint32_t ccr = regs->CCR;
+        const uint32_t periphSize = 1U << ((ccr & DMA_CCR_PSIZE) >> DMA_CCR_PSIZE_Pos);
+        const uint32_t memorySize = 1U << ((ccr & DMA_CCR_MSIZE) >> DMA_CCR_MSIZE_Pos);
+        const uintptr_t periph = regs->CPAR + (((ccr & DMA_CCR_PINC) != 0) ? periphOffset : 0U);
+        const uintptr_t memory = regs->CMAR + (((ccr & DMA_CCR_MINC) != 0) ? memoryOffset : 0U);
+
+        if ((ccr & DMA_CCR_DIR) != 0)
+        {
+            write(periph, periphSize, read(memory, memorySize));
+        }
+        else
+        {
+            write(memory, memorySize, read(periph, periphSize));
+        }
+        periphOffset += periphSize;
+        memoryOffset += memorySize;
+        transfers++;
+
+        const uint32_t remaining = regs->CNDTR - 1U;
+        regs->CNDTR = remaining;
+        lastCount = remaining;
+        if (remaining == reload - reload / 2U)
+        {
+            raise(DMA_ISR_HTIF1);
+        }
+        if (remaining == 0U)
+        {
+            raise(DMA_ISR_TCIF1);
+            if ((ccr & DMA_CCR_CIRC) != 0)
+            {
+                regs->CNDTR = reload;
+                lastCount = reload;
+                periphOffset = 0;
+                memoryOffset = 0;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Flags of this channel (TCIF/HTIF/TEIF bits of channel 1 positions)
+     */
+    [[nodiscard]] uint32_t getFlags() const { return (dma->ISR >> (index * 4U)) & 0xFU; }
+
+    [[nodiscard]] bool isInterruptPending() const
+    {
+        return (getFlags() & regs->CCR & (DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE)) != 0;
+    }
+
+    /**
+     * @brief Run handler() while an enabled flag of this channel is set
+     * @return Number of handler runs
+     */
+    template <typename Handler>
+    uint32_t dispatch(Handler handler)
+    {
+        uint32_t runs = 0;
+        applyClears();
+        while (runs < 8U && isInterruptPending())
+        {
+            handler();
+            applyClears();
+            runs++;
+        }
+        return runs;
+    }
+
+    /**
+     * @brief Raise the transfer error flag (bus error on the target)
+     */
+    void raiseTransferError() { raise(DMA_ISR_TEIF1); }
+
+private:
+    DMA_TypeDef* dma;
+    uint32_t index;
+    DMA_Channel_TypeDef* regs;
+    bool latchedEnable = false;
+    uint32_t reload = 0;
+    uint32_t periphOffset = 0;
+    uint32_t memoryOffset = 0;
+    uint32_t transfers = 0;
+    uint32_t lastCount = 0;
+    uint32_t lastMemory = 0;
+    uint32_t lastPeriph = 0;
+
+    /// EN set: the channel latches CNDTR and restarts at CPAR/CMAR. CNDTR and
+    /// the addresses only change while EN is clear, so a change means the
+    /// driver disabled, reprogrammed and re-enabled the channel in between.
+    void latchEnable()
+    {
+        const bool enabled = isEnabled();
+        const bool reprogrammed = regs->CNDTR != lastCount || regs->CMAR != lastMemory || regs->CPAR != lastPeriph;
+        if (enabled && (!latchedEnable || reprogrammed))
+        {
+            reload = regs->CNDTR;
+            periphOffset = 0;
+            memoryOffset = 0;
+        }
+        latchedEnable = enabled;
+        lastCount = regs->CNDTR;
+        lastMemory = regs->CMAR;
+        lastPeriph = regs->CPAR;
+    }
+
+    void raise(uint32_t flagOfChannel1)
+    {
+        dma->ISR = dma->ISR | ((flagOfChannel1 | DMA_ISR_GIF1) << (index * 4U));
+    }
+
+    void applyClears()
+    {
+        // CGIFx clears all four flags of channel x
+        uint32_t clears = dma->IFCR;
+        for (uint32_t channel = 0; channel < 7U; channel++)
+        {
+            if ((clears & (DMA_IFCR_CGIF1 << (channel * 4U))) != 0U)
+            {
+                clears |= 0xFU << (channel * 4U);
+            }
+        }
+        dma->ISR = dma->ISR & ~clears;
+        dma->IFCR = 0;
+        latchEnable();
+    }
+
+    static uint32_t read(uintptr_t address, uint32_t size)
+    {
+        switch (size)
+        {
+            case 1:
+                return *reinterpret_cast<volatile uint8_t*>(address);
+            case 2:
+                return *reinterpret_cast<volatile uint16_t*>(address);
+            default:
+                return *reinterpret_cast<volatile uint32_t*>(address);
+        }
+    }
+
+    static void write(uintptr_t address, uint32_t size, uint32_t value)
+    {
+        switch (size)
+        {
+            case 1:
+                *reinterpret_cast<volatile uint8_t*>(address) = static_cast<uint8_t>(value);
+                break;
+            case 2:
+                *reinterpret_cast<volatile uint16_t*>(address) = static_cast<uint16_t>(value);
+                break;
+            default:
+                *reinterpret_cast<volatile uint32_t*>(address) = value;
+                break;
+        }
+    }
+};
+
+#endif /* TESTS_HOST_SUPPORT_DMAMODEL_H_ */
@@ -0,0 +1,266 @@
+/**
+ * @file    HostMcu.cpp
+ * @brief   STM32L433 peripheral memory for host tests
+ * @author  MootSeeker
+ *
+ * @see HostMcu.h for the mapped ranges and their limits
+ */
+
+#include "HostMcu.h"
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Provided by system_stm32l4xx.c on the target
+extern "C"
+{
+    uint32_t SystemCoreClock = 32000000U;
+    const uint8_t AHBPrescTable[16] = {0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 1U, 2U, 3U, 4U, 6U, 7U, 8U, 9U};
+    const uint8_t APBPrescTable[8] = {0U, 0U, 0U, 0U, 1U, 2U, 3U, 4U};
+    const uint32_t MSIRangeTable[12] = {100000U, 200000U, 400000U, 800000U, 1000000U, 2000000U,
+                                        4000000U, 8000000U, 16000000U, 24000000U, 32000000U, 48000000U};
+
+    volatile uint32_t HostPrimask = 0;
+    DWT_Type HostDwt = {};
+    CoreDebug_Type HostCoreDebug = {};
+}
+
+namespace
+{
+    struct Region
+    {
+        uintptr_t base;
+        size_t size;
+    };
+
+    constexpr Region REGIONS[] = {
+        {PERIPH_BASE, 0x30000U},        // APB1, APB2, AHB1
+        {AHB2PERIPH_BASE, 0x2000U},     // GPIOA..GPIOH
+    };
+
+    // IRQn -16 (system exceptions) .. 111
+    constexpr int IRQ_OFFSET = 16;
+    constexpr int IRQ_SLOTS = 128;
+
+    uint8_t irqEnabled[IRQ_SLOTS];
+    uint8_t irqPending[IRQ_SLOTS];
+    uint8_t irqPriority[IRQ_SLOTS];
+    uint32_t priorityGrouping;
+
+    int slotOf(IRQn_Type irq)
+    {
+        const int slot = static_cast<int>(irq) + IRQ_OFFSET;
+        if (slot < 0 || slot >= IRQ_SLOTS)
+        {
+            std::fprintf(stderr, "HostMcu: IRQ %d out of range\n", static_cast<int>(irq));
+            std::abort();
+        }
+        return slot;
+    }
+
+    // Pages whose accesses startAccessCount() counts: all GPIO ports, and RCC
+    constexpr Region COUNTED[] = {
+        {AHB2PERIPH_BASE, 0x2000U},
+        {RCC_BASE, 0x1000U},
+    };
+
+    volatile sig_atomic_t counting;
+    HostMcu::AccessCount accesses;
+
+    void protectCounted(int protection)
+    {
+        for (const Region& region : COUNTED)
+        {
+            mprotect(reinterpret_cast<void*>(region.base), region.size, protection);
+        }
+    }
+
+#if defined(__x86_64__) && defined(__linux__)
+    constexpr greg_t X86_TRAP_FLAG = 0x100;
+    constexpr greg_t PAGE_FAULT_WRITE = 0x2;
+
+    bool isCounted(uintptr_t address)
+    {
+        for (const Region& region : COUNTED)
+        {
+            if (address >= region.base && address < region.base + region.size)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // One fault per instruction: count it, open the pages and single-step it
+    void onAccessFault(int, siginfo_t* info, void* context)
+    {
+        if (!counting || !isCounted(reinterpret_cast<uintptr_t>(info->si_addr)))
+        {
+            signal(SIGSEGV, SIG_DFL);   // A real crash: fault again without the handler
+            return;
+        }
+        ucontext_t* const uc = static_cast<ucontext_t*>(context);
+        if ((uc->uc_mcontext.gregs[REG_ERR] & PAGE_FAULT_WRITE) != 0)
+        {
+            accesses.writes++;
+        }
+        else
+        {
+            accesses.reads++;
+        }
+        protectCounted(PROT_READ | PROT_WRITE);
+        uc->uc_mcontext.gregs[REG_EFL] |= X86_TRAP_FLAG;
+    }
+
+    // After the single step: close the pages for the next access
+    void onAccessStep(int, siginfo_t*, void* context)
+    {
+        ucontext_t* const uc = static_cast<ucontext_t*>(context);
+        uc->uc_mcontext.gregs[REG_EFL] &= ~X86_TRAP_FLAG;
+        if (counting)
+        {
+            protectCounted(PROT_NONE);
+        }
+    }
+#endif
+
+    // Runs before any static object of a test, which may already touch registers
+    __attribute__((constructor(101))) void mapPeripherals()
+    {
+        for (const Region& region : REGIONS)
+        {
+            void* mapped = mmap(reinterpret_cast<void*>(region.base), region.size, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+            if (mapped != reinterpret_cast<void*>(region.base))
+            {
+                std::fprintf(stderr, "HostMcu: cannot map peripherals at 0x%08lx\n",
+                             static_cast<unsigned long>(region.base));
+                std::abort();
+            }
+        }
+        HostMcu::reset();
+    }
+}
+
+extern "C"
+{
+    void NVIC_SetPriorityGrouping(uint32_t PriorityGroup) { priorityGrouping = PriorityGroup & 0x07U; }
+    uint32_t NVIC_GetPriorityGrouping(void) { return priorityGrouping; }
+    void NVIC_EnableIRQ(IRQn_Type IRQn) { irqEnabled[slotOf(IRQn)] = 1U; }
+    void NVIC_DisableIRQ(IRQn_Type IRQn) { irqEnabled[slotOf(IRQn)] = 0U; }
+    uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn) { return irqEnabled[slotOf(IRQn)]; }
+    void NVIC_SetPendingIRQ(IRQn_Type IRQn) { irqPending[slotOf(IRQn)] = 1U; }
+    void NVIC_ClearPendingIRQ(IRQn_Type IRQn) { irqPending[slotOf(IRQn)] = 0U; }
+    uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn) { return irqPending[slotOf(IRQn)]; }
+    void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+    {
+        irqPriority[slotOf(IRQn)] = static_cast<uint8_t>(priority & ((1U << __NVIC_PRIO_BITS) - 1U));
+    }
+    uint32_t NVIC_GetPriority(IRQn_Type IRQn) { return irqPriority[slotOf(IRQn)]; }
+}
+
+namespace HostMcu
+{
+    void reset() noexcept
+    {
+        for (const Region& region : REGIONS)
+        {
+            std::memset(reinterpret_cast<void*>(region.base), 0, region.size);
+        }
+        std::memset(irqEnabled, 0, sizeof(irqEnabled));
+        std::memset(irqPending, 0, sizeof(irqPending));
+        std::memset(irqPriority, 0, sizeof(irqPriority));
+        priorityGrouping = 0;
+        HostPrimask = 0;
+        HostDwt = {};
+        HostCoreDebug = {};
+
+        // GPIO reset values (RM0394): debug pins on PA13..PA15 and PB3/PB4, all others analog
+        GPIO_TypeDef* const ports[] = {GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOH};
+        for (GPIO_TypeDef* port : ports)
+        {
+            port->MODER = 0xFFFFFFFFU;
+        }
+        GPIOA->MODER = 0xABFFFFFFU;
+        GPIOA->OSPEEDR = 0x0C000000U;
+        GPIOA->PUPDR = 0x64000000U;
+        GPIOB->MODER = 0xFFFFFEBFU;
+        GPIOB->PUPDR = 0x00000100U;
+
+        // An idle, enabled transmitter reports TXE and TC
+        USART_TypeDef* const usarts[] = {USART1, USART2, USART3, LPUART1};
+        for (USART_TypeDef* usart : usarts)
+        {
+            usart->ISR = USART_ISR_TXE | USART_ISR_TC;
+        }
+
+        // Timer auto-reload registers reset to all ones
+        TIM_TypeDef* const timers[] = {TIM1, TIM6, TIM7, TIM15, TIM16};
+        for (TIM_TypeDef* timer : timers)
+        {
+            timer->ARR = 0xFFFFU;
+        }
+        TIM2->ARR = 0xFFFFFFFFU;
+
+        // Clock tree as SystemClock_Config(): HSI x 8 / 2 = 64 MHz SYSCLK, AHB / 2, APB / 1
+        LL_RCC_HSI_Enable();
+        LL_RCC_PLL_ConfigDomain_SYS(LL_RCC_PLLSOURCE_HSI, LL_RCC_PLLM_DIV_1, 8, LL_RCC_PLLR_DIV_2);
+        LL_RCC_PLL_EnableDomain_SYS();
+        LL_RCC_SetSysClkSource(LL_RCC_SYS_CLKSOURCE_PLL);
+        MODIFY_REG(RCC->CFGR, RCC_CFGR_SWS, LL_RCC_SYS_CLKSOURCE_STATUS_PLL);
+        LL_RCC_SetAHBPrescaler(LL_RCC_SYSCLK_DIV_2);
+        LL_RCC_SetAPB1Prescaler(LL_RCC_APB1_DIV_1);
+        LL_RCC_SetAPB2Prescaler(LL_RCC_APB2_DIV_1);
+        SystemCoreClock = 32000000U;
+    }
+
+    bool isIrqEnabled(IRQn_Type irq) noexcept
+    {
+        return irqEnabled[slotOf(irq)] != 0U;
+    }
+
+    bool isIrqPending(IRQn_Type irq) noexcept
+    {
+        return irqPending[slotOf(irq)] != 0U;
+    }
+
+    uint32_t getIrqPriority(IRQn_Type irq) noexcept
+    {
+        return irqPriority[slotOf(irq)];
+    }
+
+    void startAccessCount() noexcept
+    {
+#if defined(__x86_64__) && defined(__linux__)
+        struct sigaction action = {};
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        action.sa_sigaction = onAccessFault;
+        sigaction(SIGSEGV, &action, nullptr);
+        action.sa_sigaction = onAccessStep;
+        sigaction(SIGTRAP, &action, nullptr);
+
+        accesses = {};
+        counting = 1;
+        protectCounted(PROT_NONE);
+#else
+        std::fprintf(stderr, "HostMcu: access counting needs an x86-64 Linux host\n");
+        std::abort();
+#endif
+    }
+
+    AccessCount stopAccessCount() noexcept
+    {
+        counting = 0;
+        protectCounted(PROT_READ | PROT_WRITE);
+        signal(SIGSEGV, SIG_DFL);
+        signal(SIGTRAP, SIG_DFL);
+        return accesses;
+    }
+
+} // namespace HostMcu
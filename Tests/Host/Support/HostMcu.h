@@ -0,0 +1,80 @@
+/**
+ * @file    HostMcu.h
+ * @brief   STM32L433 peripheral memory for host tests
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * The drivers access peripherals through the device header's fixed
+ * addresses (GPIOA = 0x48000000, USART1 = 0x40013800, ...). The host build
+ * maps ordinary memory at those addresses before any test code runs, so
+ * the unmodified Device/ and Library/ sources run on the host. Registers
+ * are plain memory: a write is stored, a read returns the last value, and
+ * nothing happens on its own. A test that needs hardware behaviour (a
+ * USART shifting out a byte, a DMA channel moving a word) models it itself,
+ * see UsartModel.h.
+ *
+ * Mapped ranges: APB1, APB2 and AHB1 (0x40000000..0x4002FFFF, timers,
+ * USARTs, EXTI, SYSCFG, DMA, RCC, FLASH) and AHB2 GPIO (0x48000000..0x48001FFF).
+ * The accesses to GPIO and RCC can be counted (startAccessCount()).
+ *
+ * Pointers are converted to uint32_t for DMA addresses as on the target, so
+ * test programs link without PIE and keep DMA buffers (and objects that
+ * contain them) in static storage, below 4 GB.
+ */
+
+#ifndef TESTS_HOST_SUPPORT_HOSTMCU_H_
+#define TESTS_HOST_SUPPORT_HOSTMCU_H_
+
+#include "mcu_adapter.h"
+
+#include <cstdint>
+
+/**
+ * @namespace HostMcu
+ * @brief Reset and inspection of the emulated MCU state
+ */
+namespace HostMcu
+{
+    /**
+     * @brief Return all peripherals, the NVIC, PRIMASK and DWT to their state after boot
+     *
+     * Registers get their reset values where drivers depend on them (GPIO
+     * modes, USART TXE/TC); RCC is left as SystemClock_Config() programs it
+     * (PLL from HSI, 32 MHz HCLK and PCLK), and SystemCoreClock is 32 MHz.
+     */
+    void reset() noexcept;
+
+    [[nodiscard]] bool isIrqEnabled(IRQn_Type irq) noexcept;
+    [[nodiscard]] bool isIrqPending(IRQn_Type irq) noexcept;
+    [[nodiscard]] uint32_t getIrqPriority(IRQn_Type irq) noexcept;
+
+    /**
+     * @struct AccessCount
+     * @brief CPU loads and stores to the GPIO ports and RCC
+     */
+    struct AccessCount
+    {
+        uint32_t reads;
+        uint32_t writes;
+    };
+
+    /**
+     * @brief Count every access to the GPIO ports (GPIOA..GPIOH) and RCC from now on
+     *
+     * Their pages lose all access rights: each instruction that touches
+     * them faults once, is counted as a read or a write, and is single-
+     * stepped with the pages open again. A read-modify-write is one read
+     * and one write, as on the Cortex-M4. Only for x86-64 Linux hosts; do
+     * not call reset() in between.
+     */
+    void startAccessCount() noexcept;
+
+    /**
+     * @brief Stop counting and return the accesses since startAccessCount()
+     */
+    [[nodiscard]] AccessCount stopAccessCount() noexcept;
+
+} // namespace HostMcu
+
+#endif /* TESTS_HOST_SUPPORT_HOSTMCU_H_ */
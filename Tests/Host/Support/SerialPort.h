@@ -0,0 +1,150 @@
+/**
+ * @file    SerialPort.h
+ * @brief   Linux serial port (termios, raw 8N1) and pseudo-terminal pair for host tools and tests
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * SerialPort opens a tty device (/dev/ttyACM0, a pty slave, ...) in raw
+ * mode and reads with a timeout. openPty() creates a pseudo-terminal pair:
+ * a test plays the device on the master side and hands the slave path to
+ * the host code under test, which opens it like a USB-serial adapter.
+ *
+ * ```
+ *   int master; std::string path;
+ *   openPty(master, path);
+ *   SerialPort port;
+ *   port.open(path.c_str(), B115200);
+ * ```
+ */
+
+#ifndef TESTS_HOST_SUPPORT_SERIALPORT_H_
+#define TESTS_HOST_SUPPORT_SERIALPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// termios.h defines the CRn output delay flags, which collide with the CR1..CR3 register names
+#undef CR0
+#undef CR1
+#undef CR2
+#undef CR3
+
+class SerialPort
+{
+public:
+    SerialPort() = default;
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+
+    ~SerialPort() { close(); }
+
+    /**
+     * @brief Open a tty in raw mode
+     * @param speed termios speed constant (B115200, ...)
+     */
+    bool open(const char* path, speed_t speed = B115200)
+    {
+        close();
+        fd = ::open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        termios settings{};
+        if (tcgetattr(fd, &settings) != 0)
+        {
+            close();
+            return false;
+        }
+        cfmakeraw(&settings);
+        cfsetispeed(&settings, speed);
+        cfsetospeed(&settings, speed);
+        settings.c_cflag |= CLOCAL | CREAD;
+        settings.c_cc[VMIN] = 0;
+        settings.c_cc[VTIME] = 0;
+        if (tcsetattr(fd, TCSANOW, &settings) != 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    /**
+     * @brief Read what is available, waiting up to timeoutMs for the first byte
+     * @return Bytes read (0 on timeout or error)
+     */
+    size_t read(uint8_t* data, size_t capacity, int timeoutMs)
+    {
+        pollfd request{fd, POLLIN, 0};
+        if (fd < 0 || ::poll(&request, 1, timeoutMs) <= 0 || (request.revents & POLLIN) == 0)
+        {
+            return 0;
+        }
+        const ssize_t count = ::read(fd, data, capacity);
+        return (count > 0) ? static_cast<size_t>(count) : 0U;
+    }
+
+    bool write(const uint8_t* data, size_t length)
+    {
+        while (length > 0)
+        {
+            const ssize_t count = ::write(fd, data, length);
+            if (count <= 0)
+            {
+                return false;
+            }
+            data += count;
+            length -= static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool isOpen() const { return fd >= 0; }
+    [[nodiscard]] int getDescriptor() const { return fd; }
+
+private:
+    int fd = -1;
+};
+
+/**
+ * @brief Create a pseudo-terminal pair
+ * @param master Receives the master descriptor (the "device" end)
+ * @param slavePath Receives the path the host side opens
+ */
+inline bool openPty(int& master, std::string& slavePath)
+{
+    master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0)
+    {
+        return false;
+    }
+    const char* name = nullptr;
+    if (grantpt(master) != 0 || unlockpt(master) != 0 || (name = ptsname(master)) == nullptr)
+    {
+        ::close(master);
+        master = -1;
+        return false;
+    }
+    slavePath = name;
+    return true;
+}
+
+#endif /* TESTS_HOST_SUPPORT_SERIALPORT_H_ */
@@ -0,0 +1,347 @@
+/**
+ * @file    UsartModel.h
+ * @brief   Character-time model of a USART/LPUART peripheral around a UsartDriver
+ * @author  MootSeeker
+ *
+ * ## Overview
+ *
+ * Peripheral registers are plain memory on the host (see HostMcu.h), so a
+ * driver writing TDR or clearing TC has no effect by itself. UsartModel
+ * plays the hardware side of one instance, one character time per step():
+ *
+ * - The byte in the shift register goes out on the wire. TDR moves into
+ *   the shifter, otherwise TC is set.
+ * - The next queued RX byte lands in RDR and sets RXNE. With RTS/CTS the
+ *   peer holds it back while RXNE is still set; without it, the byte
+ *   overruns (ORE).
+ * - While an enabled flag is set, the driver's handleInterrupt() runs again,
+ *   as the NVIC re-enters the handler. After each run the model applies the
+ *   side effects: a TDR write clears TXE and TC, ICR bits clear their flags,
+ *   and RQR.RXFRQ drops RDR. An RXNE the handler serviced (RXNEIE set) counts
+ *   as read.
+ * - With DEM set (RS-485), DE is asserted DEAT sample times before the first
+ *   start bit and released DEDT after the stop bit that raised TC. The
+ *   pulses are recorded in bit periods since construction.
+ * - With CR2.RTOEN set, RTOF rises RTOR.RTO bit periods after the stop bit
+ *   of the last received character. If nothing is on the wire until then,
+ *   step() only advances to that instant, so a response started from the
+ *   timeout interrupt leaves at the exact bit time.
+ * - setLoopback() models a half-duplex transceiver: every word on the wire
+ *   is also received while CR1.RE is set.
+ *
+ * ```
+ *   UsartModel<USART::StandardUSART> wire(driver);
+ *   driver.sendString("hi");
+ *   wire.run();                           // until nothing is shifting or pending
+ *   wire.takeTransmitted();               // {'h', 'i'}
+ *   wire.queueReceive(frame, sizeof(frame));
+ *   wire.run();
+ * ```
+ */
+
+#ifndef TESTS_HOST_SUPPORT_USARTMODEL_H_
+#define TESTS_HOST_SUPPORT_USARTMODEL_H_
+
+#include "usart.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+template <typename Driver>
+class UsartModel
+{
+public:
+    explicit UsartModel(Driver& driver) : driver(driver), usart(driver.getInstance())
+    {
+        usart->TDR = TDR_EMPTY;
+        usart->ISR = USART_ISR_TXE | USART_ISR_TC;
+    }
+
+    /**
+     * @brief Queue bytes arriving on RX, one per step
+     */
+    void queueReceive(const uint8_t* data, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            rxQueue.push_back(data[i]);
+        }
+    }
+
+    void queueReceive(uint8_t data) { rxQueue.push_back(data); }
+
+    /**
+     * @brief Receive our own words back, as through an RS-485 transceiver
+     */
+    void setLoopback(bool enabled) { loopback = enabled; }
+
+    /// DE assertion, both edges in bit periods since construction
+    struct DriverEnablePulse
+    {
+        double assertedAt;
+        double releasedAt;
+    };
+
+    /**
+     * @brief Raise a status flag (IDLE, RTOF, LBDF, ...) until the driver clears it through ICR
+     */
+    void raise(uint32_t isrFlag)
+    {
+        applyDriverWrites();   // An earlier ICR write must not clear the new flag
+        usart->ISR = usart->ISR | isrFlag;
+        serviceInterrupts();
+    }
+
+    /**
+     * @brief Advance one character time
+     * @return true while a character is shifting, queued or pending
+     */
+    bool step()
+    {
+        applyDriverWrites();
+
+        const bool lineIdle = rxQueue.empty() && !shifting && !tdrFull;
+        if (rtoArmed && lineIdle && rtoDeadline < bitTime + getCharacterBits())
+        {
+            bitTime = (rtoDeadline > bitTime) ? rtoDeadline : bitTime;
+            rtoArmed = false;
+            usart->ISR = usart->ISR | USART_ISR_RTOF;
+            serviceInterrupts();
+            return true;
+        }
+
+        steps++;
+        bitTime += getCharacterBits();
+
+        if (shifting)
+        {
+            transmitted.push_back(shiftRegister);
+            transmitTimes.push_back(shiftStart);
+            shifting = false;
+            if (loopback && (usart->CR1 & USART_CR1_RE) != 0)
+            {
+                rxQueue.push_front(static_cast<uint8_t>(shiftRegister));
+            }
+            if (tdrFull)
+            {
+                loadShifter();
+            }
+            else
+            {
+                usart->ISR = usart->ISR | USART_ISR_TC;
+                if (driverEnabled)
+                {
+                    driverEnabled = false;
+                    pulses.back().releasedAt = bitTime + sampleTimes(USART_CR1_DEDT, USART_CR1_DEDT_Pos);
+                }
+            }
+        }
+
+        if (!rxQueue.empty())
+        {
+            const bool rxHeld = (usart->ISR & USART_ISR_RXNE) != 0;
+            const bool rtsFlowControl = (usart->CR3 & USART_CR3_RTSE) != 0;
+            if (!rxHeld)
+            {
+                usart->RDR = rxQueue.front();
+                rxQueue.pop_front();
+                usart->ISR = usart->ISR | USART_ISR_RXNE;
+                lastReceiveEnd = bitTime;
+                if ((usart->CR2 & USART_CR2_RTOEN) != 0)
+                {
+                    rtoArmed = true;
+                    rtoDeadline = bitTime + static_cast<double>(usart->RTOR & USART_RTOR_RTO);
+                }
+            }
+            else if (!rtsFlowControl)
+            {
+                // The peer does not wait: the byte is lost
+                rxQueue.pop_front();
+                usart->ISR = usart->ISR | USART_ISR_ORE;
+                overruns++;
+            }
+        }
+
+        if (rtoArmed && bitTime >= rtoDeadline)
+        {
+            rtoArmed = false;
+            usart->ISR = usart->ISR | USART_ISR_RTOF;
+        }
+
+        serviceInterrupts();
+        return shifting || tdrFull || !rxQueue.empty() || rtoArmed || isInterruptPending();
+    }
+
+    /**
+     * @brief Step until the line is idle (or maxSteps character times passed)
+     * @return Steps taken
+     */
+    size_t run(size_t maxSteps = 100000)
+    {
+        size_t steps = 0;
+        while (steps < maxSteps)
+        {
+            steps++;
+            if (!step())
+            {
+                break;
+            }
+        }
+        return steps;
+    }
+
+    /**
+     * @brief Words that left the shift register (9 bits for address marks)
+     */
+    const std::vector<uint16_t>& getTransmitted() const { return transmitted; }
+
+    /**
+     * @brief Start bit of every word in getTransmitted(), in bit periods since construction
+     */
+    const std::vector<double>& getTransmitTimes() const { return transmitTimes; }
+
+    /**
+     * @brief Transmitted bytes since the last call
+     */
+    std::vector<uint8_t> takeTransmitted()
+    {
+        std::vector<uint8_t> bytes(transmitted.begin(), transmitted.end());
+        transmitted.clear();
+        transmitTimes.clear();
+        return bytes;
+    }
+
+    /// End of the stop bit of the last received character, in bit periods since construction
+    [[nodiscard]] double getLastReceiveTime() const { return lastReceiveEnd; }
+
+    [[nodiscard]] size_t getOverrunCount() const { return overruns; }
+    [[nodiscard]] size_t getPendingReceiveCount() const { return rxQueue.size(); }
+
+    /// Character times stepped so far
+    [[nodiscard]] size_t getStepCount() const { return steps; }
+
+    /// Start, data, parity and stop bits of one character, from CR1.M and CR2.STOP
+    [[nodiscard]] double getCharacterBits() const
+    {
+        const uint32_t m = usart->CR1 & (USART_CR1_M0 | USART_CR1_M1);
+        const double dataBits = (m == USART_CR1_M0) ? 9.0 : (m == USART_CR1_M1) ? 7.0 : 8.0;
+        const uint32_t stop = usart->CR2 & USART_CR2_STOP;
+        const double stopBits = (stop == USART_CR2_STOP_1) ? 2.0 : (stop == USART_CR2_STOP) ? 1.5
+                              : (stop == USART_CR2_STOP_0) ? 0.5 : 1.0;
+        return 1.0 + dataBits + stopBits;
+    }
+
+    /**
+     * @brief DE pulses so far; releasedAt is 0 while DE is still asserted
+     */
+    const std::vector<DriverEnablePulse>& getDriverEnablePulses() const { return pulses; }
+
+    /**
+     * @brief Run the interrupt handler while an enabled flag is pending
+     */
+    void serviceInterrupts()
+    {
+        applyDriverWrites();
+        for (int guard = 0; guard < 16 && isInterruptPending(); guard++)
+        {
+            const bool rxServiced = (usart->ISR & USART_ISR_RXNE) != 0 && (usart->CR1 & USART_CR1_RXNEIE) != 0;
+            driver.handleInterrupt();
+            if (rxServiced)
+            {
+                usart->ISR = usart->ISR & ~USART_ISR_RXNE;
+            }
+            applyDriverWrites();
+        }
+    }
+
+private:
+    static constexpr uint16_t TDR_EMPTY = 0xFFFFU;   // TDR holds at most 9 data bits
+
+    Driver& driver;
+    USART_TypeDef* usart;
+    std::deque<uint8_t> rxQueue;
+    std::vector<uint16_t> transmitted;
+    std::vector<double> transmitTimes;
+    uint16_t shiftRegister = 0;
+    uint16_t tdrValue = 0;
+    bool shifting = false;
+    bool tdrFull = false;
+    size_t overruns = 0;
+    size_t steps = 0;
+    double bitTime = 0.0;
+    double shiftStart = 0.0;
+    double lastReceiveEnd = 0.0;
+    double rtoDeadline = 0.0;
+    bool rtoArmed = false;
+    bool loopback = false;
+    bool driverEnabled = false;
+    std::vector<DriverEnablePulse> pulses;
+
+    bool isInterruptPending() const
+    {
+        const uint32_t isr = usart->ISR;
+        const uint32_t cr1 = usart->CR1;
+        return ((isr & (USART_ISR_RXNE | USART_ISR_ORE)) != 0 && (cr1 & USART_CR1_RXNEIE) != 0) ||
+               ((isr & USART_ISR_TXE) != 0 && (cr1 & USART_CR1_TXEIE) != 0) ||
+               ((isr & USART_ISR_TC) != 0 && (cr1 & USART_CR1_TCIE) != 0) ||
+               ((isr & USART_ISR_IDLE) != 0 && (cr1 & USART_CR1_IDLEIE) != 0) ||
+               ((isr & USART_ISR_RTOF) != 0 && (cr1 & USART_CR1_RTOIE) != 0) ||
+               ((isr & USART_ISR_LBDF) != 0 && (usart->CR2 & USART_CR2_LBDIE) != 0);
+    }
+
+    /// A DEAT/DEDT field in bit periods
+    double sampleTimes(uint32_t mask, uint32_t position) const
+    {
+        const double samplesPerBit = (usart->CR1 & USART_CR1_OVER8) != 0 ? 8.0 : 16.0;
+        return static_cast<double>((usart->CR1 & mask) >> position) / samplesPerBit;
+    }
+
+    void loadShifter()
+    {
+        shiftRegister = tdrValue;
+        shifting = true;
+        shiftStart = bitTime;
+        tdrFull = false;
+        usart->ISR = usart->ISR | USART_ISR_TXE;
+        if (!driverEnabled && (usart->CR3 & USART_CR3_DEM) != 0)
+        {
+            // The start bit goes out now, at bitTime
+            driverEnabled = true;
+            pulses.push_back({bitTime - sampleTimes(USART_CR1_DEAT, USART_CR1_DEAT_Pos), 0.0});
+        }
+    }
+
+    /// Side effects of register writes the driver made since the last call
+    void applyDriverWrites()
+    {
+        if (usart->TDR != TDR_EMPTY)
+        {
+            tdrValue = static_cast<uint16_t>(usart->TDR & 0x1FFU);
+            usart->TDR = TDR_EMPTY;
+            tdrFull = true;
+            usart->ISR = usart->ISR & ~(USART_ISR_TXE | USART_ISR_TC);
+            if (!shifting)
+            {
+                loadShifter();
+            }
+        }
+
+        const uint32_t icr = usart->ICR;
+        if (icr != 0)
+        {
+            // ICR bit n clears ISR bit n for the flags the drivers use
+            usart->ISR = usart->ISR & ~(icr & (USART_ISR_PE | USART_ISR_FE | USART_ISR_NE | USART_ISR_ORE |
+                                               USART_ISR_IDLE | USART_ISR_TC | USART_ISR_LBDF | USART_ISR_RTOF));
+            usart->ICR = 0;
+        }
+
+        if ((usart->RQR & USART_RQR_RXFRQ) != 0)
+        {
+            usart->ISR = usart->ISR & ~USART_ISR_RXNE;
+        }
+        usart->RQR = 0;
+    }
+};
+
+#endif /* TESTS_HOST_SUPPORT_USARTMODEL_H_ */
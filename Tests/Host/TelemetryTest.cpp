@@ -0,0 +1,226 @@
+/**
+ * @file    TelemetryTest.cpp
+ * @brief   CBOR encoder/decoder: RFC 8949 encodings, record round trips, TX reservation commit/abort, encode time
+ * @author  MootSeeker
+ *
+ * The last part measures, on the host, the time to encode an ImuSample
+ * record against formatting the same sample with vsnprintf() as
+ * sendFormatted() does, and prints both record sizes.
+ */
+
+#include "Check.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    using ImuSample = Telemetry::Record<uint32_t, float, float, float>;
+    static_assert(ImuSample::MAX_SIZE == 25, "ImuSample worst case");
+
+    USART::StandardUSART uart(USART::PeripheralType::USART_2);
+
+    std::vector<uint8_t> encodeUnsigned(uint32_t value)
+    {
+        uint8_t buffer[8];
+        Telemetry::LinearSink sink(buffer, sizeof(buffer));
+        Telemetry::Encoder<Telemetry::LinearSink> encoder(sink);
+        encoder.writeUnsigned(value);
+        return std::vector<uint8_t>(buffer, buffer + sink.size());
+    }
+
+    std::vector<uint8_t> encodeSigned(int32_t value)
+    {
+        uint8_t buffer[8];
+        Telemetry::LinearSink sink(buffer, sizeof(buffer));
+        Telemetry::Encoder<Telemetry::LinearSink> encoder(sink);
+        encoder.writeSigned(value);
+        return std::vector<uint8_t>(buffer, buffer + sink.size());
+    }
+
+    /// Examples from RFC 8949 Appendix A
+    void testRfcEncodings()
+    {
+        CHECK(encodeUnsigned(0) == std::vector<uint8_t>({0x00}));
+        CHECK(encodeUnsigned(23) == std::vector<uint8_t>({0x17}));
+        CHECK(encodeUnsigned(24) == std::vector<uint8_t>({0x18, 0x18}));
+        CHECK(encodeUnsigned(100) == std::vector<uint8_t>({0x18, 0x64}));
+        CHECK(encodeUnsigned(1000) == std::vector<uint8_t>({0x19, 0x03, 0xE8}));
+        CHECK(encodeUnsigned(1000000) == std::vector<uint8_t>({0x1A, 0x00, 0x0F, 0x42, 0x40}));
+        CHECK(encodeSigned(-1) == std::vector<uint8_t>({0x20}));
+        CHECK(encodeSigned(-100) == std::vector<uint8_t>({0x38, 0x63}));
+        CHECK(encodeSigned(-1000) == std::vector<uint8_t>({0x39, 0x03, 0xE7}));
+
+        uint8_t buffer[16];
+        Telemetry::LinearSink sink(buffer, sizeof(buffer));
+        Telemetry::Encoder<Telemetry::LinearSink> encoder(sink);
+        encoder.writeFloat(100000.0F);
+        encoder.writeBool(true);
+        encoder.writeNull();
+        encoder.writeText("a");
+        CHECK(std::vector<uint8_t>(buffer, buffer + sink.size()) ==
+              std::vector<uint8_t>({0xFA, 0x47, 0xC3, 0x50, 0x00, 0xF5, 0xF6, 0x61, 0x61}));
+    }
+
+    void testRecordRoundTrip()
+    {
+        using Mixed = Telemetry::Record<uint8_t, int16_t, int32_t, bool, Telemetry::Bytes<4>>;
+        static_assert(Mixed::MAX_SIZE == 1 + 5 + 2 + 3 + 5 + 1 + 5, "Mixed worst case");
+
+        const uint8_t blob[] = {1, 2, 3, 4, 5, 6};
+        uint8_t buffer[Mixed::MAX_SIZE];
+        Telemetry::LinearSink sink(buffer, sizeof(buffer));
+        Telemetry::Encoder<Telemetry::LinearSink> encoder(sink);
+        CHECK(Mixed::encode(encoder, uint8_t{200}, int16_t{-300}, INT32_MIN, true, Telemetry::Bytes<4>{blob, 6}));
+        CHECK(sink.size() <= Mixed::MAX_SIZE);
+
+        uint8_t small = 0;
+        int16_t medium = 0;
+        int32_t large = 0;
+        bool flag = false;
+        Telemetry::Bytes<4> bytes{nullptr, 0};
+        Telemetry::Decoder decoder(buffer, sink.size());
+        CHECK(Mixed::decode(decoder, small, medium, large, flag, bytes));
+        CHECK(decoder.isAtEnd());
+        CHECK_EQ(small, 200);
+        CHECK_EQ(medium, -300);
+        CHECK_EQ(large, INT32_MIN);
+        CHECK(flag);
+        CHECK(bytes.length == 4 && std::equal(blob, blob + 4, bytes.data));
+
+        // A value that does not fit the field type, a truncated record, a wrong schema
+        Telemetry::Decoder narrow(buffer, sink.size());
+        int8_t tooSmall = 0;
+        CHECK(!(Telemetry::Record<int8_t, int16_t, int32_t, bool, Telemetry::Bytes<4>>::decode(
+            narrow, tooSmall, medium, large, flag, bytes)));
+
+        Telemetry::Decoder truncated(buffer, static_cast<size_t>(sink.size() - 1));
+        CHECK(!Mixed::decode(truncated, small, medium, large, flag, bytes));
+
+        Telemetry::Decoder wrong(buffer, sink.size());
+        uint32_t time = 0;
+        float value = 0.0F;
+        CHECK(!(Telemetry::Record<uint32_t, float>::decode(wrong, time, value)));
+    }
+
+    void testReservation(UsartModel<USART::StandardUSART>& wire)
+    {
+        // Reservation too small: the record fails and is aborted, nothing goes out
+        auto reservation = uart.reserveTx(ImuSample::MAX_SIZE - 10);
+        Telemetry::Encoder<USART::StandardUSART::TxReservation> partial(reservation);
+        CHECK(!ImuSample::encode(partial, 123456U, 0.12F, -0.98F, 9.81F));
+        uart.abortTx(reservation);
+        CHECK_EQ(uart.commitTx(reservation), 0);
+        wire.run();
+        CHECK(wire.takeTransmitted().empty());
+
+        reservation = uart.reserveTx(ImuSample::MAX_SIZE);
+        Telemetry::Encoder<USART::StandardUSART::TxReservation> encoder(reservation);
+        CHECK(ImuSample::encode(encoder, 123456U, 0.12F, -0.98F, 9.81F));
+        CHECK_EQ(uart.commitTx(reservation), 25);
+        wire.run();
+        const std::vector<uint8_t> frame = wire.takeTransmitted();
+
+        uint32_t time = 0;
+        float ax = 0.0F;
+        float ay = 0.0F;
+        float az = 0.0F;
+        Telemetry::Decoder decoder(frame.data(), frame.size());
+        CHECK(ImuSample::decode(decoder, time, ax, ay, az) && decoder.isAtEnd());
+        CHECK(time == 123456U && ax == 0.12F && ay == -0.98F && az == 9.81F);
+    }
+
+    int format(char* buffer, size_t size, const char* text, ...)
+    {
+        va_list args;
+        va_start(args, text);
+        const int length = std::vsnprintf(buffer, size, text, args);
+        va_end(args);
+        return length;
+    }
+
+    constexpr const char* IMU_FORMAT = "t=%lu ax=%.3f ay=%.3f az=%.3f\r\n";
+
+    size_t cborSize(uint32_t time, float ax, float ay, float az)
+    {
+        uint8_t buffer[ImuSample::MAX_SIZE];
+        Telemetry::LinearSink sink(buffer, sizeof(buffer));
+        Telemetry::Encoder<Telemetry::LinearSink> encoder(sink);
+        ImuSample::encode(encoder, time, ax, ay, az);
+        return sink.size();
+    }
+
+    /// Sizes quoted in Telemetry.h: time 0..2^32-1, accelerations within +-16 g
+    void testSizeComparison()
+    {
+        char line[96];
+        const size_t textMin = static_cast<size_t>(format(line, sizeof(line), IMU_FORMAT, 0UL, 0.0, 0.0, 0.0));
+        const size_t textMax = static_cast<size_t>(format(line, sizeof(line), IMU_FORMAT, 4294967295UL, -15.999,
+                                                          -15.999, -15.999));
+        CHECK_EQ(textMin, 32);
+        CHECK_EQ(textMax, 47);
+        CHECK_EQ(cborSize(60000, 0.12F, -0.98F, 9.81F), 23);
+        CHECK_EQ(cborSize(4294967295U, 0.12F, -0.98F, 9.81F), 25);
+        std::printf("ImuSample: text %zu..%zu bytes, CBOR %zu..%zu bytes\n", textMin, textMax,
+                    cborSize(0, 0.0F, 0.0F, 0.0F), static_cast<size_t>(ImuSample::MAX_SIZE));
+    }
+
+    template<typename Body>
+    double nanosecondsPerCall(Body body)
+    {
+        constexpr int ROUNDS = 7;
+        constexpr int CALLS = 20000;
+        double best[ROUNDS];
+        for (double& result : best)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < CALLS; i++)
+            {
+                body(i);
+            }
+            result = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CALLS;
+        }
+        std::sort(best, best + ROUNDS);
+        return best[ROUNDS / 2];
+    }
+
+    void benchmarkEncode()
+    {
+        volatile size_t sink = 0;
+        const double text = nanosecondsPerCall([&](int i) {
+            char line[96];
+            sink = sink + static_cast<size_t>(format(line, sizeof(line), IMU_FORMAT, static_cast<unsigned long>(i),
+                                                     0.12 + i * 1e-4, -0.98, 9.81));
+        });
+        const double cbor = nanosecondsPerCall([&](int i) {
+            uint8_t buffer[ImuSample::MAX_SIZE];
+            Telemetry::LinearSink out(buffer, sizeof(buffer));
+            Telemetry::Encoder<Telemetry::LinearSink> encoder(out);
+            ImuSample::encode(encoder, static_cast<uint32_t>(i), 0.12F + static_cast<float>(i) * 1e-4F, -0.98F, 9.81F);
+            sink = sink + out.size();
+        });
+        std::printf("ImuSample encode (host): vsnprintf %.0f ns, CBOR %.1f ns, ratio %.0fx\n", text, cbor, text / cbor);
+        CHECK(cbor < text);
+    }
+}
+
+int main()
+{
+    HostMcu::reset();
+    CHECK(uart.initialize(USART::getDefaultUsartConfig()).isSuccess());
+    UsartModel<USART::StandardUSART> wire(uart);
+
+    testRfcEncodings();
+    testRecordRoundTrip();
+    testReservation(wire);
+    testSizeComparison();
+    benchmarkEncode();
+    return Check::result();
+}
@@ -0,0 +1,148 @@
+/**
+ * @file    TimeSyncTest.cpp
+ * @brief   TimeSync: Responder framing and the ClockModel accuracy simulation quoted in TimeSync.h
+ * @author  MootSeeker
+ *
+ * The simulation runs one exchange per second against a device clock that
+ * is 80 ppm fast, with a one-way latency of 1 ms plus uniform jitter in
+ * each direction (fixed seed). From the 60th exchange on it compares
+ * toHost() at t4 with the true host time and the fitted drift with the
+ * true drift, and prints the rejected share, offset error RMS/max and drift
+ * error max for each jitter range.
+ */
+
+#include "Check.h"
+
+#include "TimeSync.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    /// xorshift32, deterministic latency jitter
+    uint32_t random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    void testResponder()
+    {
+        uint8_t request[TimeSync::REQUEST_SIZE] = {TimeSync::REQUEST_MARKER, 0x5A, 0, 0};
+        const uint16_t crc = Crc::Crc16::compute(request, TimeSync::REQUEST_SIZE - 2);
+        request[2] = static_cast<uint8_t>(crc & 0xFFU);
+        request[3] = static_cast<uint8_t>(crc >> 8);
+
+        TimeSync::Responder responder;
+        CHECK(!responder.receiveByte('x', 1));   // Noise before the marker is skipped
+        bool complete = false;
+        for (uint8_t i = 0; i < TimeSync::REQUEST_SIZE; i++)
+        {
+            complete = responder.receiveByte(request[i], 1000 + i);
+        }
+        CHECK(complete);
+
+        uint8_t reply[TimeSync::REPLY_SIZE];
+        responder.buildReply(reply, 1050);
+        CHECK_EQ(reply[0], TimeSync::REPLY_MARKER);
+        CHECK_EQ(reply[1], 0x5A);
+        CHECK_EQ(reply[2] | (reply[3] << 8), 1003);    // t2: arrival of the last request byte
+        CHECK_EQ(reply[10] | (reply[11] << 8), 1050);  // t3
+        CHECK_EQ(Crc::Crc16::compute(reply, TimeSync::REPLY_SIZE), 0);
+
+        // A corrupted request is not answered
+        request[1] ^= 0x01U;
+        complete = false;
+        for (uint8_t i = 0; i < TimeSync::REQUEST_SIZE; i++)
+        {
+            complete = responder.receiveByte(request[i], 2000 + i);
+        }
+        CHECK(!complete);
+    }
+
+    struct Accuracy
+    {
+        double rejectedPercent;
+        double offsetRmsUs;
+        double offsetMaxUs;
+        double driftMaxPpm;
+    };
+
+    Accuracy simulate(uint32_t jitterUs)
+    {
+        constexpr int EXCHANGES = 600;
+        constexpr int FIRST_EVALUATED = 60;
+        constexpr double DEVICE_RATE = 1.0 + 80e-6;
+        constexpr double LATENCY_US = 1000.0;
+        constexpr double TURNAROUND_US = 50.0;
+        const double trueDriftPpm = (1.0 / DEVICE_RATE - 1.0) * 1e6;
+
+        uint32_t seed = 0x2468ACE1U;
+        auto jitter = [&]() { return static_cast<double>(random(seed) % (jitterUs + 1U)); };
+        auto device = [](double hostUs) { return static_cast<int64_t>(5000000.0 + hostUs * DEVICE_RATE); };
+
+        TimeSync::ClockModel model;
+        uint32_t rejectedBefore = 0;
+        double squares = 0.0;
+        Accuracy result{0.0, 0.0, 0.0, 0.0};
+        for (int i = 0; i < EXCHANGES; i++)
+        {
+            const double sent = 1e9 + i * 1e6;
+            const double received = sent + LATENCY_US + jitter();
+            const double replied = received + TURNAROUND_US;
+            const double arrived = replied + LATENCY_US + jitter();
+
+            const TimeSync::Exchange exchange{device(sent), static_cast<int64_t>(received),
+                                              static_cast<int64_t>(replied), device(arrived)};
+            model.addExchange(exchange);
+            if (i + 1 == FIRST_EVALUATED)
+            {
+                rejectedBefore = model.getRejectedCount();
+            }
+            if (i + 1 < FIRST_EVALUATED)
+            {
+                continue;
+            }
+
+            CHECK(model.isSynchronized());
+            const double offsetError = std::fabs(static_cast<double>(model.toHost(exchange.t4)) - arrived);
+            const double driftError = std::fabs(model.getDriftPpb() / 1000.0 - trueDriftPpm);
+            squares += offsetError * offsetError;
+            result.offsetMaxUs = std::fmax(result.offsetMaxUs, offsetError);
+            result.driftMaxPpm = std::fmax(result.driftMaxPpm, driftError);
+        }
+
+        const int evaluated = EXCHANGES - FIRST_EVALUATED + 1;
+        result.rejectedPercent = 100.0 * (model.getRejectedCount() - rejectedBefore) / (evaluated - 1);
+        result.offsetRmsUs = std::sqrt(squares / evaluated);
+        std::printf("jitter 0..%4u us: rejected %4.1f %%, offset RMS %5.1f us max %5.1f us, drift max %5.2f ppm\n",
+                    jitterUs, result.rejectedPercent, result.offsetRmsUs, result.offsetMaxUs, result.driftMaxPpm);
+        return result;
+    }
+
+    void testAccuracy()
+    {
+        // Bounds are the TimeSync.h table rounded up (the run is deterministic)
+        const Accuracy low = simulate(200);
+        CHECK(low.rejectedPercent < 1.0 && low.offsetRmsUs <= 15.0 && low.offsetMaxUs <= 45.0);
+        CHECK(low.driftMaxPpm <= 2.4);
+
+        const Accuracy medium = simulate(1000);
+        CHECK(medium.rejectedPercent <= 57.0 && medium.offsetRmsUs <= 64.0 && medium.offsetMaxUs <= 160.0);
+        CHECK(medium.driftMaxPpm <= 5.4);
+
+        const Accuracy high = simulate(4000);
+        CHECK(high.rejectedPercent <= 90.0 && high.offsetRmsUs <= 120.0 && high.offsetMaxUs <= 300.0);
+        CHECK(high.driftMaxPpm <= 5.5);
+    }
+}
+
+int main()
+{
+    testResponder();
+    testAccuracy();
+    return Check::result();
+}
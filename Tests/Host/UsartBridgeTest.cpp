@@ -0,0 +1,190 @@
+/**
+ * @file    UsartBridgeTest.cpp
+ * @brief   DMA bridge between USART_1 and USART_2 on the DMA channel model: ordering, interrupt count, overrun
+ * @author  MootSeeker
+ *
+ * Every step is one character time on both ports: each source RDR receives
+ * a byte that its RX DMA channel moves into the lane buffer, and each TX DMA
+ * channel moves one byte into the destination TDR. The channel interrupts go
+ * through USART_HandleDmaInterrupt() and are counted; the idle line at the
+ * end of a burst goes through the USART handler.
+ */
+
+#include "Check.h"
+#include "DmaModel.h"
+#include "HostMcu.h"
+#include "UsartModel.h"
+
+#include "usart_bridge.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr uint16_t LANE_SIZE = 512;
+
+    USART::StandardUSART portA(USART::PeripheralType::USART_1);
+    USART::StandardUSART portB(USART::PeripheralType::USART_2);
+    USART::DmaBridge<LANE_SIZE> bridge(portA, portB);
+
+    /// One direction as the hardware sees it: source RX channel, destination TX channel
+    struct Lane
+    {
+        USART_TypeDef* source;
+        USART_TypeDef* destination;
+        DmaModel rx;
+        DmaModel tx;
+        uint32_t rxChannelNumber;
+        uint32_t txChannelNumber;
+        std::vector<uint8_t> sent;
+        std::vector<uint8_t> forwarded;
+        uint32_t interrupts = 0;
+
+        /// One character time; txStalled keeps the destination from taking bytes
+        void step(const uint8_t* data, bool txStalled)
+        {
+            if (data != nullptr)
+            {
+                source->RDR = *data;
+                source->ISR = source->ISR | USART_ISR_RXNE;
+                sent.push_back(*data);
+                if (rx.request())
+                {
+                    source->ISR = source->ISR & ~USART_ISR_RXNE;
+                }
+                interrupts += rx.dispatch([this] { USART_HandleDmaInterrupt(DMA1, rxChannelNumber); });
+            }
+
+            if (!txStalled && tx.request())
+            {
+                forwarded.push_back(static_cast<uint8_t>(destination->TDR));
+                interrupts += tx.dispatch([this] { USART_HandleDmaInterrupt(DMA1, txChannelNumber); });
+            }
+        }
+
+        /// Let the destination drain what is already queued
+        void drain(size_t maxSteps = 4 * LANE_SIZE)
+        {
+            for (size_t i = 0; i < maxSteps; i++)
+            {
+                step(nullptr, false);
+            }
+        }
+    };
+
+    Lane laneAtoB{USART1, USART2, DmaModel(DMA1, LL_DMA_CHANNEL_5), DmaModel(DMA1, LL_DMA_CHANNEL_7), 5, 7, {}, {}};
+    Lane laneBtoA{USART2, USART1, DmaModel(DMA1, LL_DMA_CHANNEL_6), DmaModel(DMA1, LL_DMA_CHANNEL_4), 6, 4, {}, {}};
+
+    uint8_t pattern(size_t index, uint8_t seed)
+    {
+        return static_cast<uint8_t>((index * 7U) ^ (index >> 8) ^ seed);
+    }
+
+    void idle(UsartModel<USART::StandardUSART>& wire, Lane& lane)
+    {
+        wire.raise(USART_ISR_IDLE);
+        lane.interrupts++;
+    }
+
+    void testFullDuplexStream(UsartModel<USART::StandardUSART>& wireA, UsartModel<USART::StandardUSART>& wireB)
+    {
+        constexpr size_t STREAM_LENGTH = 16 * LANE_SIZE;
+
+        for (size_t i = 0; i < STREAM_LENGTH; i++)
+        {
+            const uint8_t a = pattern(i, 0x00);
+            const uint8_t b = pattern(i, 0x5A);
+            laneAtoB.step(&a, false);
+            laneBtoA.step(&b, false);
+        }
+        idle(wireA, laneAtoB);
+        idle(wireB, laneBtoA);
+        laneAtoB.drain();
+        laneBtoA.drain();
+
+        CHECK(laneAtoB.forwarded == laneAtoB.sent);
+        CHECK(laneBtoA.forwarded == laneBtoA.sent);
+        CHECK_EQ(bridge.getLaneAtoB().getBytesForwarded(), STREAM_LENGTH);
+        CHECK_EQ(bridge.getLaneBtoA().getBytesForwarded(), STREAM_LENGTH);
+        CHECK_EQ(bridge.getLaneAtoB().getOverrunCount(), 0);
+
+        // HT and TC per lap plus the TX completions of the chunks they start (about 5 per lap)
+        for (const Lane* lane : {&laneAtoB, &laneBtoA})
+        {
+            const double perLap = static_cast<double>(lane->interrupts) * LANE_SIZE / STREAM_LENGTH;
+            std::printf("lane: %u bytes, %u interrupts, %.2f per %u bytes\n", static_cast<unsigned>(STREAM_LENGTH),
+                        static_cast<unsigned>(lane->interrupts), perLap, static_cast<unsigned>(LANE_SIZE));
+            CHECK(perLap <= 5.5);
+        }
+    }
+
+    void testShortBurstNeedsIdle(UsartModel<USART::StandardUSART>& wireA)
+    {
+        laneAtoB.sent.clear();
+        laneAtoB.forwarded.clear();
+        const uint32_t before = bridge.getLaneAtoB().getBytesForwarded();
+
+        // Fewer bytes than half a lane: neither HT nor TC fires
+        for (size_t i = 0; i < 20; i++)
+        {
+            const uint8_t data = pattern(i, 0x33);
+            laneAtoB.step(&data, false);
+        }
+        laneAtoB.drain();
+        CHECK(laneAtoB.forwarded.empty());
+
+        idle(wireA, laneAtoB);
+        laneAtoB.drain();
+        CHECK(laneAtoB.forwarded == laneAtoB.sent);
+        CHECK_EQ(bridge.getLaneAtoB().getBytesForwarded(), before + 20);
+    }
+
+    void testOverrunResynchronizes(UsartModel<USART::StandardUSART>& wireA)
+    {
+        const uint32_t overruns = bridge.getLaneAtoB().getOverrunCount();
+
+        // The destination stalls while more than a lane arrives
+        for (size_t i = 0; i < LANE_SIZE + LANE_SIZE / 2; i++)
+        {
+            const uint8_t data = pattern(i, 0x77);
+            laneAtoB.step(&data, true);
+        }
+        laneAtoB.drain();
+        CHECK(bridge.getLaneAtoB().getOverrunCount() > overruns);
+
+        // After the drop the lane forwards new data in order again
+        laneAtoB.sent.clear();
+        laneAtoB.forwarded.clear();
+        for (size_t i = 0; i < LANE_SIZE; i++)
+        {
+            const uint8_t data = pattern(i, 0x11);
+            laneAtoB.step(&data, false);
+        }
+        idle(wireA, laneAtoB);
+        laneAtoB.drain();
+        CHECK(laneAtoB.forwarded == laneAtoB.sent);
+    }
+}
+
+int main()
+{
+    HostMcu::reset();
+    CHECK(portA.initialize(USART::getDefaultUsartConfig()).isSuccess());
+    CHECK(portB.initialize(USART::getDefaultUsartConfig()).isSuccess());
+
+    UsartModel<USART::StandardUSART> wireA(portA);
+    UsartModel<USART::StandardUSART> wireB(portB);
+    CHECK(bridge.start().isSuccess());
+    CHECK((USART1->CR3 & (USART_CR3_DMAR | USART_CR3_DMAT)) == (USART_CR3_DMAR | USART_CR3_DMAT));
+    CHECK(laneAtoB.rx.isEnabled() && laneBtoA.rx.isEnabled());
+
+    testFullDuplexStream(wireA, wireB);
+    testShortBurstNeedsIdle(wireA);
+    testOverrunResynchronizes(wireA);
+
+    bridge.stop();
+    CHECK(!laneAtoB.rx.isEnabled() && !laneAtoB.tx.isEnabled());
+    CHECK((USART1->CR3 & USART_CR3_DMAR) == 0);
+    return Check::result();
+}